@@ -0,0 +1,120 @@
+#ifndef ATSPM_H
+#define ATSPM_H
+
+/*
+ * Automated traffic signal performance measures. The aggregator consumes
+ * the records of an event log and keeps, per lane group, a ring of the
+ * latest 15 minute bins: volume, arrivals on green, yellow and red, split
+ * failures, green terminations, green and occupied time, and the arrivals
+ * of a Purdue coordination diagram. Every record updates the current bin
+ * in place and a bin boundary clears one slot, so nothing is rescanned. A
+ * split failure is a green with at least 80% detector occupancy followed
+ * by at least 80% occupancy in the first 5 seconds of red. The controller
+ * feeds the aggregator after every tick, from an in-memory log when no
+ * event log file is recorded.
+ *
+ * A lane group is the straight lanes of a direction, measured by the
+ * detector of the phase serving it: the main road directions by phases 2
+ * and 6, the side road directions by phases 4 and 8. Calls count as
+ * arrivals without occupancy, so do pulse mode actuations.
+ */
+
+#include "controller.h"
+#include "event_log.h"
+#include <stdio.h>
+
+#define ATSPM_BIN_MS (15U * MS_PER_MINUTE)
+#define ATSPM_DEFAULT_BINS 96U     // A day of bins
+#define ATSPM_PCD_BIN_MS 5000U     // Coordination diagram resolution
+#define ATSPM_PCD_BINS 48U         // Up to a 240 s cycle, later arrivals fall into the last bin
+#define ATSPM_ROR_WINDOW_MS 5000U  // Red occupancy is measured over the start of red
+#define ATSPM_SPLIT_FAILURE_OCCUPANCY 0.8 // Green and red occupancy ratio of a split failure
+
+typedef struct
+{
+    uint32_t volume;          // Detector actuations and calls
+    uint32_t arrivals_green;  // Arrivals while the phase showed green
+    uint32_t arrivals_yellow; // Yellow or flashing yellow
+    uint32_t arrivals_red;    // Any other state
+    uint32_t cycles;          // Greens started
+    uint32_t split_failures;  // Greens with occupancy >= 80% followed by red occupancy >= 80%
+    uint32_t terminations[TERMINATION_FORCE_OFF + 1U]; // Greens ended, by termination_t
+    uint32_t green_ms;
+    uint32_t occupied_ms;     // Presence detector occupied
+    uint16_t pcd[ATSPM_PCD_BINS]; // Arrivals by time since the phase turned red, the start of its cycle
+} atspm_bin_t;
+
+typedef struct
+{
+    atspm_bin_t *bins; // Ring of num_bins, absolute bin n is at n % num_bins
+    uint64_t accrued_ms;        // Green and occupied time are added to the bins up to here
+    uint64_t occupancy_ms;      // Occupied time up to occupied_since_ms
+    uint64_t occupied_since_ms;
+    uint64_t green_start_ms;
+    uint64_t green_occupancy_ms; // Occupancy at the start of green
+    uint64_t red_start_ms;
+    uint64_t ror_start_ms;      // Red occupancy window of a green with high occupancy
+    uint64_t ror_occupancy_ms;  // Occupancy at the start of the window
+    uint16_t intersection;
+    uint8_t phase;
+    uint8_t state;     // signal_state_t last logged
+    uint8_t num_lanes; // lane_group_t.count
+    uint8_t direction; // direction_type_t
+    bool is_pulse;     // Actuations have no duration
+    bool is_occupied;
+    bool is_green_occupied; // The last green ended with occupancy >= 80%
+    bool is_ror_open;
+    bool has_cycle; // red_start_ms is set
+} atspm_lane_t;
+
+typedef struct
+{
+    const controller_t *controllers;
+    size_t count;
+    atspm_lane_t *lanes;
+    size_t num_lanes;
+    int32_t *lane_of; // Index into lanes per intersection and phase_t, -1 for none
+    atspm_bin_t *bins;
+    uint32_t num_bins;
+    uint64_t origin_ms; // Wall clock of event time 0, bins are aligned to it
+    uint64_t bin;       // Current bin, counted from the Unix epoch or the start of a simulation
+    uint64_t first_bin; // Bin of event time 0
+    uint64_t cursor;    // Next event log record to consume
+    uint64_t lost;      // Records overwritten before they were consumed
+} atspm_t;
+
+// Keeps num_bins bins per lane group of the controllers, time 0 of the events is origin_ms
+bool atspm_init(
+    atspm_t *const atspm,
+    const controller_t *const controllers,
+    const size_t count,
+    const uint32_t num_bins,
+    const uint64_t origin_ms);
+
+void atspm_ingest(atspm_t *const atspm, const event_record_t *const record);
+
+// Ingests the records appended to the log since the last call
+void atspm_consume(atspm_t *const atspm, const event_log_t *const log);
+
+// Closes the bins and occupancy windows that ended by time_ms
+void atspm_advance(atspm_t *const atspm, const uint64_t time_ms);
+
+/*
+ * Copies the kept bins of a lane group, oldest first, after advancing to
+ * time_ms. The last bin is the one in progress. Returns the number copied
+ * and the start of the first one in ms since the origin's epoch.
+ */
+size_t atspm_snapshot(
+    atspm_t *const atspm,
+    const uint64_t time_ms,
+    const size_t lane,
+    atspm_bin_t *const bins,
+    const size_t max_bins,
+    uint64_t *const first_bin_ms);
+
+// Writes a snapshot of every lane group as CSV, one row per bin
+void atspm_write_csv(atspm_t *const atspm, const uint64_t time_ms, FILE *const stream);
+
+void atspm_free(atspm_t *const atspm);
+
+#endif // ATSPM_H
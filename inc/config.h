@@ -2,11 +2,20 @@
 #define CONFIG_H
 
 #include <stdbool.h>
+#include <stddef.h>
 #include <stdint.h>
 
 #define MAX_STR_LEN 64U
 #define MAX_ROADS 2U      // Exactly 2 intersecting roads
 #define MAX_DIRECTIONS 2U // Each road has exactly 2 directions
+#define MAX_PLANS 8U      // Timing plans, including the base plan
+#define MAX_SCHEDULE_ENTRIES 32U
+#define DAYS_PER_WEEK 7U
+#define MAX_PLAN_TRANSITIONS (MAX_SCHEDULE_ENTRIES * DAYS_PER_WEEK)
+#define MINUTES_PER_DAY 1440U
+#define MINUTES_PER_WEEK (MINUTES_PER_DAY * DAYS_PER_WEEK)
+#define CONFIG_BASE_PLAN 0U          // Built from the timing of the roads
+#define CONFIG_BASE_PLAN_ID "default" // Reserved, selects the base plan in a schedule
 
 typedef enum
 {
@@ -16,6 +25,18 @@ typedef enum
     DETECTOR_RADAR
 } detector_type_t;
 
+typedef enum
+{
+    DETECTOR_MEMORY_NON_LOCK, // Call held only while a vehicle is detected
+    DETECTOR_MEMORY_LOCK      // Call latched until the phase is served
+} detector_memory_t;
+
+typedef enum
+{
+    DETECTOR_MODE_PRESENCE, // Output held while a vehicle is in the zone
+    DETECTOR_MODE_PULSE     // Short output pulse per vehicle arrival
+} detector_mode_t;
+
 typedef enum
 {
     DIRECTION_NB,
@@ -35,7 +56,9 @@ typedef enum
 typedef struct
 {
     detector_type_t type;
-    uint16_t distance; // Only used for setback detectors
+    uint16_t distance;        // Only used for setback detectors
+    detector_memory_t memory; // Non-lock unless configured
+    detector_mode_t mode;     // Presence unless configured
 } detector_t;
 
 typedef struct
@@ -75,8 +98,9 @@ typedef struct
 {
     float yellow_time;      // Yellow clearance interval
     float red_clearance;    // All-red clearance interval
+    float passage_time;     // Green extension per actuation (gap), 0 if not actuated
     uint8_t min_green;      // Minimum green time
-    uint8_t max_green;      // Maximum green time
+    uint8_t max_green;      // Maximum green time, 0 if not actuated
     uint8_t ped_walk;       // Walk signal duration
     uint8_t ped_clearance;  // Pedestrian clearance time
 } phase_timing_t;
@@ -89,15 +113,115 @@ typedef struct
     phase_timing_t timing;
 } road_t;
 
+// Coordinated operation, cycle positions count from a daily sync reference at 00:00 local time
+typedef struct
+{
+    uint16_t cycle_length; // Cycle length in seconds, 0 runs free
+    uint16_t offset;       // Start of main road green after the sync reference
+    uint16_t split;        // Main road share of the cycle, including its yellow and red clearance
+} coordination_t;
+
+typedef struct
+{
+    char id[MAX_STR_LEN];
+    bool is_flash;                    // Flashes main yellow and side red instead of cycling
+    phase_timing_t timing[MAX_ROADS]; // Indexed like config_t.roads, unused when flashing
+    coordination_t coord;
+} timing_plan_t;
+
+// Plan switch of the weekly schedule
+typedef struct
+{
+    uint16_t minute; // Minute of the week, local time, Monday 00:00 is 0
+    uint8_t plan;    // Index into config_t.plans
+} plan_transition_t;
+
 typedef struct
 {
     ASSET_ID;
     intersection_type_t intersect_type;
     road_t roads[MAX_ROADS];
     road_t *main_road;
+    uint32_t corridor_position; // Distance along the coordinated corridor in feet
+    timing_plan_t plans[MAX_PLANS];
+    uint8_t num_plans;
+    uint16_t num_transitions; // No transitions runs the base plan all week
+    plan_transition_t transitions[MAX_PLAN_TRANSITIONS]; // Sorted by minute
 } config_t;
 
+#define CONFIG_PATH_DEPTH 8U     // Path elements kept per error
+#define CONFIG_PATH_NO_INDEX UINT32_MAX
+#define CONFIG_ERROR_ARGS 4U     // Message arguments kept per error
+#define CONFIG_ERROR_STR_LEN 96U // Bytes kept for the string arguments of an error
+
+typedef enum
+{
+    CONFIG_ERROR_INTERNAL,  // Assertion failure in the parser
+    CONFIG_ERROR_FILE,      // File missing or not valid JSON
+    CONFIG_ERROR_MISSING,   // Required field missing or of the wrong type
+    CONFIG_ERROR_RANGE,     // Number outside its legal range
+    CONFIG_ERROR_LENGTH,    // String longer than allowed
+    CONFIG_ERROR_UNKNOWN,   // String is none of the allowed values
+    CONFIG_ERROR_DUPLICATE, // Road name, direction pair, plan or schedule entry used twice
+    CONFIG_ERROR_RULE,      // Violates a design rule checked by config_validate
+    CONFIG_ERROR_NESTED     // Follows an error in a nested object
+} config_error_code_t;
+
+// Object member, with the array index when the member is an array
+typedef struct
+{
+    const char *key; // String literal, may hold several dotted members
+    uint32_t index;  // CONFIG_PATH_NO_INDEX if not an array element
+} config_path_elem_t;
+
+// Message argument captured by conversion, formatted only on request
+typedef struct
+{
+    uint16_t spec_offset; // Conversion specification in the format
+    uint8_t spec_len;
+    char conv;
+    union
+    {
+        long long i;
+        unsigned long long u;
+        double f;
+        uint16_t str; // Offset into config_error_t.strings
+    } value;
+} config_error_arg_t;
+
+typedef struct
+{
+    config_error_code_t code;
+    uint8_t depth;    // Elements in path, the last one is the failing field
+    uint8_t num_args;
+    config_path_elem_t path[CONFIG_PATH_DEPTH];
+    double actual;    // CONFIG_ERROR_RANGE only, limits are NAN when unbounded
+    double min;
+    double max;
+    const char *format; // printf format of the message, a string literal
+    config_error_arg_t args[CONFIG_ERROR_ARGS];
+    char strings[CONFIG_ERROR_STR_LEN];
+} config_error_t;
+
+// Caller supplied buffer for the errors of config_load and config_validate
+typedef struct
+{
+    config_error_t *errors;
+    uint32_t capacity;
+    uint32_t count; // Errors reported, only the first capacity ones are kept
+} config_error_sink_t;
+
 bool config_load(config_t *config, const char *filename);
 bool config_validate(const config_t *const cfg_ptr);
 
+// Sends config errors of the calling thread to sink, NULL prints them to stderr. A sink
+// keeps codes, paths and raw arguments, formatted only by config_error_path/config_error_message
+void config_set_error_sink(config_error_sink_t *const sink);
+
+// Formats an error like snprintf, e.g. "roads[1].directions[0].lanes.straight.count"
+int config_error_path(const config_error_t *const error, char *const buf, const size_t size);
+int config_error_message(const config_error_t *const error, char *const buf, const size_t size);
+
+const char *config_error_code_str(const config_error_code_t code);
+
 #endif // CONFIG_H
\ No newline at end of file
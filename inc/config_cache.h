@@ -0,0 +1,38 @@
+#ifndef CONFIG_CACHE_H
+#define CONFIG_CACHE_H
+
+/*
+ * Precompiled binary config images. A validated config_t is written next
+ * to its JSON source as "<source>.bin", together with a hash of the source
+ * so that an edited JSON file is detected and parsed again at startup. An
+ * image written by an incompatible build, another version or size of
+ * config_t, is ignored with a message.
+ */
+
+#include "config.h"
+
+#define CONFIG_CACHE_EXT ".bin"
+#define CONFIG_CACHE_MAGIC 0x47464354U // "TCFG"
+#define CONFIG_CACHE_VERSION 3U        // Bump on any change to config_t
+#define CONFIG_CACHE_NO_MAIN_ROAD UINT32_MAX
+
+typedef struct
+{
+    uint32_t magic;
+    uint32_t version;
+    uint32_t config_size; // sizeof(config_t) of the writer
+    uint32_t main_road;   // Index into roads, the image stores no pointers
+    uint64_t source_hash; // FNV-1a of the JSON source
+    uint64_t checksum;    // FNV-1a of the config image
+} config_cache_header_t;
+
+// Loads and validates the JSON source, then writes its binary image
+bool config_cache_compile(const char *const filename);
+
+// Loads the binary image of a JSON source, fails if it is missing or stale
+bool config_cache_load(config_t *const config, const char *const filename);
+
+// Uses the binary image when it is current, otherwise loads and validates the JSON source
+bool config_load_cached(config_t *const config, const char *const filename);
+
+#endif // CONFIG_CACHE_H
@@ -0,0 +1,154 @@
+#ifndef CONFIG_PARSE_H
+#define CONFIG_PARSE_H
+
+/*
+ * Shared by the config parsers: legal parameter ranges and lookups of
+ * enumerated parameter names, so every parser reports the same errors.
+ */
+
+#include "config.h"
+#include <stddef.h>
+
+#define MAX(a, b) ((a) > (b) ? (a) : (b))
+#define STRLEN(s) (sizeof(s) - 1U)
+
+#define DET_TYPE_LOOP "LOOP"
+#define DET_TYPE_VIDEO "VIDEO"
+#define DET_TYPE_RADAR "RADAR"
+#define MAX_DET_TYPE_STR_LEN MAX(                       \
+    MAX(STRLEN(DET_TYPE_LOOP), STRLEN(DET_TYPE_VIDEO)), \
+    STRLEN(DET_TYPE_RADAR))
+
+#define DET_MEMORY_NON_LOCK "NON_LOCK"
+#define DET_MEMORY_LOCK "LOCK"
+#define MAX_DET_MEMORY_STR_LEN MAX(STRLEN(DET_MEMORY_NON_LOCK), STRLEN(DET_MEMORY_LOCK))
+
+#define DET_MODE_PRESENCE "PRESENCE"
+#define DET_MODE_PULSE "PULSE"
+#define MAX_DET_MODE_STR_LEN MAX(STRLEN(DET_MODE_PRESENCE), STRLEN(DET_MODE_PULSE))
+
+#define DIR_TYPE_NB "NB"
+#define DIR_TYPE_SB "SB"
+#define DIR_TYPE_EB "EB"
+#define DIR_TYPE_WB "WB"
+#define MAX_DIR_TYPE_STR_LEN MAX(                  \
+    MAX(STRLEN(DIR_TYPE_NB), STRLEN(DIR_TYPE_SB)), \
+    MAX(STRLEN(DIR_TYPE_EB), STRLEN(DIR_TYPE_WB)))
+
+// Days of the week in schedule entries, in the order of the week starting Monday
+#define DAY_MON "MON"
+#define DAY_TUE "TUE"
+#define DAY_WED "WED"
+#define DAY_THU "THU"
+#define DAY_FRI "FRI"
+#define DAY_SAT "SAT"
+#define DAY_SUN "SUN"
+#define MAX_DAY_STR_LEN STRLEN(DAY_MON)
+#define ALL_DAYS_MASK ((uint8_t)((1U << DAYS_PER_WEEK) - 1U))
+
+#define MAX_LANES 3U                // Maximum lanes per direction
+#define MIN_DETECTOR_DISTANCE 80U   // Minimum distance for setback detectors
+#define MAX_DETECTOR_DISTANCE 485U  // Maximum distance for setback detectors
+#define MIN_CROSSING_DISTANCE 12U   // Minimum distance for pedestrian crossings
+#define MAX_CROSSING_DISTANCE 120U  // Maximum distance for pedestrian crossings
+#define MIN_SPEED_LIMIT 20U         // Minimum speed limit mph
+#define MAX_SPEED_LIMIT 60U         // Maximum speed limit mph
+#define MIN_SETBACK_SPEED_LIMIT 40U // Minimum speed limit for setback detectors
+
+#define MIN_YELLOW_TIME 3.0f   // Minimum yellow clearance time
+#define MAX_YELLOW_TIME 6.0f   // Maximum yellow clearance time
+#define MIN_RED_CLEARANCE 1.5f // Minimum red clearance time
+#define MAX_RED_CLEARANCE 3.0f // Maximum red clearance time
+#define MIN_GREEN_STOP_LINE 8U // For side road/left turns with stop line detection
+#define MIN_GREEN_SETBACK 15U  // For main road with setback detection (≥40 mph)
+#define MIN_PED_WALK_TIME 4U   // Minimum walk time with push buttons
+#define MIN_PASSAGE_TIME 0.5f  // Minimum green extension per actuation
+#define MAX_PASSAGE_TIME 5.0f  // Maximum green extension per actuation
+
+#define MIN_CYCLE_LENGTH 30U          // Shortest coordinated cycle in seconds
+#define MAX_CYCLE_LENGTH 240U         // Longest coordinated cycle in seconds
+#define MAX_CORRIDOR_POSITION 528000U // 100 miles in feet
+
+/*
+ * Errors go to the calling thread's error sink, or straight to stderr when
+ * there is none. field names the failing member of the object on top of the
+ * path stack, NULL if the error is about the object itself.
+ */
+void config_report_error(
+    const config_error_code_t code,
+    const char *const field,
+    const char *const format,
+    ...) __attribute__((format(printf, 3, 4)));
+
+// Reports a value outside [min, max], pass NAN for an unbounded limit
+void config_report_range(
+    const char *const field,
+    const double actual,
+    const double min,
+    const double max,
+    const char *const format,
+    ...) __attribute__((format(printf, 5, 6)));
+
+/*
+ * For a parser that reads members in document order but reports them in
+ * the order of the json-c parser: swaps in the sink that holds back the
+ * errors of a member and returns the sink to swap back, without resetting
+ * either count. config_report_held then reports the held errors to the
+ * current sink once the json-c parser would have reached the member.
+ */
+config_error_sink_t *config_swap_error_sink(config_error_sink_t *const sink);
+void config_report_held(const config_error_sink_t *const held);
+
+// Path of the member being parsed or validated, key must be a string literal
+void config_path_reset(void);
+void config_path_push(const char *const key, const uint32_t index);
+void config_path_pop(void);
+
+// Schedule entry as read from the config, the plan is resolved once all plans are read
+typedef struct
+{
+    char plan_id[MAX_STR_LEN];
+    uint8_t day_mask; // Bit 0 is Monday
+    uint16_t minute;  // Minute of the day
+} config_schedule_entry_t;
+
+/*
+ * Completes the plans of a config whose roads and plans are parsed, with
+ * the configured plans from config_t.plans[1] on and num_plans counting the
+ * base plan: fills the base plan from the timing of the roads, checks plan
+ * IDs are unique, resolves the plan of each schedule entry and expands the
+ * entries into transitions sorted by minute of the week.
+ */
+bool config_build_plans(
+    config_t *const config,
+    const config_schedule_entry_t *const entries,
+    const size_t num_entries);
+
+// Checks the ranges of a coordination object, the members are reported relative to it
+bool config_check_coordination(const coordination_t *const coord);
+
+// Parses "HH:MM" into the minute of the day
+bool config_str_to_time_of_day(const char *const time_str, uint16_t *const minute_ptr);
+
+bool config_str_to_day(
+    char *const day_str,
+    const size_t max_day_str_len,
+    uint8_t *const day_ptr);
+bool config_str_to_direction_type(
+    char *const dir_type_str,
+    const size_t max_dir_type_str_len,
+    direction_type_t *const dir_type_ptr);
+bool config_str_to_detector_type(
+    char *const det_type_str,
+    const size_t max_det_type_str_len,
+    detector_type_t *const det_type_ptr);
+bool config_str_to_detector_memory(
+    char *const det_memory_str,
+    const size_t max_det_memory_str_len,
+    detector_memory_t *const det_memory_ptr);
+bool config_str_to_detector_mode(
+    char *const det_mode_str,
+    const size_t max_det_mode_str_len,
+    detector_mode_t *const det_mode_ptr);
+
+#endif // CONFIG_PARSE_H
@@ -0,0 +1,48 @@
+#ifndef CONFIG_RELOAD_H
+#define CONFIG_RELOAD_H
+
+/*
+ * Hot reload of a running controller's config. On request, e.g. SIGHUP, a
+ * background thread loads and validates the config file again and publishes
+ * it to the controller, which switches over at its next interval boundary,
+ * or on its next step while main green rests, so every interval is timed
+ * by one config. A config that fails to load, or that changes the
+ * intersection type, is rejected and the current one keeps running.
+ * Configs live in a fixed set of slots and a slot is only reused once the
+ * controller has moved off it, so the tick path takes no locks.
+ */
+
+#include "config.h"
+#include "controller.h"
+#include <pthread.h>
+#include <semaphore.h>
+#include <stdatomic.h>
+
+#define CONFIG_RELOAD_SLOTS 3U // Running, published and being loaded
+
+typedef struct
+{
+    config_t slots[CONFIG_RELOAD_SLOTS];
+    controller_t *controller;
+    const char *path;
+    intersection_type_t intersect_type; // Fixed for the life of the controller
+    const config_t *active;             // Reload thread only, last config known to run
+    const config_t *published;          // Reload thread only, last config handed over
+    sem_t request;
+    pthread_t thread;
+    atomic_bool is_stopping;
+    bool is_started;
+    uint32_t num_published; // Reload thread only
+    uint32_t num_failed;    // Reload thread only
+} config_reload_t;
+
+// Starts the reload thread for a controller that is already initialized
+bool config_reload_start(config_reload_t *const reload, controller_t *const controller, const char *const path);
+
+// Wakes the reload thread, async-signal-safe
+void config_reload_request(config_reload_t *const reload);
+
+// Stops the reload thread, the controller must not be run afterwards
+void config_reload_stop(config_reload_t *const reload);
+
+#endif // CONFIG_RELOAD_H
@@ -0,0 +1,15 @@
+#ifndef CONFIG_STREAM_H
+#define CONFIG_STREAM_H
+
+/*
+ * Single pass config parser, what config_load runs when built with
+ * CONFIG_STREAM_PARSER. Always built, so it can be checked against the
+ * json-c parser.
+ */
+
+#include "config.h"
+
+// Loads like config_load and reports the same errors
+bool config_stream_load(config_t *config, const char *filename);
+
+#endif // CONFIG_STREAM_H
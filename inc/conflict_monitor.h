@@ -0,0 +1,75 @@
+#ifndef CONFLICT_MONITOR_H
+#define CONFLICT_MONITOR_H
+
+/*
+ * Software conflict monitor, the equivalent of a cabinet's malfunction
+ * management unit. After stepping a controller, the tick thread publishes
+ * the state of every head into a seqlock protected snapshot, and beats a
+ * heartbeat once per tick. A separate thread, pinned to its own CPU when
+ * one is available, reads the snapshots every tick without ever blocking
+ * the tick thread. It checks them against a compatibility matrix derived
+ * from each config, main road phases 2 and 6 against side road phases 4
+ * and 8, where a green, yellow or flashing yellow head conflicts. A
+ * conflict, or a heartbeat missed for longer than the timeout, latches a
+ * fault and the controller flashes red on all heads until it is restarted.
+ */
+
+#include "controller.h"
+#include "scheduler.h"
+#include <pthread.h>
+#include <stdatomic.h>
+#include <stddef.h>
+
+#define CONFLICT_HEARTBEAT_TIMEOUT_MS 1000U // Longest stall of the tick thread
+#define CONFLICT_HEARTBEAT_TICKS 3U          // Minimum timeout in ticks, for long ticks
+#define CONFLICT_READ_RETRIES 4U             // Snapshot reads per check before waiting for the next tick
+#define CONFLICT_CACHE_LINE 64U
+
+// Published head states of one controller
+typedef struct
+{
+    _Alignas(CONFLICT_CACHE_LINE) atomic_uint sequence; // Odd while the tick thread writes
+    _Atomic uint64_t states;                             // signal_state_t per phase, one byte each
+    _Atomic uint64_t time_ms;                            // Tick of the publication
+} conflict_snapshot_t;
+
+typedef struct
+{
+    conflict_snapshot_t snapshot;
+    uint8_t compatible[NUM_PHASES]; // Phases each phase may show go with, itself included when used
+    char id[MAX_STR_LEN];           // Intersection ID, copied as a reload may swap the config
+    bool is_faulted;                // Monitor thread only
+} conflict_channel_t;
+
+typedef struct
+{
+    conflict_channel_t *channels; // Same index as controllers
+    controller_t *controllers;
+    size_t count;
+    _Alignas(CONFLICT_CACHE_LINE) _Atomic uint64_t heartbeat; // Ticks completed by the tick thread
+    _Alignas(CONFLICT_CACHE_LINE) atomic_uint num_faults;     // Faults latched, read by the host
+    atomic_bool is_stopping;
+    bool is_started;
+    uint32_t timeout_ms;
+    scheduler_t scheduler;
+    pthread_t thread;
+    uint64_t checks;      // Monitor thread only, snapshots checked
+    uint64_t busy_reads;  // Monitor thread only, snapshots skipped while being written
+} conflict_monitor_t;
+
+// Derives the compatibility matrices, publishes the current states and starts the monitor thread
+bool conflict_monitor_start(
+    conflict_monitor_t *const monitor,
+    controller_t *const controllers,
+    const size_t count,
+    const uint32_t tick_ms);
+
+// Publishes the head states of a controller, call from the tick thread after stepping it
+void conflict_monitor_publish(conflict_monitor_t *const monitor, const size_t index, const uint64_t time_ms);
+
+// Marks a completed tick, call once per tick from the tick thread
+void conflict_monitor_heartbeat(conflict_monitor_t *const monitor);
+
+void conflict_monitor_stop(conflict_monitor_t *const monitor);
+
+#endif // CONFLICT_MONITOR_H
@@ -2,6 +2,7 @@
 #define CONTROLLER_H
 
 #include "config.h"
+#include <stdatomic.h>
 #include <stdint.h>
 #include <stdbool.h>
 
@@ -29,23 +30,174 @@ typedef enum
     SIGNAL_OFF
 } signal_state_t;
 
+// Reason the last green interval ended
+typedef enum
+{
+    TERMINATION_NONE,     // No green has ended yet
+    TERMINATION_TIMED,    // Non-actuated green ran its duration
+    TERMINATION_GAP_OUT,  // Passage timers of all green phases expired
+    TERMINATION_MAX_OUT,  // Max timer expired under a conflicting call
+    TERMINATION_FORCE_OFF // Coordinated cycle reached the end of the phase's split
+} termination_t;
+
+#define PHASE_BIT(phase) ((uint8_t)(1U << (phase))) // Phase flag in a call register
+#define PLAN_BIT(plan) ((uint8_t)(1U << (plan)))    // Plan flag in controller_runtime_t.flash_mask
+
+// Phases of the main road, their heads show main_state, the others side_state
+#define MAIN_ROAD_PHASES (PHASE_BIT(PHASE_1) | PHASE_BIT(PHASE_2) | PHASE_BIT(PHASE_5) | PHASE_BIT(PHASE_6))
+
+// The road config_t.main_road points at, and the other one
+typedef enum
+{
+    ROAD_MAIN,
+    ROAD_SIDE,
+    NUM_ROAD_ROLES
+} road_role_t;
+
+// Through phase serving each direction of a road, indexed by road_role_t and the direction's index in road_t
+extern const phase_t direction_phases[NUM_ROAD_ROLES][MAX_DIRECTIONS];
+
+#define MAX_INTERVALS 8U                 // Maximum timing intervals in a controller cycle
+#define CONTROLLER_FAULT_INTERVAL (MAX_INTERVALS - 1U) // Red flash after a monitor fault, reserved by every type
+#define CONTROLLER_NO_EXPIRY UINT32_MAX // Resting, only a new call ends the interval
+#define CONTROLLER_CACHE_LINE 64U
+#define MS_PER_MINUTE 60000U
+#define MS_PER_DAY (MINUTES_PER_DAY * MS_PER_MINUTE)
+#define MS_PER_WEEK (MINUTES_PER_WEEK * MS_PER_MINUTE)
+
+// A single timed step of the phase sequence, e.g. main road yellow
+typedef struct
+{
+    phase_t phase; // Leading phase timed by this interval
+    signal_state_t main_state;
+    signal_state_t side_state;
+    uint32_t duration_ms;
+    uint8_t next;       // Index of the interval that follows
+    uint8_t hold_mask;  // Rest past duration until one of these phases is called
+    uint8_t green_mask; // Phases showing green, their calls are served
+    uint8_t extend_mask; // Actuated phases extending the interval past its duration
+
+    // Cycle positions, ms, only used when coordinated. A resting interval
+    // yields to a call only inside [start, end], any other green is forced
+    // off outside [start, end)
+    uint32_t window_start_ms;
+    uint32_t window_end_ms;
+} controller_interval_t;
+
 typedef struct
 {
     phase_t current_phase;
     signal_state_t main_state;
     signal_state_t side_state;
-    uint32_t phase_timer; // Time in current phase
+    uint32_t phase_timer; // Time in current phase, ms
+    uint8_t interval;     // Index of the active interval
+
+    // Call registers, one bit per phase_t
+    uint8_t calls;     // Latched calls, kept until the phase is served
+    uint8_t presence;  // Detectors currently occupied
+    uint8_t extension; // Actuations since the previous step
+
+    // Actuated timing, ms remaining, indexed by phase_t
+    uint32_t gap_timer[NUM_PHASES]; // Passage timers, reloaded by actuations
+    uint32_t max_timer[NUM_PHASES]; // Max green timers, run under a conflicting call
+    termination_t termination;      // How the last green ended
+
+    // Time-of-day plan selection
+    uint32_t week_ms;         // Local time of the week, Monday 00:00 is 0
+    uint32_t next_plan_ms;    // week_ms of the next transition, MS_PER_WEEK after the last one
+    uint16_t next_transition; // Index into config->transitions
+    uint8_t plan;             // Plan selected by the schedule, index into config->plans
 } controller_state_t;
 
+/*
+ * Timing read on every step, compiled from the config by configure(). The
+ * tick path reads this cache line, the state and the active entry of
+ * intervals[] instead of config_t, where the same values are spread among
+ * IDs and names, and only goes back to the config when a plan or config
+ * changes. The line is full, so the intervals stay in their own array.
+ */
+typedef struct
+{
+    _Alignas(CONTROLLER_CACHE_LINE) uint32_t max_green_ms[NUM_PHASES]; // Max green counted from a conflicting call
+    uint16_t passage_ms[NUM_PHASES]; // Passage time, 0 for non-actuated phases, at most 5 s
+    uint32_t cycle_ms;    // Coordinated cycle length, 0 when running free
+    uint32_t offset_ms;   // Main road green start after the daily sync reference
+    uint8_t recall_mask;  // Phases without detection, called on every step
+    uint8_t lock_mask;    // Phases with lock memory detectors
+    uint8_t pulse_mask;   // Phases with pulse mode detectors
+    uint8_t phase_mask;   // Phases used by the intersection
+    uint8_t flash_mask;   // Flash plans, one PLAN_BIT per index into config->plans
+    uint8_t active_plan;  // Plan the intervals were compiled from
+    uint8_t num_intervals;
+} controller_runtime_t;
+
+_Static_assert(sizeof(controller_runtime_t) == CONTROLLER_CACHE_LINE, "Runtime timing must fit a cache line");
+_Static_assert(MAX_PLANS <= 8U, "flash_mask holds one bit per plan");
+
 typedef struct controller controller_t;
 struct controller
 {
-    const config_t *config;
+    controller_runtime_t runtime; // First, so controllers in an array do not share cache lines
     controller_state_t state;
+    controller_interval_t intervals[MAX_INTERVALS]; // Compiled at init
+    uint32_t tick_ms; // Time advanced by a single run() call
+    uint32_t start_week_ms; // Local time of the week at init, see controller_state_t.week_ms
     bool (*init)(controller_t *const controller);
-    void (*run)(controller_t *const controller);
+    bool (*configure)(controller_t *const controller); // Compiles timing from config, keeps state
+    void (*run)(controller_t *const controller); // Advances one tick
+    void (*advance)(controller_t *const controller, const uint32_t elapsed_ms);
+
+    // Read at plan and config changes, pending_config is checked at interval boundaries and during a rest
+    const config_t *config;
+    _Atomic(const config_t *) pending_config; // Published by a reload, taken at an interval boundary or a rest
+    atomic_bool is_faulted; // Set by the conflict monitor, latched until restart
 };
 
 bool controller_init(controller_t *const controller);
+// Switches to a published config, called by the controller type at interval boundaries and while resting
+void controller_apply_pending_config(controller_t *const controller);
+
+/*
+ * Time-of-day plans. The schedule is a sorted array of transitions, so the
+ * clock only compares against the next one and steps a cursor when it is
+ * reached. The controller type switches to a new plan at an interval
+ * boundary, like a reloaded config, or at once while main green rests. A
+ * flash plan ends the rest and runs the max timers as if the other road had
+ * called, flash is entered after a red clearance and left through the
+ * all-red interval.
+ */
+void controller_seek_plan(controller_t *const controller);
+void controller_advance_clock(controller_t *const controller, const uint32_t elapsed_ms);
+
+/*
+ * Coordination. Every controller of a corridor counts its cycle from the
+ * same sync reference, local midnight, so controllers with the same cycle
+ * length keep their offsets to each other without communicating. Position 0
+ * is the start of main road green.
+ *
+ * Main road green is not actuated and rests until the yield point, its split
+ * less clearance, and later yields to a call only while the side road still
+ * fits its minimum green. Side road green is forced off in time for main
+ * road green to start on the next cycle, a non-actuated side road runs its
+ * whole split. After a plan change the controller dwells in main road green
+ * until the new cycle reaches the yield point.
+ */
+uint32_t controller_cycle_position(const controller_t *const controller);
+
+// Time until the interval can end or the next plan transition, whichever is first
+uint32_t controller_time_to_expiry(const controller_t *const controller);
+uint8_t controller_demand(const controller_t *const controller);
+
+// State shown by the head of a phase, SIGNAL_OFF for a phase the intersection does not use
+signal_state_t controller_head_state(const controller_t *const controller, const phase_t phase);
+
+const char *signal_state_str(const signal_state_t state);
+const char *termination_str(const termination_t termination);
+
+// Places a latched call regardless of detector memory, e.g. a scripted call
+void controller_place_call(controller_t *const controller, const phase_t phase);
+
+// Applies a detector actuation according to the phase's memory and mode
+void controller_detector_input(controller_t *const controller, const phase_t phase, const bool is_on);
 
 #endif // CONTROLLER_H
@@ -6,6 +6,8 @@
 #include "controller.h"
 
 bool controller_type1_init(controller_t *const controller);
+bool controller_type1_configure(controller_t *const controller);
 void controller_type1_run(controller_t *const controller);
+void controller_type1_advance(controller_t *const controller, const uint32_t elapsed_ms);
 
 #endif // CONTROLLER_TYPE1_H
@@ -0,0 +1,73 @@
+#ifndef COORDINATION_H
+#define COORDINATION_H
+
+/*
+ * Offset optimization for a corridor of coordinated intersections along one
+ * main road. For a common cycle length it searches the main road green start
+ * of every intersection, relative to the first one, that maximizes the
+ * two-way progression bandwidth: the part of the cycle in which a vehicle
+ * travelling at the speed limit passes every intersection on green.
+ * Candidate cycle lengths are independent and optimized in parallel.
+ */
+
+#include "config.h"
+#include "config_parse.h"
+#include "thread_pool.h"
+
+#define CORRIDOR_MAX_NODES 64U
+#define CORRIDOR_MAX_CYCLES (MAX_CYCLE_LENGTH - MIN_CYCLE_LENGTH + 1U)
+
+// An intersection of the corridor, built from the base plan of its config
+typedef struct
+{
+    char id[MAX_STR_LEN];
+    uint32_t position_ft; // Nodes are sorted by corridor position
+    float speed_fps;      // Main road speed limit
+    float split_ratio;    // Configured main road share of the cycle, 0 when running free
+    float main_min_s;     // Main road minimum green and clearance
+    float main_clear_s;   // Main road yellow and red clearance
+    float side_min_s;     // Side road minimum green and clearance
+} corridor_node_t;
+
+typedef struct
+{
+    corridor_node_t nodes[CORRIDOR_MAX_NODES];
+    size_t num_nodes;
+} corridor_t;
+
+// Timing of every node for one cycle length, indexed like corridor_t.nodes
+typedef struct
+{
+    uint16_t cycle_length;
+    bool is_feasible;    // Every node fits its minimum times into the cycle
+    float bandwidth_out; // Seconds, travelling towards increasing position
+    float bandwidth_in;  // Seconds, travelling towards decreasing position
+    float efficiency;    // Two-way bandwidth as a share of twice the cycle
+    uint16_t offsets[CORRIDOR_MAX_NODES];
+    uint16_t splits[CORRIDOR_MAX_NODES];
+} corridor_plan_t;
+
+// Adds an intersection at its corridor position
+bool corridor_add(corridor_t *const corridor, const config_t *const config);
+
+// Optimizes the offsets of all nodes for a single cycle length
+void corridor_optimize(const corridor_t *const corridor, const uint16_t cycle_length, corridor_plan_t *const plan);
+
+/*
+ * Optimizes every cycle length from min_cycle to max_cycle in steps of step
+ * seconds on the pool, one task per cycle length. plans must hold
+ * CORRIDOR_MAX_CYCLES entries, num_plans receives the number filled in.
+ */
+bool corridor_search(
+    const corridor_t *const corridor,
+    thread_pool_t *const pool,
+    const uint16_t min_cycle,
+    const uint16_t max_cycle,
+    const uint16_t step,
+    corridor_plan_t *const plans,
+    size_t *const num_plans);
+
+// Index of the most efficient feasible plan, shorter cycles win ties, count if none is feasible
+size_t corridor_best_plan(const corridor_plan_t *const plans, const size_t count);
+
+#endif // COORDINATION_H
@@ -0,0 +1,97 @@
+#ifndef DETECTOR_INPUT_H
+#define DETECTOR_INPUT_H
+
+/*
+ * Detector input subsystem. Each detector source (loop card, video or
+ * radar unit) is read by its own producer thread, which pushes timestamped
+ * actuation events into a lock-free single-producer/single-consumer ring.
+ * The controller thread drains the rings in batches once per tick.
+ */
+
+#include "controller.h"
+#include "event_log.h"
+#include <pthread.h>
+#include <stdatomic.h>
+#include <stddef.h>
+
+#define DETECTOR_RING_SIZE 1024U // Events per source, power of two
+#define DETECTOR_RING_MASK (DETECTOR_RING_SIZE - 1U)
+#define DETECTOR_BATCH_SIZE 64U  // Events drained per source and pop
+#define MAX_DETECTOR_SOURCES 16U
+#define DETECTOR_CACHE_LINE 64U
+
+typedef struct
+{
+    uint64_t timestamp_ns; // CLOCK_MONOTONIC time the event was read
+    uint32_t intersection; // Index of the controller, 0 with a single one
+    uint8_t phase;         // phase_t served by the detector
+    uint8_t source;        // Index of the producing source
+    bool is_on;            // Vehicle present (on) or gone (off)
+} detector_event_t;
+
+// Controller index of an intersection ID, sorted by ID
+typedef struct
+{
+    const char *id;
+    uint32_t index;
+} detector_route_t;
+
+typedef struct
+{
+    _Alignas(DETECTOR_CACHE_LINE) atomic_size_t head; // Written by the producer
+    _Alignas(DETECTOR_CACHE_LINE) atomic_size_t tail; // Written by the consumer
+    _Alignas(DETECTOR_CACHE_LINE) detector_event_t events[DETECTOR_RING_SIZE];
+} detector_ring_t;
+
+typedef struct
+{
+    detector_ring_t ring;
+    const char *path; // File, FIFO or character device producing events
+    int fd;
+    uint8_t index;
+    pthread_t thread;
+    atomic_bool *is_stopping;
+    const detector_route_t *routes; // Lines carry an intersection ID when not NULL
+    size_t num_routes;
+    uint64_t received; // Producer only
+    uint64_t dropped;  // Producer only, ring was full
+    uint64_t invalid;  // Producer only, malformed lines
+} detector_source_t;
+
+typedef struct
+{
+    size_t count;
+    detector_source_t *sources;
+    detector_route_t *routes; // NULL for a single intersection
+    size_t num_routes;
+    atomic_bool is_stopping;
+    uint64_t drained; // Consumer only
+} detector_input_t;
+
+bool detector_ring_push(detector_ring_t *const ring, const detector_event_t *const event);
+size_t detector_ring_pop(detector_ring_t *const ring, detector_event_t *const events, const size_t max_events);
+
+/*
+ * Starts one producer thread per path. Each source emits text lines of the
+ * form "<phase> <on|off>", e.g. "4 on". When the sources serve several
+ * controllers, lines start with the intersection ID of the config instead,
+ * e.g. "INT001 4 on", and events carry the index of its controller.
+ * controllers is NULL for a single intersection.
+ */
+bool detector_input_start(
+    detector_input_t *const input,
+    char *const paths[],
+    const size_t count,
+    const controller_t *const controllers,
+    const size_t num_controllers);
+
+// Applies all pending events of a single intersection to the controller and logs them at time_ms, returns the number drained
+size_t detector_input_drain(
+    detector_input_t *const input,
+    controller_t *const controller,
+    event_log_t *const log,
+    const uint64_t time_ms);
+
+void detector_input_stop(detector_input_t *const input);
+
+#endif // DETECTOR_INPUT_H
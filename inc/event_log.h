@@ -0,0 +1,131 @@
+#ifndef EVENT_LOG_H
+#define EVENT_LOG_H
+
+/*
+ * High resolution event log. Signal changes, detector actuations, calls,
+ * plan changes and faults are appended as fixed size binary records to a
+ * ring in a memory-mapped file. The tick thread is the only writer, and
+ * an append is a plain store into the shared mapping with no system call.
+ * The file's blocks are allocated and mapped when the log is opened, so a
+ * full disk fails the open instead of a store. The kernel writes the pages
+ * back on its own, the records survive a crash of the process.
+ * tools/event_decode converts a log to CSV.
+ *
+ * File layout: event_log_header_t, the intersection IDs, then the record
+ * ring at a page aligned offset. Record i of the log's history is stored
+ * at index i % capacity.
+ */
+
+#include "controller.h"
+#include <stdatomic.h>
+#include <stddef.h>
+
+#define EVENT_LOG_MAGIC "TCEVLOG"
+#define EVENT_LOG_VERSION 1U
+#define EVENT_LOG_DEFAULT_RECORDS (1U << 20) // 16 MiB of records, power of two
+
+typedef enum
+{
+    EVENT_SIGNAL,       // Head of phase changed to state, cause is the termination of a green
+    EVENT_DETECTOR_ON,  // Detector actuation of phase
+    EVENT_DETECTOR_OFF,
+    EVENT_CALL,         // Latched call of phase
+    EVENT_PLAN,         // Timing plan change, value is the index into config->plans
+    EVENT_FAULT,        // Conflict monitor fault, red flash follows
+    EVENT_NUM_KINDS
+} event_kind_t;
+
+typedef struct
+{
+    uint64_t time_ms;      // Controller time, ms since the log was opened or the simulation started
+    uint16_t intersection; // Index into the intersection IDs of the header
+    uint8_t kind;          // event_kind_t
+    uint8_t phase;         // phase_t
+    uint8_t state;         // signal_state_t, EVENT_SIGNAL only
+    uint8_t cause;         // termination_t, EVENT_SIGNAL only
+    uint16_t value;        // Kind specific, e.g. the plan of EVENT_PLAN
+} event_record_t;
+
+_Static_assert(sizeof(event_record_t) == 16U, "Event records are 16 bytes on disk");
+
+typedef struct
+{
+    char magic[8];
+    uint32_t version;
+    uint32_t record_size;
+    uint64_t capacity;          // Records in the ring, power of two
+    _Atomic uint64_t head;      // Records appended since the log was opened
+    uint64_t epoch_ms;          // CLOCK_REALTIME of time_ms 0, 0 on a virtual clock
+    uint64_t records_offset;    // File offset of the ring
+    uint32_t tick_ms;
+    uint32_t num_intersections; // IDs follow the header, MAX_STR_LEN bytes each
+} event_log_header_t;
+
+// Signals last logged for a controller
+typedef struct
+{
+    uint8_t phase_mask;
+    uint8_t main_shown;
+    uint8_t side_shown;
+    uint8_t plan;
+    bool is_faulted;
+} event_track_t;
+
+typedef struct
+{
+    event_log_header_t *header;
+    event_record_t *records;
+    uint64_t mask;
+    uint64_t head; // Tick thread copy of header->head
+    size_t map_len;
+    const controller_t *controllers;
+    event_track_t *tracks; // Same index as controllers
+    size_t count;
+} event_log_t;
+
+// Read only mapping of a log file, for decoding and replay
+typedef struct
+{
+    const event_log_header_t *header;
+    const char (*ids)[MAX_STR_LEN];
+    const event_record_t *records;
+    uint64_t first; // History index of the oldest record kept
+    uint64_t count; // Records kept
+    size_t map_len;
+} event_log_view_t;
+
+/*
+ * Creates or truncates the log file with room for capacity records, a power
+ * of two, and logs the current signals of every controller at time 0. A
+ * NULL path keeps the ring in memory only, for in-process consumers such
+ * as the ATSPM aggregator.
+ */
+bool event_log_open(
+    event_log_t *const log,
+    const char *const path,
+    const uint64_t capacity,
+    const controller_t *const controllers,
+    const size_t count,
+    const uint32_t tick_ms,
+    const bool is_virtual);
+
+void event_log_append(event_log_t *const log, const event_record_t *const record);
+
+// Logs the signal, plan and fault changes of a controller, call after stepping it
+void event_log_update(event_log_t *const log, const size_t index, const uint64_t time_ms);
+
+// Logs a detector actuation or call of a controller
+void event_log_input(event_log_t *const log, const size_t index, const uint64_t time_ms, const event_kind_t kind, const phase_t phase);
+
+void event_log_close(event_log_t *const log);
+
+bool event_log_view_open(event_log_view_t *const view, const char *const path);
+
+// Record i of the view, 0 is the oldest
+const event_record_t *event_log_view_record(const event_log_view_t *const view, const uint64_t i);
+
+void event_log_view_close(event_log_view_t *const view);
+
+const char *event_kind_str(const event_kind_t kind);
+
+#endif // EVENT_LOG_H
@@ -0,0 +1,67 @@
+#ifndef HOST_H
+#define HOST_H
+
+/*
+ * Runs many intersection controllers in one process from a shared timer
+ * wheel. Configs, controllers and their timers are kept in contiguous
+ * arrays, and a tick only steps the controllers whose interval timers
+ * expire, on the thread pool when it has more than one thread.
+ */
+
+#include "conflict_monitor.h"
+#include "controller.h"
+#include "detector_input.h"
+#include "event_log.h"
+#include "signal_output.h"
+#include "thread_pool.h"
+#include "timer_wheel.h"
+#include <stddef.h>
+
+typedef struct
+{
+    wheel_timer_t timer;
+    uint64_t last_tick; // Wheel tick of the last controller step
+} host_entry_t;
+
+typedef struct
+{
+    size_t count;
+    uint32_t tick_ms;
+    config_t *configs;         // Contiguous, one per controller
+    controller_t *controllers; // Contiguous, same index as configs
+    host_entry_t *entries;     // Contiguous, same index as configs
+    timer_wheel_t wheel;
+    thread_pool_t pool;
+    uint32_t *expired; // Controllers due in the current tick
+    signal_output_t *output; // Signal heads of all controllers, NULL without output
+    conflict_monitor_t *monitor; // NULL without a conflict monitor
+    event_log_t *log;            // NULL without an event log
+    detector_input_t *detectors; // NULL without detector sources
+    uint32_t num_faults;         // Monitor faults already handled
+    uint64_t steps;    // Controller steps performed
+} host_t;
+
+/*
+ * Loads every config from the given paths. A path may be a config file or
+ * a directory, in which case all *.json files in it are loaded.
+ */
+bool host_init(
+    host_t *const host,
+    char *const paths[],
+    const size_t num_paths,
+    const uint32_t tick_ms,
+    const size_t num_threads);
+
+/*
+ * Advances all controllers by one tick, stepping only those whose timers
+ * expire or that received detector events. Large batches are spread across
+ * the thread pool.
+ */
+void host_tick(host_t *const host);
+
+// Catches the controller up to the current tick, then applies and logs a detector actuation, it steps on the next tick
+void host_detector_input(host_t *const host, const size_t index, const phase_t phase, const bool is_on);
+
+void host_free(host_t *const host);
+
+#endif // HOST_H
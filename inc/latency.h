@@ -0,0 +1,68 @@
+#ifndef LATENCY_H
+#define LATENCY_H
+
+/*
+ * Timing instrumentation of the tick path. Each metric is recorded into a
+ * log-bucketed histogram, HDR style: buckets double in width with every
+ * power of two and are split into LATENCY_SUB_BUCKETS linear sub-buckets,
+ * so any value from 1 ns to hours is kept within 12.5%. Every thread
+ * records into its own histograms, registered on first use, so recording
+ * takes no locks and shares no cache lines.
+ */
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+
+#define LATENCY_SUB_BUCKET_BITS 3U
+#define LATENCY_SUB_BUCKETS (1U << LATENCY_SUB_BUCKET_BITS)
+#define LATENCY_BUCKETS ((64U - LATENCY_SUB_BUCKET_BITS + 1U) * LATENCY_SUB_BUCKETS)
+#define LATENCY_CACHE_LINE 64U
+
+typedef enum
+{
+    LATENCY_TICK,   // Tick deadline to the end of its work, signals written
+    LATENCY_JITTER, // Tick deadline to the wake-up of the tick thread
+    LATENCY_STEP,   // One controller state machine step
+    LATENCY_NUM_METRICS
+} latency_metric_t;
+
+typedef struct
+{
+    uint64_t count;
+    uint64_t sum_ns;
+    uint64_t min_ns;
+    uint64_t max_ns;
+    uint64_t buckets[LATENCY_BUCKETS];
+} latency_histogram_t;
+
+typedef struct latency_thread latency_thread_t;
+struct latency_thread
+{
+    _Alignas(LATENCY_CACHE_LINE) latency_histogram_t histograms[LATENCY_NUM_METRICS];
+    latency_thread_t *next; // Registry of all recording threads
+    uint32_t index;         // Order of registration, 0 is usually the main thread
+};
+
+// CLOCK_MONOTONIC time, the clock of the scheduler deadlines
+uint64_t latency_now_ns(void);
+
+// Histograms of the calling thread, allocated and registered on the first call
+latency_thread_t *latency_thread(void);
+
+void latency_histogram_record(latency_histogram_t *const histogram, const uint64_t value_ns);
+
+// Smallest recorded value that at least the given share of all values is not above
+uint64_t latency_histogram_percentile(const latency_histogram_t *const histogram, const double percentile);
+
+// Records into the calling thread's histogram of the metric
+void latency_record(const latency_metric_t metric, const uint64_t value_ns);
+
+/*
+ * Prints every metric merged over all threads, and per thread when more than
+ * one recorded it. Other threads must not record meanwhile, e.g. call it
+ * between ticks while pool workers wait at the tick barrier.
+ */
+void latency_print(FILE *const stream);
+
+#endif // LATENCY_H
@@ -0,0 +1,96 @@
+#ifndef OPTIMIZER_H
+#define OPTIMIZER_H
+
+/*
+ * Timing plan optimization. Searches the yellow, red clearance, minimum and
+ * maximum green and passage times of both roads of one timing plan, within
+ * the ranges the config parser accepts, against the arrivals drawn from a
+ * demand profile. Yellow is not searched below the ITE kinematic change
+ * interval of the road's speed limit on a level approach,
+ * y = t + v / (2a + 2Gg) with t = 1 s, a = 10 ft/s^2 and G = 0, rounded up
+ * to OPTIMIZER_TIME_STEP. Red clearance needs the intersection width, which
+ * the config does not hold, so it is not searched below its configured
+ * value. Every candidate runs on a simulated controller, and the
+ * search keeps the Pareto front: the plans no other plan beats on average
+ * delay, maximum delay and clearance at once. Each round samples a batch,
+ * part uniformly over the legal ranges and part by perturbing plans of the
+ * front, and evaluates it in parallel on a thread pool.
+ */
+
+#include "config.h"
+#include "config_parse.h"
+#include "simulation.h"
+#include "thread_pool.h"
+
+#define OPTIMIZER_TIME_STEP 0.5f      // Resolution of yellow, red clearance and passage times in seconds
+#define OPTIMIZER_MAX_MIN_GREEN 30U   // Longest minimum green searched for an actuated road
+#define OPTIMIZER_DEFAULT_MAX_GREEN 90U
+#define OPTIMIZER_DEFAULT_BATCH 1024U
+#define OPTIMIZER_MAX_BATCH 65536U
+#define OPTIMIZER_PERCEPTION_S 1.0f     // ITE perception-reaction time
+#define OPTIMIZER_DECELERATION_FPS2 10.0f // ITE comfortable deceleration
+
+typedef struct
+{
+    phase_timing_t timing[MAX_ROADS]; // Indexed like config_t.roads
+    double avg_delay_s;
+    double max_delay_s;
+    float clearance_s;     // Shortest yellow and red clearance of the two roads, longer is safer
+    double green_share;    // Arrivals while their phase showed green
+    bool is_valid;         // Passed config_validate, e.g. fits the coordinated splits
+} optimizer_plan_t;
+
+typedef struct
+{
+    config_t config;   // Runs the optimized plan all week
+    uint8_t plan;      // Index into config.plans
+    const sim_script_t *script;
+    const sim_demand_t *demand; // Drives the queue model that measures average delay
+    uint64_t duration_ms;
+    uint32_t tick_ms;
+    uint8_t max_green; // Longest maximum green searched
+    uint64_t rng;
+    optimizer_plan_t current; // The plan as configured
+    float min_yellow_s[MAX_ROADS];        // Shortest yellow searched, from the speed limit
+    float min_red_clearance_s[MAX_ROADS]; // Shortest red clearance searched, as configured
+    optimizer_plan_t *batch;
+    uint32_t *tasks; // Indices into batch
+    size_t batch_size;
+    uint32_t rounds; // Rounds run, the first one samples uniformly only
+    optimizer_plan_t *front; // No plan of the front dominates another
+    size_t front_count;
+    size_t front_capacity;
+    uint64_t evaluated;
+    uint64_t rejected; // Failed validation
+} optimizer_t;
+
+/*
+ * Optimizes the timing plan with plan_id, the base plan for
+ * CONFIG_BASE_PLAN_ID, against the scripted arrivals. Evaluates the plan as
+ * configured, which starts the front. Average delay comes from the queue
+ * model fed by demand, maximum delay from the scripted arrivals.
+ */
+bool optimizer_init(
+    optimizer_t *const optimizer,
+    const config_t *const config,
+    const char *const plan_id,
+    const sim_script_t *const script,
+    const sim_demand_t *const demand,
+    const uint64_t duration_ms,
+    const uint32_t tick_ms,
+    const uint8_t max_green,
+    const size_t batch_size,
+    const uint64_t seed);
+
+// Simulates the timing of plan and fills in its objectives
+void optimizer_evaluate(const optimizer_t *const optimizer, optimizer_plan_t *const plan);
+
+// Samples a batch, evaluates it on the pool and merges it into the front
+bool optimizer_round(optimizer_t *const optimizer, thread_pool_t *const pool);
+
+// Orders the front by average delay, then maximum delay
+void optimizer_sort_front(optimizer_t *const optimizer);
+
+void optimizer_free(optimizer_t *const optimizer);
+
+#endif // OPTIMIZER_H
@@ -0,0 +1,94 @@
+#ifndef QUEUE_MODEL_H
+#define QUEUE_MODEL_H
+
+/*
+ * Deterministic queue model of the traffic behind the controllers. Each
+ * direction of an intersection is an approach: vehicles arrive at its
+ * current rate, queue while its phase does not serve, and discharge at the
+ * saturation flow of its lanes while it does. Delay is the time vehicles
+ * spend queued, start-up and deceleration losses are not modelled.
+ *
+ * The approaches of all intersections are kept in structure of arrays form,
+ * four consecutive approaches per intersection, so a tick updates all of
+ * them in one branch-free loop over contiguous doubles. The loop is built
+ * for AVX2, four approaches per instruction, and for the baseline ISA, and
+ * the CPU picks one at load time.
+ */
+
+#include "controller.h"
+#include <stdio.h>
+
+#define QUEUE_APPROACHES (MAX_ROADS * MAX_DIRECTIONS) // Per intersection
+#define QUEUE_ALIGN 32U                 // An AVX2 vector of four approaches
+#define QUEUE_SATURATION_VPHPL 1900.0   // Saturation flow per lane and hour of green
+#define QUEUE_FLASH_RED_SHARE 0.35      // Flashing red runs as a stop, at this share of saturation flow
+
+// Arrival rate of an approach from time_ms on
+typedef struct
+{
+    uint32_t time_ms;
+    uint32_t approach; // Index into the arrays of queue_model_t
+    double vehicles_per_hour;
+} queue_rate_t;
+
+typedef struct
+{
+    double arrived;  // Vehicles
+    double departed;
+    double delay_ms; // Vehicle ms spent queued
+    double queue;    // Vehicles queued now
+    double max_queue;
+} queue_totals_t;
+
+typedef struct
+{
+    size_t count;          // Intersections
+    size_t num_approaches; // count * QUEUE_APPROACHES
+
+    // Per approach, indexed by intersection * QUEUE_APPROACHES + road * MAX_DIRECTIONS + direction
+    double *arrival;    // Vehicles per ms
+    double *saturation; // Vehicles per ms of service, lanes times saturation flow
+    double *service;    // Share of saturation flow the signal lets through, 0 on yellow and red
+    double *queue;      // Vehicles
+    double *delay;      // Vehicle ms
+    double *arrived;
+    double *departed;
+    double *max_queue;
+    uint8_t *phase;     // phase_t serving the approach
+    uint8_t *direction; // direction_type_t
+
+    queue_rate_t *rates; // Scheduled rate changes, sorted by time
+    size_t num_rates;
+    size_t rates_capacity;
+    size_t next_rate;
+    uint64_t now_ms;
+} queue_model_t;
+
+// One approach per direction of the controllers' configs, every approach starts empty and without arrivals
+bool queue_model_init(queue_model_t *const model, const controller_t *const controllers, const size_t count);
+
+// Sets the arrival rate of a direction of an intersection from now on
+bool queue_model_set_rate(queue_model_t *const model, const size_t index, const direction_type_t direction, const double vehicles_per_hour);
+
+// Schedules the arrival rate of the approach served by phase, in time order
+bool queue_model_add_rate(
+    queue_model_t *const model,
+    const size_t index,
+    const phase_t phase,
+    const uint32_t time_ms,
+    const double vehicles_per_hour);
+
+// Reads the signals of an intersection, call when its interval changes
+void queue_model_signals(queue_model_t *const model, const size_t index, const controller_t *const controller);
+
+// Advances every approach of every intersection by elapsed_ms
+void queue_model_step(queue_model_t *const model, const uint32_t elapsed_ms);
+
+// Sums the approaches of an intersection, max_queue is the longest queue of a single approach
+void queue_model_totals(const queue_model_t *const model, const size_t index, queue_totals_t *const totals);
+
+void queue_model_print(const queue_model_t *const model, const size_t index, FILE *const stream);
+
+void queue_model_free(queue_model_t *const model);
+
+#endif // QUEUE_MODEL_H
@@ -0,0 +1,54 @@
+#ifndef REPLAY_H
+#define REPLAY_H
+
+/*
+ * Replays the calls and detector actuations of a recorded event log
+ * against candidate configs on a virtual clock, e.g. to evaluate a timing
+ * change on yesterday's traffic. The log stays memory-mapped and read-only,
+ * and every candidate runs on its own pool thread with its own controller,
+ * so candidates share nothing but the mapping. The signals the log recorded
+ * are measured the same way, for comparison.
+ */
+
+#include "controller.h"
+#include "event_log.h"
+#include "simulation.h"
+#include "thread_pool.h"
+
+typedef struct
+{
+    _Alignas(CONTROLLER_CACHE_LINE) controller_t controller;
+    config_t config;
+    const char *path;          // Candidate config
+    uint16_t intersection;     // Index of the replayed intersection in the log
+    sim_stats_t stats;         // Candidate run
+    sim_stats_t recorded;      // Recorded signals of the same arrivals
+    uint64_t wall_ns;
+    bool is_done;
+} replay_candidate_t;
+
+typedef struct
+{
+    event_log_view_t view;
+    uint64_t duration_ms;   // Time of the last record
+    uint32_t start_week_ms; // Local time of the week at log time 0
+    replay_candidate_t *candidates;
+    size_t count;
+    thread_pool_t pool;
+} replay_t;
+
+// Maps the log and loads nothing else yet
+bool replay_open(replay_t *const replay, const char *const log_path);
+
+/*
+ * Replays the intersection with the ID of each config, or the only one in
+ * the log, against every config. Up to num_threads candidates run at once.
+ */
+bool replay_run(replay_t *const replay, char *const config_paths[], const size_t count, const size_t num_threads);
+
+// Prints each candidate next to the recorded signals, delay relative to them
+void replay_print(const replay_t *const replay);
+
+void replay_close(replay_t *const replay);
+
+#endif // REPLAY_H
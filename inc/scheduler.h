@@ -0,0 +1,62 @@
+#ifndef SCHEDULER_H
+#define SCHEDULER_H
+
+/*
+ * Periodic tick scheduler driven by absolute CLOCK_MONOTONIC deadlines. The
+ * tick thread sleeps until the next deadline instead of spinning, and the
+ * periods lost to an overrun are caught up on the next wake-up, so phase
+ * timing does not drift. A virtual clock reaches its deadlines without
+ * waiting, for simulation.
+ */
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#define SCHEDULER_DEFAULT_TICK_MS 100U // Default controller tick resolution
+#define SCHEDULER_MIN_TICK_MS 1U
+#define SCHEDULER_MAX_TICK_MS 1000U
+
+typedef struct
+{
+    uint64_t ticks;           // Deadlines reached
+    uint64_t overruns;        // Wake-ups later than one full period
+    uint64_t missed_ticks;    // Periods skipped because of overruns
+    uint64_t max_jitter_ns;   // Worst wake-up lateness
+    uint64_t total_jitter_ns; // Sum of wake-up lateness
+} scheduler_stats_t;
+
+typedef struct
+{
+    uint32_t period_ms;
+    uint64_t period_ns;
+    uint64_t deadline_ns; // Next absolute deadline
+    uint64_t woken_ns;    // Deadline the last wait returned for, CLOCK_MONOTONIC
+    uint64_t jitter_ns;   // Lateness of the last wake-up
+    uint64_t start_ns;
+    uint64_t virtual_ns; // Current time of the virtual clock
+    bool is_virtual;     // Deadlines are reached without waiting, for simulation
+    scheduler_stats_t stats;
+} scheduler_t;
+
+bool scheduler_init(scheduler_t *const sched, const uint32_t period_ms);
+bool scheduler_init_virtual(scheduler_t *const sched, const uint32_t period_ms);
+
+/*
+ * Sleeps until the next deadline. Returns the number of periods elapsed
+ * since the previous deadline (more than one after an overrun), or 0 if
+ * the sleep was interrupted by a signal before the deadline was reached.
+ */
+uint32_t scheduler_wait(scheduler_t *const sched);
+
+// Time since init on the scheduler's clock
+uint64_t scheduler_now_ms(const scheduler_t *const sched);
+
+// Local wall clock time since Monday 00:00, for the time-of-day plan schedule
+uint32_t scheduler_week_ms(void);
+
+// Local time since Monday 00:00 of a Unix time in ms, e.g. the start of a recorded event log
+uint32_t scheduler_week_ms_at(const uint64_t unix_ms);
+
+void scheduler_print_stats(const scheduler_t *const sched);
+
+#endif // SCHEDULER_H
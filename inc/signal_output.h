@@ -0,0 +1,91 @@
+#ifndef SIGNAL_OUTPUT_H
+#define SIGNAL_OUTPUT_H
+
+/*
+ * Signal head output. Every used phase of an intersection drives one head.
+ * After each tick the main and side road states of the stepped controllers
+ * are compared with the states last shown, and only the heads that changed
+ * are emitted to the driver, which batches them into a single write per
+ * tick. A tick without changes makes no system call.
+ *
+ * Drivers are a table of open, emit, flush and close functions. Flashing
+ * lamps are blinked by the cabinet flasher, not per tick, and a FIFO without
+ * a reader drops changes instead of stalling the tick thread.
+ */
+
+#include "controller.h"
+#include <stddef.h>
+
+#define SIGNAL_OUTPUT_GPIO_PREFIX "gpio:"
+#define SIGNAL_OUTPUT_BUFFER_LEN 65536U // Bytes batched by the file driver
+#define SIGNAL_LAMPS 3U                 // Red, yellow and green lamp per head
+
+typedef struct
+{
+    uint64_t time_ms;      // Time of the tick that changed the head
+    uint32_t intersection; // Index into the controllers
+    uint32_t head;         // Index among the heads of all intersections
+    phase_t phase;
+    signal_state_t state;
+} signal_change_t;
+
+// Heads of one intersection, wired at start
+typedef struct
+{
+    uint32_t first_head;
+    uint8_t phase_mask; // One head per phase
+    uint8_t main_shown; // signal_state_t last emitted for the main road heads
+    uint8_t side_shown;
+} signal_heads_t;
+
+typedef struct signal_output signal_output_t;
+struct signal_output
+{
+    bool (*open)(signal_output_t *const output);
+    void (*emit)(signal_output_t *const output, const signal_change_t *const change); // Adds to the batch
+    bool (*flush)(signal_output_t *const output); // Writes the batch at once
+    void (*close)(signal_output_t *const output);
+
+    const char *path; // Output file, FIFO or GPIO character device
+    int fd;
+    const controller_t *controllers;
+    signal_heads_t *heads; // Same index as controllers
+    size_t count;
+    uint32_t num_heads;
+    size_t pending; // Changes emitted since the last flush
+
+    // File driver batch
+    char *buffer;
+    size_t buffer_len;
+
+    // GPIO driver batch, one bit per line, lines are numbered head * SIGNAL_LAMPS + lamp
+    uint64_t line_bits;
+    uint64_t line_mask;
+
+    uint64_t changes; // Heads changed
+    uint64_t writes;  // System calls made by flush
+    uint64_t dropped; // Changes lost to failed writes
+};
+
+/*
+ * Wires one head per used phase of each controller and opens the driver
+ * selected by spec: "gpio:/dev/gpiochipN" drives the lamps of consecutive
+ * lines of a GPIO chip, anything else is a file or FIFO that receives a
+ * "<time_ms> <intersection> <phase> <state>" line per change. The current
+ * state of every head is written first.
+ */
+bool signal_output_start(
+    signal_output_t *const output,
+    const char *const spec,
+    const controller_t *const controllers,
+    const size_t count);
+
+// Emits the heads of a controller whose state changed, call after stepping it
+void signal_output_update(signal_output_t *const output, const size_t index, const uint64_t time_ms);
+
+// Writes the changes emitted since the previous flush
+void signal_output_flush(signal_output_t *const output);
+
+void signal_output_stop(signal_output_t *const output);
+
+#endif // SIGNAL_OUTPUT_H
@@ -0,0 +1,164 @@
+#ifndef SIMULATION_H
+#define SIMULATION_H
+
+/*
+ * Faster than real time simulation of a controller on a virtual clock,
+ * starting on Monday 00:00 of the plan schedule. Detector input comes from
+ * a call script or from arrivals drawn from a demand profile, which also
+ * feeds a queue model behind the signals.
+ */
+
+#include "atspm.h"
+#include "controller.h"
+#include "event_log.h"
+#include "queue_model.h"
+#include "scheduler.h"
+#include "signal_output.h"
+#include <stddef.h>
+
+#define SIM_DEFAULT_DURATION_S 86400U // 24 hours
+#define SIM_VEHICLE_OCCUPANCY_MS 500U // A car crossing a 6 ft loop at 30 mph
+#define SIM_DISCHARGE_HEADWAY_MS 2000U // A queued car leaving the stop bar, 1800 vehicles per hour of green
+#define SIM_MAX_DEMAND_VPH 10000.0    // Arrival rate limit per phase
+#define SIM_DEMAND_SEED 1U            // Arrivals drawn for a simulation from a demand profile
+
+typedef enum
+{
+    SIM_CALL,         // Latched call, e.g. a scripted service request
+    SIM_DETECTOR_ON,  // Detector actuation, subject to detector memory
+    SIM_DETECTOR_OFF
+} sim_call_kind_t;
+
+typedef struct
+{
+    uint32_t time_ms; // Offset from the start of the simulation
+    phase_t phase;
+    sim_call_kind_t kind;
+} sim_call_t;
+
+// Scripted detector calls, sorted by time
+typedef struct
+{
+    sim_call_t *calls;
+    size_t count;
+} sim_script_t;
+
+// Arrival rate of a phase from time_ms on, until the next entry of the phase
+typedef struct
+{
+    uint32_t time_ms;
+    phase_t phase;
+    double vehicles_per_hour;
+} sim_demand_entry_t;
+
+// Demand profile, sorted by time
+typedef struct
+{
+    sim_demand_entry_t *entries;
+    size_t count;
+} sim_demand_t;
+
+// Where a simulation writes its signals and events, NULL members are skipped
+typedef struct
+{
+    signal_output_t *output;
+    event_log_t *log;
+    atspm_t *atspm; // Reads log, so it needs one
+    queue_model_t *queues; // Intersection 0 follows the simulated signals
+} sim_sinks_t;
+
+typedef struct
+{
+    uint64_t steps;        // Controller steps
+    uint64_t transitions;  // Interval changes
+    uint64_t cycles;       // Main road green starts
+    uint64_t side_serves;  // Side road green starts
+    uint64_t gap_outs;     // Actuated greens ended by a gap
+    uint64_t max_outs;     // Actuated greens ended by the max timer
+    uint64_t force_offs;   // Greens ended by the coordinated cycle
+    uint64_t calls_placed; // Scripted calls fed to the controller
+    uint64_t plan_changes; // Timing plans switched to by the schedule
+    uint64_t main_green_ms;
+    uint64_t side_green_ms;
+    uint64_t flash_ms;
+    uint64_t arrivals;       // Calls and detector actuations of used phases
+    uint64_t arrivals_green; // Arrivals while their phase showed green
+    uint64_t delay_ms;       // Wait of all arrivals until their phase turned green
+    uint64_t max_delay_ms;
+} sim_stats_t;
+
+/*
+ * Signal delay of arrivals, the time from a call or actuation until its
+ * phase lets traffic proceed: green, or any flashing state. Arrivals
+ * waiting for the same phase are released together, so a phase keeps only
+ * their count, the sum of their arrival times and the oldest one.
+ */
+typedef struct
+{
+    uint8_t phase_mask;   // Phases whose arrivals are counted
+    uint8_t green_mask;   // Phases showing green
+    uint8_t serving_mask; // Phases letting traffic proceed
+    uint32_t waiting[NUM_PHASES];
+    uint64_t waiting_sum_ms[NUM_PHASES];
+    uint64_t oldest_ms[NUM_PHASES];
+} sim_delay_t;
+
+/*
+ * Script format, one entry per line: "<time_s> <phase> [on|off]". Without
+ * a detector state the entry places a latched call, e.g. "12.5 4", with
+ * one it is a detector actuation, e.g. "12.5 4 on". Blank lines and lines
+ * starting with '#' are ignored.
+ */
+bool sim_script_load(sim_script_t *const script, const char *const filename);
+void sim_script_free(sim_script_t *const script);
+
+/*
+ * Demand format, one entry per line: "<time_s> <phase> <vehicles_per_hour>",
+ * e.g. "3600 4 120" sends 120 vehicles per hour to phase 4 from the second
+ * hour on. A phase has no arrivals before its first entry. Blank lines and
+ * lines starting with '#' are ignored.
+ */
+bool sim_demand_load(sim_demand_t *const demand, const char *const filename);
+void sim_demand_free(sim_demand_t *const demand);
+
+/*
+ * Draws the Poisson arrivals of a demand profile over duration_ms as
+ * detector actuations, each vehicle occupying its detector for
+ * SIM_VEHICLE_OCCUPANCY_MS. A vehicle arriving on red stops on the
+ * detector instead, sim_run holds it occupied until the phase turns green
+ * and its queue discharged. The same seed draws the same arrivals, so
+ * candidate timings can be compared on identical traffic.
+ */
+bool sim_script_generate(
+    sim_script_t *const script,
+    const sim_demand_t *const demand,
+    const uint64_t duration_ms,
+    const uint64_t seed);
+
+// Schedules the rates of a demand profile as the arrivals of an intersection of a queue model
+bool sim_demand_schedule(const sim_demand_t *const demand, queue_model_t *const queues, const size_t index);
+
+// Runs the script against the controller for duration_ms, sinks may be NULL to write nothing
+void sim_run(
+    controller_t *const controller,
+    scheduler_t *const sched,
+    const sim_script_t *const script,
+    const uint64_t duration_ms,
+    const sim_sinks_t *const sinks,
+    sim_stats_t *const stats);
+
+// Every phase starts dark, report the initial signals with sim_delay_signal
+void sim_delay_init(sim_delay_t *const delay, const uint8_t phase_mask);
+void sim_delay_arrival(sim_delay_t *const delay, sim_stats_t *const stats, const phase_t phase, const uint64_t time_ms);
+void sim_delay_signal(
+    sim_delay_t *const delay,
+    sim_stats_t *const stats,
+    const phase_t phase,
+    const signal_state_t state,
+    const uint64_t time_ms);
+// Counts the arrivals still waiting as delayed until time_ms
+void sim_delay_finish(sim_delay_t *const delay, sim_stats_t *const stats, const uint64_t time_ms);
+
+void sim_print_stats(const sim_stats_t *const stats, const uint64_t duration_ms);
+
+#endif // SIMULATION_H
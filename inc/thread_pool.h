@@ -0,0 +1,70 @@
+#ifndef THREAD_POOL_H
+#define THREAD_POOL_H
+
+/*
+ * Work-stealing thread pool for running a batch of independent tasks. Each
+ * thread starts on a contiguous chunk of the batch and steals from the
+ * others when it runs out, so threads only synchronize at the start and the
+ * end of a batch, e.g. at tick boundaries.
+ */
+
+#include <pthread.h>
+#include <stdatomic.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#define POOL_MAX_THREADS 256U
+#define POOL_CACHE_LINE 64U
+
+typedef void (*pool_task_fn)(void *const ctx, const uint32_t task);
+
+typedef struct thread_pool thread_pool_t;
+
+// Chase-Lev deque: the owner pops from the bottom, thieves steal from the top
+typedef struct
+{
+    _Alignas(POOL_CACHE_LINE) atomic_long top;
+    _Alignas(POOL_CACHE_LINE) atomic_long bottom;
+    uint32_t *tasks; // Ring of task ids, power of two capacity
+    uint32_t mask;
+    thread_pool_t *pool; // Owning pool, passed to the worker thread
+    uint32_t index;      // Worker index within the pool
+    uint64_t executed; // Tasks run by the owning thread, stats only
+    uint64_t stolen;   // Tasks taken from other deques, stats only
+} pool_deque_t;
+
+struct thread_pool
+{
+    size_t num_threads; // Including the thread calling thread_pool_run
+    pthread_t *threads;
+    pool_deque_t *deques; // One per thread, index 0 belongs to the caller
+    pthread_barrier_t start;
+    pthread_barrier_t done;
+    pthread_mutex_t launch_lock;
+    pthread_cond_t launched; // Workers wait here until every one of them started
+    pool_task_fn fn;
+    void *ctx;
+    bool is_launched;
+    bool is_stopping;
+};
+
+bool thread_pool_init(thread_pool_t *const pool, const size_t num_threads, const size_t max_tasks);
+
+// Turns a requested thread count, 0 for every online CPU, into one thread_pool_init accepts
+size_t thread_pool_resolve_threads(const size_t num_threads);
+
+/*
+ * Runs fn(ctx, task) for every task id and returns once all of them are
+ * done. The calling thread participates as worker 0.
+ */
+void thread_pool_run(
+    thread_pool_t *const pool,
+    const uint32_t *const tasks,
+    const size_t count,
+    pool_task_fn fn,
+    void *const ctx);
+
+void thread_pool_free(thread_pool_t *const pool);
+
+#endif // THREAD_POOL_H
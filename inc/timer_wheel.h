@@ -0,0 +1,41 @@
+#ifndef TIMER_WHEEL_H
+#define TIMER_WHEEL_H
+
+/* Hierarchical timer wheel with tick granularity */
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#define WHEEL_SLOT_BITS 6U
+#define WHEEL_SLOTS (1U << WHEEL_SLOT_BITS)
+#define WHEEL_SLOT_MASK (WHEEL_SLOTS - 1U)
+#define WHEEL_LEVELS 4U // Covers 2^24 ticks, ~19 days at 100 ms
+
+typedef struct wheel_timer wheel_timer_t;
+struct wheel_timer
+{
+    wheel_timer_t *next;
+    wheel_timer_t **pprev; // Link pointing at this timer, for O(1) removal
+    uint64_t expires;      // Absolute tick
+    uint32_t owner;        // Index of the object the timer belongs to
+    bool is_armed;
+};
+
+typedef struct
+{
+    uint64_t now; // Current tick
+    wheel_timer_t *slots[WHEEL_LEVELS][WHEEL_SLOTS];
+} timer_wheel_t;
+
+void timer_wheel_init(timer_wheel_t *const wheel, const uint64_t now);
+void timer_wheel_add(timer_wheel_t *const wheel, wheel_timer_t *const timer, const uint64_t expires);
+void timer_wheel_remove(timer_wheel_t *const wheel, wheel_timer_t *const timer);
+
+/*
+ * Advances the wheel by one tick and returns the list of expired timers,
+ * linked through their next pointers. Expired timers are disarmed.
+ */
+wheel_timer_t *timer_wheel_advance(timer_wheel_t *const wheel);
+
+#endif // TIMER_WHEEL_H
@@ -0,0 +1,425 @@
+#include "atspm.h"
+#include "config_parse.h"
+#include <stdlib.h>
+#include <string.h>
+
+#define ATSPM_NO_LANE (-1)
+#define MS_PER_SEC 1000.0
+
+static const char *const direction_names[] = {
+    [DIRECTION_NB] = DIR_TYPE_NB,
+    [DIRECTION_SB] = DIR_TYPE_SB,
+    [DIRECTION_EB] = DIR_TYPE_EB,
+    [DIRECTION_WB] = DIR_TYPE_WB};
+
+static atspm_bin_t *current_bin(const atspm_t *const atspm, const atspm_lane_t *const lane)
+{
+    return &lane->bins[atspm->bin % atspm->num_bins];
+}
+
+static uint64_t occupancy_at(const atspm_lane_t *const lane, const uint64_t time_ms)
+{
+    return lane->occupancy_ms + (lane->is_occupied ? time_ms - lane->occupied_since_ms : 0);
+}
+
+// Adds green and occupied time since the last accrual to the current bin
+static void accrue(const atspm_t *const atspm, atspm_lane_t *const lane, const uint64_t time_ms)
+{
+    atspm_bin_t *bin = current_bin(atspm, lane);
+    uint32_t elapsed_ms = (uint32_t)(time_ms - lane->accrued_ms);
+
+    bin->green_ms += lane->state == SIGNAL_GREEN ? elapsed_ms : 0;
+    bin->occupied_ms += lane->is_occupied ? elapsed_ms : 0;
+    lane->accrued_ms = time_ms;
+}
+
+/*
+ * Ends the red occupancy window once it is ATSPM_ROR_WINDOW_MS long, or
+ * early when the phase turns green again. Both occupancy ratios at or above
+ * the threshold count the green before it as a split failure.
+ */
+static void close_ror(const atspm_t *const atspm, atspm_lane_t *const lane, const uint64_t time_ms, const bool is_early)
+{
+    uint64_t end_ms = lane->ror_start_ms + ATSPM_ROR_WINDOW_MS;
+
+    if (!lane->is_ror_open || (time_ms < end_ms && !is_early))
+    {
+        return;
+    }
+
+    end_ms = time_ms < end_ms ? time_ms : end_ms;
+    lane->is_ror_open = false;
+
+    if (end_ms > lane->ror_start_ms &&
+        (double)(occupancy_at(lane, end_ms) - lane->ror_occupancy_ms) >=
+            ATSPM_SPLIT_FAILURE_OCCUPANCY * (double)(end_ms - lane->ror_start_ms))
+    {
+        current_bin(atspm, lane)->split_failures++;
+    }
+}
+
+// Moves every lane group into the bin of time_ms, clearing the slots it reuses
+static void roll(atspm_t *const atspm, const uint64_t time_ms)
+{
+    uint64_t bin = (atspm->origin_ms + time_ms) / ATSPM_BIN_MS;
+
+    while (atspm->bin < bin)
+    {
+        uint64_t boundary_ms = (atspm->bin + 1U) * ATSPM_BIN_MS - atspm->origin_ms;
+
+        for (size_t i = 0; i < atspm->num_lanes; i++)
+        {
+            close_ror(atspm, &atspm->lanes[i], boundary_ms, false);
+            accrue(atspm, &atspm->lanes[i], boundary_ms);
+        }
+
+        atspm->bin++;
+
+        for (size_t i = 0; i < atspm->num_lanes; i++)
+        {
+            memset(current_bin(atspm, &atspm->lanes[i]), 0, sizeof(atspm_bin_t));
+        }
+    }
+}
+
+static void arrival(const atspm_t *const atspm, atspm_lane_t *const lane, const uint64_t time_ms)
+{
+    atspm_bin_t *bin = current_bin(atspm, lane);
+
+    bin->volume++;
+    bin->arrivals_green += lane->state == SIGNAL_GREEN;
+    bin->arrivals_yellow += lane->state == SIGNAL_YELLOW || lane->state == SIGNAL_FLASH_YELLOW;
+    bin->arrivals_red += lane->state != SIGNAL_GREEN && lane->state != SIGNAL_YELLOW &&
+                         lane->state != SIGNAL_FLASH_YELLOW;
+
+    if (lane->has_cycle)
+    {
+        uint64_t pcd_bin = (time_ms - lane->red_start_ms) / ATSPM_PCD_BIN_MS;
+        bin->pcd[pcd_bin < ATSPM_PCD_BINS ? pcd_bin : ATSPM_PCD_BINS - 1U]++;
+    }
+}
+
+static void signal_change(const atspm_t *const atspm, atspm_lane_t *const lane, const event_record_t *const record)
+{
+    signal_state_t state = (signal_state_t)record->state;
+    uint64_t time_ms = record->time_ms;
+
+    if (state == lane->state)
+    {
+        return;
+    }
+
+    if (state == SIGNAL_GREEN)
+    {
+        close_ror(atspm, lane, time_ms, true);
+        current_bin(atspm, lane)->cycles++;
+        lane->green_start_ms = time_ms;
+        lane->green_occupancy_ms = occupancy_at(lane, time_ms);
+    }
+    else if (lane->state == SIGNAL_GREEN)
+    {
+        atspm_bin_t *bin = current_bin(atspm, lane);
+        bin->terminations[record->cause <= TERMINATION_FORCE_OFF ? record->cause : TERMINATION_NONE]++;
+
+        lane->is_green_occupied =
+            !lane->is_pulse && time_ms > lane->green_start_ms &&
+            (double)(occupancy_at(lane, time_ms) - lane->green_occupancy_ms) >=
+                ATSPM_SPLIT_FAILURE_OCCUPANCY * (double)(time_ms - lane->green_start_ms);
+    }
+
+    // Red after the clearance starts the phase's cycle and the red occupancy window
+    if (state == SIGNAL_RED)
+    {
+        lane->red_start_ms = time_ms;
+        lane->has_cycle = true;
+
+        if (lane->is_green_occupied)
+        {
+            lane->is_green_occupied = false;
+            lane->is_ror_open = true;
+            lane->ror_start_ms = time_ms;
+            lane->ror_occupancy_ms = occupancy_at(lane, time_ms);
+        }
+    }
+    else if (state != SIGNAL_YELLOW)
+    {
+        lane->is_green_occupied = false;
+    }
+
+    lane->state = (uint8_t)state;
+}
+
+static void add_lanes(atspm_t *const atspm, const size_t index)
+{
+    const config_t *config = atspm->controllers[index].config;
+    const road_t *main_road = config->main_road != NULL ? config->main_road : &config->roads[0];
+
+    for (size_t road = 0; road < MAX_ROADS; road++)
+    {
+        const phase_t *phases = direction_phases[&config->roads[road] == main_road ? ROAD_MAIN : ROAD_SIDE];
+
+        for (size_t dir = 0; dir < MAX_DIRECTIONS; dir++)
+        {
+            const lane_group_t *lanes = &config->roads[road].directions[dir].straight;
+            atspm_lane_t *lane = &atspm->lanes[atspm->num_lanes];
+
+            lane->bins = &atspm->bins[atspm->num_lanes * atspm->num_bins];
+            lane->intersection = (uint16_t)index;
+            lane->phase = (uint8_t)phases[dir];
+            lane->state = SIGNAL_OFF;
+            lane->num_lanes = lanes->count;
+            lane->direction = (uint8_t)config->roads[road].directions[dir].type;
+            lane->is_pulse = lanes->has_detector && lanes->detector.mode == DETECTOR_MODE_PULSE;
+            atspm->lane_of[index * NUM_PHASES + phases[dir]] = (int32_t)atspm->num_lanes;
+            atspm->num_lanes++;
+        }
+    }
+}
+
+/*Interface Functions*/
+
+bool atspm_init(
+    atspm_t *const atspm,
+    const controller_t *const controllers,
+    const size_t count,
+    const uint32_t num_bins,
+    const uint64_t origin_ms)
+{
+    bool result = false;
+
+    do
+    {
+        if (atspm == NULL || controllers == NULL || count == 0 || count > UINT16_MAX + 1U || num_bins == 0)
+        {
+            fprintf(stderr, "Assertion error in atspm_init\n");
+            break;
+        }
+
+        memset(atspm, 0, sizeof(*atspm));
+        size_t max_lanes = count * MAX_ROADS * MAX_DIRECTIONS;
+
+        atspm->lanes = calloc(max_lanes, sizeof(atspm_lane_t));
+        atspm->lane_of = malloc(count * NUM_PHASES * sizeof(int32_t));
+        atspm->bins = calloc(max_lanes * num_bins, sizeof(atspm_bin_t));
+
+        if (atspm->lanes == NULL || atspm->lane_of == NULL || atspm->bins == NULL)
+        {
+            fprintf(stderr, "Out of memory while creating ATSPM bins\n");
+            break;
+        }
+
+        for (size_t i = 0; i < count * NUM_PHASES; i++)
+        {
+            atspm->lane_of[i] = ATSPM_NO_LANE;
+        }
+
+        atspm->controllers = controllers;
+        atspm->count = count;
+        atspm->num_bins = num_bins;
+        atspm->origin_ms = origin_ms;
+        atspm->bin = origin_ms / ATSPM_BIN_MS;
+        atspm->first_bin = atspm->bin;
+
+        for (size_t i = 0; i < count; i++)
+        {
+            add_lanes(atspm, i);
+        }
+
+        result = true;
+
+    } while (0);
+
+    if (!result && atspm != NULL)
+    {
+        atspm_free(atspm);
+    }
+
+    return result;
+}
+
+void atspm_ingest(atspm_t *const atspm, const event_record_t *const record)
+{
+    roll(atspm, record->time_ms);
+
+    if (record->intersection >= atspm->count || record->phase >= NUM_PHASES)
+    {
+        return;
+    }
+
+    int32_t index = atspm->lane_of[record->intersection * NUM_PHASES + record->phase];
+
+    if (index == ATSPM_NO_LANE)
+    {
+        return;
+    }
+
+    atspm_lane_t *lane = &atspm->lanes[index];
+    uint64_t time_ms = record->time_ms;
+
+    // A record behind the accrued time would wrap the elapsed time, it still counts as an event
+    if (time_ms >= lane->accrued_ms)
+    {
+        close_ror(atspm, lane, time_ms, false);
+        accrue(atspm, lane, time_ms);
+    }
+
+    switch (record->kind)
+    {
+    case EVENT_SIGNAL:
+        signal_change(atspm, lane, record);
+        break;
+    case EVENT_DETECTOR_ON:
+        if (!lane->is_pulse && !lane->is_occupied)
+        {
+            lane->is_occupied = true;
+            lane->occupied_since_ms = time_ms;
+        }
+        arrival(atspm, lane, time_ms);
+        break;
+    case EVENT_DETECTOR_OFF:
+        if (lane->is_occupied)
+        {
+            lane->occupancy_ms += time_ms - lane->occupied_since_ms;
+            lane->is_occupied = false;
+        }
+        break;
+    case EVENT_CALL:
+        arrival(atspm, lane, time_ms);
+        break;
+    default:
+        break;
+    }
+}
+
+void atspm_consume(atspm_t *const atspm, const event_log_t *const log)
+{
+    if (atspm->num_lanes == 0 || log->header == NULL)
+    {
+        return;
+    }
+
+    // Records the ring overwrote before this call cannot be aggregated any more
+    if (log->head - atspm->cursor > log->mask + 1U)
+    {
+        atspm->lost += log->head - atspm->cursor - (log->mask + 1U);
+        atspm->cursor = log->head - (log->mask + 1U);
+    }
+
+    for (; atspm->cursor < log->head; atspm->cursor++)
+    {
+        atspm_ingest(atspm, &log->records[atspm->cursor & log->mask]);
+    }
+}
+
+void atspm_advance(atspm_t *const atspm, const uint64_t time_ms)
+{
+    roll(atspm, time_ms);
+
+    for (size_t i = 0; i < atspm->num_lanes; i++)
+    {
+        if (time_ms >= atspm->lanes[i].accrued_ms)
+        {
+            close_ror(atspm, &atspm->lanes[i], time_ms, false);
+            accrue(atspm, &atspm->lanes[i], time_ms);
+        }
+    }
+}
+
+size_t atspm_snapshot(
+    atspm_t *const atspm,
+    const uint64_t time_ms,
+    const size_t lane,
+    atspm_bin_t *const bins,
+    const size_t max_bins,
+    uint64_t *const first_bin_ms)
+{
+    if (lane >= atspm->num_lanes)
+    {
+        return 0;
+    }
+
+    atspm_advance(atspm, time_ms);
+
+    uint64_t kept = atspm->bin - atspm->first_bin + 1U;
+    kept = kept < atspm->num_bins ? kept : atspm->num_bins;
+    kept = kept < max_bins ? kept : max_bins;
+
+    uint64_t first = atspm->bin + 1U - kept;
+
+    for (uint64_t i = 0; i < kept; i++)
+    {
+        bins[i] = atspm->lanes[lane].bins[(first + i) % atspm->num_bins];
+    }
+
+    *first_bin_ms = first * ATSPM_BIN_MS;
+
+    return (size_t)kept;
+}
+
+void atspm_write_csv(atspm_t *const atspm, const uint64_t time_ms, FILE *const stream)
+{
+    atspm_bin_t *bins = malloc(atspm->num_bins * sizeof(atspm_bin_t));
+
+    if (bins == NULL)
+    {
+        fprintf(stderr, "Out of memory while writing ATSPM bins\n");
+        return;
+    }
+
+    fprintf(stream,
+            "bin_start_ms,intersection,phase,direction,lanes,volume,arrivals_on_green,"
+            "arrivals_on_yellow,arrivals_on_red,aog_pct,cycles,split_failures,gap_outs,"
+            "max_outs,force_offs,green_s,occupancy_pct,pcd\n");
+
+    for (size_t i = 0; i < atspm->num_lanes; i++)
+    {
+        const atspm_lane_t *lane = &atspm->lanes[i];
+        uint64_t first_bin_ms;
+        size_t count = atspm_snapshot(atspm, time_ms, i, bins, atspm->num_bins, &first_bin_ms);
+
+        for (size_t j = 0; j < count; j++)
+        {
+            const atspm_bin_t *bin = &bins[j];
+
+            fprintf(stream,
+                    "%llu,%s,%u,%s,%u,%u,%u,%u,%u,%.1f,%u,%u,%u,%u,%u,%.1f,%.1f,",
+                    (unsigned long long)(first_bin_ms + j * ATSPM_BIN_MS),
+                    atspm->controllers[lane->intersection].config->id,
+                    lane->phase + 1U,
+                    lane->direction < sizeof(direction_names) / sizeof(direction_names[0])
+                        ? direction_names[lane->direction]
+                        : "",
+                    lane->num_lanes,
+                    bin->volume,
+                    bin->arrivals_green,
+                    bin->arrivals_yellow,
+                    bin->arrivals_red,
+                    bin->volume > 0 ? 100.0 * bin->arrivals_green / bin->volume : 0.0,
+                    bin->cycles,
+                    bin->split_failures,
+                    bin->terminations[TERMINATION_GAP_OUT],
+                    bin->terminations[TERMINATION_MAX_OUT],
+                    bin->terminations[TERMINATION_FORCE_OFF],
+                    bin->green_ms / MS_PER_SEC,
+                    100.0 * bin->occupied_ms / ATSPM_BIN_MS);
+
+            // Coordination diagram arrivals, one count per ATSPM_PCD_BIN_MS
+            for (size_t k = 0; k < ATSPM_PCD_BINS; k++)
+            {
+                fprintf(stream, "%s%u", k > 0 ? " " : "", bin->pcd[k]);
+            }
+
+            fprintf(stream, "\n");
+        }
+    }
+
+    free(bins);
+}
+
+void atspm_free(atspm_t *const atspm)
+{
+    free(atspm->lanes);
+    free(atspm->lane_of);
+    free(atspm->bins);
+    memset(atspm, 0, sizeof(*atspm));
+}
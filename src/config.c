@@ -1,43 +1,21 @@
 #include "config.h"
-#include <json-c/json.h>
+#include "config_parse.h"
 #include <stdio.h>
+#include <stdarg.h>
+#include <math.h>
 #include <string.h>
 #include <ctype.h>
 
-#define MAX(a, b) ((a) > (b) ? (a) : (b))
-#define STRLEN(s) (sizeof(s) - 1U)
-
-#define DET_TYPE_LOOP "LOOP"
-#define DET_TYPE_VIDEO "VIDEO"
-#define DET_TYPE_RADAR "RADAR"
-#define MAX_DET_TYPE_STR_LEN MAX(                       \
-    MAX(STRLEN(DET_TYPE_LOOP), STRLEN(DET_TYPE_VIDEO)), \
-    STRLEN(DET_TYPE_RADAR))
-
-#define DIR_TYPE_NB "NB"
-#define DIR_TYPE_SB "SB"
-#define DIR_TYPE_EB "EB"
-#define DIR_TYPE_WB "WB"
-#define MAX_DIR_TYPE_STR_LEN MAX(                  \
-    MAX(STRLEN(DIR_TYPE_NB), STRLEN(DIR_TYPE_SB)), \
-    MAX(STRLEN(DIR_TYPE_EB), STRLEN(DIR_TYPE_WB)))
-
-#define MAX_LANES 3U                // Maximum lanes per direction
-#define MIN_DETECTOR_DISTANCE 80U   // Minimum distance for setback detectors
-#define MAX_DETECTOR_DISTANCE 485U  // Maximum distance for setback detectors
-#define MIN_CROSSING_DISTANCE 12U   // Minimum distance for pedestrian crossings
-#define MAX_CROSSING_DISTANCE 120U  // Maximum distance for pedestrian crossings
-#define MIN_SPEED_LIMIT 20U         // Minimum speed limit mph
-#define MAX_SPEED_LIMIT 60U         // Maximum speed limit mph
-#define MIN_SETBACK_SPEED_LIMIT 40U // Minimum speed limit for setback detectors
-
-#define MIN_YELLOW_TIME 3.0f   // Minimum yellow clearance time
-#define MAX_YELLOW_TIME 6.0f   // Maximum yellow clearance time
-#define MIN_RED_CLEARANCE 1.5f // Minimum red clearance time
-#define MAX_RED_CLEARANCE 3.0f // Maximum red clearance time
-#define MIN_GREEN_STOP_LINE 8U // For side road/left turns with stop line detection
-#define MIN_GREEN_SETBACK 15U  // For main road with setback detection (≥40 mph)
-#define MIN_PED_WALK_TIME 4U   // Minimum walk time with push buttons
+#ifndef CONFIG_STREAM_PARSER
+#include <json-c/json.h>
+#include <fcntl.h>
+#include <limits.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#endif
+
+#define MAX_MESSAGE_LEN 256U // Error message printed when a held error is reported
 
 typedef struct
 {
@@ -58,29 +36,38 @@ typedef struct
     int type_enum_value;
 } type_table_entry_t;
 
+// Member path of the config being parsed or validated on this thread
+typedef struct
+{
+    config_path_elem_t elems[CONFIG_PATH_DEPTH];
+    uint32_t depth;
+} path_stack_t;
+
+static _Thread_local config_error_sink_t *error_sink = NULL;
+static _Thread_local path_stack_t path_stack;
+
 /* Config parameters parsing and validation function prototypes */
 
+#ifndef CONFIG_STREAM_PARSER
 static bool parse_detector(json_object *det_obj, detector_t *const det_ptr);
 static bool parse_lane_group(json_object *lane_obj, lane_group_t *const lane_ptr);
 static bool parse_ped_crossing(json_object *ped_cross_obj, ped_crossing_t *const ped_cross_ptr);
 static bool parse_direction(json_object *dir_obj, direction_t *const dir_ptr);
+static bool parse_timing(json_object *timing_obj, phase_timing_t *const timing_ptr);
 static bool parse_road(json_object *road_obj, road_t *const road_ptr);
+static bool parse_coordination(json_object *coord_obj, coordination_t *const coord_ptr);
+static bool parse_plan(json_object *plan_obj, timing_plan_t *const plan_ptr);
+static bool parse_schedule_entry(json_object *entry_obj, config_schedule_entry_t *const entry_ptr);
+#endif
 static void str_to_upper(char *const str_ptr, size_t str_len);
 static bool str_to_enum_type(
     const char *const param_str,
+    const char *const field,
     char *const str,
     const size_t max_str_len,
     int *const enum_ptr,
     const type_table_entry_t *const table,
     const size_t table_size);
-static bool str_to_direction_type(
-    char *const dir_type_str,
-    const size_t max_dir_type_str_len,
-    direction_type_t *const dir_type_ptr);
-static bool str_to_detector_type(
-    char *const det_type_str,
-    const size_t max_det_type_str_len,
-    detector_type_t *const det_type_ptr);
 
 /* Config validation function prototypes */
 
@@ -100,9 +87,12 @@ static bool validate_road_config(
     const intersection_type_t type,
     const road_t *const road_ptr,
     const bool is_main_road);
+static float min_phase_time(const phase_timing_t *const timing);
+static bool validate_plan_split(const config_t *const cfg_ptr, const timing_plan_t *const plan, const size_t index);
 
 /* Config parameters parsing and validation */
 
+#ifndef CONFIG_STREAM_PARSER
 static bool parse_detector(json_object *det_obj, detector_t *const det_ptr)
 {
     bool result = false;
@@ -111,7 +101,7 @@ static bool parse_detector(json_object *det_obj, detector_t *const det_ptr)
     {
         if (det_obj == NULL || det_ptr == NULL)
         {
-            fprintf(stderr, "Assertion error in parse_detector\n");
+            config_report_error(CONFIG_ERROR_INTERNAL, NULL, "Assertion error in parse_detector\n");
             break;
         }
 
@@ -120,13 +110,13 @@ static bool parse_detector(json_object *det_obj, detector_t *const det_ptr)
         // Parse detector type (required)
         if (!json_object_object_get_ex(det_obj, "type", &temp_obj))
         {
-            fprintf(stderr, "Missing detector type\n");
+            config_report_error(CONFIG_ERROR_MISSING, "type", "Missing detector type\n");
             break;
         }
 
         char *det_type = (char *)json_object_get_string(temp_obj);
 
-        if (!str_to_detector_type(det_type, MAX_DET_TYPE_STR_LEN, &det_ptr->type))
+        if (!config_str_to_detector_type(det_type, MAX_DET_TYPE_STR_LEN, &det_ptr->type))
         {
             break;
         }
@@ -139,12 +129,38 @@ static bool parse_detector(json_object *det_obj, detector_t *const det_ptr)
             if (det_ptr->distance < MIN_DETECTOR_DISTANCE ||
                 det_ptr->distance > MAX_DETECTOR_DISTANCE)
             {
-                fprintf(stderr,
-                        "Invalid setback detector distance %u, "
-                        "must be within %u to %u feet\n",
-                        det_ptr->distance,
-                        MIN_DETECTOR_DISTANCE,
-                        MAX_DETECTOR_DISTANCE);
+                config_report_range(
+                    "distance",
+                    det_ptr->distance,
+                    MIN_DETECTOR_DISTANCE,
+                    MAX_DETECTOR_DISTANCE,
+                    "Invalid setback detector distance %u, "
+                    "must be within %u to %u feet\n",
+                    det_ptr->distance,
+                    MIN_DETECTOR_DISTANCE,
+                    MAX_DETECTOR_DISTANCE);
+                break;
+            }
+        }
+
+        // Parse detector memory (optional)
+        if (json_object_object_get_ex(det_obj, "memory", &temp_obj))
+        {
+            char *det_memory = (char *)json_object_get_string(temp_obj);
+
+            if (!config_str_to_detector_memory(det_memory, MAX_DET_MEMORY_STR_LEN, &det_ptr->memory))
+            {
+                break;
+            }
+        }
+
+        // Parse detector mode (optional)
+        if (json_object_object_get_ex(det_obj, "mode", &temp_obj))
+        {
+            char *det_mode = (char *)json_object_get_string(temp_obj);
+
+            if (!config_str_to_detector_mode(det_mode, MAX_DET_MODE_STR_LEN, &det_ptr->mode))
+            {
                 break;
             }
         }
@@ -164,7 +180,10 @@ static bool parse_lane_group(json_object *lane_obj, lane_group_t *const lane_ptr
     {
         if (lane_obj == NULL || lane_ptr == NULL)
         {
-            fprintf(stderr, "Assertion error in parse_lane_group\n");
+            config_report_error(
+                CONFIG_ERROR_INTERNAL,
+                NULL,
+                "Assertion error in parse_lane_group\n");
             break;
         }
 
@@ -173,7 +192,7 @@ static bool parse_lane_group(json_object *lane_obj, lane_group_t *const lane_ptr
         // Parse lane count (required)
         if (!json_object_object_get_ex(lane_obj, "count", &temp_obj))
         {
-            fprintf(stderr, "Missing lane count\n");
+            config_report_error(CONFIG_ERROR_MISSING, "count", "Missing lane count\n");
             break;
         }
 
@@ -181,11 +200,15 @@ static bool parse_lane_group(json_object *lane_obj, lane_group_t *const lane_ptr
 
         if (lane_ptr->count < 1 || lane_ptr->count > MAX_LANES)
         {
-            fprintf(stderr,
-                    "Invalid lane count, must be a number between 1 and %u,"
-                    "but got %u\n",
-                    MAX_LANES,
-                    lane_ptr->count);
+            config_report_range(
+                "count",
+                lane_ptr->count,
+                1,
+                MAX_LANES,
+                "Invalid lane count, must be a number between 1 and %u,"
+                "but got %u\n",
+                MAX_LANES,
+                lane_ptr->count);
             break;
         }
 
@@ -198,13 +221,16 @@ static bool parse_lane_group(json_object *lane_obj, lane_group_t *const lane_ptr
         // Parse detector configuration (optional)
         if (json_object_object_get_ex(lane_obj, "detector", &temp_obj))
         {
-            if (parse_detector(temp_obj, &lane_ptr->detector))
-            {
-                lane_ptr->has_detector = true;
-            }
-            else
+            config_path_push("detector", CONFIG_PATH_NO_INDEX);
+            lane_ptr->has_detector = parse_detector(temp_obj, &lane_ptr->detector);
+            config_path_pop();
+
+            if (!lane_ptr->has_detector)
             {
-                fprintf(stderr, "Failed to parse detector configuration\n");
+                config_report_error(
+                    CONFIG_ERROR_NESTED,
+                    "detector",
+                    "Failed to parse detector configuration\n");
                 break;
             }
         }
@@ -224,7 +250,10 @@ static bool parse_ped_crossing(json_object *ped_cross_obj, ped_crossing_t *const
     {
         if (ped_cross_obj == NULL || ped_cross_ptr == NULL)
         {
-            fprintf(stderr, "Assertion error in parse_ped_crossing\n");
+            config_report_error(
+                CONFIG_ERROR_INTERNAL,
+                NULL,
+                "Assertion error in parse_ped_crossing\n");
             break;
         }
 
@@ -233,7 +262,7 @@ static bool parse_ped_crossing(json_object *ped_cross_obj, ped_crossing_t *const
         // Parse push button (required)
         if (!json_object_object_get_ex(ped_cross_obj, "push_button", &temp_obj))
         {
-            fprintf(stderr, "Missing push button\n");
+            config_report_error(CONFIG_ERROR_MISSING, "push_button", "Missing push button\n");
             break;
         }
 
@@ -242,7 +271,7 @@ static bool parse_ped_crossing(json_object *ped_cross_obj, ped_crossing_t *const
         // Parse distance (required)
         if (!json_object_object_get_ex(ped_cross_obj, "distance", &temp_obj))
         {
-            fprintf(stderr, "Missing distance\n");
+            config_report_error(CONFIG_ERROR_MISSING, "distance", "Missing distance\n");
             break;
         }
 
@@ -251,12 +280,16 @@ static bool parse_ped_crossing(json_object *ped_cross_obj, ped_crossing_t *const
         if (ped_cross_ptr->distance < MIN_CROSSING_DISTANCE ||
             ped_cross_ptr->distance > MAX_CROSSING_DISTANCE)
         {
-            fprintf(stderr,
-                    "Invalid pedestrian crossing distance %u, "
-                    "must be within %u to %u feet\n",
-                    ped_cross_ptr->distance,
-                    MIN_CROSSING_DISTANCE,
-                    MAX_CROSSING_DISTANCE);
+            config_report_range(
+                "distance",
+                ped_cross_ptr->distance,
+                MIN_CROSSING_DISTANCE,
+                MAX_CROSSING_DISTANCE,
+                "Invalid pedestrian crossing distance %u, "
+                "must be within %u to %u feet\n",
+                ped_cross_ptr->distance,
+                MIN_CROSSING_DISTANCE,
+                MAX_CROSSING_DISTANCE);
             break;
         }
 
@@ -275,7 +308,10 @@ static bool parse_direction(json_object *dir_obj, direction_t *const dir_ptr)
     {
         if (dir_obj == NULL || dir_ptr == NULL)
         {
-            fprintf(stderr, "Assertion error in parse_direction\n");
+            config_report_error(
+                CONFIG_ERROR_INTERNAL,
+                NULL,
+                "Assertion error in parse_direction\n");
             break;
         }
 
@@ -284,13 +320,13 @@ static bool parse_direction(json_object *dir_obj, direction_t *const dir_ptr)
         // Parse direction type (required)
         if (!json_object_object_get_ex(dir_obj, "type", &temp_obj))
         {
-            fprintf(stderr, "Missing direction type\n");
+            config_report_error(CONFIG_ERROR_MISSING, "type", "Missing direction type\n");
             break;
         }
 
         char *dir_type = (char *)json_object_get_string(temp_obj);
 
-        if (!str_to_direction_type(dir_type, MAX_DIR_TYPE_STR_LEN, &dir_ptr->type))
+        if (!config_str_to_direction_type(dir_type, MAX_DIR_TYPE_STR_LEN, &dir_ptr->type))
         {
             break;
         }
@@ -298,30 +334,48 @@ static bool parse_direction(json_object *dir_obj, direction_t *const dir_ptr)
         // Parse lanes (required)
         if (!json_object_object_get_ex(dir_obj, "lanes", &temp_obj))
         {
-            fprintf(stderr, "Missing lanes\n");
+            config_report_error(CONFIG_ERROR_MISSING, "lanes", "Missing lanes\n");
             break;
         }
 
         json_object *lane_obj;
 
         // Parse straight lanes (required)
-        if (!json_object_object_get_ex(temp_obj, "straight", &lane_obj) ||
-            !parse_lane_group(lane_obj, &dir_ptr->straight))
+        if (!json_object_object_get_ex(temp_obj, "straight", &lane_obj))
+        {
+            config_report_error(
+                CONFIG_ERROR_MISSING,
+                "lanes.straight",
+                "Straight lane is missing or failed to parse it\n");
+            break;
+        }
+
+        config_path_push("lanes.straight", CONFIG_PATH_NO_INDEX);
+        bool is_parsed = parse_lane_group(lane_obj, &dir_ptr->straight);
+        config_path_pop();
+
+        if (!is_parsed)
         {
-            fprintf(stderr, "Straight lane is missing or failed to parse it\n");
+            config_report_error(
+                CONFIG_ERROR_NESTED,
+                "lanes.straight",
+                "Straight lane is missing or failed to parse it\n");
             break;
         }
 
         // Parse left turn lanes (optional)
         if (json_object_object_get_ex(temp_obj, "left", &lane_obj))
         {
-            if (parse_lane_group(lane_obj, &dir_ptr->left))
-            {
-                dir_ptr->has_left = true;
-            }
-            else
+            config_path_push("lanes.left", CONFIG_PATH_NO_INDEX);
+            dir_ptr->has_left = parse_lane_group(lane_obj, &dir_ptr->left);
+            config_path_pop();
+
+            if (!dir_ptr->has_left)
             {
-                fprintf(stderr, "Failed to parse left turn lanes\n");
+                config_report_error(
+                    CONFIG_ERROR_NESTED,
+                    "lanes.left",
+                    "Failed to parse left turn lanes\n");
                 break;
             }
         }
@@ -329,13 +383,16 @@ static bool parse_direction(json_object *dir_obj, direction_t *const dir_ptr)
         // Parse right turn lanes (optional)
         if (json_object_object_get_ex(temp_obj, "right", &lane_obj))
         {
-            if (parse_lane_group(lane_obj, &dir_ptr->right))
-            {
-                dir_ptr->has_right = true;
-            }
-            else
+            config_path_push("lanes.right", CONFIG_PATH_NO_INDEX);
+            dir_ptr->has_right = parse_lane_group(lane_obj, &dir_ptr->right);
+            config_path_pop();
+
+            if (!dir_ptr->has_right)
             {
-                fprintf(stderr, "Failed to parse right turn lanes\n");
+                config_report_error(
+                    CONFIG_ERROR_NESTED,
+                    "lanes.right",
+                    "Failed to parse right turn lanes\n");
                 break;
             }
         }
@@ -343,13 +400,16 @@ static bool parse_direction(json_object *dir_obj, direction_t *const dir_ptr)
         // Parse pedestrian crossing (optional)
         if (json_object_object_get_ex(dir_obj, "pedestrian", &temp_obj))
         {
-            if (parse_ped_crossing(temp_obj, &dir_ptr->ped_cross))
-            {
-                dir_ptr->has_ped_crossing = true;
-            }
-            else
+            config_path_push("pedestrian", CONFIG_PATH_NO_INDEX);
+            dir_ptr->has_ped_crossing = parse_ped_crossing(temp_obj, &dir_ptr->ped_cross);
+            config_path_pop();
+
+            if (!dir_ptr->has_ped_crossing)
             {
-                fprintf(stderr, "Failed to parse pedestrian crossing\n");
+                config_report_error(
+                    CONFIG_ERROR_NESTED,
+                    "pedestrian",
+                    "Failed to parse pedestrian crossing\n");
                 break;
             }
         }
@@ -361,167 +421,277 @@ static bool parse_direction(json_object *dir_obj, direction_t *const dir_ptr)
     return result;
 }
 
-static bool parse_road(json_object *road_obj, road_t *const road_ptr)
+static bool parse_timing(json_object *timing_obj, phase_timing_t *const timing_ptr)
 {
     bool result = false;
 
     do
     {
-        if (road_obj == NULL || road_ptr == NULL)
+        // A missing or non-object timing_obj reports its first missing member
+        if (timing_ptr == NULL)
         {
-            fprintf(stderr, "Assertion error in parse_road\n");
+            config_report_error(CONFIG_ERROR_INTERNAL, NULL, "Assertion error in parse_timing\n");
             break;
         }
 
         json_object *temp_obj;
 
-        // Parse road ID (required)
-        if (!json_object_object_get_ex(road_obj, "id", &temp_obj))
+        // Parse yellow clearance time (required)
+        if (!json_object_object_get_ex(timing_obj, "yellow_time", &temp_obj))
         {
-            fprintf(stderr, "Missing road ID\n");
+            config_report_error(
+                CONFIG_ERROR_MISSING,
+                "yellow_time",
+                "Missing yellow clearance time\n");
             break;
         }
 
-        snprintf(road_ptr->id, MAX_STR_LEN, "%s", json_object_get_string(temp_obj));
+        timing_ptr->yellow_time = json_object_get_double(temp_obj);
 
-        // Parse road name (required)
-        if (!json_object_object_get_ex(road_obj, "name", &temp_obj))
+        if (timing_ptr->yellow_time < MIN_YELLOW_TIME ||
+            timing_ptr->yellow_time > MAX_YELLOW_TIME)
         {
-            fprintf(stderr, "Missing road name\n");
+            config_report_range(
+                "yellow_time",
+                timing_ptr->yellow_time,
+                MIN_YELLOW_TIME,
+                MAX_YELLOW_TIME,
+                "Invalid yellow clearance time %.1f, "
+                "must be between %f and %f seconds\n",
+                timing_ptr->yellow_time,
+                MIN_YELLOW_TIME,
+                MAX_YELLOW_TIME);
             break;
         }
 
-        snprintf(road_ptr->name, MAX_STR_LEN, "%s", json_object_get_string(temp_obj));
-
-        // Parse speed limit (required)
-        if (!json_object_object_get_ex(road_obj, "speed_limit", &temp_obj))
+        // Parse red clearance time (required)
+        if (!json_object_object_get_ex(timing_obj, "red_clearance", &temp_obj))
         {
-            fprintf(stderr, "Missing speed limit\n");
+            config_report_error(
+                CONFIG_ERROR_MISSING,
+                "red_clearance",
+                "Missing red clearance time\n");
             break;
         }
 
-        road_ptr->speed_limit = json_object_get_int(temp_obj);
+        timing_ptr->red_clearance = json_object_get_double(temp_obj);
 
-        if (road_ptr->speed_limit < MIN_SPEED_LIMIT ||
-            road_ptr->speed_limit > MAX_SPEED_LIMIT)
+        if (timing_ptr->red_clearance < MIN_RED_CLEARANCE ||
+            timing_ptr->red_clearance > MAX_RED_CLEARANCE)
         {
-            fprintf(stderr,
-                    "Invalid speed limit %u, "
-                    "must be within %u to %u mph\n",
-                    road_ptr->speed_limit,
-                    MIN_SPEED_LIMIT,
-                    MAX_SPEED_LIMIT);
+            config_report_range(
+                "red_clearance",
+                timing_ptr->red_clearance,
+                MIN_RED_CLEARANCE,
+                MAX_RED_CLEARANCE,
+                "Invalid red clearance time %.1f, "
+                "must be between %f and %f seconds\n",
+                timing_ptr->red_clearance,
+                MIN_RED_CLEARANCE,
+                MAX_RED_CLEARANCE);
             break;
         }
 
-        json_object *timing_obj;
-
-        // Parse timing configuration (required)
-        if (!json_object_object_get_ex(road_obj, "timing", &timing_obj))
+        // Parse minimum green time (required)
+        if (!json_object_object_get_ex(timing_obj, "min_green", &temp_obj))
         {
-            fprintf(stderr, "Missing timing configuration\n");
+            config_report_error(
+                CONFIG_ERROR_MISSING,
+                "min_green",
+                "Missing minimum green time\n");
             break;
         }
 
-        // Parse yellow clearance time (required)
-        if (!json_object_object_get_ex(timing_obj, "yellow_time", &temp_obj))
+        timing_ptr->min_green = json_object_get_int(temp_obj);
+
+        if (timing_ptr->min_green < MIN_GREEN_STOP_LINE)
         {
-            fprintf(stderr, "Missing yellow clearance time\n");
+            config_report_range(
+                "min_green",
+                timing_ptr->min_green,
+                MIN_GREEN_STOP_LINE,
+                NAN,
+                "Invalid minimum green time %u, "
+                "must be at least %u seconds\n",
+                timing_ptr->min_green,
+                MIN_GREEN_STOP_LINE);
             break;
         }
 
-        road_ptr->timing.yellow_time = json_object_get_double(temp_obj);
+        // Parse maximum green time (optional)
+        if (json_object_object_get_ex(timing_obj, "max_green", &temp_obj))
+        {
+            timing_ptr->max_green = json_object_get_int(temp_obj);
+
+            if (timing_ptr->max_green < timing_ptr->min_green)
+            {
+                config_report_range(
+                    "max_green",
+                    timing_ptr->max_green,
+                    timing_ptr->min_green,
+                    NAN,
+                    "Invalid maximum green time %u, "
+                    "must be at least the minimum green time of %u seconds\n",
+                    timing_ptr->max_green,
+                    timing_ptr->min_green);
+                break;
+            }
+        }
 
-        if (road_ptr->timing.yellow_time < MIN_YELLOW_TIME ||
-            road_ptr->timing.yellow_time > MAX_YELLOW_TIME)
+        // Parse passage time (optional)
+        if (json_object_object_get_ex(timing_obj, "passage_time", &temp_obj))
         {
-            fprintf(stderr,
-                    "Invalid yellow clearance time %.1f, "
+            timing_ptr->passage_time = json_object_get_double(temp_obj);
+
+            if (timing_ptr->passage_time < MIN_PASSAGE_TIME ||
+                timing_ptr->passage_time > MAX_PASSAGE_TIME)
+            {
+                config_report_range(
+                    "passage_time",
+                    timing_ptr->passage_time,
+                    MIN_PASSAGE_TIME,
+                    MAX_PASSAGE_TIME,
+                    "Invalid passage time %.1f, "
                     "must be between %f and %f seconds\n",
-                    road_ptr->timing.yellow_time,
-                    MIN_YELLOW_TIME,
-                    MAX_YELLOW_TIME);
-            break;
+                    timing_ptr->passage_time,
+                    MIN_PASSAGE_TIME,
+                    MAX_PASSAGE_TIME);
+                break;
+            }
         }
 
-        // Parse red clearance time (required)
-        if (!json_object_object_get_ex(timing_obj, "red_clearance", &temp_obj))
+        // Parse pedestrian walk time (optional)
+        if (json_object_object_get_ex(timing_obj, "pedestrian_walk", &temp_obj))
         {
-            fprintf(stderr, "Missing red clearance time\n");
-            break;
+            timing_ptr->ped_walk = json_object_get_int(temp_obj);
+
+            if (timing_ptr->ped_walk < MIN_PED_WALK_TIME)
+            {
+                config_report_range(
+                    "pedestrian_walk",
+                    timing_ptr->ped_walk,
+                    MIN_PED_WALK_TIME,
+                    NAN,
+                    "Invalid pedestrian walk time %u, "
+                    "must be at least %u seconds\n",
+                    timing_ptr->ped_walk,
+                    MIN_PED_WALK_TIME);
+                break;
+            }
         }
 
-        road_ptr->timing.red_clearance = json_object_get_double(temp_obj);
+        // Parse pedestrian clearance time (optional)
+        if (json_object_object_get_ex(
+                timing_obj, "pedestrian_clearance", &temp_obj))
+        {
+            timing_ptr->ped_clearance = json_object_get_int(temp_obj);
+
+            if (timing_ptr->ped_clearance < MIN_PED_WALK_TIME)
+            {
+                config_report_range(
+                    "pedestrian_clearance",
+                    timing_ptr->ped_clearance,
+                    MIN_PED_WALK_TIME,
+                    NAN,
+                    "Invalid pedestrian clearance time %u, "
+                    "must be at least %u seconds\n",
+                    timing_ptr->ped_clearance,
+                    MIN_PED_WALK_TIME);
+                break;
+            }
+        }
+
+        result = true;
+
+    } while (0);
+
+    return result;
+}
+
+static bool parse_road(json_object *road_obj, road_t *const road_ptr)
+{
+    bool result = false;
 
-        if (road_ptr->timing.red_clearance < MIN_RED_CLEARANCE ||
-            road_ptr->timing.red_clearance > MAX_RED_CLEARANCE)
+    do
+    {
+        if (road_obj == NULL || road_ptr == NULL)
         {
-            fprintf(stderr,
-                    "Invalid red clearance time %.1f, "
-                    "must be between %f and %f seconds\n",
-                    road_ptr->timing.red_clearance,
-                    MIN_RED_CLEARANCE,
-                    MAX_RED_CLEARANCE);
+            config_report_error(CONFIG_ERROR_INTERNAL, NULL, "Assertion error in parse_road\n");
             break;
         }
 
-        // Parse minimum green time (required)
-        if (!json_object_object_get_ex(timing_obj, "min_green", &temp_obj))
+        json_object *temp_obj;
+
+        // Parse road ID (required)
+        if (!json_object_object_get_ex(road_obj, "id", &temp_obj))
         {
-            fprintf(stderr, "Missing minimum green time\n");
+            config_report_error(CONFIG_ERROR_MISSING, "id", "Missing road ID\n");
             break;
         }
 
-        road_ptr->timing.min_green = json_object_get_int(temp_obj);
+        snprintf(road_ptr->id, MAX_STR_LEN, "%s", json_object_get_string(temp_obj));
 
-        if (road_ptr->timing.min_green < MIN_GREEN_STOP_LINE)
+        // Parse road name (required)
+        if (!json_object_object_get_ex(road_obj, "name", &temp_obj))
         {
-            fprintf(stderr,
-                    "Invalid minimum green time %u, "
-                    "must be at least %u seconds\n",
-                    road_ptr->timing.min_green,
-                    MIN_GREEN_STOP_LINE);
+            config_report_error(CONFIG_ERROR_MISSING, "name", "Missing road name\n");
             break;
         }
 
-        // Parse pedestrian walk time (optional)
-        if (json_object_object_get_ex(timing_obj, "pedestrian_walk", &temp_obj))
+        snprintf(road_ptr->name, MAX_STR_LEN, "%s", json_object_get_string(temp_obj));
+
+        // Parse speed limit (required)
+        if (!json_object_object_get_ex(road_obj, "speed_limit", &temp_obj))
         {
-            road_ptr->timing.ped_walk = json_object_get_int(temp_obj);
+            config_report_error(CONFIG_ERROR_MISSING, "speed_limit", "Missing speed limit\n");
+            break;
+        }
 
-            if (road_ptr->timing.ped_walk < MIN_PED_WALK_TIME)
-            {
-                fprintf(stderr,
-                        "Invalid pedestrian walk time %u, "
-                        "must be at least %u seconds\n",
-                        road_ptr->timing.ped_walk,
-                        MIN_PED_WALK_TIME);
-                break;
-            }
+        road_ptr->speed_limit = json_object_get_int(temp_obj);
+
+        if (road_ptr->speed_limit < MIN_SPEED_LIMIT ||
+            road_ptr->speed_limit > MAX_SPEED_LIMIT)
+        {
+            config_report_range(
+                "speed_limit",
+                road_ptr->speed_limit,
+                MIN_SPEED_LIMIT,
+                MAX_SPEED_LIMIT,
+                "Invalid speed limit %u, "
+                "must be within %u to %u mph\n",
+                road_ptr->speed_limit,
+                MIN_SPEED_LIMIT,
+                MAX_SPEED_LIMIT);
+            break;
         }
 
-        // Parse pedestrian clearance time (optional)
-        if (json_object_object_get_ex(
-                timing_obj, "pedestrian_clearance", &temp_obj))
+        json_object *timing_obj;
+
+        // Parse timing configuration (required)
+        if (!json_object_object_get_ex(road_obj, "timing", &timing_obj))
         {
-            road_ptr->timing.ped_clearance = json_object_get_int(temp_obj);
+            config_report_error(CONFIG_ERROR_MISSING, "timing", "Missing timing configuration\n");
+            break;
+        }
 
-            if (road_ptr->timing.ped_clearance < MIN_PED_WALK_TIME)
-            {
-                fprintf(stderr,
-                        "Invalid pedestrian clearance time %u, "
-                        "must be at least %u seconds\n",
-                        road_ptr->timing.ped_clearance,
-                        MIN_PED_WALK_TIME);
-                break;
-            }
+        config_path_push("timing", CONFIG_PATH_NO_INDEX);
+        bool is_timing_parsed = parse_timing(timing_obj, &road_ptr->timing);
+        config_path_pop();
+
+        if (!is_timing_parsed)
+        {
+            break;
         }
 
         // Parse directions array (required)
         if (!json_object_object_get_ex(road_obj, "directions", &temp_obj) ||
+            !json_object_is_type(temp_obj, json_type_array) ||
             json_object_array_length(temp_obj) != MAX_DIRECTIONS)
         {
-            fprintf(stderr, "Missing or invalid directions array\n");
+            config_report_error(
+                CONFIG_ERROR_MISSING,
+                "directions",
+                "Missing or invalid directions array\n");
             break;
         }
 
@@ -529,7 +699,11 @@ static bool parse_road(json_object *road_obj, road_t *const road_ptr)
         size_t i;
         for (i = 0; i < MAX_DIRECTIONS; i++)
         {
-            if (!parse_direction(json_object_array_get_idx(temp_obj, i), &road_ptr->directions[i]))
+            config_path_push("directions", (uint32_t)i);
+            bool is_parsed = parse_direction(json_object_array_get_idx(temp_obj, i), &road_ptr->directions[i]);
+            config_path_pop();
+
+            if (!is_parsed)
             {
                 break;
             }
@@ -537,7 +711,11 @@ static bool parse_road(json_object *road_obj, road_t *const road_ptr)
 
         if (i != MAX_DIRECTIONS)
         {
-            fprintf(stderr, "Failed to parse direction %lu\n", i);
+            config_report_error(
+                CONFIG_ERROR_NESTED,
+                "directions",
+                "Failed to parse direction %lu\n",
+                i);
             break;
         }
 
@@ -548,104 +726,672 @@ static bool parse_road(json_object *road_obj, road_t *const road_ptr)
     return result;
 }
 
-static void str_to_upper(char *const str_ptr, size_t str_len)
+static bool parse_coordination(json_object *coord_obj, coordination_t *const coord_ptr)
 {
-    for (size_t i = 0; i < str_len; i++)
-    {
-        str_ptr[i] = (char)toupper(str_ptr[i]);
-    }
-}
+    bool result = false;
 
-static bool str_to_enum_type(
-    const char *const param_str,
-    char *const str,
-    const size_t max_str_len,
-    int *const enum_ptr,
-    const type_table_entry_t *const table,
-    const size_t table_size)
-{
-    if (param_str == NULL ||
-        str == NULL ||
-        max_str_len == 0 ||
-        enum_ptr == NULL ||
-        table == NULL ||
-        table_size < sizeof(type_table_entry_t))
+    do
     {
-        return false;
-    }
+        if (coord_ptr == NULL)
+        {
+            config_report_error(CONFIG_ERROR_INTERNAL, NULL, "Assertion error in parse_coordination\n");
+            break;
+        }
 
-    size_t str_len = strnlen(str, MAX_STR_LEN);
+        json_object *temp_obj;
 
-    if (str_len > max_str_len)
-    {
-        fprintf(
-            stderr,
-            "Invalid %s type length of %lu, "
-            "must be not more than %lu characters\n",
-            param_str,
-            str_len,
-            max_str_len);
+        // Parse cycle length (required)
+        if (!json_object_object_get_ex(coord_obj, "cycle_length", &temp_obj))
+        {
+            config_report_error(CONFIG_ERROR_MISSING, "cycle_length", "Missing cycle length\n");
+            break;
+        }
 
-        return false;
-    }
+        coord_ptr->cycle_length = json_object_get_int(temp_obj);
 
-    str_to_upper(str, str_len);
+        // Parse offset (required)
+        if (!json_object_object_get_ex(coord_obj, "offset", &temp_obj))
+        {
+            config_report_error(CONFIG_ERROR_MISSING, "offset", "Missing offset\n");
+            break;
+        }
 
-    for (size_t i = 0; i < table_size; i++)
-    {
-        if (str_len != table[i].type_str_len)
+        coord_ptr->offset = json_object_get_int(temp_obj);
+
+        // Parse main road split (required)
+        if (!json_object_object_get_ex(coord_obj, "split", &temp_obj))
         {
-            continue;
+            config_report_error(CONFIG_ERROR_MISSING, "split", "Missing main road split\n");
+            break;
         }
 
-        if (strncmp(str, table[i].type_str, MAX_STR_LEN) == 0)
+        coord_ptr->split = json_object_get_int(temp_obj);
+
+        if (!config_check_coordination(coord_ptr))
         {
-            *enum_ptr = table[i].type_enum_value;
-            return true;
+            break;
         }
-    }
 
-    fprintf(stderr, "Unknown %s type: %s\n", param_str, str);
-    return false;
-}
+        result = true;
 
-static bool str_to_direction_type(
-    char *const dir_type_str,
-    const size_t max_dir_type_str_len,
-    direction_type_t *const dir_type_ptr)
-{
-    static const type_table_entry_t dir_types[] = {
-        {DIR_TYPE_NB, STRLEN(DIR_TYPE_NB), DIRECTION_NB},
-        {DIR_TYPE_SB, STRLEN(DIR_TYPE_SB), DIRECTION_SB},
-        {DIR_TYPE_EB, STRLEN(DIR_TYPE_EB), DIRECTION_EB},
-        {DIR_TYPE_WB, STRLEN(DIR_TYPE_WB), DIRECTION_WB}};
+    } while (0);
 
-    return str_to_enum_type(
-        "direction",
-        dir_type_str,
-        max_dir_type_str_len,
-        (int *const)dir_type_ptr,
-        dir_types,
-        sizeof(dir_types) / sizeof(type_table_entry_t));
+    return result;
 }
 
-static bool str_to_detector_type(
-    char *const det_type_str,
-    const size_t max_det_type_str_len,
-    detector_type_t *const det_type_ptr)
+static bool parse_plan(json_object *plan_obj, timing_plan_t *const plan_ptr)
 {
-    static const type_table_entry_t det_types[] = {
-        {DET_TYPE_LOOP, STRLEN(DET_TYPE_LOOP), DETECTOR_LOOP},
-        {DET_TYPE_VIDEO, STRLEN(DET_TYPE_VIDEO), DETECTOR_VIDEO},
-        {DET_TYPE_RADAR, STRLEN(DET_TYPE_RADAR), DETECTOR_RADAR}};
+    bool result = false;
 
-    return str_to_enum_type(
-        "detector",
-        det_type_str,
-        max_det_type_str_len,
-        (int *const)det_type_ptr,
-        det_types,
-        sizeof(det_types) / sizeof(type_table_entry_t));
+    do
+    {
+        if (plan_obj == NULL || plan_ptr == NULL)
+        {
+            config_report_error(CONFIG_ERROR_INTERNAL, NULL, "Assertion error in parse_plan\n");
+            break;
+        }
+
+        json_object *temp_obj;
+
+        // Parse plan ID (required)
+        if (!json_object_object_get_ex(plan_obj, "id", &temp_obj))
+        {
+            config_report_error(CONFIG_ERROR_MISSING, "id", "Missing plan ID\n");
+            break;
+        }
+
+        snprintf(plan_ptr->id, MAX_STR_LEN, "%s", json_object_get_string(temp_obj));
+
+        // Parse flash operation (optional)
+        if (json_object_object_get_ex(plan_obj, "flash", &temp_obj))
+        {
+            plan_ptr->is_flash = json_object_get_boolean(temp_obj);
+        }
+
+        // Parse timing per road, in the order of the roads array (required unless flashing)
+        bool has_timing = json_object_object_get_ex(plan_obj, "timing", &temp_obj);
+
+        if (has_timing || !plan_ptr->is_flash)
+        {
+            if (!has_timing ||
+                !json_object_is_type(temp_obj, json_type_array) ||
+                json_object_array_length(temp_obj) != MAX_ROADS)
+            {
+                config_report_error(
+                    CONFIG_ERROR_MISSING,
+                    "timing",
+                    "Missing or invalid plan timing array\n");
+                break;
+            }
+
+            size_t i;
+            for (i = 0; i < MAX_ROADS; i++)
+            {
+                config_path_push("timing", (uint32_t)i);
+                bool is_parsed = parse_timing(json_object_array_get_idx(temp_obj, i), &plan_ptr->timing[i]);
+                config_path_pop();
+
+                if (!is_parsed)
+                {
+                    break;
+                }
+            }
+
+            if (i != MAX_ROADS)
+            {
+                config_report_error(
+                    CONFIG_ERROR_NESTED,
+                    "timing",
+                    "Failed to parse timing of road %lu\n",
+                    i);
+                break;
+            }
+        }
+
+        // Parse coordination (optional, runs free without)
+        if (json_object_object_get_ex(plan_obj, "coordination", &temp_obj))
+        {
+            config_path_push("coordination", CONFIG_PATH_NO_INDEX);
+            bool is_parsed = parse_coordination(temp_obj, &plan_ptr->coord);
+            config_path_pop();
+
+            if (!is_parsed)
+            {
+                break;
+            }
+        }
+
+        result = true;
+
+    } while (0);
+
+    return result;
+}
+
+static bool parse_schedule_entry(json_object *entry_obj, config_schedule_entry_t *const entry_ptr)
+{
+    bool result = false;
+
+    do
+    {
+        if (entry_obj == NULL || entry_ptr == NULL)
+        {
+            config_report_error(CONFIG_ERROR_INTERNAL, NULL, "Assertion error in parse_schedule_entry\n");
+            break;
+        }
+
+        json_object *temp_obj;
+        char str[MAX_STR_LEN];
+
+        // Parse plan ID (required)
+        if (!json_object_object_get_ex(entry_obj, "plan", &temp_obj))
+        {
+            config_report_error(CONFIG_ERROR_MISSING, "plan", "Missing schedule plan\n");
+            break;
+        }
+
+        snprintf(entry_ptr->plan_id, MAX_STR_LEN, "%s", json_object_get_string(temp_obj));
+
+        // Parse start time (required)
+        if (!json_object_object_get_ex(entry_obj, "time", &temp_obj))
+        {
+            config_report_error(CONFIG_ERROR_MISSING, "time", "Missing schedule time\n");
+            break;
+        }
+
+        snprintf(str, MAX_STR_LEN, "%s", json_object_get_string(temp_obj));
+
+        if (!config_str_to_time_of_day(str, &entry_ptr->minute))
+        {
+            break;
+        }
+
+        // Parse days of the week (optional, every day if missing)
+        entry_ptr->day_mask = ALL_DAYS_MASK;
+
+        if (json_object_object_get_ex(entry_obj, "days", &temp_obj))
+        {
+            if (!json_object_is_type(temp_obj, json_type_array) ||
+                json_object_array_length(temp_obj) == 0)
+            {
+                config_report_error(CONFIG_ERROR_MISSING, "days", "Missing or invalid schedule days array\n");
+                break;
+            }
+
+            size_t num_days = json_object_array_length(temp_obj);
+            size_t i;
+
+            entry_ptr->day_mask = 0;
+            for (i = 0; i < num_days; i++)
+            {
+                uint8_t day;
+
+                snprintf(str, MAX_STR_LEN, "%s", json_object_get_string(json_object_array_get_idx(temp_obj, i)));
+
+                if (!config_str_to_day(str, MAX_DAY_STR_LEN, &day))
+                {
+                    break;
+                }
+
+                entry_ptr->day_mask |= (uint8_t)(1U << day);
+            }
+
+            if (i != num_days)
+            {
+                break;
+            }
+        }
+
+        result = true;
+
+    } while (0);
+
+    return result;
+}
+#endif // CONFIG_STREAM_PARSER
+
+static void str_to_upper(char *const str_ptr, size_t str_len)
+{
+    for (size_t i = 0; i < str_len; i++)
+    {
+        str_ptr[i] = (char)toupper(str_ptr[i]);
+    }
+}
+
+static bool str_to_enum_type(
+    const char *const param_str,
+    const char *const field,
+    char *const str,
+    const size_t max_str_len,
+    int *const enum_ptr,
+    const type_table_entry_t *const table,
+    const size_t table_size)
+{
+    if (param_str == NULL ||
+        field == NULL ||
+        str == NULL ||
+        max_str_len == 0 ||
+        enum_ptr == NULL ||
+        table == NULL ||
+        table_size == 0)
+    {
+        return false;
+    }
+
+    size_t str_len = strnlen(str, MAX_STR_LEN);
+
+    if (str_len > max_str_len)
+    {
+        config_report_error(
+            CONFIG_ERROR_LENGTH,
+            field,
+            "Invalid %s type length of %lu, "
+            "must be not more than %lu characters\n",
+            param_str,
+            str_len,
+            max_str_len);
+
+        return false;
+    }
+
+    str_to_upper(str, str_len);
+
+    for (size_t i = 0; i < table_size; i++)
+    {
+        if (str_len != table[i].type_str_len)
+        {
+            continue;
+        }
+
+        if (strncmp(str, table[i].type_str, MAX_STR_LEN) == 0)
+        {
+            *enum_ptr = table[i].type_enum_value;
+            return true;
+        }
+    }
+
+    config_report_error(
+        CONFIG_ERROR_UNKNOWN,
+        field,
+        "Unknown %s type: %s\n",
+        param_str,
+        str);
+    return false;
+}
+
+bool config_str_to_direction_type(
+    char *const dir_type_str,
+    const size_t max_dir_type_str_len,
+    direction_type_t *const dir_type_ptr)
+{
+    static const type_table_entry_t dir_types[] = {
+        {DIR_TYPE_NB, STRLEN(DIR_TYPE_NB), DIRECTION_NB},
+        {DIR_TYPE_SB, STRLEN(DIR_TYPE_SB), DIRECTION_SB},
+        {DIR_TYPE_EB, STRLEN(DIR_TYPE_EB), DIRECTION_EB},
+        {DIR_TYPE_WB, STRLEN(DIR_TYPE_WB), DIRECTION_WB}};
+
+    return str_to_enum_type(
+        "direction",
+        "type",
+        dir_type_str,
+        max_dir_type_str_len,
+        (int *const)dir_type_ptr,
+        dir_types,
+        sizeof(dir_types) / sizeof(type_table_entry_t));
+}
+
+bool config_str_to_detector_type(
+    char *const det_type_str,
+    const size_t max_det_type_str_len,
+    detector_type_t *const det_type_ptr)
+{
+    static const type_table_entry_t det_types[] = {
+        {DET_TYPE_LOOP, STRLEN(DET_TYPE_LOOP), DETECTOR_LOOP},
+        {DET_TYPE_VIDEO, STRLEN(DET_TYPE_VIDEO), DETECTOR_VIDEO},
+        {DET_TYPE_RADAR, STRLEN(DET_TYPE_RADAR), DETECTOR_RADAR}};
+
+    return str_to_enum_type(
+        "detector",
+        "type",
+        det_type_str,
+        max_det_type_str_len,
+        (int *const)det_type_ptr,
+        det_types,
+        sizeof(det_types) / sizeof(type_table_entry_t));
+}
+
+bool config_str_to_detector_memory(
+    char *const det_memory_str,
+    const size_t max_det_memory_str_len,
+    detector_memory_t *const det_memory_ptr)
+{
+    static const type_table_entry_t det_memories[] = {
+        {DET_MEMORY_NON_LOCK, STRLEN(DET_MEMORY_NON_LOCK), DETECTOR_MEMORY_NON_LOCK},
+        {DET_MEMORY_LOCK, STRLEN(DET_MEMORY_LOCK), DETECTOR_MEMORY_LOCK}};
+
+    return str_to_enum_type(
+        "detector memory",
+        "memory",
+        det_memory_str,
+        max_det_memory_str_len,
+        (int *const)det_memory_ptr,
+        det_memories,
+        sizeof(det_memories) / sizeof(type_table_entry_t));
+}
+
+bool config_str_to_detector_mode(
+    char *const det_mode_str,
+    const size_t max_det_mode_str_len,
+    detector_mode_t *const det_mode_ptr)
+{
+    static const type_table_entry_t det_modes[] = {
+        {DET_MODE_PRESENCE, STRLEN(DET_MODE_PRESENCE), DETECTOR_MODE_PRESENCE},
+        {DET_MODE_PULSE, STRLEN(DET_MODE_PULSE), DETECTOR_MODE_PULSE}};
+
+    return str_to_enum_type(
+        "detector mode",
+        "mode",
+        det_mode_str,
+        max_det_mode_str_len,
+        (int *const)det_mode_ptr,
+        det_modes,
+        sizeof(det_modes) / sizeof(type_table_entry_t));
+}
+
+bool config_str_to_day(
+    char *const day_str,
+    const size_t max_day_str_len,
+    uint8_t *const day_ptr)
+{
+    static const type_table_entry_t days[] = {
+        {DAY_MON, STRLEN(DAY_MON), 0},
+        {DAY_TUE, STRLEN(DAY_TUE), 1},
+        {DAY_WED, STRLEN(DAY_WED), 2},
+        {DAY_THU, STRLEN(DAY_THU), 3},
+        {DAY_FRI, STRLEN(DAY_FRI), 4},
+        {DAY_SAT, STRLEN(DAY_SAT), 5},
+        {DAY_SUN, STRLEN(DAY_SUN), 6}};
+
+    int day;
+
+    if (day_ptr == NULL ||
+        !str_to_enum_type(
+            "day",
+            "days",
+            day_str,
+            max_day_str_len,
+            &day,
+            days,
+            sizeof(days) / sizeof(type_table_entry_t)))
+    {
+        return false;
+    }
+
+    *day_ptr = (uint8_t)day;
+    return true;
+}
+
+bool config_str_to_time_of_day(const char *const time_str, uint16_t *const minute_ptr)
+{
+    if (time_str == NULL || minute_ptr == NULL)
+    {
+        return false;
+    }
+
+    const char *s = time_str;
+
+    if (strnlen(s, MAX_STR_LEN) != STRLEN("HH:MM") ||
+        !isdigit((unsigned char)s[0]) || !isdigit((unsigned char)s[1]) ||
+        s[2] != ':' ||
+        !isdigit((unsigned char)s[3]) || !isdigit((unsigned char)s[4]))
+    {
+        config_report_error(
+            CONFIG_ERROR_UNKNOWN,
+            "time",
+            "Invalid schedule time %s, must be HH:MM\n",
+            time_str);
+        return false;
+    }
+
+    unsigned hours = (unsigned)(s[0] - '0') * 10U + (unsigned)(s[1] - '0');
+    unsigned minutes = (unsigned)(s[3] - '0') * 10U + (unsigned)(s[4] - '0');
+
+    if (hours > 23U || minutes > 59U)
+    {
+        config_report_error(
+            CONFIG_ERROR_UNKNOWN,
+            "time",
+            "Invalid schedule time %s, must be within 00:00 to 23:59\n",
+            time_str);
+        return false;
+    }
+
+    *minute_ptr = (uint16_t)(hours * 60U + minutes);
+    return true;
+}
+
+bool config_check_coordination(const coordination_t *const coord)
+{
+    bool result = false;
+
+    do
+    {
+        if (coord == NULL)
+        {
+            config_report_error(CONFIG_ERROR_INTERNAL, NULL, "Assertion error in config_check_coordination\n");
+            break;
+        }
+
+        // Zero cycle length runs free, the other members are then unused
+        bool is_coordinated = coord->cycle_length != 0;
+
+        if (is_coordinated &&
+            (coord->cycle_length < MIN_CYCLE_LENGTH ||
+             coord->cycle_length > MAX_CYCLE_LENGTH))
+        {
+            config_report_range(
+                "cycle_length",
+                coord->cycle_length,
+                MIN_CYCLE_LENGTH,
+                MAX_CYCLE_LENGTH,
+                "Invalid cycle length %u, "
+                "must be 0 or within %u to %u seconds\n",
+                coord->cycle_length,
+                MIN_CYCLE_LENGTH,
+                MAX_CYCLE_LENGTH);
+            break;
+        }
+
+        if (is_coordinated && coord->offset >= coord->cycle_length)
+        {
+            config_report_range(
+                "offset",
+                coord->offset,
+                0,
+                coord->cycle_length - 1U,
+                "Invalid offset %u, "
+                "must be less than the cycle length of %u seconds\n",
+                coord->offset,
+                coord->cycle_length);
+            break;
+        }
+
+        if (is_coordinated && (coord->split == 0 || coord->split >= coord->cycle_length))
+        {
+            config_report_range(
+                "split",
+                coord->split,
+                1,
+                coord->cycle_length - 1U,
+                "Invalid main road split %u, "
+                "must be within 1 to %u seconds\n",
+                coord->split,
+                coord->cycle_length - 1U);
+            break;
+        }
+
+        result = true;
+
+    } while (0);
+
+    return result;
+}
+
+static bool find_plan(const config_t *const config, const char *const id, uint8_t *const plan_ptr)
+{
+    for (uint8_t i = 0; i < config->num_plans; i++)
+    {
+        if (strncmp(config->plans[i].id, id, MAX_STR_LEN) == 0)
+        {
+            *plan_ptr = i;
+            return true;
+        }
+    }
+
+    return false;
+}
+
+bool config_build_plans(
+    config_t *const config,
+    const config_schedule_entry_t *const entries,
+    const size_t num_entries)
+{
+    static const char *const day_strs[DAYS_PER_WEEK] = {
+        DAY_MON, DAY_TUE, DAY_WED, DAY_THU, DAY_FRI, DAY_SAT, DAY_SUN};
+
+    bool result = false;
+
+    do
+    {
+        if (config == NULL ||
+            (entries == NULL && num_entries > 0) ||
+            num_entries > MAX_SCHEDULE_ENTRIES ||
+            config->num_plans == 0 ||
+            config->num_plans > MAX_PLANS)
+        {
+            config_report_error(CONFIG_ERROR_INTERNAL, NULL, "Assertion error in config_build_plans\n");
+            break;
+        }
+
+        // The parsers already stored the coordination of the base plan
+        timing_plan_t *base = &config->plans[CONFIG_BASE_PLAN];
+        snprintf(base->id, MAX_STR_LEN, "%s", CONFIG_BASE_PLAN_ID);
+        base->is_flash = false;
+
+        size_t i;
+        for (i = 0; i < MAX_ROADS; i++)
+        {
+            base->timing[i] = config->roads[i].timing;
+        }
+
+        // Check for duplicate plan IDs, the base plan ID is reserved
+        for (i = 1; i < config->num_plans; i++)
+        {
+            uint8_t plan;
+
+            if (find_plan(config, config->plans[i].id, &plan) && plan != i)
+            {
+                config_path_push("plans", (uint32_t)(i - 1U));
+                config_report_error(
+                    CONFIG_ERROR_DUPLICATE,
+                    "id",
+                    "Duplicate plan ID found: %s\n",
+                    config->plans[i].id);
+                config_path_pop();
+                break;
+            }
+        }
+
+        if (i != config->num_plans)
+        {
+            break;
+        }
+
+        // Expand each entry into one transition per day
+        config->num_transitions = 0;
+        for (i = 0; i < num_entries; i++)
+        {
+            const config_schedule_entry_t *entry = &entries[i];
+            bool is_valid = true;
+            uint8_t plan;
+
+            config_path_push("schedule", (uint32_t)i);
+
+            if (!find_plan(config, entry->plan_id, &plan))
+            {
+                config_report_error(
+                    CONFIG_ERROR_UNKNOWN,
+                    "plan",
+                    "Unknown timing plan: %s\n",
+                    entry->plan_id);
+                is_valid = false;
+            }
+
+            for (uint8_t day = 0; is_valid && day < DAYS_PER_WEEK; day++)
+            {
+                if ((entry->day_mask & (1U << day)) == 0)
+                {
+                    continue;
+                }
+
+                uint16_t minute = (uint16_t)(day * MINUTES_PER_DAY + entry->minute);
+
+                for (size_t j = 0; j < config->num_transitions; j++)
+                {
+                    if (config->transitions[j].minute == minute)
+                    {
+                        config_report_error(
+                            CONFIG_ERROR_DUPLICATE,
+                            "time",
+                            "Duplicate schedule entry for %s at %02u:%02u\n",
+                            day_strs[day],
+                            entry->minute / 60U,
+                            entry->minute % 60U);
+                        is_valid = false;
+                        break;
+                    }
+                }
+
+                if (is_valid)
+                {
+                    config->transitions[config->num_transitions].minute = minute;
+                    config->transitions[config->num_transitions].plan = plan;
+                    config->num_transitions++;
+                }
+            }
+
+            config_path_pop();
+
+            if (!is_valid)
+            {
+                break;
+            }
+        }
+
+        if (i != num_entries)
+        {
+            break;
+        }
+
+        // Sort by minute of the week, the controller walks them in order
+        for (i = 1; i < config->num_transitions; i++)
+        {
+            plan_transition_t transition = config->transitions[i];
+            size_t j = i;
+
+            for (; j > 0 && config->transitions[j - 1U].minute > transition.minute; j--)
+            {
+                config->transitions[j] = config->transitions[j - 1U];
+            }
+
+            config->transitions[j] = transition;
+        }
+
+        result = true;
+
+    } while (0);
+
+    return result;
 }
 
 /* Config Validation */
@@ -675,7 +1421,11 @@ static bool is_turn_lane_allowed(const intersection_type_t type, const bool is_l
         result = true;        // all turns allowed
         break;
     default:
-        fprintf(stderr, "Unknown intersection type: %d\n", type);
+        config_report_error(
+            CONFIG_ERROR_INTERNAL,
+            NULL,
+            "Unknown intersection type: %d\n",
+            type);
         result = false;
         break;
     }
@@ -704,8 +1454,12 @@ static bool is_valid_directions_pair(const direction_t directions[MAX_DIRECTIONS
         }
     }
 
-    fprintf(stderr, "Invalid direction combination: %d and %d\n",
-            directions[0].type, directions[1].type);
+    config_report_error(
+        CONFIG_ERROR_RULE,
+        "directions",
+        "Invalid direction combination: %d and %d\n",
+        directions[0].type,
+        directions[1].type);
 
     return false;
 }
@@ -722,7 +1476,21 @@ static bool validate_detector_config(
     {
         if (det_ptr == NULL)
         {
-            fprintf(stderr, "Assertion error in validate_detector_config\n");
+            config_report_error(
+                CONFIG_ERROR_INTERNAL,
+                NULL,
+                "Assertion error in validate_detector_config\n");
+            break;
+        }
+
+        // A pulse cannot hold a non-lock call, the call would drop right away
+        if (det_ptr->memory == DETECTOR_MEMORY_NON_LOCK &&
+            det_ptr->mode == DETECTOR_MODE_PULSE)
+        {
+            config_report_error(
+                CONFIG_ERROR_RULE,
+                "mode",
+                "Non-lock memory detector must operate in presence mode\n");
             break;
         }
 
@@ -730,7 +1498,10 @@ static bool validate_detector_config(
         {
             if (det_ptr->distance == 0)
             {
-                fprintf(stderr, "Main road cannot have a stop line detector\n");
+                config_report_error(
+                    CONFIG_ERROR_RULE,
+                    "distance",
+                    "Main road cannot have a stop line detector\n");
                 break;
             }
 
@@ -753,181 +1524,681 @@ static bool validate_detector_config(
                     {
                         if (speed_limit == loop_distances[i].speed)
                         {
-                            if (det_ptr->distance != loop_distances[i].distance)
-                            {
-                                fprintf(stderr,
-                                        "Invalid setback detector distance %u for speed limit %u, "
-                                        "must be %u feet\n",
-                                        det_ptr->distance,
-                                        speed_limit,
-                                        loop_distances[i].distance);
-                                break;
-                            }
+                            break;
                         }
                     }
 
                     if (i == sizeof(loop_distances) / sizeof(speed_table_entry_t))
                     {
-                        fprintf(stderr,
-                                "Invalid speed limit %u for setback detector on main road, "
-                                "must be one of the following: 30, 35, 40, 45, 50, 55, 60 mph\n",
-                                speed_limit);
+                        config_report_error(
+                            CONFIG_ERROR_RULE,
+                            "distance",
+                            "Invalid speed limit %u for setback detector on main road, "
+                            "must be one of the following: 30, 35, 40, 45, 50, 55, 60 mph\n",
+                            speed_limit);
+                        break;
+                    }
+
+                    if (det_ptr->distance != loop_distances[i].distance)
+                    {
+                        config_report_range(
+                            "distance",
+                            det_ptr->distance,
+                            loop_distances[i].distance,
+                            loop_distances[i].distance,
+                            "Invalid setback detector distance %u for speed limit %u, "
+                            "must be %u feet\n",
+                            det_ptr->distance,
+                            speed_limit,
+                            loop_distances[i].distance);
                         break;
                     }
                 }
 
-                // Add more checks for other detector types if necessary
-            }
-            else if (det_ptr->distance > 0)
+                // Add more checks for other detector types if necessary
+            }
+            else if (det_ptr->distance > 0)
+            {
+                config_report_error(
+                    CONFIG_ERROR_RULE,
+                    "distance",
+                    "Main road cannot have a setback detector on a turn lane\n");
+                break;
+            }
+        }
+        else if (det_ptr->distance > 0)
+        {
+            config_report_error(
+                CONFIG_ERROR_RULE,
+                "distance",
+                "Non-main roads cannot have a setback detector\n");
+            break;
+        }
+        else if (det_ptr->memory != DETECTOR_MEMORY_NON_LOCK)
+        {
+            config_report_error(
+                CONFIG_ERROR_RULE,
+                "memory",
+                "Non-main road stop line detectors must use non-lock memory\n");
+            break;
+        }
+
+        result = true;
+
+    } while (0);
+
+    return result;
+}
+
+static bool validate_direction_config(
+    const intersection_type_t type,
+    const direction_t *const dir_ptr,
+    const bool is_main_road,
+    const uint8_t speed_limit)
+{
+    bool result = false;
+
+    do
+    {
+        if (dir_ptr == NULL)
+        {
+            config_report_error(
+                CONFIG_ERROR_INTERNAL,
+                NULL,
+                "Assertion error in validate_direction_config\n");
+            break;
+        }
+
+        if (dir_ptr->straight.has_detector)
+        {
+            config_path_push("lanes.straight.detector", CONFIG_PATH_NO_INDEX);
+            bool is_valid = validate_detector_config(
+                &dir_ptr->straight.detector,
+                is_main_road,
+                true,
+                speed_limit);
+            config_path_pop();
+
+            if (!is_valid)
+            {
+                config_report_error(
+                    CONFIG_ERROR_NESTED,
+                    "lanes.straight.detector",
+                    "Invalid straight lane detector configuration\n");
+                break;
+            }
+        }
+        else if (is_main_road || speed_limit >= MIN_SETBACK_SPEED_LIMIT)
+        {
+            config_report_error(
+                CONFIG_ERROR_RULE,
+                "lanes.straight.detector",
+                "Setback detector must be present on a main road"
+                " or for speed limits at or above %u\n",
+                MIN_SETBACK_SPEED_LIMIT);
+            break;
+        }
+
+        if (dir_ptr->has_left)
+        {
+            if (!is_turn_lane_allowed(type, true))
+            {
+                config_report_error(
+                    CONFIG_ERROR_RULE,
+                    "lanes.left",
+                    "Left turn lane not allowed for intersection type %d\n",
+                    type);
+                break;
+            }
+
+            if (dir_ptr->left.has_detector)
+            {
+                config_path_push("lanes.left.detector", CONFIG_PATH_NO_INDEX);
+                bool is_valid = validate_detector_config(
+                    &dir_ptr->left.detector,
+                    is_main_road,
+                    false,
+                    speed_limit);
+                config_path_pop();
+
+                if (!is_valid)
+                {
+                    config_report_error(
+                        CONFIG_ERROR_NESTED,
+                        "lanes.left.detector",
+                        "Invalid left turn lane detector configuration\n");
+                    break;
+                }
+            }
+        }
+
+        if (dir_ptr->has_right)
+        {
+            if (!is_turn_lane_allowed(type, false))
+            {
+                config_report_error(
+                    CONFIG_ERROR_RULE,
+                    "lanes.right",
+                    "Right turn lane not allowed for intersection type %d\n",
+                    type);
+                break;
+            }
+
+            if (dir_ptr->right.has_detector)
+            {
+                config_path_push("lanes.right.detector", CONFIG_PATH_NO_INDEX);
+                bool is_valid = validate_detector_config(
+                    &dir_ptr->right.detector,
+                    is_main_road,
+                    false,
+                    speed_limit);
+                config_path_pop();
+
+                if (!is_valid)
+                {
+                    config_report_error(
+                        CONFIG_ERROR_NESTED,
+                        "lanes.right.detector",
+                        "Invalid right turn lane detector configuration\n");
+                    break;
+                }
+            }
+        }
+
+        result = true;
+
+    } while (0);
+
+    return result;
+}
+
+static bool validate_road_config(
+    const intersection_type_t type,
+    const road_t *const road_ptr,
+    const bool is_main_road)
+{
+    bool result = false;
+
+    do
+    {
+        if (road_ptr == NULL)
+        {
+            config_report_error(
+                CONFIG_ERROR_INTERNAL,
+                NULL,
+                "Assertion error in validate_road_config\n");
+            break;
+        }
+
+        size_t i;
+        for (i = 0; i < MAX_DIRECTIONS; i++)
+        {
+            config_path_push("directions", (uint32_t)i);
+            bool is_valid = validate_direction_config(
+                type,
+                &road_ptr->directions[i],
+                is_main_road,
+                road_ptr->speed_limit);
+            config_path_pop();
+
+            if (!is_valid)
+            {
+                break;
+            }
+        }
+
+        if (i != MAX_DIRECTIONS)
+        {
+            config_report_error(
+                CONFIG_ERROR_NESTED,
+                "directions",
+                "Invalid configuration for direction %lu\n",
+                i);
+            break;
+        }
+
+        result = true;
+
+    } while (0);
+
+    return result;
+}
+
+// Seconds a road needs per cycle: minimum green, yellow and red clearance
+static float min_phase_time(const phase_timing_t *const timing)
+{
+    return (float)timing->min_green + timing->yellow_time + timing->red_clearance;
+}
+
+static bool validate_plan_split(const config_t *const cfg_ptr, const timing_plan_t *const plan, const size_t index)
+{
+    const coordination_t *coord = &plan->coord;
+
+    if (plan->is_flash || coord->cycle_length == 0)
+    {
+        return true;
+    }
+
+    size_t main_index = cfg_ptr->main_road != NULL ? (size_t)(cfg_ptr->main_road - cfg_ptr->roads) : 0U;
+    float main_time = min_phase_time(&plan->timing[main_index]);
+    float side_time = min_phase_time(&plan->timing[1U - main_index]);
+    bool result = true;
+
+    if (index != CONFIG_BASE_PLAN)
+    {
+        config_path_push("plans", (uint32_t)(index - 1U));
+    }
+
+    config_path_push("coordination", CONFIG_PATH_NO_INDEX);
+
+    if ((float)coord->split < main_time)
+    {
+        config_report_error(
+            CONFIG_ERROR_RULE,
+            "split",
+            "Main road split %u is shorter than its minimum green and clearance of %.1f seconds\n",
+            coord->split,
+            main_time);
+        result = false;
+    }
+    else if ((float)(coord->cycle_length - coord->split) < side_time)
+    {
+        config_report_error(
+            CONFIG_ERROR_RULE,
+            "split",
+            "Side road split %u is shorter than its minimum green and clearance of %.1f seconds\n",
+            coord->cycle_length - coord->split,
+            side_time);
+        result = false;
+    }
+
+    config_path_pop();
+
+    if (index != CONFIG_BASE_PLAN)
+    {
+        config_path_pop();
+    }
+
+    return result;
+}
+
+/*Interface Functions*/
+
+void config_set_error_sink(config_error_sink_t *const sink)
+{
+    if (sink != NULL)
+    {
+        sink->count = 0;
+    }
+
+    error_sink = sink;
+}
+
+config_error_sink_t *config_swap_error_sink(config_error_sink_t *const sink)
+{
+    config_error_sink_t *previous = error_sink;
+
+    error_sink = sink;
+
+    return previous;
+}
+
+void config_report_held(const config_error_sink_t *const held)
+{
+    uint32_t num_kept = held->count < held->capacity ? held->count : held->capacity;
+
+    for (uint32_t i = 0; i < held->count; i++)
+    {
+        if (error_sink == NULL)
+        {
+            char message[MAX_MESSAGE_LEN];
+
+            if (i < num_kept && config_error_message(&held->errors[i], message, sizeof(message)) >= 0)
             {
-                fprintf(stderr, "Main road cannot have a setback detector on a turn lane\n");
-                break;
+                fprintf(stderr, "%s\n", message); // Formatted without the newline of the format
             }
         }
-        else if (det_ptr->distance > 0)
+        else if (error_sink->count++ < error_sink->capacity && error_sink->errors != NULL && i < num_kept)
         {
-            fprintf(stderr, "Non-main roads cannot have a setback detector\n");
-            break;
+            error_sink->errors[error_sink->count - 1U] = held->errors[i];
         }
+    }
+}
 
-        result = true;
+void config_path_reset(void)
+{
+    path_stack.depth = 0;
+}
 
-    } while (0);
+void config_path_push(const char *const key, const uint32_t index)
+{
+    if (path_stack.depth < CONFIG_PATH_DEPTH)
+    {
+        path_stack.elems[path_stack.depth].key = key;
+        path_stack.elems[path_stack.depth].index = index;
+    }
 
-    return result;
+    path_stack.depth++; // Counted past the limit so pops stay balanced
 }
 
-static bool validate_direction_config(
-    const intersection_type_t type,
-    const direction_t *const dir_ptr,
-    const bool is_main_road,
-    const uint8_t speed_limit)
+void config_path_pop(void)
 {
-    bool result = false;
+    if (path_stack.depth > 0)
+    {
+        path_stack.depth--;
+    }
+}
 
-    do
+static config_error_t *record_error(
+    const config_error_code_t code,
+    const char *const field,
+    const char *const format)
+{
+    if (error_sink->count++ >= error_sink->capacity || error_sink->errors == NULL)
     {
-        if (dir_ptr == NULL)
-        {
-            fprintf(stderr, "Assertion error in validate_direction_config\n");
-            break;
-        }
+        return NULL;
+    }
 
-        if (dir_ptr->straight.has_detector)
+    config_error_t *error = &error_sink->errors[error_sink->count - 1U];
+    uint32_t depth = path_stack.depth < CONFIG_PATH_DEPTH ? path_stack.depth : CONFIG_PATH_DEPTH;
+
+    error->code = code;
+    error->format = format;
+    error->num_args = 0;
+    error->actual = NAN;
+    error->min = NAN;
+    error->max = NAN;
+    memcpy(error->path, path_stack.elems, depth * sizeof(config_path_elem_t));
+
+    if (field != NULL && depth < CONFIG_PATH_DEPTH)
+    {
+        error->path[depth].key = field;
+        error->path[depth].index = CONFIG_PATH_NO_INDEX;
+        depth++;
+    }
+
+    error->depth = (uint8_t)depth;
+
+    return error;
+}
+
+// Keeps the raw arguments of each conversion, the message is only formatted on request
+static void capture_args(config_error_t *const error, va_list args)
+{
+    size_t str_len = 0;
+    const char *pos = error->format;
+
+    while ((pos = strchr(pos, '%')) != NULL && error->num_args < CONFIG_ERROR_ARGS)
+    {
+        config_error_arg_t *arg = &error->args[error->num_args++];
+        const char *spec = pos++;
+        bool is_long = false;
+
+        pos += strspn(pos, "-+ #0123456789.");
+
+        while (*pos == 'l' || *pos == 'z')
         {
-            if (!validate_detector_config(
-                    &dir_ptr->straight.detector,
-                    is_main_road,
-                    true,
-                    speed_limit))
-            {
-                fprintf(stderr, "Invalid straight lane detector configuration\n");
-                break;
-            }
+            is_long = true;
+            pos++;
         }
-        else if (is_main_road || speed_limit >= MIN_SETBACK_SPEED_LIMIT)
+
+        arg->conv = *pos++;
+        arg->spec_offset = (uint16_t)(spec - error->format);
+        arg->spec_len = (uint8_t)(pos - spec);
+
+        switch (arg->conv)
         {
-            fprintf(
-                stderr,
-                "Setback detector must be present on a main road"
-                " or for speed limits at or above %u\n",
-                MIN_SETBACK_SPEED_LIMIT);
+        case 'd':
+        case 'i':
+            arg->value.i = is_long ? va_arg(args, long) : va_arg(args, int);
+            break;
+        case 'u':
+        case 'x':
+            arg->value.u = is_long ? va_arg(args, unsigned long) : va_arg(args, unsigned int);
+            break;
+        case 'f':
+        case 'g':
+        case 'e':
+            arg->value.f = va_arg(args, double);
+            break;
+        case 's':
+            arg->value.str = (uint16_t)str_len;
+            str_len += (size_t)snprintf(
+                &error->strings[str_len],
+                sizeof(error->strings) - str_len,
+                "%s",
+                va_arg(args, const char *));
+            str_len = str_len < sizeof(error->strings) ? str_len + 1U : sizeof(error->strings) - 1U;
+            break;
+        default: // "%%" takes no argument
             break;
         }
+    }
+}
 
-        if (dir_ptr->has_left)
-        {
-            if (!is_turn_lane_allowed(type, true))
-            {
-                fprintf(stderr, "Left turn lane not allowed for intersection type %d\n", type);
-                break;
-            }
+void config_report_error(
+    const config_error_code_t code,
+    const char *const field,
+    const char *const format,
+    ...)
+{
+    va_list args;
+    va_start(args, format);
 
-            if (dir_ptr->left.has_detector)
-            {
-                if (!validate_detector_config(
-                        &dir_ptr->left.detector,
-                        is_main_road,
-                        false,
-                        speed_limit))
-                {
-                    fprintf(stderr, "Invalid left turn lane detector configuration\n");
-                    break;
-                }
-            }
-        }
+    if (error_sink == NULL)
+    {
+        vfprintf(stderr, format, args);
+    }
+    else
+    {
+        config_error_t *error = record_error(code, field, format);
 
-        if (dir_ptr->has_right)
+        if (error != NULL)
         {
-            if (!is_turn_lane_allowed(type, false))
-            {
-                fprintf(stderr, "Right turn lane not allowed for intersection type %d\n", type);
-                break;
-            }
+            capture_args(error, args);
+        }
+    }
 
-            if (dir_ptr->right.has_detector)
-            {
-                if (!validate_detector_config(
-                        &dir_ptr->right.detector,
-                        is_main_road,
-                        false,
-                        speed_limit))
-                {
-                    fprintf(stderr, "Invalid right turn lane detector configuration\n");
-                    break;
-                }
-            }
+    va_end(args);
+}
+
+void config_report_range(
+    const char *const field,
+    const double actual,
+    const double min,
+    const double max,
+    const char *const format,
+    ...)
+{
+    va_list args;
+    va_start(args, format);
+
+    if (error_sink == NULL)
+    {
+        vfprintf(stderr, format, args);
+    }
+    else
+    {
+        config_error_t *error = record_error(CONFIG_ERROR_RANGE, field, format);
+
+        if (error != NULL)
+        {
+            error->actual = actual;
+            error->min = min;
+            error->max = max;
+            capture_args(error, args);
         }
+    }
 
-        result = true;
+    va_end(args);
+}
 
-    } while (0);
+// Appends like snprintf, len keeps counting once buf is full
+static void append(char *const buf, const size_t size, size_t *const len, const char *const format, ...)
+    __attribute__((format(printf, 4, 5)));
 
-    return result;
+static void append(char *const buf, const size_t size, size_t *const len, const char *const format, ...)
+{
+    va_list args;
+    va_start(args, format);
+
+    int n = vsnprintf(*len < size ? &buf[*len] : NULL, *len < size ? size - *len : 0, format, args);
+    *len += n > 0 ? (size_t)n : 0;
+
+    va_end(args);
 }
 
-static bool validate_road_config(
-    const intersection_type_t type,
-    const road_t *const road_ptr,
-    const bool is_main_road)
+int config_error_path(const config_error_t *const error, char *const buf, const size_t size)
 {
-    bool result = false;
+    size_t len = 0;
 
-    do
+    if (error == NULL)
     {
-        if (road_ptr == NULL)
+        return -1;
+    }
+
+    if (size > 0)
+    {
+        buf[0] = '\0';
+    }
+
+    for (size_t i = 0; i < error->depth; i++)
+    {
+        append(buf, size, &len, "%s%s", i > 0 ? "." : "", error->path[i].key);
+
+        if (error->path[i].index != CONFIG_PATH_NO_INDEX)
         {
-            fprintf(stderr, "Assertion error in validate_road_config\n");
-            break;
+            append(buf, size, &len, "[%u]", error->path[i].index);
         }
+    }
 
-        size_t i;
-        for (i = 0; i < MAX_DIRECTIONS; i++)
+    return (int)len;
+}
+
+int config_error_message(const config_error_t *const error, char *const buf, const size_t size)
+{
+    size_t len = 0;
+    size_t pos = 0;
+
+    if (error == NULL || error->format == NULL)
+    {
+        return -1;
+    }
+
+    if (size > 0)
+    {
+        buf[0] = '\0';
+    }
+
+    for (size_t i = 0; i < error->num_args; i++)
+    {
+        const config_error_arg_t *arg = &error->args[i];
+        char spec[16];
+        size_t spec_len = 0;
+
+        append(buf, size, &len, "%.*s", (int)(arg->spec_offset - pos), &error->format[pos]);
+        pos = arg->spec_offset + arg->spec_len;
+
+        // Flags, width and precision of the original conversion without its length modifier
+        for (size_t j = 0; j + 1U < arg->spec_len && spec_len + 4U < sizeof(spec); j++)
         {
-            if (!validate_direction_config(
-                    type,
-                    &road_ptr->directions[i],
-                    is_main_road,
-                    road_ptr->speed_limit))
+            char c = error->format[arg->spec_offset + j];
+
+            if (c != 'l' && c != 'z')
             {
-                break;
+                spec[spec_len++] = c;
             }
         }
 
-        if (i != MAX_DIRECTIONS)
+        switch (arg->conv)
         {
-            fprintf(stderr, "Invalid configuration for direction %lu\n", i);
+        case 'd':
+        case 'i':
+            snprintf(&spec[spec_len], sizeof(spec) - spec_len, "ll%c", arg->conv);
+            append(buf, size, &len, spec, arg->value.i);
+            break;
+        case 'u':
+        case 'x':
+            snprintf(&spec[spec_len], sizeof(spec) - spec_len, "ll%c", arg->conv);
+            append(buf, size, &len, spec, arg->value.u);
+            break;
+        case 'f':
+        case 'g':
+        case 'e':
+            snprintf(&spec[spec_len], sizeof(spec) - spec_len, "%c", arg->conv);
+            append(buf, size, &len, spec, arg->value.f);
+            break;
+        case 's':
+            append(buf, size, &len, "%s", &error->strings[arg->value.str]);
+            break;
+        default:
+            append(buf, size, &len, "%%");
             break;
         }
+    }
 
-        result = true;
+    // The rest of the format without its trailing newline
+    size_t rest = strcspn(&error->format[pos], "\n");
+    append(buf, size, &len, "%.*s", (int)rest, &error->format[pos]);
 
-    } while (0);
+    return (int)len;
+}
 
-    return result;
+const char *config_error_code_str(const config_error_code_t code)
+{
+    static const char *const code_strs[] = {
+        [CONFIG_ERROR_INTERNAL] = "internal",
+        [CONFIG_ERROR_FILE] = "file",
+        [CONFIG_ERROR_MISSING] = "missing",
+        [CONFIG_ERROR_RANGE] = "range",
+        [CONFIG_ERROR_LENGTH] = "length",
+        [CONFIG_ERROR_UNKNOWN] = "unknown",
+        [CONFIG_ERROR_DUPLICATE] = "duplicate",
+        [CONFIG_ERROR_RULE] = "rule",
+        [CONFIG_ERROR_NESTED] = "nested"};
+
+    return (unsigned)code < sizeof(code_strs) / sizeof(code_strs[0]) ? code_strs[code] : "unknown";
 }
 
-/*Interface Functions*/
+#ifndef CONFIG_STREAM_PARSER
+/*
+ * json_object_from_file records failures in a process wide buffer, a
+ * private tokener keeps concurrent loads on worker threads independent.
+ */
+static json_object *parse_file(const char *const filename)
+{
+    json_object *root = NULL;
+    const char *data = MAP_FAILED;
+    size_t size = 0;
+    int fd = open(filename, O_RDONLY);
+    struct stat st;
+
+    if (fd >= 0 && fstat(fd, &st) == 0 && st.st_size > 0 && st.st_size <= INT_MAX)
+    {
+        size = (size_t)st.st_size;
+        data = mmap(NULL, size, PROT_READ, MAP_PRIVATE, fd, 0);
+    }
+
+    if (fd >= 0)
+    {
+        close(fd);
+    }
+
+    if (data != MAP_FAILED)
+    {
+        json_tokener *tok = json_tokener_new();
+
+        if (tok != NULL)
+        {
+            root = json_tokener_parse_ex(tok, data, (int)size);
+            json_tokener_free(tok);
+        }
+
+        munmap((void *)data, size);
+    }
+
+    return root;
+}
 
 bool config_load(config_t *config, const char *filename)
 {
@@ -938,15 +2209,21 @@ bool config_load(config_t *config, const char *filename)
     {
         if (config == NULL || filename == NULL)
         {
-            fprintf(stderr, "Assertion error in load_config\n");
+            config_report_error(CONFIG_ERROR_INTERNAL, NULL, "Assertion error in load_config\n");
             break;
         }
 
+        config_path_reset();
+
         // Load JSON file
-        root = json_object_from_file(filename);
+        root = parse_file(filename);
         if (root == NULL)
         {
-            fprintf(stderr, "Failed to load config file: %s\n", filename);
+            config_report_error(
+                CONFIG_ERROR_FILE,
+                NULL,
+                "Failed to load config file: %s\n",
+                filename);
             break;
         }
 
@@ -955,7 +2232,10 @@ bool config_load(config_t *config, const char *filename)
         // Parse intersection ID (required)
         if (!json_object_object_get_ex(root, "intersection_id", &temp_obj))
         {
-            fprintf(stderr, "Missing intersection_id\n");
+            config_report_error(
+                CONFIG_ERROR_MISSING,
+                "intersection_id",
+                "Missing intersection_id\n");
             break;
         }
 
@@ -964,7 +2244,7 @@ bool config_load(config_t *config, const char *filename)
         // Parse intersection type (required)
         if (!json_object_object_get_ex(root, "type", &temp_obj))
         {
-            fprintf(stderr, "Missing intersection type\n");
+            config_report_error(CONFIG_ERROR_MISSING, "type", "Missing intersection type\n");
             break;
         }
 
@@ -972,8 +2252,11 @@ bool config_load(config_t *config, const char *filename)
 
         if (config->intersect_type < INTERSECTION_TYPE_1 || config->intersect_type > INTERSECTION_TYPE_4)
         {
-            fprintf(
-                stderr,
+            config_report_range(
+                "type",
+                config->intersect_type + 1,
+                1,
+                4,
                 "Invalid intersection type, must be a number from 1 to 4, "
                 "but got %d\n",
                 config->intersect_type);
@@ -989,9 +2272,10 @@ bool config_load(config_t *config, const char *filename)
 
         // Parse roads array (required)
         if (!json_object_object_get_ex(root, "roads", &temp_obj) ||
+            !json_object_is_type(temp_obj, json_type_array) ||
             (json_object_array_length(temp_obj) != MAX_ROADS))
         {
-            fprintf(stderr, "Missing or invalid roads array\n");
+            config_report_error(CONFIG_ERROR_MISSING, "roads", "Missing or invalid roads array\n");
             break;
         }
 
@@ -1002,9 +2286,17 @@ bool config_load(config_t *config, const char *filename)
         {
             road_obj = json_object_array_get_idx(temp_obj, i);
 
-            if (!parse_road(road_obj, &config->roads[i]))
+            config_path_push("roads", (uint32_t)i);
+            bool is_parsed = parse_road(road_obj, &config->roads[i]);
+            config_path_pop();
+
+            if (!is_parsed)
             {
-                fprintf(stderr, "Failed to parse road %lu\n", i);
+                config_report_error(
+                    CONFIG_ERROR_NESTED,
+                    "roads",
+                    "Failed to parse road %lu\n",
+                    i);
                 break;
             }
 
@@ -1018,20 +2310,165 @@ bool config_load(config_t *config, const char *filename)
 
         if (i != MAX_ROADS)
         {
-            fprintf(stderr, "Failed to parse road %lu\n", i);
+            config_report_error(
+                CONFIG_ERROR_NESTED,
+                "roads",
+                "Failed to parse road %lu\n",
+                i);
             break;
         }
 
         if (main_road_id != NULL && config->main_road == NULL)
         {
-            fprintf(stderr, "No matching entry for the main road found\n");
+            config_report_error(
+                CONFIG_ERROR_UNKNOWN,
+                "main_road",
+                "No matching entry for the main road found\n");
             break;
         }
 
-        // Parse timing parameters (required)
-        if (!json_object_object_get_ex(root, "timing", &temp_obj))
+        // Parse corridor position (optional)
+        if (json_object_object_get_ex(root, "corridor_position", &temp_obj))
+        {
+            int position = json_object_get_int(temp_obj);
+
+            if (position < 0 || position > (int)MAX_CORRIDOR_POSITION)
+            {
+                config_report_range(
+                    "corridor_position",
+                    position,
+                    0,
+                    MAX_CORRIDOR_POSITION,
+                    "Invalid corridor position %d, "
+                    "must be within 0 to %u feet\n",
+                    position,
+                    MAX_CORRIDOR_POSITION);
+                break;
+            }
+
+            config->corridor_position = (uint32_t)position;
+        }
+
+        // Parse coordination of the base plan (optional, runs free without)
+        if (json_object_object_get_ex(root, "coordination", &temp_obj))
+        {
+            config_path_push("coordination", CONFIG_PATH_NO_INDEX);
+            bool is_parsed = parse_coordination(temp_obj, &config->plans[CONFIG_BASE_PLAN].coord);
+            config_path_pop();
+
+            if (!is_parsed)
+            {
+                break;
+            }
+        }
+
+        // Parse timing plans (optional), they follow the base plan
+        config->num_plans = 1U;
+
+        if (json_object_object_get_ex(root, "plans", &temp_obj))
+        {
+            if (!json_object_is_type(temp_obj, json_type_array))
+            {
+                config_report_error(CONFIG_ERROR_MISSING, "plans", "Missing or invalid plans array\n");
+                break;
+            }
+
+            size_t num_plans = json_object_array_length(temp_obj);
+
+            if (num_plans > MAX_PLANS - 1U)
+            {
+                config_report_range(
+                    "plans",
+                    num_plans,
+                    0,
+                    MAX_PLANS - 1U,
+                    "Too many timing plans %lu, "
+                    "must be not more than %u\n",
+                    num_plans,
+                    MAX_PLANS - 1U);
+                break;
+            }
+
+            for (i = 0; i < num_plans; i++)
+            {
+                config_path_push("plans", (uint32_t)i);
+                bool is_parsed = parse_plan(json_object_array_get_idx(temp_obj, i), &config->plans[i + 1U]);
+                config_path_pop();
+
+                if (!is_parsed)
+                {
+                    break;
+                }
+
+                config->num_plans++;
+            }
+
+            if (i != num_plans)
+            {
+                config_report_error(
+                    CONFIG_ERROR_NESTED,
+                    "plans",
+                    "Failed to parse plan %lu\n",
+                    i);
+                break;
+            }
+        }
+
+        // Parse schedule (optional), the base plan runs all week without one
+        config_schedule_entry_t entries[MAX_SCHEDULE_ENTRIES];
+        size_t num_entries = 0;
+
+        if (json_object_object_get_ex(root, "schedule", &temp_obj))
+        {
+            if (!json_object_is_type(temp_obj, json_type_array))
+            {
+                config_report_error(CONFIG_ERROR_MISSING, "schedule", "Missing or invalid schedule array\n");
+                break;
+            }
+
+            num_entries = json_object_array_length(temp_obj);
+
+            if (num_entries > MAX_SCHEDULE_ENTRIES)
+            {
+                config_report_range(
+                    "schedule",
+                    num_entries,
+                    0,
+                    MAX_SCHEDULE_ENTRIES,
+                    "Too many schedule entries %lu, "
+                    "must be not more than %u\n",
+                    num_entries,
+                    MAX_SCHEDULE_ENTRIES);
+                break;
+            }
+
+            for (i = 0; i < num_entries; i++)
+            {
+                memset(&entries[i], 0, sizeof(entries[i]));
+
+                config_path_push("schedule", (uint32_t)i);
+                bool is_parsed = parse_schedule_entry(json_object_array_get_idx(temp_obj, i), &entries[i]);
+                config_path_pop();
+
+                if (!is_parsed)
+                {
+                    break;
+                }
+            }
+
+            if (i != num_entries)
+            {
+                config_report_error(
+                    CONFIG_ERROR_NESTED,
+                    "schedule",
+                    "Failed to parse schedule entry %lu\n",
+                    i);
+                break;
+            }
+        }
+
+        if (!config_build_plans(config, entries, num_entries))
         {
-            fprintf(stderr, "Missing timing parameters\n");
             break;
         }
 
@@ -1046,6 +2483,7 @@ bool config_load(config_t *config, const char *filename)
 
     return status;
 }
+#endif // CONFIG_STREAM_PARSER
 
 bool config_validate(const config_t *const cfg_ptr)
 {
@@ -1055,16 +2493,23 @@ bool config_validate(const config_t *const cfg_ptr)
     {
         if (cfg_ptr == NULL)
         {
-            fprintf(stderr, "Assertion error in config_validate\n");
+            config_report_error(
+                CONFIG_ERROR_INTERNAL,
+                NULL,
+                "Assertion error in config_validate\n");
             break;
         }
 
+        config_path_reset();
+
         bool found_duplicate = false;
         char seen_names[MAX_ROADS][MAX_STR_LEN] = {0};
         direction_pair_t seen_dir_pairs[MAX_ROADS] = {0};
         size_t i;
         for (i = 0; i < MAX_ROADS; i++)
         {
+            config_path_push("roads", (uint32_t)i);
+
             // Check for duplicate road names and direction pairs
             for (size_t j = 0; j < i; j++)
             {
@@ -1073,8 +2518,9 @@ bool config_validate(const config_t *const cfg_ptr)
                         cfg_ptr->roads[i].name,
                         MAX_STR_LEN) == 0)
                 {
-                    fprintf(
-                        stderr,
+                    config_report_error(
+                        CONFIG_ERROR_DUPLICATE,
+                        "name",
                         "Duplicate road name found: %s\n",
                         cfg_ptr->roads[i].name);
                     found_duplicate = true;
@@ -1086,8 +2532,9 @@ bool config_validate(const config_t *const cfg_ptr)
                     (seen_dir_pairs[j].dir2 == cfg_ptr->roads[i].directions[0].type &&
                      seen_dir_pairs[j].dir1 == cfg_ptr->roads[i].directions[1].type))
                 {
-                    fprintf(
-                        stderr,
+                    config_report_error(
+                        CONFIG_ERROR_DUPLICATE,
+                        "directions",
                         "Duplicate direction pair found for road %s\n",
                         cfg_ptr->roads[i].name);
                     found_duplicate = true;
@@ -1109,8 +2556,9 @@ bool config_validate(const config_t *const cfg_ptr)
             }
             else
             {
-                fprintf(
-                    stderr,
+                config_report_error(
+                    CONFIG_ERROR_NESTED,
+                    "directions",
                     "Invalid direction combination for road %s\n",
                     cfg_ptr->roads[i].name);
 
@@ -1124,12 +2572,33 @@ bool config_validate(const config_t *const cfg_ptr)
                     &cfg_ptr->roads[i],
                     is_main_road))
             {
-                fprintf(stderr, "Invalid configuration for road %lu\n", i);
+                config_report_error(
+                    CONFIG_ERROR_NESTED,
+                    NULL,
+                    "Invalid configuration for road %lu\n",
+                    i);
                 break;
             }
+
+            config_path_pop();
         }
 
         if (i != MAX_ROADS)
+        {
+            config_path_pop();
+            break;
+        }
+
+        // Each road must fit its minimum green and clearance into its share of the cycle
+        for (i = 0; i < cfg_ptr->num_plans; i++)
+        {
+            if (!validate_plan_split(cfg_ptr, &cfg_ptr->plans[i], i))
+            {
+                break;
+            }
+        }
+
+        if (i != cfg_ptr->num_plans)
         {
             break;
         }
@@ -0,0 +1,256 @@
+#include "config_cache.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <limits.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+#define FNV_OFFSET_BASIS 0xcbf29ce484222325ULL
+#define FNV_PRIME 0x100000001b3ULL
+
+static uint64_t fnv1a(const void *const data, const size_t size)
+{
+    const uint8_t *bytes = data;
+    uint64_t hash = FNV_OFFSET_BASIS;
+
+    for (size_t i = 0; i < size; i++)
+    {
+        hash ^= bytes[i];
+        hash *= FNV_PRIME;
+    }
+
+    return hash;
+}
+
+// Maps a whole file read-only, returns NULL for missing or empty files
+static const void *map_file(const char *const filename, size_t *const size)
+{
+    const void *data = NULL;
+    int fd = open(filename, O_RDONLY);
+    struct stat st;
+
+    if (fd >= 0 && fstat(fd, &st) == 0 && st.st_size > 0)
+    {
+        data = mmap(NULL, (size_t)st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+        data = (data == MAP_FAILED) ? NULL : data;
+        *size = (size_t)st.st_size;
+    }
+
+    if (fd >= 0)
+    {
+        close(fd);
+    }
+
+    return data;
+}
+
+static bool hash_source(const char *const filename, uint64_t *const hash)
+{
+    size_t size;
+    const void *data = map_file(filename, &size);
+
+    if (data == NULL)
+    {
+        return false;
+    }
+
+    *hash = fnv1a(data, size);
+    munmap((void *)data, size);
+
+    return true;
+}
+
+static bool cache_path(char *const path, const char *const filename)
+{
+    int len = snprintf(path, PATH_MAX, "%s%s", filename, CONFIG_CACHE_EXT);
+
+    return len > 0 && len < PATH_MAX;
+}
+
+bool config_cache_compile(const char *const filename)
+{
+    bool result = false;
+    FILE *file = NULL;
+    char path[PATH_MAX];
+    char tmp_path[PATH_MAX];
+    config_t config;
+
+    do
+    {
+        if (filename == NULL)
+        {
+            fprintf(stderr, "Assertion error in config_cache_compile\n");
+            break;
+        }
+
+        if (!cache_path(path, filename) ||
+            snprintf(tmp_path, sizeof(tmp_path), "%s.tmp", path) >= (int)sizeof(tmp_path))
+        {
+            fprintf(stderr, "Config path too long: %s\n", filename);
+            break;
+        }
+
+        // Padding bytes are part of the checksummed image, keep them zero
+        memset(&config, 0, sizeof(config));
+
+        if (!config_load(&config, filename) || !config_validate(&config))
+        {
+            fprintf(stderr, "Invalid configuration: %s\n", filename);
+            break;
+        }
+
+        config_cache_header_t header = {
+            .magic = CONFIG_CACHE_MAGIC,
+            .version = CONFIG_CACHE_VERSION,
+            .config_size = sizeof(config_t),
+            .main_road = config.main_road != NULL ? (uint32_t)(config.main_road - config.roads)
+                                                  : CONFIG_CACHE_NO_MAIN_ROAD};
+
+        config.main_road = NULL;
+
+        if (!hash_source(filename, &header.source_hash))
+        {
+            fprintf(stderr, "Failed to read config file: %s\n", filename);
+            break;
+        }
+
+        header.checksum = fnv1a(&config, sizeof(config));
+
+        // Write to a temporary file and rename, a running loader never sees a partial image
+        file = fopen(tmp_path, "wb");
+        if (file == NULL)
+        {
+            fprintf(stderr, "Failed to create config cache: %s\n", tmp_path);
+            break;
+        }
+
+        bool is_written = fwrite(&header, sizeof(header), 1, file) == 1 &&
+                          fwrite(&config, sizeof(config), 1, file) == 1;
+
+        if (fclose(file) != 0 || !is_written)
+        {
+            file = NULL;
+            fprintf(stderr, "Failed to write config cache: %s\n", tmp_path);
+            unlink(tmp_path);
+            break;
+        }
+
+        file = NULL;
+
+        if (rename(tmp_path, path) != 0)
+        {
+            fprintf(stderr, "Failed to replace config cache: %s\n", path);
+            unlink(tmp_path);
+            break;
+        }
+
+        result = true;
+
+    } while (0);
+
+    if (file != NULL)
+    {
+        fclose(file);
+        unlink(tmp_path);
+    }
+
+    return result;
+}
+
+bool config_cache_load(config_t *const config, const char *const filename)
+{
+    bool result = false;
+    const void *image = NULL;
+    size_t size = 0;
+    char path[PATH_MAX];
+
+    do
+    {
+        if (config == NULL || filename == NULL)
+        {
+            fprintf(stderr, "Assertion error in config_cache_load\n");
+            break;
+        }
+
+        if (!cache_path(path, filename))
+        {
+            break;
+        }
+
+        image = map_file(path, &size);
+        if (image == NULL)
+        {
+            break; // No image compiled for this source
+        }
+
+        const config_cache_header_t *header = image;
+
+        if (size != sizeof(config_cache_header_t) + sizeof(config_t) ||
+            header->magic != CONFIG_CACHE_MAGIC ||
+            header->version != CONFIG_CACHE_VERSION ||
+            header->config_size != sizeof(config_t) ||
+            (header->main_road >= MAX_ROADS && header->main_road != CONFIG_CACHE_NO_MAIN_ROAD))
+        {
+            fprintf(stderr, "Ignoring incompatible config cache: %s\n", path);
+            break;
+        }
+
+        const void *body = header + 1;
+
+        if (fnv1a(body, sizeof(config_t)) != header->checksum)
+        {
+            fprintf(stderr, "Ignoring corrupt config cache: %s\n", path);
+            break;
+        }
+
+        uint64_t source_hash;
+
+        if (!hash_source(filename, &source_hash) || source_hash != header->source_hash)
+        {
+            fprintf(stderr, "Config cache is stale: %s\n", path);
+            break;
+        }
+
+        // The image is position independent apart from the main road
+        memcpy(config, body, sizeof(config_t));
+        config->main_road = header->main_road != CONFIG_CACHE_NO_MAIN_ROAD ? &config->roads[header->main_road]
+                                                                           : NULL;
+
+        result = true;
+
+    } while (0);
+
+    if (image != NULL)
+    {
+        munmap((void *)image, size);
+    }
+
+    return result;
+}
+
+bool config_load_cached(config_t *const config, const char *const filename)
+{
+    if (config_cache_load(config, filename))
+    {
+        return true;
+    }
+
+    memset(config, 0, sizeof(*config));
+
+    if (!config_load(config, filename))
+    {
+        fprintf(stderr, "Failed to load configuration\n");
+        return false;
+    }
+
+    if (!config_validate(config))
+    {
+        fprintf(stderr, "Invalid configuration\n");
+        return false;
+    }
+
+    return true;
+}
@@ -0,0 +1,162 @@
+#include "config_reload.h"
+#include "config_cache.h"
+#include <stdio.h>
+#include <string.h>
+#include <errno.h>
+
+// A slot the controller can neither be running nor be about to take
+static config_t *free_slot(config_reload_t *const reload)
+{
+    for (size_t i = 0; i < CONFIG_RELOAD_SLOTS; i++)
+    {
+        if (&reload->slots[i] != reload->active && &reload->slots[i] != reload->published)
+        {
+            return &reload->slots[i];
+        }
+    }
+
+    return NULL;
+}
+
+static void reload_config(config_reload_t *const reload)
+{
+    config_t *config = free_slot(reload);
+    controller_t scratch;
+
+    do
+    {
+        if (!config_load_cached(config, reload->path))
+        {
+            break;
+        }
+
+        if (config->intersect_type != reload->intersect_type)
+        {
+            fprintf(stderr, "Intersection type cannot change without a restart\n");
+            break;
+        }
+
+        // Compile it once here, switching over on the tick path then cannot fail
+        memset(&scratch, 0, sizeof(scratch));
+        scratch.config = config;
+        scratch.tick_ms = reload->controller->tick_ms;
+
+        if (!controller_init(&scratch))
+        {
+            break;
+        }
+
+        const config_t *unused = atomic_exchange_explicit(
+            &reload->controller->pending_config,
+            config,
+            memory_order_acq_rel);
+
+        // Taken by the controller unless it is still pending and now superseded
+        if (unused == NULL && reload->published != NULL)
+        {
+            reload->active = reload->published;
+        }
+
+        reload->published = config;
+        reload->num_published++;
+
+        printf("Reloaded %s, switching over at the next interval boundary, or at once while resting\n", reload->path);
+        return;
+
+    } while (0);
+
+    reload->num_failed++;
+    fprintf(stderr, "Config reload failed, keeping the current configuration\n");
+}
+
+static void *reload_main(void *arg)
+{
+    config_reload_t *reload = arg;
+
+    while (true)
+    {
+        if (sem_wait(&reload->request) != 0)
+        {
+            if (errno == EINTR)
+            {
+                continue;
+            }
+
+            fprintf(stderr, "Config reload request failed: %s\n", strerror(errno));
+            break;
+        }
+
+        if (atomic_load(&reload->is_stopping))
+        {
+            break;
+        }
+
+        reload_config(reload);
+    }
+
+    return NULL;
+}
+
+bool config_reload_start(config_reload_t *const reload, controller_t *const controller, const char *const path)
+{
+    bool result = false;
+
+    do
+    {
+        if (reload == NULL || controller == NULL || controller->config == NULL || path == NULL)
+        {
+            fprintf(stderr, "Assertion error in config_reload_start\n");
+            break;
+        }
+
+        memset(reload, 0, sizeof(*reload));
+        atomic_init(&reload->is_stopping, false);
+        reload->controller = controller;
+        reload->path = path;
+        reload->intersect_type = controller->config->intersect_type;
+        reload->active = controller->config;
+
+        if (sem_init(&reload->request, 0, 0) != 0)
+        {
+            fprintf(stderr, "Failed to create config reload semaphore\n");
+            break;
+        }
+
+        if (pthread_create(&reload->thread, NULL, reload_main, reload) != 0)
+        {
+            fprintf(stderr, "Failed to start config reload thread\n");
+            sem_destroy(&reload->request);
+            break;
+        }
+
+        reload->is_started = true;
+        result = true;
+
+    } while (0);
+
+    return result;
+}
+
+void config_reload_request(config_reload_t *const reload)
+{
+    if (reload->is_started)
+    {
+        sem_post(&reload->request);
+    }
+}
+
+void config_reload_stop(config_reload_t *const reload)
+{
+    if (!reload->is_started)
+    {
+        return;
+    }
+
+    atomic_store(&reload->is_stopping, true);
+    sem_post(&reload->request);
+    pthread_join(reload->thread, NULL);
+    sem_destroy(&reload->request);
+    reload->is_started = false;
+
+    printf("Config reload: %u published, %u failed\n", reload->num_published, reload->num_failed);
+}
@@ -0,0 +1,2543 @@
+/*
+ * Single pass config parser. Reads the mapped JSON document once and fills
+ * config_t straight from the token stream, without building a DOM and
+ * without heap allocation. config_load runs it instead of the json-c
+ * parser in config.c when CONFIG_STREAM_PARSER is defined (make
+ * CONFIG_PARSER=stream).
+ *
+ * Members may appear in any order, so each object records which members it
+ * has seen and checks them, in the order of the json-c parser, once the
+ * object is closed. Nested objects are checked as soon as they are read,
+ * and their errors held back until the check of the member they belong to,
+ * so both parsers report the same first error.
+ * Like json_object_from_file, anything after the document is ignored.
+ */
+
+#include "config_stream.h"
+#include "config_parse.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <math.h>
+#include <string.h>
+#include <limits.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+#define MAX_KEY_LEN 32U      // Longer keys are unknown and skipped
+#define MAX_NUMBER_LEN 64U   // Longest accepted number literal
+#define MAX_NESTING_DEPTH 32U // Bounds recursion when skipping unknown values
+#define MAX_HELD_ERRORS 8U    // Per nested member, an error per level and the repeated ones
+
+typedef enum
+{
+    JSON_NULL,
+    JSON_BOOLEAN,
+    JSON_NUMBER,
+    JSON_STRING,
+    JSON_CONTAINER // Object or array read as a scalar, already checked and skipped
+} json_type_t;
+
+// Read position in a mapped JSON document
+typedef struct
+{
+    const char *pos;
+    const char *end;
+    bool is_error; // Malformed JSON, reported once by config_stream_load
+} json_stream_t;
+
+// Scalar member value, strings are decoded when converted
+typedef struct
+{
+    json_type_t type;
+    const char *text; // Number literal, string including its quotes, or container text
+    size_t len;
+    double number;
+    bool boolean;
+} json_scalar_t;
+
+typedef enum
+{
+    LANE_GROUP_STRAIGHT,
+    LANE_GROUP_LEFT,
+    LANE_GROUP_RIGHT,
+    NUM_LANE_GROUPS
+} lane_group_index_t;
+
+// Errors of a nested member, held back until the json-c parser would reach it
+typedef struct
+{
+    config_error_sink_t sink;
+    config_error_t errors[MAX_HELD_ERRORS];
+} held_errors_t;
+
+// Position in an object or array being iterated
+typedef struct
+{
+    bool is_open;
+    size_t count; // Members or elements read so far
+} json_iter_t;
+
+// Members seen in a timing object
+typedef struct
+{
+    bool has_yellow_time;
+    bool has_red_clearance;
+    bool has_min_green;
+    bool has_max_green;
+    bool has_passage_time;
+    bool has_ped_walk;
+    bool has_ped_clearance;
+} timing_fields_t;
+
+// Members seen in a coordination object
+typedef struct
+{
+    bool has_cycle_length;
+    bool has_offset;
+    bool has_split;
+} coordination_fields_t;
+
+/* Tokenizer */
+
+static bool fail(json_stream_t *const s)
+{
+    s->is_error = true;
+    return false;
+}
+
+static char peek(json_stream_t *const s)
+{
+    while (s->pos < s->end &&
+           (*s->pos == ' ' || *s->pos == '\t' || *s->pos == '\n' || *s->pos == '\r'))
+    {
+        s->pos++;
+    }
+
+    return s->pos < s->end ? *s->pos : '\0';
+}
+
+static bool consume(json_stream_t *const s, const char c)
+{
+    if (peek(s) != c)
+    {
+        return fail(s);
+    }
+
+    s->pos++;
+    return true;
+}
+
+static bool consume_literal(json_stream_t *const s, const char *const literal, const size_t len)
+{
+    if ((size_t)(s->end - s->pos) < len || memcmp(s->pos, literal, len) != 0)
+    {
+        return fail(s);
+    }
+
+    s->pos += len;
+    return true;
+}
+
+static bool read_hex4(json_stream_t *const s, uint32_t *const code)
+{
+    *code = 0;
+
+    for (size_t i = 0; i < 4U; i++)
+    {
+        char c = s->pos < s->end ? *s->pos++ : '\0';
+        uint32_t digit;
+
+        if (c >= '0' && c <= '9')
+        {
+            digit = (uint32_t)(c - '0');
+        }
+        else if (c >= 'a' && c <= 'f')
+        {
+            digit = (uint32_t)(c - 'a' + 10);
+        }
+        else if (c >= 'A' && c <= 'F')
+        {
+            digit = (uint32_t)(c - 'A' + 10);
+        }
+        else
+        {
+            return fail(s);
+        }
+
+        *code = (*code << 4) | digit;
+    }
+
+    return true;
+}
+
+static size_t utf8_encode(const uint32_t code, char *const buf)
+{
+    if (code < 0x80U)
+    {
+        buf[0] = (char)code;
+        return 1U;
+    }
+
+    if (code < 0x800U)
+    {
+        buf[0] = (char)(0xC0U | (code >> 6));
+        buf[1] = (char)(0x80U | (code & 0x3FU));
+        return 2U;
+    }
+
+    if (code < 0x10000U)
+    {
+        buf[0] = (char)(0xE0U | (code >> 12));
+        buf[1] = (char)(0x80U | ((code >> 6) & 0x3FU));
+        buf[2] = (char)(0x80U | (code & 0x3FU));
+        return 3U;
+    }
+
+    buf[0] = (char)(0xF0U | (code >> 18));
+    buf[1] = (char)(0x80U | ((code >> 12) & 0x3FU));
+    buf[2] = (char)(0x80U | ((code >> 6) & 0x3FU));
+    buf[3] = (char)(0x80U | (code & 0x3FU));
+    return 4U;
+}
+
+static bool read_escape(json_stream_t *const s, char *const buf, size_t *const len)
+{
+    char c = s->pos < s->end ? *s->pos++ : '\0';
+    uint32_t code;
+
+    *len = 1U;
+
+    switch (c)
+    {
+    case '"':
+    case '\\':
+    case '/':
+        buf[0] = c;
+        break;
+    case 'b':
+        buf[0] = '\b';
+        break;
+    case 'f':
+        buf[0] = '\f';
+        break;
+    case 'n':
+        buf[0] = '\n';
+        break;
+    case 'r':
+        buf[0] = '\r';
+        break;
+    case 't':
+        buf[0] = '\t';
+        break;
+    case 'u':
+        if (!read_hex4(s, &code))
+        {
+            return false;
+        }
+
+        // Combine a surrogate pair into a single code point
+        if (code >= 0xD800U && code < 0xDC00U &&
+            s->end - s->pos >= 6 && s->pos[0] == '\\' && s->pos[1] == 'u')
+        {
+            uint32_t low;
+
+            s->pos += 2;
+            if (!read_hex4(s, &low))
+            {
+                return false;
+            }
+
+            if (low >= 0xDC00U && low < 0xE000U)
+            {
+                code = 0x10000U + ((code - 0xD800U) << 10) + (low - 0xDC00U);
+            }
+        }
+
+        *len = utf8_encode(code, buf);
+        break;
+    default:
+        return fail(s);
+    }
+
+    return true;
+}
+
+// Decodes the string at the stream position into out, truncated like snprintf, or skips it
+static bool read_string(json_stream_t *const s, char *const out, const size_t out_size)
+{
+    size_t len = 0;
+
+    if (!consume(s, '"'))
+    {
+        return false;
+    }
+
+    while (s->pos < s->end && *s->pos != '"')
+    {
+        char buf[4];
+        size_t num_bytes = 1U;
+
+        if ((unsigned char)*s->pos < 0x20U)
+        {
+            return fail(s); // Unescaped control character
+        }
+
+        if (*s->pos == '\\')
+        {
+            s->pos++;
+
+            if (!read_escape(s, buf, &num_bytes))
+            {
+                return false;
+            }
+        }
+        else
+        {
+            buf[0] = *s->pos++;
+        }
+
+        for (size_t i = 0; i < num_bytes; i++)
+        {
+            if (out != NULL && len + 1U < out_size)
+            {
+                out[len++] = buf[i];
+            }
+        }
+    }
+
+    if (s->pos == s->end)
+    {
+        return fail(s); // Unterminated string
+    }
+
+    s->pos++;
+
+    if (out != NULL && out_size > 0)
+    {
+        out[len] = '\0';
+    }
+
+    return true;
+}
+
+static bool read_number(json_stream_t *const s, json_scalar_t *const value)
+{
+    char literal[MAX_NUMBER_LEN];
+
+    value->type = JSON_NUMBER;
+    value->text = s->pos;
+
+    while (s->pos < s->end && strchr("+-0123456789.eE", *s->pos) != NULL)
+    {
+        s->pos++;
+    }
+
+    value->len = (size_t)(s->pos - value->text);
+
+    if (value->len == 0 || value->len >= sizeof(literal))
+    {
+        return fail(s);
+    }
+
+    memcpy(literal, value->text, value->len);
+    literal[value->len] = '\0';
+
+    char *end;
+    value->number = strtod(literal, &end);
+
+    return (*end == '\0') ? true : fail(s);
+}
+
+static bool skip_value(json_stream_t *const s, const size_t depth);
+static bool read_scalar(json_stream_t *const s, json_scalar_t *const value);
+
+// A null member reads as a NULL json_object in the json-c parser
+static bool is_null(json_stream_t *const s)
+{
+    json_scalar_t value;
+
+    if (peek(s) != 'n')
+    {
+        return false;
+    }
+
+    read_scalar(s, &value);
+    return true;
+}
+
+static bool read_scalar(json_stream_t *const s, json_scalar_t *const value)
+{
+    char c = peek(s);
+
+    memset(value, 0, sizeof(*value));
+
+    if (c == '"')
+    {
+        value->type = JSON_STRING;
+        value->text = s->pos;
+
+        if (!read_string(s, NULL, 0))
+        {
+            return false;
+        }
+
+        value->len = (size_t)(s->pos - value->text);
+        return true;
+    }
+
+    if (c == '-' || (c >= '0' && c <= '9'))
+    {
+        return read_number(s, value);
+    }
+
+    if (c == 't' || c == 'f')
+    {
+        value->type = JSON_BOOLEAN;
+        value->boolean = (c == 't');
+        return value->boolean ? consume_literal(s, "true", 4U) : consume_literal(s, "false", 5U);
+    }
+
+    if (c == 'n')
+    {
+        value->type = JSON_NULL;
+        return consume_literal(s, "null", 4U);
+    }
+
+    if (c == '{' || c == '[')
+    {
+        value->type = JSON_CONTAINER;
+        value->text = s->pos;
+
+        if (!skip_value(s, 0))
+        {
+            return false;
+        }
+
+        value->len = (size_t)(s->pos - value->text);
+        return true;
+    }
+
+    return fail(s);
+}
+
+static bool skip_value(json_stream_t *const s, const size_t depth)
+{
+    char open = peek(s);
+    char close = (open == '{') ? '}' : ']';
+    json_scalar_t value;
+
+    if (open != '{' && open != '[')
+    {
+        return read_scalar(s, &value);
+    }
+
+    if (depth == MAX_NESTING_DEPTH)
+    {
+        return fail(s);
+    }
+
+    s->pos++;
+
+    for (size_t count = 0; peek(s) != close; count++)
+    {
+        if (count > 0 && !consume(s, ','))
+        {
+            return false;
+        }
+
+        if (open == '{' && (!read_string(s, NULL, 0) || !consume(s, ':')))
+        {
+            return false;
+        }
+
+        if (!skip_value(s, depth + 1U))
+        {
+            return false;
+        }
+    }
+
+    s->pos++;
+    return true;
+}
+
+/* Object and array iteration */
+
+// Enters an object, a value of any other type is skipped and reads as an empty object
+static void object_begin(json_stream_t *const s, json_iter_t *const it)
+{
+    it->count = 0;
+    it->is_open = (peek(s) == '{');
+
+    if (it->is_open)
+    {
+        s->pos++;
+    }
+    else
+    {
+        skip_value(s, 0);
+    }
+}
+
+// Reads the next member key, the stream is then positioned at its value
+static bool object_next(json_stream_t *const s, json_iter_t *const it, char *const key, const size_t key_size)
+{
+    if (!it->is_open || s->is_error)
+    {
+        return false;
+    }
+
+    if (peek(s) == '}')
+    {
+        s->pos++;
+        it->is_open = false;
+        return false;
+    }
+
+    if ((it->count > 0 && !consume(s, ',')) ||
+        !read_string(s, key, key_size) ||
+        !consume(s, ':'))
+    {
+        it->is_open = false;
+        return false;
+    }
+
+    it->count++;
+    return true;
+}
+
+// Enters an array, returns false and skips the value if it is not one
+static bool array_begin(json_stream_t *const s, json_iter_t *const it)
+{
+    it->count = 0;
+    it->is_open = (peek(s) == '[');
+
+    if (it->is_open)
+    {
+        s->pos++;
+    }
+    else
+    {
+        skip_value(s, 0);
+    }
+
+    return it->is_open;
+}
+
+static bool array_next(json_stream_t *const s, json_iter_t *const it)
+{
+    if (!it->is_open || s->is_error)
+    {
+        return false;
+    }
+
+    if (peek(s) == ']')
+    {
+        s->pos++;
+        it->is_open = false;
+        return false;
+    }
+
+    if (it->count > 0 && !consume(s, ','))
+    {
+        it->is_open = false;
+        return false;
+    }
+
+    it->count++;
+    return true;
+}
+
+// Skips the value at the stream position, returns its elements if it is an array
+static size_t count_elements(json_stream_t *const s)
+{
+    json_iter_t it;
+
+    if (!array_begin(s, &it))
+    {
+        return 0;
+    }
+
+    while (array_next(s, &it) && skip_value(s, 0))
+    {
+    }
+
+    return it.count;
+}
+
+/* Nested members, read in document order and reported in the json-c parser's order */
+
+// Starts holding back the errors of a nested member, returns the sink to swap back
+static config_error_sink_t *hold_errors(held_errors_t *const held)
+{
+    held->sink = (config_error_sink_t){.errors = held->errors, .capacity = MAX_HELD_ERRORS};
+
+    return config_swap_error_sink(&held->sink);
+}
+
+// Position of the member value, where skip_failed restarts
+static const char *member_start(json_stream_t *const s)
+{
+    peek(s);
+
+    return s->pos;
+}
+
+// Reports the held errors of a member that failed, returns true if there were any
+static bool report_held(const held_errors_t *const held)
+{
+    config_report_held(&held->sink);
+
+    return held->sink.count > 0;
+}
+
+/*
+ * Skips the rest of a member that failed to parse, so the members after it
+ * are still read, and counts the elements of an array member into count
+ * unless it is NULL. Only a failed member is read twice.
+ */
+static void skip_failed(json_stream_t *const s, const char *const start, const bool is_parsed, size_t *const count)
+{
+    if (!is_parsed && !s->is_error)
+    {
+        s->pos = start;
+
+        if (count != NULL)
+        {
+            *count = count_elements(s);
+        }
+        else
+        {
+            skip_value(s, 0);
+        }
+    }
+}
+
+/* Scalar conversions, these follow the json-c getters used by config.c */
+
+// Output of a conversion, truncated like snprintf
+typedef struct
+{
+    char *out;
+    size_t size;
+    size_t len;
+} json_text_t;
+
+static void text_append(json_text_t *const t, const char *const str, const size_t len)
+{
+    for (size_t i = 0; i < len; i++)
+    {
+        if (t->len + 1U < t->size)
+        {
+            t->out[t->len++] = str[i];
+        }
+    }
+}
+
+// Integers are printed back from their value, doubles keep their literal
+static void number_to_string(const json_scalar_t *const value, char *const out, const size_t out_size)
+{
+    char literal[MAX_NUMBER_LEN];
+    char *end;
+
+    memcpy(literal, value->text, value->len);
+    literal[value->len] = '\0';
+
+    errno = 0;
+    long long number = strtoll(literal, &end, 10);
+
+    if (*end != '\0' || errno == ERANGE)
+    {
+        snprintf(out, out_size, "%s", literal);
+    }
+    else
+    {
+        snprintf(out, out_size, "%lld", number);
+    }
+}
+
+// Writes the string at the stream position with the escapes of json_object_to_json_string
+static void write_string(json_stream_t *const s, json_text_t *const t)
+{
+    char decoded[MAX_STR_LEN + 1U]; // Each byte writes at least one, no longer is ever kept
+
+    read_string(s, decoded, sizeof(decoded));
+    text_append(t, "\"", 1U);
+
+    for (const char *c = decoded; *c != '\0'; c++)
+    {
+        static const char escaped[] = "\"\\/\b\f\n\r\t";
+        static const char letters[] = "\"\\/bfnrt";
+        const char *found = strchr(escaped, *c);
+        char buf[8];
+
+        if (found != NULL)
+        {
+            buf[0] = '\\';
+            buf[1] = letters[found - escaped];
+            text_append(t, buf, 2U);
+        }
+        else if ((unsigned char)*c < 0x20U)
+        {
+            snprintf(buf, sizeof(buf), "\\u%04x", (unsigned int)(unsigned char)*c);
+            text_append(t, buf, 6U);
+        }
+        else
+        {
+            text_append(t, c, 1U);
+        }
+    }
+
+    text_append(t, "\"", 1U);
+}
+
+// Writes the value at the stream position like json_object_to_json_string, it was checked by skip_value
+static void write_value(json_stream_t *const s, json_text_t *const t)
+{
+    char open = peek(s);
+    json_scalar_t value;
+    char str[MAX_NUMBER_LEN];
+
+    if (open == '"')
+    {
+        write_string(s, t);
+        return;
+    }
+
+    if (open != '{' && open != '[')
+    {
+        read_scalar(s, &value);
+
+        if (value.type == JSON_NUMBER)
+        {
+            number_to_string(&value, str, sizeof(str));
+        }
+        else
+        {
+            snprintf(str, sizeof(str), "%s", value.type == JSON_NULL ? "null" : value.boolean ? "true" : "false");
+        }
+
+        text_append(t, str, strlen(str));
+        return;
+    }
+
+    char close = (open == '{') ? '}' : ']';
+
+    s->pos++;
+    text_append(t, &open, 1U);
+
+    for (size_t count = 0; peek(s) != close; count++)
+    {
+        if (count > 0)
+        {
+            consume(s, ',');
+            text_append(t, ",", 1U);
+        }
+
+        text_append(t, " ", 1U);
+
+        if (open == '{')
+        {
+            write_string(s, t);
+            consume(s, ':');
+            text_append(t, ": ", 2U);
+        }
+
+        write_value(s, t);
+    }
+
+    s->pos++;
+    text_append(t, " ", 1U);
+    text_append(t, &close, 1U);
+}
+
+// Returns out, or NULL for a JSON null like json_object_get_string
+static char *scalar_to_string(const json_scalar_t *const value, char *const out, const size_t out_size)
+{
+    // Asset IDs and names copy a NULL string as printf formats it
+    static const char null_str[] = "(null)";
+
+    json_stream_t sub = {.pos = value->text, .end = value->text + value->len};
+
+    switch (value->type)
+    {
+    case JSON_STRING:
+        read_string(&sub, out, out_size);
+        break;
+    case JSON_NUMBER:
+        number_to_string(value, out, out_size);
+        break;
+    case JSON_BOOLEAN:
+        snprintf(out, out_size, "%s", value->boolean ? "true" : "false");
+        break;
+    case JSON_NULL:
+        snprintf(out, out_size, "%s", null_str);
+        break;
+    default:
+    {
+        json_text_t text = {.out = out, .size = out_size};
+
+        write_value(&sub, &text);
+        out[text.len] = '\0';
+        break;
+    }
+    }
+
+    return value->type == JSON_NULL ? NULL : out;
+}
+
+static double scalar_to_double(const json_scalar_t *const value)
+{
+    char str[MAX_NUMBER_LEN];
+
+    switch (value->type)
+    {
+    case JSON_NUMBER:
+        return value->number;
+    case JSON_BOOLEAN:
+        return value->boolean ? 1.0 : 0.0;
+    case JSON_STRING:
+        scalar_to_string(value, str, sizeof(str));
+        return strtod(str, NULL);
+    default:
+        return 0.0;
+    }
+}
+
+static int scalar_to_int(const json_scalar_t *const value)
+{
+    double number = scalar_to_double(value);
+
+    if (number >= (double)INT_MAX)
+    {
+        return INT_MAX;
+    }
+
+    if (number <= (double)INT_MIN)
+    {
+        return INT_MIN;
+    }
+
+    return (int)number;
+}
+
+static bool scalar_to_bool(const json_scalar_t *const value)
+{
+    switch (value->type)
+    {
+    case JSON_NUMBER:
+        return value->number != 0.0;
+    case JSON_BOOLEAN:
+        return value->boolean;
+    case JSON_STRING:
+        return value->len > 2U; // Any non-empty string
+    default:
+        return false;
+    }
+}
+
+/* Config parameters parsing */
+
+static bool parse_detector(json_stream_t *const s, detector_t *const det_ptr)
+{
+    bool result = false;
+    char key[MAX_KEY_LEN];
+    char det_type[MAX_STR_LEN + 1U];
+    char det_memory[MAX_STR_LEN + 1U];
+    char det_mode[MAX_STR_LEN + 1U];
+    char *det_type_str = NULL;
+    char *det_memory_str = NULL;
+    char *det_mode_str = NULL;
+    bool has_type = false;
+    bool has_distance = false;
+    bool has_memory = false;
+    bool has_mode = false;
+    json_scalar_t value;
+    json_iter_t it;
+
+    if (det_ptr == NULL || is_null(s))
+    {
+        config_report_error(CONFIG_ERROR_INTERNAL, NULL, "Assertion error in parse_detector\n");
+        return false;
+    }
+
+    object_begin(s, &it);
+
+    while (object_next(s, &it, key, sizeof(key)) && read_scalar(s, &value))
+    {
+        if (strcmp(key, "type") == 0)
+        {
+            det_type_str = scalar_to_string(&value, det_type, sizeof(det_type));
+            has_type = true;
+        }
+        else if (strcmp(key, "distance") == 0)
+        {
+            det_ptr->distance = scalar_to_int(&value);
+            has_distance = true;
+        }
+        else if (strcmp(key, "memory") == 0)
+        {
+            det_memory_str = scalar_to_string(&value, det_memory, sizeof(det_memory));
+            has_memory = true;
+        }
+        else if (strcmp(key, "mode") == 0)
+        {
+            det_mode_str = scalar_to_string(&value, det_mode, sizeof(det_mode));
+            has_mode = true;
+        }
+    }
+
+    do
+    {
+        if (s->is_error)
+        {
+            break;
+        }
+
+        // Parse detector type (required)
+        if (!has_type)
+        {
+            config_report_error(CONFIG_ERROR_MISSING, "type", "Missing detector type\n");
+            break;
+        }
+
+        if (!config_str_to_detector_type(det_type_str, MAX_DET_TYPE_STR_LEN, &det_ptr->type))
+        {
+            break;
+        }
+
+        // Parse detector installation distance (optional)
+        if (has_distance &&
+            (det_ptr->distance < MIN_DETECTOR_DISTANCE ||
+             det_ptr->distance > MAX_DETECTOR_DISTANCE))
+        {
+            config_report_range(
+                "distance",
+                det_ptr->distance,
+                MIN_DETECTOR_DISTANCE,
+                MAX_DETECTOR_DISTANCE,
+                "Invalid setback detector distance %u, "
+                "must be within %u to %u feet\n",
+                det_ptr->distance,
+                MIN_DETECTOR_DISTANCE,
+                MAX_DETECTOR_DISTANCE);
+            break;
+        }
+
+        // Parse detector memory (optional)
+        if (has_memory &&
+            !config_str_to_detector_memory(det_memory_str, MAX_DET_MEMORY_STR_LEN, &det_ptr->memory))
+        {
+            break;
+        }
+
+        // Parse detector mode (optional)
+        if (has_mode &&
+            !config_str_to_detector_mode(det_mode_str, MAX_DET_MODE_STR_LEN, &det_ptr->mode))
+        {
+            break;
+        }
+
+        result = true;
+
+    } while (0);
+
+    return result;
+}
+
+static bool parse_lane_group(json_stream_t *const s, lane_group_t *const lane_ptr)
+{
+    bool result = false;
+    bool has_count = false;
+    held_errors_t detector_errors = {.sink.count = 0};
+    config_error_sink_t *sink;
+    const char *start;
+    char key[MAX_KEY_LEN];
+    json_scalar_t value;
+    json_iter_t it;
+
+    if (lane_ptr == NULL || is_null(s))
+    {
+        config_report_error(CONFIG_ERROR_INTERNAL, NULL, "Assertion error in parse_lane_group\n");
+        return false;
+    }
+
+    object_begin(s, &it);
+
+    while (object_next(s, &it, key, sizeof(key)))
+    {
+        start = member_start(s);
+
+        // Parse detector configuration (optional)
+        if (strcmp(key, "detector") == 0)
+        {
+            sink = hold_errors(&detector_errors);
+            config_path_push("detector", CONFIG_PATH_NO_INDEX);
+            lane_ptr->has_detector = parse_detector(s, &lane_ptr->detector);
+            config_path_pop();
+
+            if (!lane_ptr->has_detector && !s->is_error)
+            {
+                config_report_error(
+                    CONFIG_ERROR_NESTED,
+                    "detector",
+                    "Failed to parse detector configuration\n");
+            }
+
+            skip_failed(s, start, lane_ptr->has_detector, NULL);
+            config_swap_error_sink(sink);
+        }
+        else if (!read_scalar(s, &value))
+        {
+            break;
+        }
+        else if (strcmp(key, "count") == 0)
+        {
+            lane_ptr->count = scalar_to_int(&value);
+            has_count = true;
+        }
+        else if (strcmp(key, "protected") == 0)
+        {
+            lane_ptr->is_protected = scalar_to_bool(&value);
+        }
+    }
+
+    do
+    {
+        if (s->is_error)
+        {
+            break;
+        }
+
+        // Parse lane count (required)
+        if (!has_count)
+        {
+            config_report_error(CONFIG_ERROR_MISSING, "count", "Missing lane count\n");
+            break;
+        }
+
+        if (lane_ptr->count < 1 || lane_ptr->count > MAX_LANES)
+        {
+            config_report_range(
+                "count",
+                lane_ptr->count,
+                1,
+                MAX_LANES,
+                "Invalid lane count, must be a number between 1 and %u,"
+                "but got %u\n",
+                MAX_LANES,
+                lane_ptr->count);
+            break;
+        }
+
+        if (report_held(&detector_errors))
+        {
+            break;
+        }
+
+        result = true;
+
+    } while (0);
+
+    return result;
+}
+
+static bool parse_ped_crossing(json_stream_t *const s, ped_crossing_t *const ped_cross_ptr)
+{
+    bool result = false;
+    bool has_push_button = false;
+    bool has_distance = false;
+    char key[MAX_KEY_LEN];
+    json_scalar_t value;
+    json_iter_t it;
+
+    if (ped_cross_ptr == NULL || is_null(s))
+    {
+        config_report_error(CONFIG_ERROR_INTERNAL, NULL, "Assertion error in parse_ped_crossing\n");
+        return false;
+    }
+
+    object_begin(s, &it);
+
+    while (object_next(s, &it, key, sizeof(key)) && read_scalar(s, &value))
+    {
+        if (strcmp(key, "push_button") == 0)
+        {
+            ped_cross_ptr->push_button = scalar_to_bool(&value);
+            has_push_button = true;
+        }
+        else if (strcmp(key, "distance") == 0)
+        {
+            ped_cross_ptr->distance = scalar_to_int(&value);
+            has_distance = true;
+        }
+    }
+
+    do
+    {
+        if (s->is_error)
+        {
+            break;
+        }
+
+        // Parse push button (required)
+        if (!has_push_button)
+        {
+            config_report_error(CONFIG_ERROR_MISSING, "push_button", "Missing push button\n");
+            break;
+        }
+
+        // Parse distance (required)
+        if (!has_distance)
+        {
+            config_report_error(CONFIG_ERROR_MISSING, "distance", "Missing distance\n");
+            break;
+        }
+
+        if (ped_cross_ptr->distance < MIN_CROSSING_DISTANCE ||
+            ped_cross_ptr->distance > MAX_CROSSING_DISTANCE)
+        {
+            config_report_range(
+                "distance",
+                ped_cross_ptr->distance,
+                MIN_CROSSING_DISTANCE,
+                MAX_CROSSING_DISTANCE,
+                "Invalid pedestrian crossing distance %u, "
+                "must be within %u to %u feet\n",
+                ped_cross_ptr->distance,
+                MIN_CROSSING_DISTANCE,
+                MAX_CROSSING_DISTANCE);
+            break;
+        }
+
+        result = true;
+
+    } while (0);
+
+    return result;
+}
+
+// Errors of each lane group are held for parse_direction to report in the json-c order
+static bool parse_lane_groups(
+    json_stream_t *const s,
+    direction_t *const dir_ptr,
+    bool *const has_straight,
+    held_errors_t lane_errors[NUM_LANE_GROUPS])
+{
+    char key[MAX_KEY_LEN];
+    json_iter_t it;
+
+    object_begin(s, &it);
+
+    while (object_next(s, &it, key, sizeof(key)))
+    {
+        const char *start = member_start(s);
+        config_error_sink_t *sink = NULL;
+        bool is_parsed = true;
+
+        if (strcmp(key, "straight") == 0)
+        {
+            // Parse straight lanes (required)
+            *has_straight = true;
+            sink = hold_errors(&lane_errors[LANE_GROUP_STRAIGHT]);
+            config_path_push("lanes.straight", CONFIG_PATH_NO_INDEX);
+            is_parsed = parse_lane_group(s, &dir_ptr->straight);
+            config_path_pop();
+
+            if (!is_parsed && !s->is_error)
+            {
+                config_report_error(
+                    CONFIG_ERROR_NESTED,
+                    "lanes.straight",
+                    "Straight lane is missing or failed to parse it\n");
+            }
+        }
+        else if (strcmp(key, "left") == 0)
+        {
+            // Parse left turn lanes (optional)
+            sink = hold_errors(&lane_errors[LANE_GROUP_LEFT]);
+            config_path_push("lanes.left", CONFIG_PATH_NO_INDEX);
+            is_parsed = dir_ptr->has_left = parse_lane_group(s, &dir_ptr->left);
+            config_path_pop();
+
+            if (!is_parsed && !s->is_error)
+            {
+                config_report_error(
+                    CONFIG_ERROR_NESTED,
+                    "lanes.left",
+                    "Failed to parse left turn lanes\n");
+            }
+        }
+        else if (strcmp(key, "right") == 0)
+        {
+            // Parse right turn lanes (optional)
+            sink = hold_errors(&lane_errors[LANE_GROUP_RIGHT]);
+            config_path_push("lanes.right", CONFIG_PATH_NO_INDEX);
+            is_parsed = dir_ptr->has_right = parse_lane_group(s, &dir_ptr->right);
+            config_path_pop();
+
+            if (!is_parsed && !s->is_error)
+            {
+                config_report_error(
+                    CONFIG_ERROR_NESTED,
+                    "lanes.right",
+                    "Failed to parse right turn lanes\n");
+            }
+        }
+        else
+        {
+            skip_value(s, 0);
+            continue;
+        }
+
+        skip_failed(s, start, is_parsed, NULL);
+        config_swap_error_sink(sink);
+    }
+
+    return !s->is_error;
+}
+
+static bool parse_direction(json_stream_t *const s, direction_t *const dir_ptr)
+{
+    bool result = false;
+    bool has_type = false;
+    bool has_lanes = false;
+    bool has_straight = false;
+    held_errors_t lane_errors[NUM_LANE_GROUPS] = {{.sink.count = 0}};
+    held_errors_t ped_errors = {.sink.count = 0};
+    config_error_sink_t *sink;
+    const char *start;
+    char key[MAX_KEY_LEN];
+    char dir_type[MAX_STR_LEN + 1U];
+    char *dir_type_str = NULL;
+    json_scalar_t value;
+    json_iter_t it;
+
+    if (dir_ptr == NULL || is_null(s))
+    {
+        config_report_error(CONFIG_ERROR_INTERNAL, NULL, "Assertion error in parse_direction\n");
+        return false;
+    }
+
+    object_begin(s, &it);
+
+    while (object_next(s, &it, key, sizeof(key)))
+    {
+        start = member_start(s);
+
+        if (strcmp(key, "lanes") == 0)
+        {
+            has_lanes = true;
+            has_straight = false;
+            dir_ptr->has_left = false;
+            dir_ptr->has_right = false;
+            memset(lane_errors, 0, sizeof(lane_errors));
+            parse_lane_groups(s, dir_ptr, &has_straight, lane_errors);
+        }
+        else if (strcmp(key, "pedestrian") == 0)
+        {
+            // Parse pedestrian crossing (optional)
+            sink = hold_errors(&ped_errors);
+            config_path_push("pedestrian", CONFIG_PATH_NO_INDEX);
+            dir_ptr->has_ped_crossing = parse_ped_crossing(s, &dir_ptr->ped_cross);
+            config_path_pop();
+
+            if (!dir_ptr->has_ped_crossing && !s->is_error)
+            {
+                config_report_error(
+                    CONFIG_ERROR_NESTED,
+                    "pedestrian",
+                    "Failed to parse pedestrian crossing\n");
+            }
+
+            skip_failed(s, start, dir_ptr->has_ped_crossing, NULL);
+            config_swap_error_sink(sink);
+        }
+        else if (!read_scalar(s, &value))
+        {
+            break;
+        }
+        else if (strcmp(key, "type") == 0)
+        {
+            dir_type_str = scalar_to_string(&value, dir_type, sizeof(dir_type));
+            has_type = true;
+        }
+    }
+
+    do
+    {
+        if (s->is_error)
+        {
+            break;
+        }
+
+        // Parse direction type (required)
+        if (!has_type)
+        {
+            config_report_error(CONFIG_ERROR_MISSING, "type", "Missing direction type\n");
+            break;
+        }
+
+        if (!config_str_to_direction_type(dir_type_str, MAX_DIR_TYPE_STR_LEN, &dir_ptr->type))
+        {
+            break;
+        }
+
+        // Parse lanes (required)
+        if (!has_lanes)
+        {
+            config_report_error(CONFIG_ERROR_MISSING, "lanes", "Missing lanes\n");
+            break;
+        }
+
+        if (!has_straight)
+        {
+            config_report_error(
+                CONFIG_ERROR_MISSING,
+                "lanes.straight",
+                "Straight lane is missing or failed to parse it\n");
+            break;
+        }
+
+        if (report_held(&lane_errors[LANE_GROUP_STRAIGHT]) ||
+            report_held(&lane_errors[LANE_GROUP_LEFT]) ||
+            report_held(&lane_errors[LANE_GROUP_RIGHT]) ||
+            report_held(&ped_errors))
+        {
+            break;
+        }
+
+        result = true;
+
+    } while (0);
+
+    return result;
+}
+
+static void parse_timing(json_stream_t *const s, phase_timing_t *const timing, timing_fields_t *const fields)
+{
+    char key[MAX_KEY_LEN];
+    json_scalar_t value;
+    json_iter_t it;
+
+    object_begin(s, &it);
+
+    while (object_next(s, &it, key, sizeof(key)) && read_scalar(s, &value))
+    {
+        if (strcmp(key, "yellow_time") == 0)
+        {
+            timing->yellow_time = scalar_to_double(&value);
+            fields->has_yellow_time = true;
+        }
+        else if (strcmp(key, "red_clearance") == 0)
+        {
+            timing->red_clearance = scalar_to_double(&value);
+            fields->has_red_clearance = true;
+        }
+        else if (strcmp(key, "min_green") == 0)
+        {
+            timing->min_green = scalar_to_int(&value);
+            fields->has_min_green = true;
+        }
+        else if (strcmp(key, "max_green") == 0)
+        {
+            timing->max_green = scalar_to_int(&value);
+            fields->has_max_green = true;
+        }
+        else if (strcmp(key, "passage_time") == 0)
+        {
+            timing->passage_time = scalar_to_double(&value);
+            fields->has_passage_time = true;
+        }
+        else if (strcmp(key, "pedestrian_walk") == 0)
+        {
+            timing->ped_walk = scalar_to_int(&value);
+            fields->has_ped_walk = true;
+        }
+        else if (strcmp(key, "pedestrian_clearance") == 0)
+        {
+            timing->ped_clearance = scalar_to_int(&value);
+            fields->has_ped_clearance = true;
+        }
+    }
+}
+
+static bool validate_timing(const phase_timing_t *const timing, const timing_fields_t *const fields)
+{
+    bool result = false;
+
+    do
+    {
+        // Parse yellow clearance time (required)
+        if (!fields->has_yellow_time)
+        {
+            config_report_error(
+                CONFIG_ERROR_MISSING,
+                "yellow_time",
+                "Missing yellow clearance time\n");
+            break;
+        }
+
+        if (timing->yellow_time < MIN_YELLOW_TIME ||
+            timing->yellow_time > MAX_YELLOW_TIME)
+        {
+            config_report_range(
+                "yellow_time",
+                timing->yellow_time,
+                MIN_YELLOW_TIME,
+                MAX_YELLOW_TIME,
+                "Invalid yellow clearance time %.1f, "
+                "must be between %f and %f seconds\n",
+                timing->yellow_time,
+                MIN_YELLOW_TIME,
+                MAX_YELLOW_TIME);
+            break;
+        }
+
+        // Parse red clearance time (required)
+        if (!fields->has_red_clearance)
+        {
+            config_report_error(
+                CONFIG_ERROR_MISSING,
+                "red_clearance",
+                "Missing red clearance time\n");
+            break;
+        }
+
+        if (timing->red_clearance < MIN_RED_CLEARANCE ||
+            timing->red_clearance > MAX_RED_CLEARANCE)
+        {
+            config_report_range(
+                "red_clearance",
+                timing->red_clearance,
+                MIN_RED_CLEARANCE,
+                MAX_RED_CLEARANCE,
+                "Invalid red clearance time %.1f, "
+                "must be between %f and %f seconds\n",
+                timing->red_clearance,
+                MIN_RED_CLEARANCE,
+                MAX_RED_CLEARANCE);
+            break;
+        }
+
+        // Parse minimum green time (required)
+        if (!fields->has_min_green)
+        {
+            config_report_error(
+                CONFIG_ERROR_MISSING,
+                "min_green",
+                "Missing minimum green time\n");
+            break;
+        }
+
+        if (timing->min_green < MIN_GREEN_STOP_LINE)
+        {
+            config_report_range(
+                "min_green",
+                timing->min_green,
+                MIN_GREEN_STOP_LINE,
+                NAN,
+                "Invalid minimum green time %u, "
+                "must be at least %u seconds\n",
+                timing->min_green,
+                MIN_GREEN_STOP_LINE);
+            break;
+        }
+
+        // Parse maximum green time (optional)
+        if (fields->has_max_green && timing->max_green < timing->min_green)
+        {
+            config_report_range(
+                "max_green",
+                timing->max_green,
+                timing->min_green,
+                NAN,
+                "Invalid maximum green time %u, "
+                "must be at least the minimum green time of %u seconds\n",
+                timing->max_green,
+                timing->min_green);
+            break;
+        }
+
+        // Parse passage time (optional)
+        if (fields->has_passage_time &&
+            (timing->passage_time < MIN_PASSAGE_TIME ||
+             timing->passage_time > MAX_PASSAGE_TIME))
+        {
+            config_report_range(
+                "passage_time",
+                timing->passage_time,
+                MIN_PASSAGE_TIME,
+                MAX_PASSAGE_TIME,
+                "Invalid passage time %.1f, "
+                "must be between %f and %f seconds\n",
+                timing->passage_time,
+                MIN_PASSAGE_TIME,
+                MAX_PASSAGE_TIME);
+            break;
+        }
+
+        // Parse pedestrian walk time (optional)
+        if (fields->has_ped_walk && timing->ped_walk < MIN_PED_WALK_TIME)
+        {
+            config_report_range(
+                "pedestrian_walk",
+                timing->ped_walk,
+                MIN_PED_WALK_TIME,
+                NAN,
+                "Invalid pedestrian walk time %u, "
+                "must be at least %u seconds\n",
+                timing->ped_walk,
+                MIN_PED_WALK_TIME);
+            break;
+        }
+
+        // Parse pedestrian clearance time (optional)
+        if (fields->has_ped_clearance && timing->ped_clearance < MIN_PED_WALK_TIME)
+        {
+            config_report_range(
+                "pedestrian_clearance",
+                timing->ped_clearance,
+                MIN_PED_WALK_TIME,
+                NAN,
+                "Invalid pedestrian clearance time %u, "
+                "must be at least %u seconds\n",
+                timing->ped_clearance,
+                MIN_PED_WALK_TIME);
+            break;
+        }
+
+        result = true;
+
+    } while (0);
+
+    return result;
+}
+
+// Counts the elements into count, the caller checks there are MAX_DIRECTIONS
+static bool parse_directions(json_stream_t *const s, road_t *const road_ptr, size_t *const count)
+{
+    json_iter_t it;
+
+    *count = 0;
+
+    if (!array_begin(s, &it))
+    {
+        return !s->is_error;
+    }
+
+    while (array_next(s, &it))
+    {
+        size_t i = it.count - 1U;
+
+        // Only counted, the array is invalid
+        if (i >= MAX_DIRECTIONS)
+        {
+            skip_value(s, 0);
+            continue;
+        }
+
+        // Parse each direction (required)
+        config_path_push("directions", (uint32_t)i);
+        bool is_parsed = parse_direction(s, &road_ptr->directions[i]);
+        config_path_pop();
+
+        if (!is_parsed)
+        {
+            if (!s->is_error)
+            {
+                config_report_error(
+                    CONFIG_ERROR_NESTED,
+                    "directions",
+                    "Failed to parse direction %lu\n",
+                    i);
+            }
+
+            return false;
+        }
+    }
+
+    *count = it.count;
+
+    return !s->is_error;
+}
+
+static bool parse_road(json_stream_t *const s, road_t *const road_ptr)
+{
+    bool result = false;
+    bool has_id = false;
+    bool has_name = false;
+    bool has_speed_limit = false;
+    bool has_timing = false;
+    size_t num_directions = 0;
+    timing_fields_t timing_fields = {0};
+    held_errors_t direction_errors = {.sink.count = 0};
+    config_error_sink_t *sink;
+    const char *start;
+    char key[MAX_KEY_LEN];
+    json_scalar_t value;
+    json_iter_t it;
+
+    if (road_ptr == NULL || is_null(s))
+    {
+        config_report_error(CONFIG_ERROR_INTERNAL, NULL, "Assertion error in parse_road\n");
+        return false;
+    }
+
+    object_begin(s, &it);
+
+    while (object_next(s, &it, key, sizeof(key)))
+    {
+        start = member_start(s);
+
+        if (strcmp(key, "timing") == 0)
+        {
+            has_timing = true;
+            parse_timing(s, &road_ptr->timing, &timing_fields);
+        }
+        else if (strcmp(key, "directions") == 0)
+        {
+            sink = hold_errors(&direction_errors);
+            skip_failed(s, start, parse_directions(s, road_ptr, &num_directions), &num_directions);
+            config_swap_error_sink(sink);
+        }
+        else if (!read_scalar(s, &value))
+        {
+            break;
+        }
+        else if (strcmp(key, "id") == 0)
+        {
+            scalar_to_string(&value, road_ptr->id, MAX_STR_LEN);
+            has_id = true;
+        }
+        else if (strcmp(key, "name") == 0)
+        {
+            scalar_to_string(&value, road_ptr->name, MAX_STR_LEN);
+            has_name = true;
+        }
+        else if (strcmp(key, "speed_limit") == 0)
+        {
+            road_ptr->speed_limit = scalar_to_int(&value);
+            has_speed_limit = true;
+        }
+    }
+
+    do
+    {
+        if (s->is_error)
+        {
+            break;
+        }
+
+        // Parse road ID (required)
+        if (!has_id)
+        {
+            config_report_error(CONFIG_ERROR_MISSING, "id", "Missing road ID\n");
+            break;
+        }
+
+        // Parse road name (required)
+        if (!has_name)
+        {
+            config_report_error(CONFIG_ERROR_MISSING, "name", "Missing road name\n");
+            break;
+        }
+
+        // Parse speed limit (required)
+        if (!has_speed_limit)
+        {
+            config_report_error(CONFIG_ERROR_MISSING, "speed_limit", "Missing speed limit\n");
+            break;
+        }
+
+        if (road_ptr->speed_limit < MIN_SPEED_LIMIT ||
+            road_ptr->speed_limit > MAX_SPEED_LIMIT)
+        {
+            config_report_range(
+                "speed_limit",
+                road_ptr->speed_limit,
+                MIN_SPEED_LIMIT,
+                MAX_SPEED_LIMIT,
+                "Invalid speed limit %u, "
+                "must be within %u to %u mph\n",
+                road_ptr->speed_limit,
+                MIN_SPEED_LIMIT,
+                MAX_SPEED_LIMIT);
+            break;
+        }
+
+        // Parse timing configuration (required)
+        if (!has_timing)
+        {
+            config_report_error(CONFIG_ERROR_MISSING, "timing", "Missing timing configuration\n");
+            break;
+        }
+
+        config_path_push("timing", CONFIG_PATH_NO_INDEX);
+        bool is_timing_valid = validate_timing(&road_ptr->timing, &timing_fields);
+        config_path_pop();
+
+        if (!is_timing_valid)
+        {
+            break;
+        }
+
+        // Parse directions array (required)
+        if (num_directions != MAX_DIRECTIONS)
+        {
+            config_report_error(
+                CONFIG_ERROR_MISSING,
+                "directions",
+                "Missing or invalid directions array\n");
+            break;
+        }
+
+        if (report_held(&direction_errors))
+        {
+            break;
+        }
+
+        result = true;
+
+    } while (0);
+
+    return result;
+}
+
+// Counts the elements into count, the caller checks there are MAX_ROADS
+static bool parse_roads(json_stream_t *const s, config_t *const config, size_t *const count)
+{
+    json_iter_t it;
+
+    *count = 0;
+
+    if (!array_begin(s, &it))
+    {
+        return !s->is_error;
+    }
+
+    while (array_next(s, &it))
+    {
+        size_t i = it.count - 1U;
+
+        // Only counted, the array is invalid
+        if (i >= MAX_ROADS)
+        {
+            skip_value(s, 0);
+            continue;
+        }
+
+        // Parse each road
+        config_path_push("roads", (uint32_t)i);
+        bool is_parsed = parse_road(s, &config->roads[i]);
+        config_path_pop();
+
+        if (!is_parsed)
+        {
+            if (!s->is_error)
+            {
+                config_report_error(
+                    CONFIG_ERROR_NESTED,
+                    "roads",
+                    "Failed to parse road %lu\n",
+                    i);
+                config_report_error(
+                    CONFIG_ERROR_NESTED,
+                    "roads",
+                    "Failed to parse road %lu\n",
+                    i);
+            }
+
+            return false;
+        }
+    }
+
+    *count = it.count;
+
+    return !s->is_error;
+}
+
+static bool parse_plan_timing(
+    json_stream_t *const s,
+    timing_plan_t *const plan_ptr,
+    timing_fields_t fields[MAX_ROADS],
+    size_t *const count)
+{
+    json_iter_t it;
+
+    if (!array_begin(s, &it))
+    {
+        return !s->is_error;
+    }
+
+    while (array_next(s, &it))
+    {
+        size_t i = it.count - 1U;
+
+        // Only counted past the roads, the plan then reports the array invalid
+        if (i >= MAX_ROADS)
+        {
+            skip_value(s, 0);
+            continue;
+        }
+
+        parse_timing(s, &plan_ptr->timing[i], &fields[i]);
+    }
+
+    *count = it.count;
+
+    return !s->is_error;
+}
+
+static void parse_coordination(
+    json_stream_t *const s,
+    coordination_t *const coord,
+    coordination_fields_t *const fields)
+{
+    char key[MAX_KEY_LEN];
+    json_scalar_t value;
+    json_iter_t it;
+
+    object_begin(s, &it);
+
+    while (object_next(s, &it, key, sizeof(key)) && read_scalar(s, &value))
+    {
+        if (strcmp(key, "cycle_length") == 0)
+        {
+            coord->cycle_length = scalar_to_int(&value);
+            fields->has_cycle_length = true;
+        }
+        else if (strcmp(key, "offset") == 0)
+        {
+            coord->offset = scalar_to_int(&value);
+            fields->has_offset = true;
+        }
+        else if (strcmp(key, "split") == 0)
+        {
+            coord->split = scalar_to_int(&value);
+            fields->has_split = true;
+        }
+    }
+}
+
+static bool validate_coordination(const coordination_t *const coord, const coordination_fields_t *const fields)
+{
+    bool result = false;
+
+    do
+    {
+        // Parse cycle length (required)
+        if (!fields->has_cycle_length)
+        {
+            config_report_error(CONFIG_ERROR_MISSING, "cycle_length", "Missing cycle length\n");
+            break;
+        }
+
+        // Parse offset (required)
+        if (!fields->has_offset)
+        {
+            config_report_error(CONFIG_ERROR_MISSING, "offset", "Missing offset\n");
+            break;
+        }
+
+        // Parse main road split (required)
+        if (!fields->has_split)
+        {
+            config_report_error(CONFIG_ERROR_MISSING, "split", "Missing main road split\n");
+            break;
+        }
+
+        if (!config_check_coordination(coord))
+        {
+            break;
+        }
+
+        result = true;
+
+    } while (0);
+
+    return result;
+}
+
+static bool parse_plan(json_stream_t *const s, timing_plan_t *const plan_ptr)
+{
+    bool result = false;
+    bool is_valid = true;
+    bool has_id = false;
+    bool has_timing = false;
+    bool has_coord = false;
+    size_t num_timings = 0;
+    timing_fields_t timing_fields[MAX_ROADS];
+    coordination_fields_t coord_fields;
+    char key[MAX_KEY_LEN];
+    json_scalar_t value;
+    json_iter_t it;
+
+    if (plan_ptr == NULL || is_null(s))
+    {
+        config_report_error(CONFIG_ERROR_INTERNAL, NULL, "Assertion error in parse_plan\n");
+        return false;
+    }
+
+    object_begin(s, &it);
+
+    while (is_valid && object_next(s, &it, key, sizeof(key)))
+    {
+        if (strcmp(key, "timing") == 0)
+        {
+            has_timing = true;
+            num_timings = 0;
+            memset(timing_fields, 0, sizeof(timing_fields));
+            is_valid = parse_plan_timing(s, plan_ptr, timing_fields, &num_timings);
+        }
+        else if (strcmp(key, "coordination") == 0)
+        {
+            has_coord = true;
+            memset(&coord_fields, 0, sizeof(coord_fields));
+            parse_coordination(s, &plan_ptr->coord, &coord_fields);
+            is_valid = !s->is_error;
+        }
+        else if (!read_scalar(s, &value))
+        {
+            is_valid = false;
+        }
+        else if (strcmp(key, "id") == 0)
+        {
+            scalar_to_string(&value, plan_ptr->id, MAX_STR_LEN);
+            has_id = true;
+        }
+        else if (strcmp(key, "flash") == 0)
+        {
+            plan_ptr->is_flash = scalar_to_bool(&value);
+        }
+    }
+
+    do
+    {
+        if (!is_valid || s->is_error)
+        {
+            break;
+        }
+
+        // Parse plan ID (required)
+        if (!has_id)
+        {
+            config_report_error(CONFIG_ERROR_MISSING, "id", "Missing plan ID\n");
+            break;
+        }
+
+        // Parse timing per road, in the order of the roads array (required unless flashing)
+        if (has_timing || !plan_ptr->is_flash)
+        {
+            if (num_timings != MAX_ROADS)
+            {
+                config_report_error(
+                    CONFIG_ERROR_MISSING,
+                    "timing",
+                    "Missing or invalid plan timing array\n");
+                break;
+            }
+
+            size_t i;
+            for (i = 0; i < MAX_ROADS; i++)
+            {
+                config_path_push("timing", (uint32_t)i);
+                bool is_timing_valid = validate_timing(&plan_ptr->timing[i], &timing_fields[i]);
+                config_path_pop();
+
+                if (!is_timing_valid)
+                {
+                    break;
+                }
+            }
+
+            if (i != MAX_ROADS)
+            {
+                config_report_error(
+                    CONFIG_ERROR_NESTED,
+                    "timing",
+                    "Failed to parse timing of road %lu\n",
+                    i);
+                break;
+            }
+        }
+
+        // Parse coordination (optional, runs free without)
+        if (has_coord)
+        {
+            config_path_push("coordination", CONFIG_PATH_NO_INDEX);
+            bool is_coord_valid = validate_coordination(&plan_ptr->coord, &coord_fields);
+            config_path_pop();
+
+            if (!is_coord_valid)
+            {
+                break;
+            }
+        }
+
+        result = true;
+
+    } while (0);
+
+    return result;
+}
+
+// Plans are stored after the base plan, is_array is false for any other JSON type
+static bool parse_plans(json_stream_t *const s, config_t *const config, bool *const is_array, size_t *const count)
+{
+    json_iter_t it;
+
+    *count = 0;
+    *is_array = array_begin(s, &it);
+
+    while (array_next(s, &it))
+    {
+        size_t i = it.count - 1U;
+
+        // Only counted, the number of plans is checked by the caller
+        if (i >= MAX_PLANS - 1U)
+        {
+            skip_value(s, 0);
+            continue;
+        }
+
+        // Parse each plan
+        config_path_push("plans", (uint32_t)i);
+        bool is_parsed = parse_plan(s, &config->plans[i + 1U]);
+        config_path_pop();
+
+        if (!is_parsed)
+        {
+            if (!s->is_error)
+            {
+                config_report_error(
+                    CONFIG_ERROR_NESTED,
+                    "plans",
+                    "Failed to parse plan %lu\n",
+                    i);
+            }
+
+            return false;
+        }
+
+        config->num_plans++;
+    }
+
+    *count = it.count;
+
+    return !s->is_error;
+}
+
+// Counts the elements into count, the caller checks there are any
+static bool parse_days(json_stream_t *const s, uint8_t *const day_mask, size_t *const count)
+{
+    char str[MAX_STR_LEN];
+    json_scalar_t value;
+    json_iter_t it;
+
+    *count = 0;
+
+    if (!array_begin(s, &it))
+    {
+        return !s->is_error;
+    }
+
+    while (array_next(s, &it) && read_scalar(s, &value))
+    {
+        uint8_t day;
+
+        scalar_to_string(&value, str, sizeof(str));
+
+        if (!config_str_to_day(str, MAX_DAY_STR_LEN, &day))
+        {
+            return false;
+        }
+
+        *day_mask |= (uint8_t)(1U << day);
+    }
+
+    *count = it.count;
+
+    return !s->is_error;
+}
+
+static bool parse_schedule_entry(json_stream_t *const s, config_schedule_entry_t *const entry_ptr)
+{
+    bool result = false;
+    bool has_plan = false;
+    bool has_time = false;
+    bool has_days = false;
+    size_t num_days = 0;
+    uint8_t day_mask = 0;
+    held_errors_t day_errors = {.sink.count = 0};
+    config_error_sink_t *sink;
+    const char *start;
+    char time_str[MAX_STR_LEN];
+    char key[MAX_KEY_LEN];
+    json_scalar_t value;
+    json_iter_t it;
+
+    if (entry_ptr == NULL || is_null(s))
+    {
+        config_report_error(CONFIG_ERROR_INTERNAL, NULL, "Assertion error in parse_schedule_entry\n");
+        return false;
+    }
+
+    object_begin(s, &it);
+
+    while (object_next(s, &it, key, sizeof(key)))
+    {
+        start = member_start(s);
+
+        if (strcmp(key, "days") == 0)
+        {
+            has_days = true;
+            day_mask = 0;
+            sink = hold_errors(&day_errors);
+            skip_failed(s, start, parse_days(s, &day_mask, &num_days), &num_days);
+            config_swap_error_sink(sink);
+        }
+        else if (!read_scalar(s, &value))
+        {
+            break;
+        }
+        else if (strcmp(key, "plan") == 0)
+        {
+            scalar_to_string(&value, entry_ptr->plan_id, MAX_STR_LEN);
+            has_plan = true;
+        }
+        else if (strcmp(key, "time") == 0)
+        {
+            scalar_to_string(&value, time_str, sizeof(time_str));
+            has_time = true;
+        }
+    }
+
+    do
+    {
+        if (s->is_error)
+        {
+            break;
+        }
+
+        // Parse plan ID (required)
+        if (!has_plan)
+        {
+            config_report_error(CONFIG_ERROR_MISSING, "plan", "Missing schedule plan\n");
+            break;
+        }
+
+        // Parse start time (required)
+        if (!has_time)
+        {
+            config_report_error(CONFIG_ERROR_MISSING, "time", "Missing schedule time\n");
+            break;
+        }
+
+        if (!config_str_to_time_of_day(time_str, &entry_ptr->minute))
+        {
+            break;
+        }
+
+        // Parse days of the week (optional, every day if missing)
+        if (has_days && num_days == 0)
+        {
+            config_report_error(CONFIG_ERROR_MISSING, "days", "Missing or invalid schedule days array\n");
+            break;
+        }
+
+        if (report_held(&day_errors))
+        {
+            break;
+        }
+
+        entry_ptr->day_mask = has_days ? day_mask : ALL_DAYS_MASK;
+
+        result = true;
+
+    } while (0);
+
+    return result;
+}
+
+static bool parse_schedule(
+    json_stream_t *const s,
+    config_schedule_entry_t entries[MAX_SCHEDULE_ENTRIES],
+    size_t *const count,
+    bool *const is_array)
+{
+    json_iter_t it;
+
+    *count = 0;
+    *is_array = array_begin(s, &it);
+
+    while (array_next(s, &it))
+    {
+        size_t i = it.count - 1U;
+
+        // Only counted, the number of entries is checked by the caller
+        if (i >= MAX_SCHEDULE_ENTRIES)
+        {
+            skip_value(s, 0);
+            continue;
+        }
+
+        memset(&entries[i], 0, sizeof(entries[i]));
+
+        // Parse each schedule entry
+        config_path_push("schedule", (uint32_t)i);
+        bool is_parsed = parse_schedule_entry(s, &entries[i]);
+        config_path_pop();
+
+        if (!is_parsed)
+        {
+            if (!s->is_error)
+            {
+                config_report_error(
+                    CONFIG_ERROR_NESTED,
+                    "schedule",
+                    "Failed to parse schedule entry %lu\n",
+                    i);
+            }
+
+            return false;
+        }
+    }
+
+    *count = it.count;
+
+    return !s->is_error;
+}
+
+static bool parse_config(json_stream_t *const s, config_t *const config)
+{
+    bool result = false;
+    bool has_id = false;
+    bool has_type = false;
+    bool has_main_road = false;
+    bool has_roads = false;
+    bool has_position = false;
+    bool has_coord = false;
+    bool has_plans = false;
+    bool is_plans_array = false;
+    bool has_schedule = false;
+    bool is_schedule_array = false;
+    size_t num_roads = 0;
+    size_t num_plans = 0;
+    size_t num_entries = 0;
+    int position = 0;
+    coordination_fields_t coord_fields;
+    config_schedule_entry_t entries[MAX_SCHEDULE_ENTRIES];
+    char main_road_id[MAX_STR_LEN + 1U];
+    char key[MAX_KEY_LEN];
+    held_errors_t road_errors = {.sink.count = 0};
+    held_errors_t plan_errors = {.sink.count = 0};
+    held_errors_t schedule_errors = {.sink.count = 0};
+    config_error_sink_t *sink;
+    const char *start;
+    json_scalar_t value;
+    json_iter_t it;
+
+    config->num_plans = 1U; // Configured plans follow the base plan
+
+    object_begin(s, &it);
+
+    while (object_next(s, &it, key, sizeof(key)))
+    {
+        start = member_start(s);
+
+        if (strcmp(key, "roads") == 0)
+        {
+            has_roads = true;
+            sink = hold_errors(&road_errors);
+            skip_failed(s, start, parse_roads(s, config, &num_roads), &num_roads);
+            config_swap_error_sink(sink);
+        }
+        else if (strcmp(key, "coordination") == 0)
+        {
+            has_coord = true;
+            memset(&coord_fields, 0, sizeof(coord_fields));
+            parse_coordination(s, &config->plans[CONFIG_BASE_PLAN].coord, &coord_fields);
+        }
+        else if (strcmp(key, "plans") == 0)
+        {
+            has_plans = true;
+            config->num_plans = 1U;
+            sink = hold_errors(&plan_errors);
+            skip_failed(s, start, parse_plans(s, config, &is_plans_array, &num_plans), &num_plans);
+            config_swap_error_sink(sink);
+        }
+        else if (strcmp(key, "schedule") == 0)
+        {
+            has_schedule = true;
+            sink = hold_errors(&schedule_errors);
+            skip_failed(s, start, parse_schedule(s, entries, &num_entries, &is_schedule_array), &num_entries);
+            config_swap_error_sink(sink);
+        }
+        else if (!read_scalar(s, &value))
+        {
+            break;
+        }
+        else if (strcmp(key, "intersection_id") == 0)
+        {
+            scalar_to_string(&value, config->id, MAX_STR_LEN);
+            has_id = true;
+        }
+        else if (strcmp(key, "type") == 0)
+        {
+            config->intersect_type = scalar_to_int(&value) - 1; // Convert 1-based to 0-based enum
+            has_type = true;
+        }
+        else if (strcmp(key, "main_road") == 0)
+        {
+            has_main_road = scalar_to_string(&value, main_road_id, sizeof(main_road_id)) != NULL;
+        }
+        else if (strcmp(key, "corridor_position") == 0)
+        {
+            position = scalar_to_int(&value);
+            has_position = true;
+        }
+    }
+
+    do
+    {
+        if (s->is_error)
+        {
+            break; // Reported as a file that failed to load, like json-c does
+        }
+
+        // Parse intersection ID (required)
+        if (!has_id)
+        {
+            config_report_error(
+                CONFIG_ERROR_MISSING,
+                "intersection_id",
+                "Missing intersection_id\n");
+            break;
+        }
+
+        // Parse intersection type (required)
+        if (!has_type)
+        {
+            config_report_error(CONFIG_ERROR_MISSING, "type", "Missing intersection type\n");
+            break;
+        }
+
+        if (config->intersect_type < INTERSECTION_TYPE_1 || config->intersect_type > INTERSECTION_TYPE_4)
+        {
+            config_report_range(
+                "type",
+                config->intersect_type + 1,
+                1,
+                4,
+                "Invalid intersection type, must be a number from 1 to 4, "
+                "but got %d\n",
+                config->intersect_type);
+            break;
+        }
+
+        // Parse roads array (required)
+        if (!has_roads || num_roads != MAX_ROADS)
+        {
+            config_report_error(CONFIG_ERROR_MISSING, "roads", "Missing or invalid roads array\n");
+            break;
+        }
+
+        if (report_held(&road_errors))
+        {
+            break;
+        }
+
+        // Set main road pointer if one of the roads is the main road
+        for (size_t i = 0; has_main_road && i < MAX_ROADS; i++)
+        {
+            if (strncmp(config->roads[i].id, main_road_id, MAX_STR_LEN) == 0)
+            {
+                config->main_road = &config->roads[i];
+            }
+        }
+
+        if (has_main_road && config->main_road == NULL)
+        {
+            config_report_error(
+                CONFIG_ERROR_UNKNOWN,
+                "main_road",
+                "No matching entry for the main road found\n");
+            break;
+        }
+
+        // Parse corridor position (optional)
+        if (has_position)
+        {
+            if (position < 0 || position > (int)MAX_CORRIDOR_POSITION)
+            {
+                config_report_range(
+                    "corridor_position",
+                    position,
+                    0,
+                    MAX_CORRIDOR_POSITION,
+                    "Invalid corridor position %d, "
+                    "must be within 0 to %u feet\n",
+                    position,
+                    MAX_CORRIDOR_POSITION);
+                break;
+            }
+
+            config->corridor_position = (uint32_t)position;
+        }
+
+        // Parse coordination of the base plan (optional, runs free without)
+        if (has_coord)
+        {
+            config_path_push("coordination", CONFIG_PATH_NO_INDEX);
+            bool is_coord_valid = validate_coordination(&config->plans[CONFIG_BASE_PLAN].coord, &coord_fields);
+            config_path_pop();
+
+            if (!is_coord_valid)
+            {
+                break;
+            }
+        }
+
+        // Parse timing plans (optional)
+        if (has_plans && !is_plans_array)
+        {
+            config_report_error(CONFIG_ERROR_MISSING, "plans", "Missing or invalid plans array\n");
+            break;
+        }
+
+        if (num_plans > MAX_PLANS - 1U)
+        {
+            config_report_range(
+                "plans",
+                num_plans,
+                0,
+                MAX_PLANS - 1U,
+                "Too many timing plans %lu, "
+                "must be not more than %u\n",
+                num_plans,
+                MAX_PLANS - 1U);
+            break;
+        }
+
+        if (report_held(&plan_errors))
+        {
+            break;
+        }
+
+        // Parse schedule (optional), the base plan runs all week without one
+        if (has_schedule && !is_schedule_array)
+        {
+            config_report_error(CONFIG_ERROR_MISSING, "schedule", "Missing or invalid schedule array\n");
+            break;
+        }
+
+        if (num_entries > MAX_SCHEDULE_ENTRIES)
+        {
+            config_report_range(
+                "schedule",
+                num_entries,
+                0,
+                MAX_SCHEDULE_ENTRIES,
+                "Too many schedule entries %lu, "
+                "must be not more than %u\n",
+                num_entries,
+                MAX_SCHEDULE_ENTRIES);
+            break;
+        }
+
+        if (report_held(&schedule_errors))
+        {
+            break;
+        }
+
+        if (!config_build_plans(config, entries, num_entries))
+        {
+            break;
+        }
+
+        result = true;
+
+    } while (0);
+
+    return result;
+}
+
+/*Interface Functions*/
+
+bool config_stream_load(config_t *config, const char *filename)
+{
+    bool status = false;
+    const char *data = MAP_FAILED;
+    size_t size = 0;
+
+    do
+    {
+        if (config == NULL || filename == NULL)
+        {
+            config_report_error(CONFIG_ERROR_INTERNAL, NULL, "Assertion error in load_config\n");
+            break;
+        }
+
+        config_path_reset();
+
+        int fd = open(filename, O_RDONLY);
+        struct stat st;
+
+        if (fd >= 0 && fstat(fd, &st) == 0 && st.st_size > 0)
+        {
+            size = (size_t)st.st_size;
+            data = mmap(NULL, size, PROT_READ, MAP_PRIVATE, fd, 0);
+        }
+
+        if (fd >= 0)
+        {
+            close(fd);
+        }
+
+        if (data == MAP_FAILED)
+        {
+            config_report_error(
+                CONFIG_ERROR_FILE,
+                NULL,
+                "Failed to load config file: %s\n",
+                filename);
+            break;
+        }
+
+        json_stream_t stream = {.pos = data, .end = data + size};
+
+        if (!parse_config(&stream, config))
+        {
+            if (stream.is_error)
+            {
+                config_report_error(
+                    CONFIG_ERROR_FILE,
+                    NULL,
+                    "Failed to load config file: %s\n",
+                    filename);
+            }
+
+            break;
+        }
+
+        status = true;
+
+    } while (0);
+
+    if (data != MAP_FAILED)
+    {
+        munmap((void *)data, size);
+    }
+
+    return status;
+}
+
+#ifdef CONFIG_STREAM_PARSER
+bool config_load(config_t *config, const char *filename)
+{
+    return config_stream_load(config, filename);
+}
+#endif // CONFIG_STREAM_PARSER
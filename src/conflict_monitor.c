@@ -0,0 +1,303 @@
+#define _GNU_SOURCE // pthread_setaffinity_np
+#include "conflict_monitor.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sched.h>
+#include <unistd.h>
+
+#define STATE_BITS 8U
+#define STATE_MASK 0xFFULL
+
+// States that let traffic proceed, two of them must never face each other
+#define GO_STATES ((1U << SIGNAL_GREEN) | (1U << SIGNAL_YELLOW) | (1U << SIGNAL_FLASH_YELLOW))
+
+/*
+ * Phases of the same road may show go together, phases of different roads
+ * conflict. A phase of neither road conflicts with everything, itself too.
+ */
+static void derive_compatibility(const config_t *const config, uint8_t compatible[NUM_PHASES])
+{
+    const road_t *main_road = config->main_road != NULL ? config->main_road : &config->roads[0];
+
+    memset(compatible, 0, NUM_PHASES);
+
+    for (size_t road = 0; road < MAX_ROADS; road++)
+    {
+        const phase_t *phases = direction_phases[&config->roads[road] == main_road ? ROAD_MAIN : ROAD_SIDE];
+        uint8_t road_mask = 0;
+
+        for (size_t dir = 0; dir < MAX_DIRECTIONS; dir++)
+        {
+            road_mask |= PHASE_BIT(phases[dir]);
+        }
+
+        for (size_t dir = 0; dir < MAX_DIRECTIONS; dir++)
+        {
+            compatible[phases[dir]] |= road_mask;
+        }
+    }
+}
+
+static bool read_snapshot(const conflict_snapshot_t *const snapshot, uint64_t *const states, uint64_t *const time_ms)
+{
+    for (size_t i = 0; i < CONFLICT_READ_RETRIES; i++)
+    {
+        unsigned begin = atomic_load_explicit(&snapshot->sequence, memory_order_acquire);
+
+        if ((begin & 1U) != 0)
+        {
+            continue; // The tick thread is writing
+        }
+
+        *states = atomic_load_explicit(&snapshot->states, memory_order_relaxed);
+        *time_ms = atomic_load_explicit(&snapshot->time_ms, memory_order_relaxed);
+        atomic_thread_fence(memory_order_acquire);
+
+        if (atomic_load_explicit(&snapshot->sequence, memory_order_relaxed) == begin)
+        {
+            return true;
+        }
+    }
+
+    return false;
+}
+
+static void latch_fault(conflict_monitor_t *const monitor, const size_t index)
+{
+    monitor->channels[index].is_faulted = true;
+    atomic_store_explicit(&monitor->controllers[index].is_faulted, true, memory_order_release);
+    atomic_fetch_add_explicit(&monitor->num_faults, 1U, memory_order_release);
+}
+
+static void check_channel(conflict_monitor_t *const monitor, const size_t index)
+{
+    conflict_channel_t *channel = &monitor->channels[index];
+    uint64_t states;
+    uint64_t time_ms;
+
+    if (!read_snapshot(&channel->snapshot, &states, &time_ms))
+    {
+        monitor->busy_reads++;
+        return;
+    }
+
+    uint8_t go = 0;
+    for (size_t phase = 0; phase < NUM_PHASES; phase++)
+    {
+        unsigned state = (unsigned)((states >> (phase * STATE_BITS)) & STATE_MASK);
+        go |= ((GO_STATES >> state) & 1U) != 0 ? PHASE_BIT(phase) : 0;
+    }
+
+    monitor->checks++;
+
+    for (size_t phase = 0; phase < NUM_PHASES; phase++)
+    {
+        uint8_t conflicting = go & (uint8_t)~channel->compatible[phase];
+
+        if ((go & PHASE_BIT(phase)) == 0 || conflicting == 0)
+        {
+            continue;
+        }
+
+        fprintf(stderr,
+                "Conflict monitor: phase %lu conflicts with phase %d at %s, %llu ms, flashing red\n",
+                phase + 1U,
+                __builtin_ctz(conflicting) + 1,
+                channel->id,
+                (unsigned long long)time_ms);
+        latch_fault(monitor, index);
+        return;
+    }
+}
+
+static void *monitor_main(void *arg)
+{
+    conflict_monitor_t *monitor = arg;
+    uint64_t last_beat = atomic_load_explicit(&monitor->heartbeat, memory_order_relaxed);
+    uint64_t last_beat_ms = scheduler_now_ms(&monitor->scheduler);
+    bool is_stalled = false;
+
+    while (!atomic_load_explicit(&monitor->is_stopping, memory_order_relaxed))
+    {
+        if (scheduler_wait(&monitor->scheduler) == 0)
+        {
+            continue;
+        }
+
+        uint64_t now_ms = scheduler_now_ms(&monitor->scheduler);
+        uint64_t beat = atomic_load_explicit(&monitor->heartbeat, memory_order_relaxed);
+
+        if (beat != last_beat)
+        {
+            last_beat = beat;
+            last_beat_ms = now_ms;
+        }
+        else if (!is_stalled && now_ms - last_beat_ms > monitor->timeout_ms)
+        {
+            // The tick thread is stuck, its controllers flash red as soon as they step again
+            size_t num_latched = 0;
+            is_stalled = true;
+
+            for (size_t i = 0; i < monitor->count; i++)
+            {
+                if (!monitor->channels[i].is_faulted)
+                {
+                    latch_fault(monitor, i);
+                    num_latched++;
+                }
+            }
+
+            if (num_latched > 0)
+            {
+                fprintf(stderr,
+                        "Conflict monitor: no heartbeat for %llu ms, flashing red\n",
+                        (unsigned long long)(now_ms - last_beat_ms));
+            }
+        }
+
+        for (size_t i = 0; i < monitor->count; i++)
+        {
+            if (!monitor->channels[i].is_faulted)
+            {
+                check_channel(monitor, i);
+            }
+        }
+    }
+
+    return NULL;
+}
+
+/*Interface Functions*/
+
+bool conflict_monitor_start(
+    conflict_monitor_t *const monitor,
+    controller_t *const controllers,
+    const size_t count,
+    const uint32_t tick_ms)
+{
+    bool result = false;
+
+    do
+    {
+        if (monitor == NULL || controllers == NULL || count == 0 || tick_ms == 0)
+        {
+            fprintf(stderr, "Assertion error in conflict_monitor_start\n");
+            break;
+        }
+
+        memset(monitor, 0, sizeof(*monitor));
+        atomic_init(&monitor->heartbeat, 0);
+        atomic_init(&monitor->num_faults, 0);
+        atomic_init(&monitor->is_stopping, false);
+        monitor->controllers = controllers;
+        monitor->timeout_ms = CONFLICT_HEARTBEAT_TICKS * tick_ms > CONFLICT_HEARTBEAT_TIMEOUT_MS
+                                  ? CONFLICT_HEARTBEAT_TICKS * tick_ms
+                                  : CONFLICT_HEARTBEAT_TIMEOUT_MS;
+
+        monitor->channels = aligned_alloc(CONFLICT_CACHE_LINE, count * sizeof(conflict_channel_t));
+
+        if (monitor->channels == NULL)
+        {
+            fprintf(stderr, "Out of memory while creating conflict monitor\n");
+            break;
+        }
+
+        memset(monitor->channels, 0, count * sizeof(conflict_channel_t));
+        monitor->count = count;
+
+        for (size_t i = 0; i < count; i++)
+        {
+            atomic_init(&monitor->channels[i].snapshot.sequence, 0);
+            derive_compatibility(controllers[i].config, monitor->channels[i].compatible);
+            snprintf(monitor->channels[i].id, sizeof(monitor->channels[i].id), "%s", controllers[i].config->id);
+            conflict_monitor_publish(monitor, i, 0);
+        }
+
+        if (!scheduler_init(&monitor->scheduler, tick_ms))
+        {
+            fprintf(stderr, "Failed to initialize conflict monitor scheduler\n");
+            break;
+        }
+
+        if (pthread_create(&monitor->thread, NULL, monitor_main, monitor) != 0)
+        {
+            fprintf(stderr, "Failed to start conflict monitor thread\n");
+            break;
+        }
+
+        monitor->is_started = true;
+
+        // Best effort, away from the first CPUs the tick thread and workers usually start on
+        long num_cpus = sysconf(_SC_NPROCESSORS_ONLN);
+
+        if (num_cpus > 1)
+        {
+            cpu_set_t cpus;
+            CPU_ZERO(&cpus);
+            CPU_SET((int)(num_cpus - 1), &cpus);
+            pthread_setaffinity_np(monitor->thread, sizeof(cpus), &cpus);
+        }
+
+        result = true;
+
+    } while (0);
+
+    if (!result && monitor != NULL)
+    {
+        conflict_monitor_stop(monitor);
+    }
+
+    return result;
+}
+
+void conflict_monitor_publish(conflict_monitor_t *const monitor, const size_t index, const uint64_t time_ms)
+{
+    if (index >= monitor->count)
+    {
+        return;
+    }
+
+    const controller_t *controller = &monitor->controllers[index];
+    conflict_snapshot_t *snapshot = &monitor->channels[index].snapshot;
+    uint64_t states = 0;
+
+    for (phase_t phase = PHASE_1; phase < NUM_PHASES; phase++)
+    {
+        states |= (uint64_t)controller_head_state(controller, phase) << (phase * STATE_BITS);
+    }
+
+    // Single writer seqlock, the monitor retries a read that overlaps this
+    unsigned sequence = atomic_load_explicit(&snapshot->sequence, memory_order_relaxed);
+    atomic_store_explicit(&snapshot->sequence, sequence + 1U, memory_order_relaxed);
+    atomic_thread_fence(memory_order_release);
+    atomic_store_explicit(&snapshot->states, states, memory_order_relaxed);
+    atomic_store_explicit(&snapshot->time_ms, time_ms, memory_order_relaxed);
+    atomic_store_explicit(&snapshot->sequence, sequence + 2U, memory_order_release);
+}
+
+void conflict_monitor_heartbeat(conflict_monitor_t *const monitor)
+{
+    // Single writer, a plain store avoids a locked read-modify-write on every tick
+    uint64_t beat = atomic_load_explicit(&monitor->heartbeat, memory_order_relaxed);
+    atomic_store_explicit(&monitor->heartbeat, beat + 1U, memory_order_relaxed);
+}
+
+void conflict_monitor_stop(conflict_monitor_t *const monitor)
+{
+    if (monitor->is_started)
+    {
+        atomic_store(&monitor->is_stopping, true);
+        pthread_join(monitor->thread, NULL);
+
+        printf("Conflict monitor: %llu checks, %llu busy reads, %u faults\n",
+               (unsigned long long)monitor->checks,
+               (unsigned long long)monitor->busy_reads,
+               atomic_load(&monitor->num_faults));
+    }
+
+    free(monitor->channels);
+    monitor->channels = NULL;
+    monitor->count = 0;
+    monitor->is_started = false;
+}
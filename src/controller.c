@@ -2,6 +2,10 @@
 #include "controller_type1.h"
 #include <stdio.h>
 
+const phase_t direction_phases[NUM_ROAD_ROLES][MAX_DIRECTIONS] = {
+    [ROAD_MAIN] = {PHASE_2, PHASE_6},
+    [ROAD_SIDE] = {PHASE_4, PHASE_8}};
+
 bool controller_init(controller_t *const controller)
 {
     bool result = false;
@@ -14,10 +18,18 @@ bool controller_init(controller_t *const controller)
             break;
         }
 
+        if (controller->tick_ms == 0)
+        {
+            fprintf(stderr, "Controller tick resolution not set\n");
+            break;
+        }
+
         if (controller->config->intersect_type == INTERSECTION_TYPE_1)
         {
             controller->init = controller_type1_init;
+            controller->configure = controller_type1_configure;
             controller->run = controller_type1_run;
+            controller->advance = controller_type1_advance;
         }
         else if (controller->config->intersect_type == INTERSECTION_TYPE_2 ||
                  controller->config->intersect_type == INTERSECTION_TYPE_3 ||
@@ -34,15 +46,250 @@ bool controller_init(controller_t *const controller)
             break;
         }
 
-        if (controller->init == NULL || controller->run == NULL)
+        if (controller->init == NULL ||
+            controller->configure == NULL ||
+            controller->run == NULL ||
+            controller->advance == NULL)
         {
             fprintf(stderr, "Controller functions not set\n");
             break;
         }
 
+        controller->state.week_ms = controller->start_week_ms % MS_PER_WEEK;
+        controller_seek_plan(controller);
+
         result = controller->init(controller);
 
     } while (0);
 
     return result;
 }
+
+void controller_apply_pending_config(controller_t *const controller)
+{
+    const config_t *config = atomic_exchange_explicit(&controller->pending_config, NULL, memory_order_acquire);
+
+    // The reload thread compiled the config once already, so this cannot fail
+    if (config != NULL)
+    {
+        controller->config = config;
+        controller_seek_plan(controller);
+        controller->configure(controller);
+    }
+}
+
+// Steps past every transition reached by the clock, starting at the given one
+static void step_plans(controller_t *const controller, uint16_t index)
+{
+    const config_t *config = controller->config;
+    controller_state_t *state = &controller->state;
+
+    while (index < config->num_transitions &&
+           config->transitions[index].minute * MS_PER_MINUTE <= state->week_ms)
+    {
+        state->plan = config->transitions[index].plan;
+        index++;
+    }
+
+    state->next_transition = index;
+    state->next_plan_ms = index < config->num_transitions
+                              ? config->transitions[index].minute * MS_PER_MINUTE
+                              : MS_PER_WEEK;
+}
+
+void controller_seek_plan(controller_t *const controller)
+{
+    const config_t *config = controller->config;
+
+    // Before the first transition of the week the last one of the previous week applies
+    controller->state.plan = config->num_transitions > 0
+                                 ? config->transitions[config->num_transitions - 1U].plan
+                                 : CONFIG_BASE_PLAN;
+
+    step_plans(controller, 0);
+}
+
+void controller_advance_clock(controller_t *const controller, const uint32_t elapsed_ms)
+{
+    controller_state_t *state = &controller->state;
+
+    state->week_ms += elapsed_ms;
+
+    if (state->week_ms < state->next_plan_ms)
+    {
+        return;
+    }
+
+    if (state->week_ms >= MS_PER_WEEK)
+    {
+        state->week_ms %= MS_PER_WEEK;
+        controller_seek_plan(controller);
+        return;
+    }
+
+    step_plans(controller, state->next_transition);
+}
+
+uint32_t controller_cycle_position(const controller_t *const controller)
+{
+    uint32_t cycle_ms = controller->runtime.cycle_ms;
+
+    if (cycle_ms == 0)
+    {
+        return 0;
+    }
+
+    uint32_t day_ms = controller->state.week_ms % MS_PER_DAY;
+
+    return (day_ms + cycle_ms - controller->runtime.offset_ms % cycle_ms) % cycle_ms;
+}
+
+uint8_t controller_demand(const controller_t *const controller)
+{
+    const controller_state_t *state = &controller->state;
+
+    return state->calls | state->presence | controller->runtime.recall_mask;
+}
+
+signal_state_t controller_head_state(const controller_t *const controller, const phase_t phase)
+{
+    if ((controller->runtime.phase_mask & PHASE_BIT(phase)) == 0)
+    {
+        return SIGNAL_OFF;
+    }
+
+    return (MAIN_ROAD_PHASES & PHASE_BIT(phase)) != 0 ? controller->state.main_state : controller->state.side_state;
+}
+
+const char *signal_state_str(const signal_state_t state)
+{
+    static const char *const state_strs[] = {
+        [SIGNAL_RED] = "red",
+        [SIGNAL_YELLOW] = "yellow",
+        [SIGNAL_GREEN] = "green",
+        [SIGNAL_FLASH_YELLOW] = "flash_yellow",
+        [SIGNAL_FLASH_RED] = "flash_red",
+        [SIGNAL_OFF] = "off"};
+
+    return (unsigned)state < sizeof(state_strs) / sizeof(state_strs[0]) ? state_strs[state] : "unknown";
+}
+
+const char *termination_str(const termination_t termination)
+{
+    static const char *const termination_strs[] = {
+        [TERMINATION_NONE] = "none",
+        [TERMINATION_TIMED] = "timed",
+        [TERMINATION_GAP_OUT] = "gap_out",
+        [TERMINATION_MAX_OUT] = "max_out",
+        [TERMINATION_FORCE_OFF] = "force_off"};
+
+    return (unsigned)termination < sizeof(termination_strs) / sizeof(termination_strs[0])
+               ? termination_strs[termination]
+               : "unknown";
+}
+
+static uint32_t interval_expiry(const controller_t *const controller)
+{
+    const controller_state_t *state = &controller->state;
+    const controller_interval_t *interval = &controller->intervals[state->interval];
+
+    if (interval->duration_ms > state->phase_timer)
+    {
+        return interval->duration_ms - state->phase_timer;
+    }
+
+    uint8_t demand = controller_demand(controller);
+    bool is_flash = (controller->runtime.flash_mask & PLAN_BIT(state->plan)) != 0;
+
+    bool is_coordinated = controller->runtime.cycle_ms != 0 && !is_flash;
+    uint32_t position = controller_cycle_position(controller);
+
+    // A flash plan ends the rest so the cycle can reach a red clearance
+    if (interval->hold_mask != 0 && !is_flash)
+    {
+        if ((demand & interval->hold_mask) == 0)
+        {
+            return CONTROLLER_NO_EXPIRY;
+        }
+
+        // A coordinated rest yields when the cycle next enters the window
+        if (is_coordinated && position < interval->window_start_ms)
+        {
+            return interval->window_start_ms - position;
+        }
+
+        if (is_coordinated && position > interval->window_end_ms)
+        {
+            return controller->runtime.cycle_ms - position + interval->window_start_ms;
+        }
+    }
+
+    // A coordinated green is forced off at the end of its window
+    uint32_t force_off_ms = CONTROLLER_NO_EXPIRY;
+
+    if (is_coordinated && interval->hold_mask == 0 && interval->green_mask != 0)
+    {
+        bool is_open = position >= interval->window_start_ms && position < interval->window_end_ms;
+        force_off_ms = is_open ? interval->window_end_ms - position : 0;
+
+        // Without actuation the green runs its whole split
+        if (interval->extend_mask == 0)
+        {
+            return force_off_ms;
+        }
+    }
+
+    // Extending green, earliest of the last passage timer and the first max timer
+    uint32_t gap_ms = 0;
+    uint32_t max_ms = CONTROLLER_NO_EXPIRY;
+    bool is_conflicting = is_flash || (demand & controller->runtime.phase_mask & (uint8_t)~interval->green_mask) != 0;
+
+    for (size_t phase = 0; phase < NUM_PHASES; phase++)
+    {
+        if ((interval->extend_mask & PHASE_BIT(phase)) == 0)
+        {
+            continue;
+        }
+
+        if (state->gap_timer[phase] > gap_ms)
+        {
+            gap_ms = state->gap_timer[phase];
+        }
+
+        if (is_conflicting && state->max_timer[phase] < max_ms)
+        {
+            max_ms = state->max_timer[phase];
+        }
+    }
+
+    uint32_t expiry_ms = gap_ms < max_ms ? gap_ms : max_ms;
+
+    return force_off_ms < expiry_ms ? force_off_ms : expiry_ms;
+}
+
+uint32_t controller_time_to_expiry(const controller_t *const controller)
+{
+    const controller_state_t *state = &controller->state;
+    uint32_t expiry_ms = interval_expiry(controller);
+    uint32_t plan_ms = state->next_plan_ms - state->week_ms;
+
+    return plan_ms < expiry_ms ? plan_ms : expiry_ms;
+}
+
+void controller_place_call(controller_t *const controller, const phase_t phase)
+{
+    controller->state.calls |= PHASE_BIT(phase);
+}
+
+void controller_detector_input(controller_t *const controller, const phase_t phase, const bool is_on)
+{
+    controller_state_t *state = &controller->state;
+    uint8_t bit = PHASE_BIT(phase);
+    uint8_t on = (uint8_t)-(uint8_t)is_on; // All ones for an on event
+    uint8_t green = controller->intervals[state->interval].green_mask;
+
+    // Pulse detectors never hold presence, lock memory only latches off green
+    state->presence = (uint8_t)((state->presence & ~bit) | (bit & on & ~controller->runtime.pulse_mask));
+    state->extension |= bit & on;
+    state->calls |= bit & on & controller->runtime.lock_mask & (uint8_t)~green;
+}
@@ -1,14 +1,491 @@
 #include "controller_type1.h"
+#include <stdio.h>
+
+#define MS_PER_SEC 1000.0f
+
+#define MAIN_PHASES (PHASE_BIT(PHASE_2) | PHASE_BIT(PHASE_6))
+#define SIDE_PHASES (PHASE_BIT(PHASE_4) | PHASE_BIT(PHASE_8))
+
+typedef enum
+{
+    TIMING_GREEN,
+    TIMING_YELLOW,
+    TIMING_RED_CLEARANCE
+} timing_source_t;
+
+// Interval template, durations are resolved from phase_timing_t at init
+typedef struct
+{
+    phase_t phase;
+    signal_state_t main_state;
+    signal_state_t side_state;
+    road_role_t road;
+    timing_source_t timing;
+    uint8_t hold_mask;
+    uint8_t green_mask;
+} interval_template_t;
+
+/*
+ * Phases 2/6 (main road) and 4/8 (side road) run concurrently, so each
+ * interval is keyed by the leading phase of its pair. Main road green
+ * rests until the side road is called.
+ */
+static const interval_template_t type1_sequence[] = {
+    {PHASE_2, SIGNAL_GREEN, SIGNAL_RED, ROAD_MAIN, TIMING_GREEN, SIDE_PHASES, MAIN_PHASES},
+    {PHASE_2, SIGNAL_YELLOW, SIGNAL_RED, ROAD_MAIN, TIMING_YELLOW, 0, 0},
+    {PHASE_2, SIGNAL_RED, SIGNAL_RED, ROAD_MAIN, TIMING_RED_CLEARANCE, 0, 0},
+    {PHASE_4, SIGNAL_RED, SIGNAL_GREEN, ROAD_SIDE, TIMING_GREEN, 0, SIDE_PHASES},
+    {PHASE_4, SIGNAL_RED, SIGNAL_YELLOW, ROAD_SIDE, TIMING_YELLOW, 0, 0},
+    {PHASE_4, SIGNAL_RED, SIGNAL_RED, ROAD_SIDE, TIMING_RED_CLEARANCE, 0, 0}};
+
+#define TYPE1_NUM_INTERVALS (sizeof(type1_sequence) / sizeof(interval_template_t))
+#define TYPE1_STARTUP_INTERVAL (TYPE1_NUM_INTERVALS - 1U) // All-red before main green
+#define TYPE1_FLASH_INTERVAL TYPE1_NUM_INTERVALS          // Follows the cycle, held by a flash plan
+#define TYPE1_MAIN_GREEN_INTERVAL 0U
+
+_Static_assert(TYPE1_FLASH_INTERVAL < CONTROLLER_FAULT_INTERVAL, "Type 1 intervals overlap the fault interval");
+#define TYPE1_SIDE_GREEN_INTERVAL 3U
+
+static uint32_t seconds_to_ms(const float seconds)
+{
+    return (uint32_t)(seconds * MS_PER_SEC + 0.5f);
+}
+
+static uint32_t interval_duration(const phase_timing_t *const timing, const timing_source_t source)
+{
+    uint32_t duration_ms;
+
+    switch (source)
+    {
+    case TIMING_GREEN:
+        duration_ms = seconds_to_ms(timing->min_green);
+        break;
+    case TIMING_YELLOW:
+        duration_ms = seconds_to_ms(timing->yellow_time);
+        break;
+    case TIMING_RED_CLEARANCE:
+        duration_ms = seconds_to_ms(timing->red_clearance);
+        break;
+    default:
+        duration_ms = 0;
+        break;
+    }
+
+    return duration_ms;
+}
+
+static void enter_interval(controller_t *const controller, const uint8_t index)
+{
+    const controller_interval_t *interval = &controller->intervals[index];
+
+    for (size_t phase = 0; phase < NUM_PHASES; phase++)
+    {
+        // A phase turning green starts with a full max timer
+        if (interval->green_mask & PHASE_BIT(phase))
+        {
+            controller->state.max_timer[phase] = controller->runtime.max_green_ms[phase];
+        }
+    }
+
+    controller->state.interval = index;
+    controller->state.current_phase = interval->phase;
+    controller->state.main_state = interval->main_state;
+    controller->state.side_state = interval->side_state;
+    controller->state.calls &= (uint8_t)~interval->green_mask;
+
+#ifdef DEBUG
+    printf("Interval %u: phase %d, main %d, side %d for %u ms\n",
+           index,
+           interval->phase + 1,
+           interval->main_state,
+           interval->side_state,
+           interval->duration_ms);
+#endif
+}
+
+/*
+ * Coordinated cycle, position 0 is the start of main road green. Main road
+ * green rests until its split less clearance has run, the yield point, and
+ * may yield later only while the side road still fits its minimum green
+ * before the cycle ends. Side road green is forced off in time for its
+ * clearance to end with the cycle.
+ */
+static void configure_coordination(controller_t *const controller, const coordination_t *const coord)
+{
+    controller_interval_t *intervals = controller->intervals;
+    controller_interval_t *main_green = &intervals[TYPE1_MAIN_GREEN_INTERVAL];
+    controller_interval_t *side_green = &intervals[TYPE1_SIDE_GREEN_INTERVAL];
+
+    controller->runtime.cycle_ms = seconds_to_ms(coord->cycle_length);
+    controller->runtime.offset_ms = seconds_to_ms(coord->offset);
+
+    if (controller->runtime.cycle_ms == 0)
+    {
+        return;
+    }
+
+    uint32_t cycle_ms = controller->runtime.cycle_ms;
+    uint32_t split_ms = seconds_to_ms(coord->split);
+    uint32_t main_clear_ms = intervals[TYPE1_MAIN_GREEN_INTERVAL + 1U].duration_ms +
+                             intervals[TYPE1_MAIN_GREEN_INTERVAL + 2U].duration_ms;
+    uint32_t side_clear_ms = intervals[TYPE1_SIDE_GREEN_INTERVAL + 1U].duration_ms +
+                             intervals[TYPE1_SIDE_GREEN_INTERVAL + 2U].duration_ms;
+    uint32_t late_yield_ms = side_green->duration_ms + side_clear_ms + main_clear_ms; // Before the cycle ends
+
+    // Validation keeps these ordered, rounding to ms must not close the window
+    main_green->window_start_ms = split_ms > main_clear_ms ? split_ms - main_clear_ms : 0;
+    main_green->window_end_ms = cycle_ms > late_yield_ms ? cycle_ms - late_yield_ms : 0;
+
+    if (main_green->window_end_ms < main_green->window_start_ms)
+    {
+        main_green->window_end_ms = main_green->window_start_ms;
+    }
+
+    main_green->extend_mask = 0; // Coordinated phases are not actuated
+
+    side_green->window_start_ms = split_ms;
+    side_green->window_end_ms = cycle_ms > side_clear_ms ? cycle_ms - side_clear_ms : 0;
+}
+
+bool controller_type1_configure(controller_t *const controller)
+{
+    bool result = false;
+
+    do
+    {
+        if (controller == NULL || controller->config == NULL)
+        {
+            fprintf(stderr, "Assertion error in controller_type1_configure\n");
+            break;
+        }
+
+        const config_t *config = controller->config;
+        const road_t *main_road = config->main_road != NULL ? config->main_road : &config->roads[0];
+        const road_t *side_road = main_road == &config->roads[0] ? &config->roads[1] : &config->roads[0];
+        const road_t *roads[] = {main_road, side_road}; // Indexed by road_role_t
+
+        // The cycle of a flash plan only runs on the way out of flash, in base timing
+        uint8_t plan = controller->state.plan;
+        const timing_plan_t *timing_plan = &config->plans[config->plans[plan].is_flash ? CONFIG_BASE_PLAN : plan];
+        const phase_timing_t *timings[] = {
+            &timing_plan->timing[main_road - config->roads],
+            &timing_plan->timing[side_road - config->roads]};
+
+        // Actuated timing per phase, a road's timing applies to both its directions
+        controller->runtime.phase_mask = 0;
+        for (size_t road = ROAD_MAIN; road <= ROAD_SIDE; road++)
+        {
+            const phase_timing_t *timing = timings[road];
+            bool is_actuated = timing->passage_time > 0.0f && timing->max_green > 0;
+
+            for (size_t dir = 0; dir < MAX_DIRECTIONS; dir++)
+            {
+                phase_t phase = direction_phases[road][dir];
+
+                controller->runtime.phase_mask |= PHASE_BIT(phase);
+                controller->runtime.passage_ms[phase] = is_actuated ? (uint16_t)seconds_to_ms(timing->passage_time) : 0;
+                controller->runtime.max_green_ms[phase] = is_actuated ? seconds_to_ms(timing->max_green) : 0;
+            }
+        }
+
+        size_t i;
+        for (i = 0; i < TYPE1_NUM_INTERVALS; i++)
+        {
+            const interval_template_t *tmpl = &type1_sequence[i];
+            controller_interval_t *interval = &controller->intervals[i];
+
+            interval->phase = tmpl->phase;
+            interval->main_state = tmpl->main_state;
+            interval->side_state = tmpl->side_state;
+            interval->duration_ms = interval_duration(timings[tmpl->road], tmpl->timing);
+            interval->next = (uint8_t)((i + 1U) % TYPE1_NUM_INTERVALS);
+            interval->hold_mask = tmpl->hold_mask;
+            interval->green_mask = tmpl->green_mask;
+            interval->extend_mask = 0;
+            interval->window_start_ms = 0;
+            interval->window_end_ms = 0;
+
+            for (size_t phase = 0; phase < NUM_PHASES; phase++)
+            {
+                if (controller->runtime.passage_ms[phase] > 0)
+                {
+                    interval->extend_mask |= tmpl->green_mask & PHASE_BIT(phase);
+                }
+            }
+
+            if (interval->duration_ms == 0)
+            {
+                fprintf(stderr, "Interval %lu has zero duration\n", i);
+                break;
+            }
+        }
+
+        if (i != TYPE1_NUM_INTERVALS)
+        {
+            break;
+        }
+
+        configure_coordination(controller, &timing_plan->coord);
+
+        // Main road flashes yellow and side road red until the schedule leaves the flash plan
+        controller->intervals[TYPE1_FLASH_INTERVAL] = (controller_interval_t){
+            .phase = PHASE_2,
+            .main_state = SIGNAL_FLASH_YELLOW,
+            .side_state = SIGNAL_FLASH_RED,
+            .duration_ms = CONTROLLER_NO_EXPIRY,
+            .next = TYPE1_STARTUP_INTERVAL,
+        };
+
+        // Both roads flash red after a conflict monitor fault, nothing leaves it
+        controller->intervals[CONTROLLER_FAULT_INTERVAL] = (controller_interval_t){
+            .phase = PHASE_2,
+            .main_state = SIGNAL_FLASH_RED,
+            .side_state = SIGNAL_FLASH_RED,
+            .duration_ms = CONTROLLER_NO_EXPIRY,
+            .next = CONTROLLER_FAULT_INTERVAL,
+        };
+
+        // Approaches without a detector cannot place calls, keep them on recall
+        controller->runtime.recall_mask = 0;
+        controller->runtime.lock_mask = 0;
+        controller->runtime.pulse_mask = 0;
+        for (size_t road = ROAD_MAIN; road <= ROAD_SIDE; road++)
+        {
+            for (size_t dir = 0; dir < MAX_DIRECTIONS; dir++)
+            {
+                const lane_group_t *lanes = &roads[road]->directions[dir].straight;
+                uint8_t bit = PHASE_BIT(direction_phases[road][dir]);
+
+                if (!lanes->has_detector)
+                {
+                    controller->runtime.recall_mask |= bit;
+                    continue;
+                }
+
+                if (lanes->detector.memory == DETECTOR_MEMORY_LOCK)
+                {
+                    controller->runtime.lock_mask |= bit;
+                }
+
+                if (lanes->detector.mode == DETECTOR_MODE_PULSE)
+                {
+                    controller->runtime.pulse_mask |= bit;
+                }
+            }
+        }
+
+        controller->runtime.flash_mask = 0;
+        for (i = 0; i < config->num_plans; i++)
+        {
+            controller->runtime.flash_mask |= config->plans[i].is_flash ? PLAN_BIT(i) : 0;
+        }
+
+        controller->runtime.num_intervals = CONTROLLER_FAULT_INTERVAL + 1U;
+        controller->runtime.active_plan = plan;
+
+        result = true;
+
+    } while (0);
+
+    return result;
+}
 
 bool controller_type1_init(controller_t *const controller)
 {
-    (void)controller;
+    if (!controller_type1_configure(controller))
+    {
+        return false;
+    }
+
+    controller->state.phase_timer = 0;
+    controller->state.termination = TERMINATION_NONE;
+
+    for (size_t phase = 0; phase < NUM_PHASES; phase++)
+    {
+        controller->state.gap_timer[phase] = 0;
+        controller->state.max_timer[phase] = controller->runtime.max_green_ms[phase];
+    }
+
+    enter_interval(controller, TYPE1_STARTUP_INTERVAL);
+
     return true;
 }
 
 void controller_type1_run(controller_t *const controller)
 {
-    (void)controller;
-    while (1)
-        ;
+    controller_type1_advance(controller, controller->tick_ms);
+}
+
+static uint32_t count_down(const uint32_t timer, const uint32_t elapsed_ms)
+{
+    return timer > elapsed_ms ? timer - elapsed_ms : 0;
+}
+
+/*
+ * Updates all passage and max timers in a single pass. Any actuation or
+ * occupied detector reloads the phase's passage timer. Max timers of green
+ * phases only run while a conflicting phase is waiting and reload otherwise,
+ * so a call that drops away (non-lock memory) restarts the max period. A
+ * flash plan waiting to start counts as a conflicting call, so steady
+ * traffic cannot hold off flash by extending green.
+ */
+static void update_phase_timers(
+    controller_t *const controller,
+    const uint8_t demand,
+    const bool is_flash,
+    const uint32_t elapsed_ms)
+{
+    controller_state_t *state = &controller->state;
+    uint8_t green = controller->intervals[state->interval].green_mask;
+    uint8_t actuated = state->extension | state->presence;
+    bool is_conflicting = is_flash || (demand & controller->runtime.phase_mask & (uint8_t)~green) != 0;
+    uint8_t running = is_conflicting ? green : 0;
+
+    for (size_t phase = 0; phase < NUM_PHASES; phase++)
+    {
+        uint8_t bit = PHASE_BIT(phase);
+
+        state->gap_timer[phase] = (actuated & bit) ? controller->runtime.passage_ms[phase]
+                                                   : count_down(state->gap_timer[phase], elapsed_ms);
+        state->max_timer[phase] = (running & bit) ? count_down(state->max_timer[phase], elapsed_ms)
+                                                  : controller->runtime.max_green_ms[phase];
+    }
+}
+
+// Switches to a reloaded config or a scheduled plan, between intervals or while resting
+static void take_plan_change(controller_t *const controller)
+{
+    if (atomic_load_explicit(&controller->pending_config, memory_order_relaxed) != NULL)
+    {
+        controller_apply_pending_config(controller);
+    }
+    else if (controller->state.plan != controller->runtime.active_plan)
+    {
+        controller->configure(controller);
+    }
+}
+
+// Leaves the flash interval once the schedule ends the flash plan or a reloaded config is waiting
+static void advance_flash(controller_t *const controller, const bool is_flash)
+{
+    if (is_flash && atomic_load_explicit(&controller->pending_config, memory_order_relaxed) == NULL)
+    {
+        return;
+    }
+
+    controller->state.phase_timer = 0;
+    take_plan_change(controller);
+
+    // Stay in flash if a reloaded config still selects a flash plan
+    bool is_still_flash = (controller->runtime.flash_mask & PLAN_BIT(controller->state.plan)) != 0;
+    enter_interval(controller, is_still_flash ? TYPE1_FLASH_INTERVAL : TYPE1_STARTUP_INTERVAL);
+}
+
+void controller_type1_advance(controller_t *const controller, const uint32_t elapsed_ms)
+{
+    controller_state_t *state = &controller->state;
+    const controller_interval_t *interval = &controller->intervals[state->interval];
+
+    controller_advance_clock(controller, elapsed_ms);
+
+    if (atomic_load_explicit(&controller->is_faulted, memory_order_relaxed))
+    {
+        if (state->interval != CONTROLLER_FAULT_INTERVAL)
+        {
+            enter_interval(controller, CONTROLLER_FAULT_INTERVAL);
+        }
+
+        return;
+    }
+
+    uint8_t demand = controller_demand(controller);
+    bool is_flash = (controller->runtime.flash_mask & PLAN_BIT(state->plan)) != 0;
+
+    update_phase_timers(controller, demand, is_flash, elapsed_ms);
+    state->extension = 0; // Actuations are consumed once per step
+    state->phase_timer += elapsed_ms;
+
+    if (state->interval == TYPE1_FLASH_INTERVAL)
+    {
+        advance_flash(controller, is_flash);
+        return;
+    }
+
+    if (state->phase_timer < interval->duration_ms)
+    {
+        return;
+    }
+
+    bool is_coordinated = controller->runtime.cycle_ms != 0 && !is_flash;
+    uint32_t position = controller_cycle_position(controller);
+
+    if (interval->hold_mask != 0 && !is_flash &&
+        ((demand & interval->hold_mask) == 0 ||
+         (is_coordinated && (position < interval->window_start_ms || position > interval->window_end_ms))))
+    {
+        // Rest in green, nothing conflicting is waiting or the cycle has not reached the yield point.
+        // A rest may last all day, so plan and config changes are taken here too and the rest goes on.
+        take_plan_change(controller);
+        state->phase_timer = controller->intervals[state->interval].duration_ms;
+        return;
+    }
+
+    termination_t termination = TERMINATION_TIMED;
+    bool is_split = is_coordinated && interval->hold_mask == 0 && interval->green_mask != 0;
+
+    if (is_split && (position < interval->window_start_ms || position >= interval->window_end_ms))
+    {
+        termination = TERMINATION_FORCE_OFF;
+    }
+    else if (is_split && interval->extend_mask == 0)
+    {
+        return; // Non-actuated green runs its whole split
+    }
+    else if (interval->extend_mask != 0)
+    {
+        uint8_t gapped = 0;
+        uint8_t maxed = 0;
+
+        for (size_t phase = 0; phase < NUM_PHASES; phase++)
+        {
+            gapped |= (state->gap_timer[phase] == 0) ? PHASE_BIT(phase) : 0;
+            maxed |= (state->max_timer[phase] == 0) ? PHASE_BIT(phase) : 0;
+        }
+
+        if ((maxed & interval->extend_mask) != 0)
+        {
+            termination = TERMINATION_MAX_OUT;
+        }
+        else if ((gapped & interval->extend_mask) == interval->extend_mask)
+        {
+            termination = TERMINATION_GAP_OUT;
+        }
+        else
+        {
+            return; // Extend green, traffic is still arriving
+        }
+    }
+
+    // Keep the remainder of an interval that just expired, no drift
+    uint32_t overrun_ms = state->phase_timer - interval->duration_ms;
+    state->phase_timer = overrun_ms < elapsed_ms ? overrun_ms : 0;
+
+    if (interval->green_mask != 0)
+    {
+        state->termination = termination;
+    }
+
+    uint8_t next = interval->next;
+    bool is_red_clearance = interval->main_state == SIGNAL_RED && interval->side_state == SIGNAL_RED;
+
+    // A reloaded config or a scheduled plan takes effect here, each interval is timed by a single plan
+    take_plan_change(controller);
+
+    // Flash starts after a red clearance, when every approach is already stopped
+    if (is_red_clearance && (controller->runtime.flash_mask & PLAN_BIT(state->plan)) != 0)
+    {
+        next = TYPE1_FLASH_INTERVAL;
+    }
+
+    enter_interval(controller, next);
 }
@@ -0,0 +1,454 @@
+#include "coordination.h"
+#include <math.h>
+#include <stdio.h>
+#include <string.h>
+
+#define FT_PER_MILE 5280.0f
+#define SEC_PER_HOUR 3600.0f
+#define MAX_SWEEPS 16U       // Coordinate descent passes over all nodes
+#define MIN_IMPROVEMENT 0.01f // Seconds of bandwidth, ends the descent
+
+// Model of the corridor for one cycle length, times in seconds
+typedef struct
+{
+    size_t num_nodes;
+    float cycle;
+    float travel[CORRIDOR_MAX_NODES]; // From the first node at progression speed, modulo the cycle
+    float green[CORRIDOR_MAX_NODES];  // Main road green within its split
+    float offset[CORRIDOR_MAX_NODES]; // Main road green start, whole seconds
+} band_model_t;
+
+// Starting offsets of the descent
+typedef enum
+{
+    START_OUTBOUND,     // Progression towards increasing position
+    START_INBOUND,      // Progression towards decreasing position
+    START_SIMULTANEOUS, // All greens start together
+    START_ALTERNATE,    // Neighbours half a cycle apart
+    NUM_STARTS
+} start_t;
+
+typedef struct
+{
+    const corridor_t *corridor;
+    corridor_plan_t *plans;
+    uint16_t min_cycle;
+    uint16_t step;
+} search_t;
+
+/* Bandwidth, these helpers are branch free so the candidate loop vectorizes */
+
+static inline float min_f(const float a, const float b)
+{
+    return a < b ? a : b;
+}
+
+static inline float max_f(const float a, const float b)
+{
+    return a > b ? a : b;
+}
+
+// Wraps a time less than one cycle away from [0, cycle) into it
+static inline float wrap(const float t, const float cycle)
+{
+    float wrapped = t + (t < 0.0f ? cycle : 0.0f);
+    return wrapped - (wrapped >= cycle ? cycle : 0.0f);
+}
+
+// Overlap of [lo, hi] with a green arc starting at start, which may run past the end of the cycle
+static inline float arc_overlap(const float lo, const float hi, const float start, const float green, const float cycle)
+{
+    float overlap = min_f(hi, start + green) - max_f(lo, start);
+    float wrapped = min_f(hi, start - cycle + green) - max_f(lo, start - cycle);
+    return max_f(max_f(overlap, wrapped), 0.0f);
+}
+
+/*
+ * Intersects the green arcs of all nodes but skip, as seen by a vehicle
+ * passing the first node. Outbound vehicles reach a node travel seconds
+ * later (direction 1), inbound ones left it travel seconds earlier (-1).
+ * Times are relative to the green start of the first node.
+ */
+static void band_bounds(
+    const band_model_t *const model,
+    const size_t skip,
+    const float direction,
+    float *const lo,
+    float *const hi)
+{
+    float cycle = model->cycle;
+    float first_green = model->green[0];
+
+    *lo = 0.0f;
+    *hi = first_green;
+
+    for (size_t i = 1; i < model->num_nodes; i++)
+    {
+        if (i == skip)
+        {
+            continue;
+        }
+
+        float start = wrap(model->offset[i] - direction * model->travel[i], cycle);
+        float end = start + model->green[i];
+
+        // An arc running past the cycle end may reach the first green from before it,
+        // start lies in [0, cycle) so only the arc itself can begin inside that green
+        float overlap = min_f(first_green, end) - start;
+        float wrapped_overlap = min_f(first_green, end - cycle);
+
+        if (wrapped_overlap > overlap)
+        {
+            start -= cycle;
+            end -= cycle;
+        }
+
+        *lo = max_f(*lo, start);
+        *hi = min_f(*hi, end);
+    }
+}
+
+static void bandwidths(const band_model_t *const model, float *const out, float *const in)
+{
+    float lo;
+    float hi;
+
+    band_bounds(model, 0, 1.0f, &lo, &hi);
+    *out = max_f(hi - lo, 0.0f);
+
+    band_bounds(model, 0, -1.0f, &lo, &hi);
+    *in = max_f(hi - lo, 0.0f);
+}
+
+// Two-way bandwidth for every whole second offset of one node, with the band of the others fixed
+static void candidate_bands(
+    const float out_lo,
+    const float out_hi,
+    const float in_lo,
+    const float in_hi,
+    const float travel,
+    const float green,
+    const float cycle,
+    float bands[MAX_CYCLE_LENGTH])
+{
+    // A fixed trip count and a signed counter, which converts to float in a
+    // vector instruction, keep the loop vectorized. Offsets past the cycle are ignored
+    for (int32_t k = 0; k < (int32_t)MAX_CYCLE_LENGTH; k++)
+    {
+        float offset = (float)k;
+        float out_start = wrap(offset - travel, cycle);
+        float in_start = wrap(offset + travel, cycle);
+
+        bands[k] = arc_overlap(out_lo, out_hi, out_start, green, cycle) +
+                   arc_overlap(in_lo, in_hi, in_start, green, cycle);
+    }
+}
+
+// Best offset of one node, the others fixed, returns the resulting two-way bandwidth
+static float optimize_node(band_model_t *const model, const size_t index, const float bandwidth)
+{
+    float bands[MAX_CYCLE_LENGTH];
+    float out_lo;
+    float out_hi;
+    float in_lo;
+    float in_hi;
+
+    band_bounds(model, index, 1.0f, &out_lo, &out_hi);
+    band_bounds(model, index, -1.0f, &in_lo, &in_hi);
+    candidate_bands(
+        out_lo,
+        out_hi,
+        in_lo,
+        in_hi,
+        model->travel[index],
+        model->green[index],
+        model->cycle,
+        bands);
+
+    size_t best = 0;
+    size_t num_candidates = (size_t)model->cycle;
+    for (size_t k = 1; k < num_candidates; k++)
+    {
+        best = bands[k] > bands[best] ? k : best;
+    }
+
+    // The candidate bands pick each arc's best wrap, so confirm on the whole corridor
+    float previous = model->offset[index];
+    float out;
+    float in;
+
+    model->offset[index] = (float)best;
+    bandwidths(model, &out, &in);
+
+    if (out + in > bandwidth + MIN_IMPROVEMENT)
+    {
+        return out + in;
+    }
+
+    model->offset[index] = previous;
+    return bandwidth;
+}
+
+// Sets the starting offsets, then improves one node at a time until no node gains bandwidth
+static float descend(band_model_t *const model, const start_t start)
+{
+    for (size_t i = 1; i < model->num_nodes; i++)
+    {
+        float offset;
+
+        switch (start)
+        {
+        case START_OUTBOUND:
+            offset = roundf(model->travel[i]);
+            break;
+        case START_INBOUND:
+            offset = roundf(model->cycle - model->travel[i]);
+            break;
+        case START_ALTERNATE:
+            offset = (i % 2U) != 0 ? roundf(0.5f * model->cycle) : 0.0f;
+            break;
+        default:
+            offset = 0.0f;
+            break;
+        }
+
+        model->offset[i] = fmodf(offset, model->cycle);
+    }
+
+    float out;
+    float in;
+    bandwidths(model, &out, &in);
+    float bandwidth = out + in;
+
+    for (size_t sweep = 0; sweep < MAX_SWEEPS; sweep++)
+    {
+        float previous = bandwidth;
+
+        for (size_t i = 1; i < model->num_nodes; i++)
+        {
+            bandwidth = optimize_node(model, i, bandwidth);
+        }
+
+        if (bandwidth <= previous)
+        {
+            break;
+        }
+    }
+
+    return bandwidth;
+}
+
+// Main road split of a node scaled to the cycle, 0 if its minimum times do not fit
+static uint16_t node_split(const corridor_node_t *const node, const float cycle)
+{
+    float min_split = ceilf(node->main_min_s);
+    float max_split = floorf(cycle - node->side_min_s);
+
+    if (min_split > max_split)
+    {
+        return 0;
+    }
+
+    // A node running free gives the side road its minimum and the main road the rest
+    float split = node->split_ratio > 0.0f ? roundf(node->split_ratio * cycle) : max_split;
+
+    return (uint16_t)max_f(min_f(split, max_split), min_split);
+}
+
+static void optimize_task(void *const ctx, const uint32_t task)
+{
+    const search_t *search = ctx;
+
+    corridor_optimize(
+        search->corridor,
+        (uint16_t)(search->min_cycle + task * search->step),
+        &search->plans[task]);
+}
+
+/*Interface Functions*/
+
+bool corridor_add(corridor_t *const corridor, const config_t *const config)
+{
+    bool result = false;
+
+    do
+    {
+        if (corridor == NULL || config == NULL)
+        {
+            fprintf(stderr, "Assertion error in corridor_add\n");
+            break;
+        }
+
+        if (corridor->num_nodes == CORRIDOR_MAX_NODES)
+        {
+            fprintf(stderr,
+                    "Too many intersections in the corridor, must be not more than %u\n",
+                    CORRIDOR_MAX_NODES);
+            break;
+        }
+
+        const road_t *main_road = config->main_road != NULL ? config->main_road : &config->roads[0];
+        size_t main_index = (size_t)(main_road - config->roads);
+        const timing_plan_t *plan = &config->plans[CONFIG_BASE_PLAN];
+        const phase_timing_t *main_timing = &plan->timing[main_index];
+        const phase_timing_t *side_timing = &plan->timing[1U - main_index];
+        const coordination_t *coord = &plan->coord;
+
+        corridor_node_t node = {
+            .position_ft = config->corridor_position,
+            .speed_fps = (float)main_road->speed_limit * FT_PER_MILE / SEC_PER_HOUR,
+            .split_ratio = coord->cycle_length > 0 ? (float)coord->split / (float)coord->cycle_length : 0.0f,
+            .main_clear_s = main_timing->yellow_time + main_timing->red_clearance,
+            .side_min_s = (float)side_timing->min_green + side_timing->yellow_time + side_timing->red_clearance,
+        };
+
+        snprintf(node.id, MAX_STR_LEN, "%s", config->id);
+        node.main_min_s = (float)main_timing->min_green + node.main_clear_s;
+
+        // Keep the nodes sorted, a node at the same position goes after the ones already there
+        size_t i = corridor->num_nodes;
+        while (i > 0 && corridor->nodes[i - 1U].position_ft > node.position_ft)
+        {
+            corridor->nodes[i] = corridor->nodes[i - 1U];
+            i--;
+        }
+
+        corridor->nodes[i] = node;
+        corridor->num_nodes++;
+
+        result = true;
+
+    } while (0);
+
+    return result;
+}
+
+void corridor_optimize(const corridor_t *const corridor, const uint16_t cycle_length, corridor_plan_t *const plan)
+{
+    band_model_t model = {.num_nodes = corridor->num_nodes, .cycle = (float)cycle_length};
+
+    memset(plan, 0, sizeof(*plan));
+    plan->cycle_length = cycle_length;
+
+    float travel = 0.0f;
+    for (size_t i = 0; i < corridor->num_nodes; i++)
+    {
+        const corridor_node_t *node = &corridor->nodes[i];
+
+        plan->splits[i] = node_split(node, model.cycle);
+
+        if (plan->splits[i] == 0)
+        {
+            return; // Infeasible cycle length
+        }
+
+        model.green[i] = (float)plan->splits[i] - node->main_clear_s;
+
+        // Links are travelled at the mean speed limit of their ends
+        if (i > 0)
+        {
+            const corridor_node_t *prev = &corridor->nodes[i - 1U];
+            float speed = max_f(0.5f * (prev->speed_fps + node->speed_fps), 1.0f);
+            travel += (float)(node->position_ft - prev->position_ft) / speed;
+        }
+
+        model.travel[i] = fmodf(travel, model.cycle);
+    }
+
+    // The descent only finds a local optimum, so it starts from each classic pattern
+    float best_bandwidth = -1.0f;
+
+    for (size_t start = 0; start < NUM_STARTS; start++)
+    {
+        float bandwidth = descend(&model, (start_t)start);
+
+        if (bandwidth > best_bandwidth)
+        {
+            best_bandwidth = bandwidth;
+
+            for (size_t i = 0; i < model.num_nodes; i++)
+            {
+                plan->offsets[i] = (uint16_t)model.offset[i];
+            }
+        }
+    }
+
+    for (size_t i = 0; i < model.num_nodes; i++)
+    {
+        model.offset[i] = (float)plan->offsets[i];
+    }
+
+    bandwidths(&model, &plan->bandwidth_out, &plan->bandwidth_in);
+    plan->efficiency = (plan->bandwidth_out + plan->bandwidth_in) / (2.0f * model.cycle);
+    plan->is_feasible = true;
+}
+
+bool corridor_search(
+    const corridor_t *const corridor,
+    thread_pool_t *const pool,
+    const uint16_t min_cycle,
+    const uint16_t max_cycle,
+    const uint16_t step,
+    corridor_plan_t *const plans,
+    size_t *const num_plans)
+{
+    bool result = false;
+    uint32_t tasks[CORRIDOR_MAX_CYCLES];
+
+    do
+    {
+        if (corridor == NULL ||
+            pool == NULL ||
+            plans == NULL ||
+            num_plans == NULL ||
+            step == 0 ||
+            min_cycle < MIN_CYCLE_LENGTH ||
+            max_cycle > MAX_CYCLE_LENGTH ||
+            min_cycle > max_cycle)
+        {
+            fprintf(stderr, "Assertion error in corridor_search\n");
+            break;
+        }
+
+        if (corridor->num_nodes == 0)
+        {
+            fprintf(stderr, "Corridor has no intersections\n");
+            break;
+        }
+
+        size_t count = (size_t)(max_cycle - min_cycle) / step + 1U;
+
+        for (size_t i = 0; i < count; i++)
+        {
+            tasks[i] = (uint32_t)i;
+        }
+
+        search_t search = {.corridor = corridor, .plans = plans, .min_cycle = min_cycle, .step = step};
+        thread_pool_run(pool, tasks, count, optimize_task, &search);
+
+        *num_plans = count;
+        result = true;
+
+    } while (0);
+
+    return result;
+}
+
+size_t corridor_best_plan(const corridor_plan_t *const plans, const size_t count)
+{
+    size_t best = count;
+
+    for (size_t i = 0; i < count; i++)
+    {
+        if (plans[i].is_feasible &&
+            (best == count ||
+             plans[i].efficiency > plans[best].efficiency ||
+             (plans[i].efficiency == plans[best].efficiency &&
+              plans[i].cycle_length < plans[best].cycle_length)))
+        {
+            best = i;
+        }
+    }
+
+    return best;
+}
@@ -0,0 +1,416 @@
+#include "detector_input.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <strings.h>
+#include <ctype.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <poll.h>
+#include <time.h>
+#include <unistd.h>
+#include <sys/stat.h>
+
+#define SOURCE_BUFFER_LEN 4096U
+#define SOURCE_POLL_TIMEOUT_MS 100 // Bounds shutdown latency of producer threads
+#define NS_PER_SEC 1000000000ULL
+
+static uint64_t monotonic_ns(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * NS_PER_SEC + (uint64_t)ts.tv_nsec;
+}
+
+bool detector_ring_push(detector_ring_t *const ring, const detector_event_t *const event)
+{
+    size_t head = atomic_load_explicit(&ring->head, memory_order_relaxed);
+    size_t tail = atomic_load_explicit(&ring->tail, memory_order_acquire);
+
+    if (head - tail == DETECTOR_RING_SIZE)
+    {
+        return false;
+    }
+
+    ring->events[head & DETECTOR_RING_MASK] = *event;
+    atomic_store_explicit(&ring->head, head + 1U, memory_order_release);
+
+    return true;
+}
+
+size_t detector_ring_pop(detector_ring_t *const ring, detector_event_t *const events, const size_t max_events)
+{
+    size_t tail = atomic_load_explicit(&ring->tail, memory_order_relaxed);
+    size_t head = atomic_load_explicit(&ring->head, memory_order_acquire);
+    size_t count = head - tail < max_events ? head - tail : max_events;
+
+    for (size_t i = 0; i < count; i++)
+    {
+        events[i] = ring->events[(tail + i) & DETECTOR_RING_MASK];
+    }
+
+    atomic_store_explicit(&ring->tail, tail + count, memory_order_release);
+
+    return count;
+}
+
+static int compare_routes(const void *a, const void *b)
+{
+    return strcmp(((const detector_route_t *)a)->id, ((const detector_route_t *)b)->id);
+}
+
+static int compare_route_id(const void *key, const void *route)
+{
+    return strcmp(key, ((const detector_route_t *)route)->id);
+}
+
+// Cuts the first word off line and returns it, line then points past it
+static char *next_word(char **const line)
+{
+    char *word = *line;
+    char *end = word;
+
+    while (*end != '\0' && !isspace((unsigned char)*end))
+    {
+        end++;
+    }
+
+    *line = end;
+
+    while (isspace((unsigned char)**line))
+    {
+        (*line)++;
+    }
+
+    *end = '\0';
+
+    return word;
+}
+
+static bool parse_event_line(const detector_source_t *const source, char *line, detector_event_t *const event)
+{
+    event->intersection = 0;
+
+    if (source->routes != NULL)
+    {
+        const char *id = next_word(&line);
+        const detector_route_t *route = bsearch(id, source->routes, source->num_routes, sizeof(detector_route_t), compare_route_id);
+
+        if (route == NULL)
+        {
+            return false;
+        }
+
+        event->intersection = route->index;
+    }
+
+    char *end;
+    long phase = strtol(line, &end, 10);
+
+    if (end == line || phase < 1 || phase > NUM_PHASES)
+    {
+        return false;
+    }
+
+    while (isspace((unsigned char)*end))
+    {
+        end++;
+    }
+
+    char *state = end;
+    while (*end != '\0' && !isspace((unsigned char)*end))
+    {
+        end++;
+    }
+    *end = '\0';
+
+    if (strcasecmp(state, "on") == 0 || strcmp(state, "1") == 0)
+    {
+        event->is_on = true;
+    }
+    else if (strcasecmp(state, "off") == 0 || strcmp(state, "0") == 0)
+    {
+        event->is_on = false;
+    }
+    else
+    {
+        return false;
+    }
+
+    event->phase = (uint8_t)(PHASE_1 + phase - 1);
+    return true;
+}
+
+static void process_lines(detector_source_t *const source, char *const buffer, size_t *const len)
+{
+    char *line = buffer;
+    char *newline;
+
+    while ((newline = memchr(line, '\n', *len - (size_t)(line - buffer))) != NULL)
+    {
+        *newline = '\0';
+
+        detector_event_t event = {
+            .timestamp_ns = monotonic_ns(),
+            .source = source->index};
+
+        if (*line == '\0' || *line == '#')
+        {
+            // Blank or comment line
+        }
+        else if (!parse_event_line(source, line, &event))
+        {
+            source->invalid++;
+        }
+        else if (detector_ring_push(&source->ring, &event))
+        {
+            source->received++;
+        }
+        else
+        {
+            source->dropped++;
+        }
+
+        line = newline + 1;
+    }
+
+    // Keep the incomplete tail for the next read, drop overlong lines
+    size_t remaining = *len - (size_t)(line - buffer);
+
+    if (remaining == SOURCE_BUFFER_LEN)
+    {
+        source->invalid++;
+        remaining = 0;
+    }
+
+    memmove(buffer, line, remaining);
+    *len = remaining;
+}
+
+static void *source_main(void *arg)
+{
+    detector_source_t *source = arg;
+    char buffer[SOURCE_BUFFER_LEN];
+    size_t len = 0;
+    struct pollfd pfd = {.fd = source->fd, .events = POLLIN};
+
+    while (!atomic_load_explicit(source->is_stopping, memory_order_relaxed))
+    {
+        int ready = poll(&pfd, 1, SOURCE_POLL_TIMEOUT_MS);
+
+        if (ready <= 0)
+        {
+            continue;
+        }
+
+        ssize_t num_read = read(source->fd, buffer + len, sizeof(buffer) - len);
+
+        if (num_read < 0 && (errno == EINTR || errno == EAGAIN))
+        {
+            continue;
+        }
+
+        if (num_read <= 0)
+        {
+            // End of a recorded file, or the device went away
+            break;
+        }
+
+        len += (size_t)num_read;
+        process_lines(source, buffer, &len);
+    }
+
+    return NULL;
+}
+
+static int open_source(const char *const path)
+{
+    struct stat st;
+
+    if (stat(path, &st) != 0)
+    {
+        return -1;
+    }
+
+    // Holding the write end of a FIFO open keeps it from reporting EOF between writers
+    return open(path, S_ISFIFO(st.st_mode) ? O_RDWR : O_RDONLY);
+}
+
+// Sorts the intersection IDs of the controllers, an ID must name a single controller
+static bool build_routes(detector_input_t *const input, const controller_t *const controllers, const size_t num_controllers)
+{
+    input->routes = malloc(num_controllers * sizeof(detector_route_t));
+
+    if (input->routes == NULL)
+    {
+        fprintf(stderr, "Out of memory while routing detector sources\n");
+        return false;
+    }
+
+    input->num_routes = num_controllers;
+
+    for (size_t i = 0; i < num_controllers; i++)
+    {
+        input->routes[i] = (detector_route_t){.id = controllers[i].config->id, .index = (uint32_t)i};
+    }
+
+    qsort(input->routes, num_controllers, sizeof(detector_route_t), compare_routes);
+
+    for (size_t i = 1; i < num_controllers; i++)
+    {
+        if (strcmp(input->routes[i - 1U].id, input->routes[i].id) == 0)
+        {
+            fprintf(stderr, "Intersection ID %s is used by several configs, detector lines cannot tell them apart\n", input->routes[i].id);
+            return false;
+        }
+    }
+
+    return true;
+}
+
+bool detector_input_start(
+    detector_input_t *const input,
+    char *const paths[],
+    const size_t count,
+    const controller_t *const controllers,
+    const size_t num_controllers)
+{
+    bool result = false;
+    size_t num_started = 0;
+
+    do
+    {
+        if (input == NULL || paths == NULL || count == 0)
+        {
+            fprintf(stderr, "Assertion error in detector_input_start\n");
+            break;
+        }
+
+        memset(input, 0, sizeof(*input));
+        atomic_init(&input->is_stopping, false);
+
+        if (count > MAX_DETECTOR_SOURCES)
+        {
+            fprintf(stderr,
+                    "Too many detector sources %lu, must be not more than %u\n",
+                    count,
+                    MAX_DETECTOR_SOURCES);
+            break;
+        }
+
+        if (controllers != NULL && !build_routes(input, controllers, num_controllers))
+        {
+            break;
+        }
+
+        input->sources = aligned_alloc(DETECTOR_CACHE_LINE, count * sizeof(detector_source_t));
+
+        if (input->sources == NULL)
+        {
+            fprintf(stderr, "Out of memory while creating detector sources\n");
+            break;
+        }
+
+        memset(input->sources, 0, count * sizeof(detector_source_t));
+
+        for (num_started = 0; num_started < count; num_started++)
+        {
+            detector_source_t *source = &input->sources[num_started];
+
+            atomic_init(&source->ring.head, 0);
+            atomic_init(&source->ring.tail, 0);
+            source->path = paths[num_started];
+            source->index = (uint8_t)num_started;
+            source->is_stopping = &input->is_stopping;
+            source->routes = input->routes;
+            source->num_routes = input->num_routes;
+            source->fd = open_source(source->path);
+
+            if (source->fd < 0)
+            {
+                fprintf(stderr, "Failed to open detector source: %s\n", source->path);
+                break;
+            }
+
+            if (pthread_create(&source->thread, NULL, source_main, source) != 0)
+            {
+                fprintf(stderr, "Failed to start detector thread for %s\n", source->path);
+                close(source->fd);
+                break;
+            }
+        }
+
+        input->count = num_started;
+
+        if (num_started != count)
+        {
+            break;
+        }
+
+        result = true;
+
+    } while (0);
+
+    if (!result && input != NULL)
+    {
+        detector_input_stop(input);
+    }
+
+    return result;
+}
+
+size_t detector_input_drain(
+    detector_input_t *const input,
+    controller_t *const controller,
+    event_log_t *const log,
+    const uint64_t time_ms)
+{
+    detector_event_t events[DETECTOR_BATCH_SIZE];
+    size_t total = 0;
+
+    for (size_t i = 0; i < input->count; i++)
+    {
+        size_t count;
+
+        while ((count = detector_ring_pop(&input->sources[i].ring, events, DETECTOR_BATCH_SIZE)) > 0)
+        {
+            for (size_t j = 0; j < count; j++)
+            {
+                controller_detector_input(controller, (phase_t)events[j].phase, events[j].is_on);
+                event_log_input(log, 0, time_ms, events[j].is_on ? EVENT_DETECTOR_ON : EVENT_DETECTOR_OFF, (phase_t)events[j].phase);
+            }
+
+            total += count;
+        }
+    }
+
+    input->drained += total;
+
+    return total;
+}
+
+void detector_input_stop(detector_input_t *const input)
+{
+    atomic_store(&input->is_stopping, true);
+
+    for (size_t i = 0; i < input->count; i++)
+    {
+        detector_source_t *source = &input->sources[i];
+
+        pthread_join(source->thread, NULL);
+        close(source->fd);
+
+        printf("Detector %s: %llu events, %llu dropped, %llu invalid\n",
+               source->path,
+               (unsigned long long)source->received,
+               (unsigned long long)source->dropped,
+               (unsigned long long)source->invalid);
+    }
+
+    free(input->sources);
+    free(input->routes);
+    input->sources = NULL;
+    input->routes = NULL;
+    input->count = 0;
+    input->num_routes = 0;
+}
@@ -0,0 +1,357 @@
+#include "event_log.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <fcntl.h>
+#include <time.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+#define EVENT_SHOWN_NONE 0xFFU // Nothing logged yet, forces the first update
+#define EVENT_PAGE_SIZE 4096U
+
+static uint64_t records_offset(const size_t count)
+{
+    uint64_t ids_end = sizeof(event_log_header_t) + (uint64_t)count * MAX_STR_LEN;
+    return (ids_end + EVENT_PAGE_SIZE - 1U) & ~(uint64_t)(EVENT_PAGE_SIZE - 1U);
+}
+
+static uint64_t realtime_ms(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_REALTIME, &ts);
+    return (uint64_t)ts.tv_sec * 1000U + (uint64_t)ts.tv_nsec / 1000000U;
+}
+
+/*Interface Functions*/
+
+bool event_log_open(
+    event_log_t *const log,
+    const char *const path,
+    const uint64_t capacity,
+    const controller_t *const controllers,
+    const size_t count,
+    const uint32_t tick_ms,
+    const bool is_virtual)
+{
+    bool result = false;
+    int fd = -1;
+
+    do
+    {
+        if (log == NULL || controllers == NULL || count == 0 || count > UINT16_MAX + 1U ||
+            capacity == 0 || (capacity & (capacity - 1U)) != 0)
+        {
+            fprintf(stderr, "Assertion error in event_log_open\n");
+            break;
+        }
+
+        memset(log, 0, sizeof(*log));
+        log->map_len = (size_t)(records_offset(count) + capacity * sizeof(event_record_t));
+
+        void *map = MAP_FAILED;
+
+        if (path == NULL)
+        {
+            map = mmap(NULL, log->map_len, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_POPULATE, -1, 0);
+        }
+        else
+        {
+            fd = open(path, O_RDWR | O_CREAT | O_TRUNC, 0644);
+
+            if (fd < 0)
+            {
+                fprintf(stderr, "Failed to create event log: %s\n", path);
+                break;
+            }
+
+            // Allocated, not sparse, so writeback of a store can never run out of space
+            if (posix_fallocate(fd, 0, (off_t)log->map_len) != 0)
+            {
+                fprintf(stderr, "Failed to allocate %lu bytes for event log: %s\n", log->map_len, path);
+                break;
+            }
+
+            map = mmap(NULL, log->map_len, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, fd, 0);
+        }
+
+        if (map == MAP_FAILED)
+        {
+            fprintf(stderr, "Failed to map event log: %s\n", path != NULL ? path : "memory");
+            break;
+        }
+
+        log->header = map;
+        log->records = (event_record_t *)((char *)map + records_offset(count));
+        log->mask = capacity - 1U;
+
+        log->tracks = calloc(count, sizeof(event_track_t));
+
+        if (log->tracks == NULL)
+        {
+            fprintf(stderr, "Out of memory while creating event log\n");
+            break;
+        }
+
+        log->controllers = controllers;
+        log->count = count;
+
+        char (*ids)[MAX_STR_LEN] = (char (*)[MAX_STR_LEN])(log->header + 1);
+
+        for (size_t i = 0; i < count; i++)
+        {
+            snprintf(ids[i], MAX_STR_LEN, "%s", controllers[i].config->id);
+            log->tracks[i].phase_mask = controllers[i].runtime.phase_mask;
+            log->tracks[i].main_shown = EVENT_SHOWN_NONE;
+            log->tracks[i].side_shown = EVENT_SHOWN_NONE;
+            log->tracks[i].plan = EVENT_SHOWN_NONE;
+        }
+
+        event_log_header_t *header = log->header;
+        header->version = EVENT_LOG_VERSION;
+        header->record_size = sizeof(event_record_t);
+        header->capacity = capacity;
+        atomic_init(&header->head, 0);
+        header->epoch_ms = is_virtual ? 0 : realtime_ms();
+        header->records_offset = records_offset(count);
+        header->tick_ms = tick_ms;
+        header->num_intersections = (uint32_t)count;
+        memcpy(header->magic, EVENT_LOG_MAGIC, sizeof(EVENT_LOG_MAGIC));
+
+        // Every controller starts from an unknown state, so the log opens with all signals and plans
+        for (size_t i = 0; i < count; i++)
+        {
+            event_log_update(log, i, 0);
+        }
+
+        result = true;
+
+    } while (0);
+
+    // The mapping keeps the file open
+    if (fd >= 0)
+    {
+        close(fd);
+    }
+
+    if (!result && log != NULL)
+    {
+        event_log_close(log);
+    }
+
+    return result;
+}
+
+void event_log_append(event_log_t *const log, const event_record_t *const record)
+{
+    log->records[log->head & log->mask] = *record;
+    log->head++;
+
+    // Single writer, a reader of the file sees the record before the head that counts it
+    atomic_store_explicit(&log->header->head, log->head, memory_order_release);
+}
+
+void event_log_update(event_log_t *const log, const size_t index, const uint64_t time_ms)
+{
+    if (index >= log->count)
+    {
+        return;
+    }
+
+    const controller_t *controller = &log->controllers[index];
+    const controller_state_t *state = &controller->state;
+    event_track_t *track = &log->tracks[index];
+    event_record_t record = {.time_ms = time_ms, .intersection = (uint16_t)index};
+
+    if (controller->runtime.active_plan != track->plan)
+    {
+        record.kind = EVENT_PLAN;
+        record.value = controller->runtime.active_plan;
+        event_log_append(log, &record);
+        track->plan = controller->runtime.active_plan;
+    }
+
+    if (state->interval == CONTROLLER_FAULT_INTERVAL && !track->is_faulted)
+    {
+        record.kind = EVENT_FAULT;
+        record.value = 0;
+        event_log_append(log, &record);
+        track->is_faulted = true;
+    }
+
+    if (state->main_state == track->main_shown && state->side_state == track->side_shown)
+    {
+        return;
+    }
+
+    record.kind = EVENT_SIGNAL;
+    record.value = 0;
+
+    for (phase_t phase = PHASE_1; phase < NUM_PHASES; phase++)
+    {
+        if ((track->phase_mask & PHASE_BIT(phase)) == 0)
+        {
+            continue;
+        }
+
+        bool is_main = (MAIN_ROAD_PHASES & PHASE_BIT(phase)) != 0;
+        uint8_t shown = is_main ? track->main_shown : track->side_shown;
+        record.phase = (uint8_t)phase;
+        record.state = (uint8_t)(is_main ? state->main_state : state->side_state);
+
+        if (record.state == shown)
+        {
+            continue;
+        }
+
+        // A head leaving green was ended by the termination the controller just recorded
+        record.cause = (uint8_t)(shown == SIGNAL_GREEN ? state->termination : TERMINATION_NONE);
+        event_log_append(log, &record);
+    }
+
+    track->main_shown = (uint8_t)state->main_state;
+    track->side_shown = (uint8_t)state->side_state;
+}
+
+void event_log_input(event_log_t *const log, const size_t index, const uint64_t time_ms, const event_kind_t kind, const phase_t phase)
+{
+    if (index >= log->count)
+    {
+        return;
+    }
+
+    event_record_t record = {
+        .time_ms = time_ms,
+        .intersection = (uint16_t)index,
+        .kind = (uint8_t)kind,
+        .phase = (uint8_t)phase};
+
+    event_log_append(log, &record);
+}
+
+void event_log_close(event_log_t *const log)
+{
+    if (log->header != NULL)
+    {
+        printf("Event log: %llu records\n", (unsigned long long)log->head);
+        munmap(log->header, log->map_len);
+    }
+
+    free(log->tracks);
+    memset(log, 0, sizeof(*log));
+}
+
+bool event_log_view_open(event_log_view_t *const view, const char *const path)
+{
+    bool result = false;
+    int fd = -1;
+    void *map = MAP_FAILED;
+    struct stat st;
+
+    do
+    {
+        if (view == NULL || path == NULL)
+        {
+            fprintf(stderr, "Assertion error in event_log_view_open\n");
+            break;
+        }
+
+        memset(view, 0, sizeof(*view));
+        fd = open(path, O_RDONLY);
+
+        if (fd < 0 || fstat(fd, &st) != 0)
+        {
+            fprintf(stderr, "Failed to open event log: %s\n", path);
+            break;
+        }
+
+        if ((uint64_t)st.st_size < sizeof(event_log_header_t))
+        {
+            fprintf(stderr, "Not an event log: %s\n", path);
+            break;
+        }
+
+        map = mmap(NULL, (size_t)st.st_size, PROT_READ, MAP_SHARED, fd, 0);
+
+        if (map == MAP_FAILED)
+        {
+            fprintf(stderr, "Failed to map event log: %s\n", path);
+            break;
+        }
+
+        const event_log_header_t *header = map;
+        uint64_t capacity = header->capacity;
+
+        if (memcmp(header->magic, EVENT_LOG_MAGIC, sizeof(EVENT_LOG_MAGIC)) != 0)
+        {
+            fprintf(stderr, "Not an event log: %s\n", path);
+            break;
+        }
+
+        if (header->version != EVENT_LOG_VERSION || header->record_size != sizeof(event_record_t))
+        {
+            fprintf(stderr, "Unsupported event log version %u: %s\n", header->version, path);
+            break;
+        }
+
+        if (capacity == 0 || (capacity & (capacity - 1U)) != 0 ||
+            header->records_offset != records_offset(header->num_intersections) ||
+            header->records_offset + capacity * sizeof(event_record_t) > (uint64_t)st.st_size)
+        {
+            fprintf(stderr, "Corrupt event log header: %s\n", path);
+            break;
+        }
+
+        uint64_t head = atomic_load_explicit(&header->head, memory_order_acquire);
+
+        view->header = header;
+        view->ids = (const char (*)[MAX_STR_LEN])(header + 1);
+        view->records = (const event_record_t *)((const char *)map + header->records_offset);
+        view->count = head < capacity ? head : capacity;
+        view->first = head - view->count;
+        view->map_len = (size_t)st.st_size;
+        result = true;
+
+    } while (0);
+
+    if (fd >= 0)
+    {
+        close(fd);
+    }
+
+    if (!result && map != MAP_FAILED)
+    {
+        munmap(map, (size_t)st.st_size);
+    }
+
+    return result;
+}
+
+const event_record_t *event_log_view_record(const event_log_view_t *const view, const uint64_t i)
+{
+    return &view->records[(view->first + i) & (view->header->capacity - 1U)];
+}
+
+void event_log_view_close(event_log_view_t *const view)
+{
+    if (view->header != NULL)
+    {
+        munmap((void *)view->header, view->map_len);
+    }
+
+    memset(view, 0, sizeof(*view));
+}
+
+const char *event_kind_str(const event_kind_t kind)
+{
+    static const char *const kind_strs[] = {
+        [EVENT_SIGNAL] = "signal",
+        [EVENT_DETECTOR_ON] = "detector_on",
+        [EVENT_DETECTOR_OFF] = "detector_off",
+        [EVENT_CALL] = "call",
+        [EVENT_PLAN] = "plan",
+        [EVENT_FAULT] = "fault"};
+
+    return (unsigned)kind < sizeof(kind_strs) / sizeof(kind_strs[0]) ? kind_strs[kind] : "unknown";
+}
@@ -0,0 +1,390 @@
+#include "host.h"
+#include "config_cache.h"
+#include "latency.h"
+#include "scheduler.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <limits.h>
+#include <dirent.h>
+#include <sys/stat.h>
+
+#define CONFIG_FILE_EXT ".json"
+#define MIN_PARALLEL_STEPS 64U // Smaller batches are cheaper to step inline
+
+typedef struct
+{
+    char **paths;
+    size_t count;
+    size_t capacity;
+} path_list_t;
+
+static bool path_list_append(path_list_t *const list, const char *const path)
+{
+    if (list->count == list->capacity)
+    {
+        size_t capacity = list->capacity > 0 ? list->capacity * 2U : 16U;
+        char **paths = realloc(list->paths, capacity * sizeof(char *));
+
+        if (paths == NULL)
+        {
+            fprintf(stderr, "Out of memory while collecting config paths\n");
+            return false;
+        }
+
+        list->paths = paths;
+        list->capacity = capacity;
+    }
+
+    list->paths[list->count] = strdup(path);
+
+    if (list->paths[list->count] == NULL)
+    {
+        fprintf(stderr, "Out of memory while collecting config paths\n");
+        return false;
+    }
+
+    list->count++;
+    return true;
+}
+
+static void path_list_free(path_list_t *const list)
+{
+    for (size_t i = 0; i < list->count; i++)
+    {
+        free(list->paths[i]);
+    }
+
+    free(list->paths);
+    memset(list, 0, sizeof(*list));
+}
+
+static int is_config_file(const struct dirent *entry)
+{
+    size_t len = strlen(entry->d_name);
+
+    return entry->d_name[0] != '.' &&
+           len > strlen(CONFIG_FILE_EXT) &&
+           strcmp(entry->d_name + len - strlen(CONFIG_FILE_EXT), CONFIG_FILE_EXT) == 0;
+}
+
+static bool collect_paths(path_list_t *const list, char *const paths[], const size_t num_paths)
+{
+    for (size_t i = 0; i < num_paths; i++)
+    {
+        struct stat st;
+
+        if (stat(paths[i], &st) != 0)
+        {
+            fprintf(stderr, "Cannot access config path: %s\n", paths[i]);
+            return false;
+        }
+
+        if (!S_ISDIR(st.st_mode))
+        {
+            if (!path_list_append(list, paths[i]))
+            {
+                return false;
+            }
+
+            continue;
+        }
+
+        struct dirent **entries;
+        int num_entries = scandir(paths[i], &entries, is_config_file, alphasort);
+
+        if (num_entries < 0)
+        {
+            fprintf(stderr, "Failed to scan config directory: %s\n", paths[i]);
+            return false;
+        }
+
+        bool ok = true;
+        for (int j = 0; j < num_entries; j++)
+        {
+            char full_path[PATH_MAX];
+            snprintf(full_path, sizeof(full_path), "%s/%s", paths[i], entries[j]->d_name);
+
+            ok = ok && path_list_append(list, full_path);
+            free(entries[j]);
+        }
+
+        free(entries);
+
+        if (!ok)
+        {
+            return false;
+        }
+    }
+
+    return true;
+}
+
+static void schedule_controller(host_t *const host, const size_t index)
+{
+    uint32_t expiry_ms = controller_time_to_expiry(&host->controllers[index]);
+
+    if (expiry_ms == CONTROLLER_NO_EXPIRY)
+    {
+        // Resting, host_detector_input re-arms the timer
+        timer_wheel_remove(&host->wheel, &host->entries[index].timer);
+        return;
+    }
+
+    uint64_t ticks = ((uint64_t)expiry_ms + host->tick_ms - 1U) / host->tick_ms;
+
+    timer_wheel_add(&host->wheel, &host->entries[index].timer, host->wheel.now + ticks);
+}
+
+static void step_controller(void *const ctx, const uint32_t index)
+{
+    host_t *host = ctx;
+    controller_t *controller = &host->controllers[index];
+    uint64_t elapsed_ticks = host->wheel.now - host->entries[index].last_tick;
+
+    uint64_t start_ns = latency_now_ns();
+
+    controller->advance(controller, (uint32_t)elapsed_ticks * host->tick_ms);
+    latency_record(LATENCY_STEP, latency_now_ns() - start_ns);
+}
+
+bool host_init(
+    host_t *const host,
+    char *const paths[],
+    const size_t num_paths,
+    const uint32_t tick_ms,
+    const size_t num_threads)
+{
+    bool result = false;
+    path_list_t list = {0};
+
+    do
+    {
+        if (host == NULL || paths == NULL || num_paths == 0 || tick_ms == 0)
+        {
+            fprintf(stderr, "Assertion error in host_init\n");
+            break;
+        }
+
+        memset(host, 0, sizeof(*host));
+
+        if (!collect_paths(&list, paths, num_paths))
+        {
+            break;
+        }
+
+        if (list.count == 0)
+        {
+            fprintf(stderr, "No config files found\n");
+            break;
+        }
+
+        host->configs = calloc(list.count, sizeof(config_t));
+        // Cache line aligned, so each controller starts with its runtime timing line
+        host->controllers = aligned_alloc(CONTROLLER_CACHE_LINE, list.count * sizeof(controller_t));
+        host->entries = calloc(list.count, sizeof(host_entry_t));
+        host->expired = calloc(list.count, sizeof(uint32_t));
+
+        if (host->configs == NULL ||
+            host->controllers == NULL ||
+            host->entries == NULL ||
+            host->expired == NULL)
+        {
+            fprintf(stderr, "Out of memory while allocating %lu controllers\n", list.count);
+            break;
+        }
+
+        memset(host->controllers, 0, list.count * sizeof(controller_t));
+        host->count = list.count;
+        host->tick_ms = tick_ms;
+        timer_wheel_init(&host->wheel, 0);
+
+        uint32_t week_ms = scheduler_week_ms(); // One reading, the plan clocks of all controllers agree
+
+        size_t i;
+        for (i = 0; i < host->count; i++)
+        {
+            config_t *config = &host->configs[i];
+            controller_t *controller = &host->controllers[i];
+
+            if (!config_load_cached(config, list.paths[i]))
+            {
+                fprintf(stderr, "Invalid configuration: %s\n", list.paths[i]);
+                break;
+            }
+
+            controller->config = config;
+            controller->tick_ms = tick_ms;
+            controller->start_week_ms = week_ms;
+
+            if (!controller_init(controller))
+            {
+                fprintf(stderr, "Failed to initialize controller for %s\n", list.paths[i]);
+                break;
+            }
+
+            host->entries[i].timer.owner = (uint32_t)i;
+            schedule_controller(host, i);
+        }
+
+        if (i != host->count)
+        {
+            break;
+        }
+
+        if (!thread_pool_init(&host->pool, num_threads, host->count))
+        {
+            fprintf(stderr, "Failed to start %lu worker threads\n", num_threads);
+            break;
+        }
+
+        result = true;
+
+    } while (0);
+
+    path_list_free(&list);
+
+    if (!result && host != NULL)
+    {
+        host_free(host);
+    }
+
+    return result;
+}
+
+// Detector events step their controllers on this tick, like a single controller draining before its step
+static void drain_detectors(host_t *const host)
+{
+    detector_event_t events[DETECTOR_BATCH_SIZE];
+    size_t total = 0;
+
+    for (size_t i = 0; i < host->detectors->count; i++)
+    {
+        size_t count;
+
+        while ((count = detector_ring_pop(&host->detectors->sources[i].ring, events, DETECTOR_BATCH_SIZE)) > 0)
+        {
+            for (size_t j = 0; j < count; j++)
+            {
+                host_detector_input(host, events[j].intersection, (phase_t)events[j].phase, events[j].is_on);
+            }
+
+            total += count;
+        }
+    }
+
+    host->detectors->drained += total;
+}
+
+void host_tick(host_t *const host)
+{
+    size_t count = 0;
+
+    if (host->detectors != NULL)
+    {
+        drain_detectors(host);
+    }
+
+    // Resting controllers only step when due, wake the ones the monitor faulted to flash red
+    if (host->monitor != NULL &&
+        atomic_load_explicit(&host->monitor->num_faults, memory_order_acquire) != host->num_faults)
+    {
+        host->num_faults = atomic_load_explicit(&host->monitor->num_faults, memory_order_acquire);
+
+        for (size_t i = 0; i < host->count; i++)
+        {
+            if (atomic_load_explicit(&host->controllers[i].is_faulted, memory_order_relaxed) &&
+                host->controllers[i].state.interval != CONTROLLER_FAULT_INTERVAL)
+            {
+                timer_wheel_add(&host->wheel, &host->entries[i].timer, host->wheel.now + 1U);
+            }
+        }
+    }
+
+    for (wheel_timer_t *timer = timer_wheel_advance(&host->wheel); timer != NULL; timer = timer->next)
+    {
+        host->expired[count++] = timer->owner;
+    }
+
+    if (count >= MIN_PARALLEL_STEPS && host->pool.num_threads > 1)
+    {
+        thread_pool_run(&host->pool, host->expired, count, step_controller, host);
+    }
+    else
+    {
+        for (size_t i = 0; i < count; i++)
+        {
+            step_controller(host, host->expired[i]);
+        }
+    }
+
+    // The wheel is single-threaded, re-arm after the barrier
+    for (size_t i = 0; i < count; i++)
+    {
+        host->entries[host->expired[i]].last_tick = host->wheel.now;
+        schedule_controller(host, host->expired[i]);
+    }
+
+    // Only stepped controllers can change their signals
+    uint64_t time_ms = host->wheel.now * host->tick_ms;
+
+    for (size_t i = 0; i < count; i++)
+    {
+        if (host->monitor != NULL)
+        {
+            conflict_monitor_publish(host->monitor, host->expired[i], time_ms);
+        }
+
+        if (host->output != NULL)
+        {
+            signal_output_update(host->output, host->expired[i], time_ms);
+        }
+
+        if (host->log != NULL)
+        {
+            event_log_update(host->log, host->expired[i], time_ms);
+        }
+    }
+
+    if (host->output != NULL)
+    {
+        signal_output_flush(host->output);
+    }
+
+    if (host->monitor != NULL)
+    {
+        conflict_monitor_heartbeat(host->monitor);
+    }
+
+    host->steps += count;
+}
+
+void host_detector_input(host_t *const host, const size_t index, const phase_t phase, const bool is_on)
+{
+    // Catch up on the rest first, so the idle time is not charged against the timers the event starts
+    if (host->entries[index].last_tick != host->wheel.now)
+    {
+        step_controller(host, (uint32_t)index);
+        host->entries[index].last_tick = host->wheel.now;
+    }
+
+    controller_detector_input(&host->controllers[index], phase, is_on);
+
+    if (host->log != NULL)
+    {
+        event_log_input(host->log, index, host->wheel.now * host->tick_ms, is_on ? EVENT_DETECTOR_ON : EVENT_DETECTOR_OFF, phase);
+    }
+
+    // An actuation may end a rest or extend a green, step at the next tick
+    timer_wheel_add(&host->wheel, &host->entries[index].timer, host->wheel.now + 1U);
+}
+
+void host_free(host_t *const host)
+{
+    thread_pool_free(&host->pool);
+    free(host->expired);
+    free(host->configs);
+    free(host->controllers);
+    free(host->entries);
+    memset(host, 0, sizeof(*host));
+}
@@ -0,0 +1,210 @@
+#include "latency.h"
+#include <stdlib.h>
+#include <string.h>
+#include <stdatomic.h>
+#include <time.h>
+
+#define NS_PER_SEC 1000000000ULL
+#define NS_PER_US 1000.0
+
+static const char *const metric_names[] = {
+    [LATENCY_TICK] = "tick latency",
+    [LATENCY_JITTER] = "wake-up jitter",
+    [LATENCY_STEP] = "controller step"};
+
+static const double percentiles[] = {0.50, 0.90, 0.99, 0.999};
+
+static _Atomic(latency_thread_t *) registry;
+static atomic_uint num_threads;
+static _Thread_local latency_thread_t *current;
+
+// Scratch thread for the records of a thread whose histograms could not be allocated
+static latency_thread_t fallback;
+
+static uint32_t bucket_index(const uint64_t value)
+{
+    if (value < LATENCY_SUB_BUCKETS)
+    {
+        return (uint32_t)value;
+    }
+
+    uint32_t shift = (uint32_t)(63 - __builtin_clzll(value)) - LATENCY_SUB_BUCKET_BITS;
+
+    return (shift + 1U) * LATENCY_SUB_BUCKETS + (uint32_t)(value >> shift) - LATENCY_SUB_BUCKETS;
+}
+
+static uint64_t bucket_lower(const uint32_t index)
+{
+    if (index < LATENCY_SUB_BUCKETS)
+    {
+        return index;
+    }
+
+    uint32_t shift = index / LATENCY_SUB_BUCKETS - 1U;
+
+    return (uint64_t)(LATENCY_SUB_BUCKETS + index % LATENCY_SUB_BUCKETS) << shift;
+}
+
+static void histogram_merge(latency_histogram_t *const into, const latency_histogram_t *const from)
+{
+    if (from->count == 0)
+    {
+        return;
+    }
+
+    into->min_ns = into->count == 0 || from->min_ns < into->min_ns ? from->min_ns : into->min_ns;
+    into->max_ns = from->max_ns > into->max_ns ? from->max_ns : into->max_ns;
+    into->count += from->count;
+    into->sum_ns += from->sum_ns;
+
+    for (size_t i = 0; i < LATENCY_BUCKETS; i++)
+    {
+        into->buckets[i] += from->buckets[i];
+    }
+}
+
+static void histogram_print(FILE *const stream, const char *const label, const latency_histogram_t *const histogram)
+{
+    fprintf(stream, "%s: %llu samples", label, (unsigned long long)histogram->count);
+
+    if (histogram->count == 0)
+    {
+        fprintf(stream, "\n");
+        return;
+    }
+
+    fprintf(stream, ", min %.1f us", (double)histogram->min_ns / NS_PER_US);
+
+    for (size_t i = 0; i < sizeof(percentiles) / sizeof(percentiles[0]); i++)
+    {
+        fprintf(stream,
+                ", p%g %.1f us",
+                percentiles[i] * 100.0,
+                (double)latency_histogram_percentile(histogram, percentiles[i]) / NS_PER_US);
+    }
+
+    fprintf(stream,
+            ", max %.1f us, mean %.1f us\n",
+            (double)histogram->max_ns / NS_PER_US,
+            (double)histogram->sum_ns / (double)histogram->count / NS_PER_US);
+}
+
+/*Interface Functions*/
+
+uint64_t latency_now_ns(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * NS_PER_SEC + (uint64_t)ts.tv_nsec;
+}
+
+latency_thread_t *latency_thread(void)
+{
+    if (current != NULL)
+    {
+        return current;
+    }
+
+    latency_thread_t *thread = aligned_alloc(LATENCY_CACHE_LINE, sizeof(latency_thread_t));
+
+    if (thread == NULL)
+    {
+        fprintf(stderr, "Out of memory while creating latency histograms\n");
+        current = &fallback;
+        return current;
+    }
+
+    memset(thread, 0, sizeof(*thread));
+    thread->index = atomic_fetch_add(&num_threads, 1U);
+    thread->next = atomic_load_explicit(&registry, memory_order_relaxed);
+
+    // Lock-free push, threads only ever register, the registry is never shrunk
+    while (!atomic_compare_exchange_weak_explicit(
+        &registry, &thread->next, thread, memory_order_release, memory_order_relaxed))
+    {
+    }
+
+    current = thread;
+
+    return current;
+}
+
+void latency_histogram_record(latency_histogram_t *const histogram, const uint64_t value_ns)
+{
+    histogram->min_ns = histogram->count == 0 || value_ns < histogram->min_ns ? value_ns : histogram->min_ns;
+    histogram->max_ns = value_ns > histogram->max_ns ? value_ns : histogram->max_ns;
+    histogram->count++;
+    histogram->sum_ns += value_ns;
+    histogram->buckets[bucket_index(value_ns)]++;
+}
+
+uint64_t latency_histogram_percentile(const latency_histogram_t *const histogram, const double percentile)
+{
+    if (histogram->count == 0)
+    {
+        return 0;
+    }
+
+    uint64_t rank = (uint64_t)(percentile * (double)histogram->count + 0.5);
+    rank = rank > 0 ? rank : 1U;
+    uint64_t seen = 0;
+
+    for (uint32_t i = 0; i < LATENCY_BUCKETS; i++)
+    {
+        seen += histogram->buckets[i];
+
+        if (seen >= rank)
+        {
+            // Highest value of the bucket, within the recorded range
+            uint64_t value = i + 1U < LATENCY_BUCKETS ? bucket_lower(i + 1U) - 1U : histogram->max_ns;
+            value = value < histogram->max_ns ? value : histogram->max_ns;
+            return value > histogram->min_ns ? value : histogram->min_ns;
+        }
+    }
+
+    return histogram->max_ns;
+}
+
+void latency_record(const latency_metric_t metric, const uint64_t value_ns)
+{
+    latency_histogram_record(&latency_thread()->histograms[metric], value_ns);
+}
+
+void latency_print(FILE *const stream)
+{
+    latency_thread_t *head = atomic_load_explicit(&registry, memory_order_acquire);
+
+    for (size_t metric = 0; metric < LATENCY_NUM_METRICS; metric++)
+    {
+        latency_histogram_t merged;
+        size_t num_recording = 0;
+
+        memset(&merged, 0, sizeof(merged));
+
+        for (latency_thread_t *thread = head; thread != NULL; thread = thread->next)
+        {
+            histogram_merge(&merged, &thread->histograms[metric]);
+            num_recording += thread->histograms[metric].count > 0;
+        }
+
+        char label[64];
+        snprintf(label, sizeof(label), "Latency %s", metric_names[metric]);
+        histogram_print(stream, label, &merged);
+
+        if (num_recording < 2)
+        {
+            continue;
+        }
+
+        for (latency_thread_t *thread = head; thread != NULL; thread = thread->next)
+        {
+            if (thread->histograms[metric].count == 0)
+            {
+                continue;
+            }
+
+            snprintf(label, sizeof(label), "  thread %u", thread->index);
+            histogram_print(stream, label, &thread->histograms[metric]);
+        }
+    }
+}
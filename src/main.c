@@ -1,12 +1,30 @@
+#include "atspm.h"
 #include "controller.h"
 #include "config.h"
+#include "config_cache.h"
+#include "config_reload.h"
+#include "conflict_monitor.h"
+#include "detector_input.h"
+#include "event_log.h"
+#include "host.h"
+#include "latency.h"
+#include "replay.h"
+#include "scheduler.h"
+#include "signal_output.h"
+#include "simulation.h"
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
 #include <signal.h>
 #include <stdbool.h>
+#include <unistd.h>
+#include <getopt.h>
+#include <sys/stat.h>
+#include <time.h>
 
-static volatile bool running = true;
+static volatile sig_atomic_t running = true;
+static volatile sig_atomic_t is_dump_requested = false;
+static config_reload_t reload;
 
 static void signal_handler(int signum)
 {
@@ -14,51 +32,665 @@ static void signal_handler(int signum)
     running = false;
 }
 
-int main(int argc, char *argv[])
+static void reload_handler(int signum)
+{
+    (void)signum; // Unused parameter
+    config_reload_request(&reload);
+}
+
+static void dump_handler(int signum)
+{
+    (void)signum; // Unused parameter
+    is_dump_requested = true;
+}
+
+/*
+ * Records the latency of a tick once its work is done, prints the histograms
+ * when SIGUSR1 asked for them. Returns whether they were printed.
+ */
+static bool record_tick(const scheduler_t *const scheduler, const uint32_t elapsed)
 {
-    if (argc != 2)
+    if (elapsed > 0)
     {
-        fprintf(stderr, "Usage: %s <config_file_path>\n", argv[0]);
-        return EXIT_FAILURE;
+        latency_record(LATENCY_JITTER, scheduler->jitter_ns);
+        latency_record(LATENCY_TICK, latency_now_ns() - scheduler->woken_ns);
     }
 
-    // Set up signal handling for graceful shutdown
-    signal(SIGINT, signal_handler);
-    signal(SIGTERM, signal_handler);
+    if (!is_dump_requested)
+    {
+        return false;
+    }
+
+    is_dump_requested = false;
+    latency_print(stdout);
+    fflush(stdout);
+
+    return true;
+}
+
+static void print_usage(const char *const prog)
+{
+    fprintf(stderr,
+            "Usage: %s [options] <config_file_path|config_dir>...\n"
+            "  -t, --tick-ms N  Controller tick resolution in ms (default %u)\n"
+            "  -j, --threads N  Worker threads for multiple intersections,\n"
+            "                   0 uses all online CPUs (default 1)\n"
+            "  -s, --simulate   Run on a virtual clock as fast as possible\n"
+            "  -d, --duration S Simulated time in seconds (default %u)\n"
+            "  -c, --calls FILE Scripted detector calls for the simulation\n"
+            "  -q, --demand FILE\n"
+            "                   Vehicles per hour by phase over time, lines of\n"
+            "                   \"<time_s> <phase> <vehicles_per_hour>\", queued\n"
+            "                   behind the simulated signals and, without -c,\n"
+            "                   drawn as detector actuations\n"
+            "  -D, --detector PATH\n"
+            "                   Detector event source (file, FIFO or device),\n"
+            "                   may be repeated, lines of \"<phase> <on|off>\",\n"
+            "                   with several configs \"<id> <phase> <on|off>\"\n"
+            "  -o, --output SPEC\n"
+            "                   Signal head output, a file or FIFO receiving\n"
+            "                   \"<time_ms> <id> <phase> <state>\" lines, or\n"
+            "                   %s/dev/gpiochipN driving lamp lines\n"
+            "  -e, --event-log FILE\n"
+            "                   Record signal changes, detector calls, plan\n"
+            "                   changes and faults into a ring of the last\n"
+            "                   %u events, decoded by event_decode\n"
+            "  -r, --replay LOG Replay the detector calls of an event log against\n"
+            "                   each config on a virtual clock, -j in parallel,\n"
+            "                   and compare the delay with the recorded signals\n"
+            "  -A, --atspm FILE Aggregate performance measures per lane group\n"
+            "                   into 15 minute bins, written to FILE as CSV\n"
+            "                   on exit and on SIGUSR1\n"
+            "  -C, --compile-config\n"
+            "                   Validate the configs and write binary images\n"
+            "                   (<config_file_path>%s) used at startup\n"
+            "Several configs or a directory run all intersections in one process.\n",
+            prog,
+            SCHEDULER_DEFAULT_TICK_MS,
+            SIM_DEFAULT_DURATION_S,
+            SIGNAL_OUTPUT_GPIO_PREFIX,
+            EVENT_LOG_DEFAULT_RECORDS,
+            CONFIG_CACHE_EXT);
+}
+
+/*
+ * Opens the event log when one is recorded or aggregated, in memory only
+ * without a log path, and the ATSPM aggregator reading it.
+ */
+static bool start_events(
+    event_log_t *const log,
+    atspm_t *const atspm,
+    const char *const log_path,
+    const char *const atspm_path,
+    const controller_t *const controllers,
+    const size_t count,
+    const uint32_t tick_ms,
+    const bool is_virtual)
+{
+    if (log_path == NULL && atspm_path == NULL)
+    {
+        return true;
+    }
+
+    if (!event_log_open(log, log_path, EVENT_LOG_DEFAULT_RECORDS, controllers, count, tick_ms, is_virtual))
+    {
+        return false;
+    }
+
+    if (atspm_path != NULL && !atspm_init(atspm, controllers, count, ATSPM_DEFAULT_BINS, log->header->epoch_ms))
+    {
+        event_log_close(log);
+        return false;
+    }
+
+    return true;
+}
+
+static void write_atspm(atspm_t *const atspm, const char *const path, const uint64_t time_ms)
+{
+    if (path == NULL)
+    {
+        return;
+    }
+
+    FILE *file = fopen(path, "w");
+
+    if (file == NULL)
+    {
+        fprintf(stderr, "Failed to create ATSPM file: %s\n", path);
+        return;
+    }
+
+    atspm_write_csv(atspm, time_ms, file);
+    fclose(file);
+}
+
+static bool is_directory(const char *const path)
+{
+    struct stat st;
+    return stat(path, &st) == 0 && S_ISDIR(st.st_mode);
+}
+
+static bool load_controller(
+    config_t *const config,
+    controller_t *const controller,
+    const char *const config_path,
+    const uint32_t tick_ms,
+    const uint32_t week_ms)
+{
+    // Load the precompiled image, or parse and validate the JSON source
+    if (!config_load_cached(config, config_path))
+    {
+        return false;
+    }
+
+    // Initialize controller
+    memset(controller, 0, sizeof(*controller));
+    controller->config = config;
+    controller->tick_ms = tick_ms;
+    controller->start_week_ms = week_ms;
+
+    if (!controller_init(controller))
+    {
+        fprintf(stderr, "Failed to initialize controller\n");
+        return false;
+    }
 
-    // Load and validate configuration
+    return true;
+}
+
+static int run_single(
+    const char *const config_path,
+    const uint32_t tick_ms,
+    char *const detector_paths[],
+    const size_t num_detectors,
+    const char *const output_spec,
+    const char *const log_path,
+    const char *const atspm_path)
+{
     static config_t config;
-    memset(&config, 0, sizeof(config));
+    static controller_t controller;
+    static detector_input_t detectors;
+    static signal_output_t output;
+    static event_log_t log;
+    static atspm_t atspm;
+    static conflict_monitor_t monitor;
 
-    if (!config_load(&config, argv[1]))
+    if (!load_controller(&config, &controller, config_path, tick_ms, scheduler_week_ms()))
     {
-        fprintf(stderr, "Failed to load configuration\n");
         return EXIT_FAILURE;
     }
 
-    if (!config_validate(&config))
+    if (num_detectors > 0 && !detector_input_start(&detectors, detector_paths, num_detectors, NULL, 0))
     {
-        fprintf(stderr, "Invalid configuration\n");
+        fprintf(stderr, "Failed to start detector input\n");
         return EXIT_FAILURE;
     }
 
-    // Initialize controller
-    static controller_t controller;
-    memset(&controller, 0, sizeof(controller));
-    controller.config = &config;
+    if (output_spec != NULL && !signal_output_start(&output, output_spec, &controller, 1))
+    {
+        fprintf(stderr, "Failed to start signal output\n");
+        return EXIT_FAILURE;
+    }
 
-    if (!controller_init(&controller))
+    if (!start_events(&log, &atspm, log_path, atspm_path, &controller, 1, tick_ms, false))
+    {
+        return EXIT_FAILURE;
+    }
+
+    if (!conflict_monitor_start(&monitor, &controller, 1, tick_ms))
     {
-        fprintf(stderr, "Failed to initialize controller\n");
         return EXIT_FAILURE;
     }
 
-    // Main control loop
+    static scheduler_t scheduler;
+
+    if (!scheduler_init(&scheduler, tick_ms))
+    {
+        fprintf(stderr, "Failed to initialize scheduler\n");
+        return EXIT_FAILURE;
+    }
+
+    // SIGHUP reloads the config file without stopping the controller
+    if (!config_reload_start(&reload, &controller, config_path))
+    {
+        return EXIT_FAILURE;
+    }
+
+    signal(SIGHUP, reload_handler);
+
+    // Main control loop, one controller step per elapsed tick
     printf("Started traffic light controller. Press Ctrl+C to exit.\n");
     while (running)
     {
-        controller.run(&controller);
+        uint32_t elapsed = scheduler_wait(&scheduler);
+
+        if (elapsed > 0)
+        {
+            detector_input_drain(&detectors, &controller, &log, scheduler_now_ms(&scheduler));
+        }
+
+        for (uint32_t i = 0; i < elapsed; i++)
+        {
+            uint64_t step_start_ns = latency_now_ns();
+            controller.run(&controller);
+            latency_record(LATENCY_STEP, latency_now_ns() - step_start_ns);
+        }
+
+        uint64_t now_ms = scheduler_now_ms(&scheduler);
+
+        conflict_monitor_publish(&monitor, 0, now_ms);
+        signal_output_update(&output, 0, now_ms);
+        signal_output_flush(&output);
+        event_log_update(&log, 0, now_ms);
+        atspm_consume(&atspm, &log);
+        conflict_monitor_heartbeat(&monitor);
+
+        if (record_tick(&scheduler, elapsed))
+        {
+            write_atspm(&atspm, atspm_path, now_ms);
+        }
     }
 
+    write_atspm(&atspm, atspm_path, scheduler_now_ms(&scheduler));
+
+    signal(SIGHUP, SIG_IGN);
+    config_reload_stop(&reload);
+    detector_input_stop(&detectors);
+    signal_output_stop(&output);
+    atspm_free(&atspm);
+    event_log_close(&log);
+    conflict_monitor_stop(&monitor);
+    scheduler_print_stats(&scheduler);
+    latency_print(stdout);
+
     return EXIT_SUCCESS;
 }
+
+static int run_simulation(
+    const char *const config_path,
+    const uint32_t tick_ms,
+    const uint64_t duration_ms,
+    const char *const calls_path,
+    const char *const demand_path,
+    const char *const output_spec,
+    const char *const log_path,
+    const char *const atspm_path)
+{
+    static config_t config;
+    static controller_t controller;
+    static scheduler_t scheduler;
+    static signal_output_t output;
+    static event_log_t log;
+    static atspm_t atspm;
+    static queue_model_t queues;
+    sim_script_t script = {0};
+    sim_demand_t demand = {0};
+
+    // The virtual clock starts on Monday 00:00 so a run covers the schedule from its start
+    if (!load_controller(&config, &controller, config_path, tick_ms, 0))
+    {
+        return EXIT_FAILURE;
+    }
+
+    if (!scheduler_init_virtual(&scheduler, tick_ms))
+    {
+        fprintf(stderr, "Failed to initialize scheduler\n");
+        return EXIT_FAILURE;
+    }
+
+    if (calls_path != NULL && !sim_script_load(&script, calls_path))
+    {
+        fprintf(stderr, "Failed to load call script\n");
+        return EXIT_FAILURE;
+    }
+
+    // The demand feeds the queue model, and the detectors too unless calls are scripted
+    if (demand_path != NULL)
+    {
+        if (!sim_demand_load(&demand, demand_path) ||
+            (calls_path == NULL && !sim_script_generate(&script, &demand, duration_ms, SIM_DEMAND_SEED)) ||
+            !queue_model_init(&queues, &controller, 1) ||
+            !sim_demand_schedule(&demand, &queues, 0))
+        {
+            fprintf(stderr, "Failed to load demand profile\n");
+            return EXIT_FAILURE;
+        }
+    }
+
+    if (output_spec != NULL && !signal_output_start(&output, output_spec, &controller, 1))
+    {
+        fprintf(stderr, "Failed to start signal output\n");
+        return EXIT_FAILURE;
+    }
+
+    // Times of a virtual clock, counted from the start of the simulation
+    if (!start_events(&log, &atspm, log_path, atspm_path, &controller, 1, tick_ms, true))
+    {
+        return EXIT_FAILURE;
+    }
+
+    sim_sinks_t sinks = {
+        .output = output_spec != NULL ? &output : NULL,
+        .log = log_path != NULL || atspm_path != NULL ? &log : NULL,
+        .atspm = atspm_path != NULL ? &atspm : NULL,
+        .queues = demand_path != NULL ? &queues : NULL};
+    struct timespec start, end;
+    sim_stats_t stats;
+
+    clock_gettime(CLOCK_MONOTONIC, &start);
+    sim_run(&controller, &scheduler, &script, duration_ms, &sinks, &stats);
+    clock_gettime(CLOCK_MONOTONIC, &end);
+
+    double wall_ms = (double)(end.tv_sec - start.tv_sec) * 1000.0 +
+                     (double)(end.tv_nsec - start.tv_nsec) / 1000000.0;
+
+    sim_print_stats(&stats, duration_ms);
+
+    if (demand_path != NULL)
+    {
+        queue_model_print(&queues, 0, stdout);
+    }
+
+    printf("Wall time: %.1f ms\n", wall_ms);
+
+    write_atspm(&atspm, atspm_path, duration_ms);
+    signal_output_stop(&output);
+    atspm_free(&atspm);
+    event_log_close(&log);
+    queue_model_free(&queues);
+    sim_demand_free(&demand);
+    sim_script_free(&script);
+
+    return EXIT_SUCCESS;
+}
+
+static int run_host(
+    char *const paths[],
+    const size_t num_paths,
+    const uint32_t tick_ms,
+    const size_t num_threads,
+    char *const detector_paths[],
+    const size_t num_detectors,
+    const char *const output_spec,
+    const char *const log_path,
+    const char *const atspm_path)
+{
+    static scheduler_t scheduler;
+
+    if (!scheduler_init(&scheduler, tick_ms))
+    {
+        fprintf(stderr, "Failed to initialize scheduler\n");
+        return EXIT_FAILURE;
+    }
+
+    static host_t host;
+
+    if (!host_init(&host, paths, num_paths, tick_ms, num_threads))
+    {
+        fprintf(stderr, "Failed to initialize controllers\n");
+        return EXIT_FAILURE;
+    }
+
+    // Detector lines name the intersection, every source may serve any of them
+    static detector_input_t detectors;
+
+    if (num_detectors > 0)
+    {
+        if (!detector_input_start(&detectors, detector_paths, num_detectors, host.controllers, host.count))
+        {
+            fprintf(stderr, "Failed to start detector input\n");
+            host_free(&host);
+            return EXIT_FAILURE;
+        }
+
+        host.detectors = &detectors;
+    }
+
+    static signal_output_t output;
+
+    if (output_spec != NULL)
+    {
+        if (!signal_output_start(&output, output_spec, host.controllers, host.count))
+        {
+            fprintf(stderr, "Failed to start signal output\n");
+            detector_input_stop(&detectors);
+            host_free(&host);
+            return EXIT_FAILURE;
+        }
+
+        host.output = &output;
+    }
+
+    static event_log_t log;
+    static atspm_t atspm;
+
+    if (!start_events(&log, &atspm, log_path, atspm_path, host.controllers, host.count, tick_ms, false))
+    {
+        signal_output_stop(&output);
+        detector_input_stop(&detectors);
+        host_free(&host);
+        return EXIT_FAILURE;
+    }
+
+    host.log = log.header != NULL ? &log : NULL;
+
+    static conflict_monitor_t monitor;
+
+    if (!conflict_monitor_start(&monitor, host.controllers, host.count, tick_ms))
+    {
+        atspm_free(&atspm);
+        event_log_close(&log);
+        signal_output_stop(&output);
+        detector_input_stop(&detectors);
+        host_free(&host);
+        return EXIT_FAILURE;
+    }
+
+    host.monitor = &monitor;
+
+    printf("Started %lu traffic light controllers on %lu threads. Press Ctrl+C to exit.\n",
+           host.count,
+           host.pool.num_threads);
+    while (running)
+    {
+        uint32_t elapsed = scheduler_wait(&scheduler);
+
+        for (uint32_t i = 0; i < elapsed; i++)
+        {
+            host_tick(&host);
+        }
+
+        atspm_consume(&atspm, &log);
+
+        if (record_tick(&scheduler, elapsed))
+        {
+            write_atspm(&atspm, atspm_path, host.wheel.now * tick_ms);
+        }
+    }
+
+    write_atspm(&atspm, atspm_path, host.wheel.now * tick_ms);
+
+    scheduler_print_stats(&scheduler);
+    latency_print(stdout);
+    printf("Host: %lu controllers, %llu controller steps\n",
+           host.count,
+           (unsigned long long)host.steps);
+
+    conflict_monitor_stop(&monitor);
+    detector_input_stop(&detectors);
+    atspm_free(&atspm);
+    event_log_close(&log);
+    signal_output_stop(&output);
+    host_free(&host);
+
+    return EXIT_SUCCESS;
+}
+
+static int run_replay(const char *const log_path, char *const paths[], const size_t num_paths, const size_t num_threads)
+{
+    static replay_t replay;
+
+    if (!replay_open(&replay, log_path))
+    {
+        return EXIT_FAILURE;
+    }
+
+    struct timespec start, end;
+
+    clock_gettime(CLOCK_MONOTONIC, &start);
+    bool is_done = replay_run(&replay, paths, num_paths, num_threads);
+    clock_gettime(CLOCK_MONOTONIC, &end);
+
+    replay_print(&replay);
+    printf("Wall time: %.1f ms\n",
+           (double)(end.tv_sec - start.tv_sec) * 1000.0 + (double)(end.tv_nsec - start.tv_nsec) / 1000000.0);
+    replay_close(&replay);
+
+    return is_done ? EXIT_SUCCESS : EXIT_FAILURE;
+}
+
+static int compile_configs(char *const paths[], const size_t num_paths)
+{
+    size_t num_failed = 0;
+
+    for (size_t i = 0; i < num_paths; i++)
+    {
+        if (!config_cache_compile(paths[i]))
+        {
+            num_failed++;
+            continue;
+        }
+
+        printf("Compiled %s%s\n", paths[i], CONFIG_CACHE_EXT);
+    }
+
+    return num_failed == 0 ? EXIT_SUCCESS : EXIT_FAILURE;
+}
+
+int main(int argc, char *argv[])
+{
+    static const struct option long_options[] = {
+        {"tick-ms", required_argument, NULL, 't'},
+        {"threads", required_argument, NULL, 'j'},
+        {"simulate", no_argument, NULL, 's'},
+        {"duration", required_argument, NULL, 'd'},
+        {"calls", required_argument, NULL, 'c'},
+        {"demand", required_argument, NULL, 'q'},
+        {"detector", required_argument, NULL, 'D'},
+        {"compile-config", no_argument, NULL, 'C'},
+        {"output", required_argument, NULL, 'o'},
+        {"event-log", required_argument, NULL, 'e'},
+        {"atspm", required_argument, NULL, 'A'},
+        {"replay", required_argument, NULL, 'r'},
+        {NULL, 0, NULL, 0}};
+
+    uint32_t tick_ms = SCHEDULER_DEFAULT_TICK_MS;
+    size_t num_threads = 1;
+    bool is_simulation = false;
+    uint64_t duration_ms = SIM_DEFAULT_DURATION_S * 1000ULL;
+    const char *calls_path = NULL;
+    const char *demand_path = NULL;
+    char *detector_paths[MAX_DETECTOR_SOURCES];
+    size_t num_detectors = 0;
+    bool is_compile = false;
+    const char *output_spec = NULL;
+    const char *log_path = NULL;
+    const char *atspm_path = NULL;
+    const char *replay_path = NULL;
+    int opt;
+
+    while ((opt = getopt_long(argc, argv, "t:j:sd:c:q:D:Co:e:A:r:", long_options, NULL)) != -1)
+    {
+        switch (opt)
+        {
+        case 't':
+            tick_ms = (uint32_t)strtoul(optarg, NULL, 10);
+            break;
+        case 'j':
+            num_threads = thread_pool_resolve_threads((size_t)strtoul(optarg, NULL, 10));
+            break;
+        case 's':
+            is_simulation = true;
+            break;
+        case 'd':
+            duration_ms = strtoull(optarg, NULL, 10) * 1000ULL;
+            break;
+        case 'c':
+            calls_path = optarg;
+            break;
+        case 'q':
+            demand_path = optarg;
+            break;
+        case 'D':
+            if (num_detectors == MAX_DETECTOR_SOURCES)
+            {
+                fprintf(stderr, "At most %u detector sources are supported\n", MAX_DETECTOR_SOURCES);
+                return EXIT_FAILURE;
+            }
+            detector_paths[num_detectors++] = optarg;
+            break;
+        case 'C':
+            is_compile = true;
+            break;
+        case 'o':
+            output_spec = optarg;
+            break;
+        case 'e':
+            log_path = optarg;
+            break;
+        case 'A':
+            atspm_path = optarg;
+            break;
+        case 'r':
+            replay_path = optarg;
+            break;
+        default:
+            print_usage(argv[0]);
+            return EXIT_FAILURE;
+        }
+    }
+
+    if (argc - optind < 1)
+    {
+        print_usage(argv[0]);
+        return EXIT_FAILURE;
+    }
+
+    size_t num_paths = (size_t)(argc - optind);
+
+    if (is_compile)
+    {
+        return compile_configs(&argv[optind], num_paths);
+    }
+
+    if (replay_path != NULL)
+    {
+        return run_replay(replay_path, &argv[optind], num_paths, num_threads);
+    }
+
+    // Set up signal handling for graceful shutdown
+    signal(SIGINT, signal_handler);
+    signal(SIGTERM, signal_handler);
+
+    if (is_simulation)
+    {
+        if (num_paths != 1)
+        {
+            fprintf(stderr, "Simulation runs a single config file\n");
+            return EXIT_FAILURE;
+        }
+
+        return run_simulation(argv[optind], tick_ms, duration_ms, calls_path, demand_path, output_spec, log_path, atspm_path);
+    }
+
+    // SIGUSR1 prints the latency histograms of the running controllers
+    signal(SIGUSR1, dump_handler);
+
+    if (num_paths == 1 && !is_directory(argv[optind]))
+    {
+        return run_single(argv[optind], tick_ms, detector_paths, num_detectors, output_spec, log_path, atspm_path);
+    }
+
+    return run_host(&argv[optind], num_paths, tick_ms, num_threads, detector_paths, num_detectors, output_spec, log_path, atspm_path);
+}
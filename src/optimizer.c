@@ -0,0 +1,546 @@
+#include "optimizer.h"
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define MS_PER_SEC 1000.0
+#define FT_PER_MILE 5280.0f
+#define SEC_PER_HOUR 3600.0f
+#define NEIGHBOR_SHARE 4U // A quarter of every batch after the first samples uniformly
+#define MAX_CHANGES 2U    // Parameters a neighbor changes
+#define MAX_STEP 2U       // Levels a changed parameter moves
+
+typedef enum
+{
+    PARAM_YELLOW,
+    PARAM_RED_CLEARANCE,
+    PARAM_MIN_GREEN,
+    PARAM_MAX_GREEN, // Actuated roads only
+    PARAM_PASSAGE,   // Actuated roads only
+    NUM_PARAMS
+} param_t;
+
+// splitmix64
+static uint64_t next_random(uint64_t *const state)
+{
+    uint64_t z = (*state += 0x9E3779B97F4A7C15ULL);
+    z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ULL;
+    z = (z ^ (z >> 27)) * 0x94D049BB133111EBULL;
+
+    return z ^ (z >> 31);
+}
+
+static bool is_actuated(const phase_timing_t *const timing)
+{
+    return timing->passage_time > 0.0f && timing->max_green > 0;
+}
+
+static uint32_t time_levels(const float min_s, const float max_s)
+{
+    return (uint32_t)((max_s - min_s) / OPTIMIZER_TIME_STEP + 0.5f) + 1U;
+}
+
+static uint32_t time_level(const float value_s, const float min_s, const uint32_t levels)
+{
+    float level = (value_s - min_s) / OPTIMIZER_TIME_STEP + 0.5f;
+
+    return level < 0.0f ? 0U : (uint32_t)level < levels ? (uint32_t)level : levels - 1U;
+}
+
+static uint32_t green_level(const uint8_t green_s, const uint32_t levels)
+{
+    uint32_t level = green_s > MIN_GREEN_STOP_LINE ? green_s - MIN_GREEN_STOP_LINE : 0U;
+
+    return level < levels ? level : levels - 1U;
+}
+
+// An actuated road extends its minimum green, a fixed one times its whole green with it
+static uint8_t min_green_limit(const optimizer_t *const optimizer, const phase_timing_t *const timing)
+{
+    return is_actuated(timing) && optimizer->max_green > OPTIMIZER_MAX_MIN_GREEN ? OPTIMIZER_MAX_MIN_GREEN
+                                                                                   : optimizer->max_green;
+}
+
+// ITE kinematic yellow of a level approach, rounded up to the search grid and kept within the parser's range
+static float ite_yellow_time(const uint8_t speed_limit)
+{
+    float speed_fps = (float)speed_limit * FT_PER_MILE / SEC_PER_HOUR;
+    float yellow_s = OPTIMIZER_PERCEPTION_S + speed_fps / (2.0f * OPTIMIZER_DECELERATION_FPS2);
+    float level = ceilf((yellow_s - MIN_YELLOW_TIME) / OPTIMIZER_TIME_STEP);
+    float max_level = (float)(time_levels(MIN_YELLOW_TIME, MAX_YELLOW_TIME) - 1U);
+
+    return MIN_YELLOW_TIME + (level < 0.0f ? 0.0f : level < max_level ? level : max_level) * OPTIMIZER_TIME_STEP;
+}
+
+// The legal values of a parameter are levels steps from its minimum, 1 if it is not searched
+static uint32_t param_levels(
+    const optimizer_t *const optimizer,
+    const size_t road,
+    const phase_timing_t *const timing,
+    const param_t param)
+{
+    switch (param)
+    {
+    case PARAM_YELLOW:
+        return time_levels(optimizer->min_yellow_s[road], MAX_YELLOW_TIME);
+    case PARAM_RED_CLEARANCE:
+        return time_levels(optimizer->min_red_clearance_s[road], MAX_RED_CLEARANCE);
+    case PARAM_MIN_GREEN:
+        return min_green_limit(optimizer, timing) - MIN_GREEN_STOP_LINE + 1U;
+    case PARAM_MAX_GREEN:
+        return is_actuated(timing) ? optimizer->max_green - MIN_GREEN_STOP_LINE + 1U : 1U;
+    case PARAM_PASSAGE:
+        return is_actuated(timing) ? time_levels(MIN_PASSAGE_TIME, MAX_PASSAGE_TIME) : 1U;
+    default:
+        return 1U;
+    }
+}
+
+static uint32_t param_level(
+    const optimizer_t *const optimizer,
+    const size_t road,
+    const phase_timing_t *const timing,
+    const param_t param)
+{
+    uint32_t levels = param_levels(optimizer, road, timing, param);
+
+    switch (param)
+    {
+    case PARAM_YELLOW:
+        return time_level(timing->yellow_time, optimizer->min_yellow_s[road], levels);
+    case PARAM_RED_CLEARANCE:
+        return time_level(timing->red_clearance, optimizer->min_red_clearance_s[road], levels);
+    case PARAM_MIN_GREEN:
+        return green_level(timing->min_green, levels);
+    case PARAM_MAX_GREEN:
+        return green_level(timing->max_green, levels);
+    case PARAM_PASSAGE:
+        return time_level(timing->passage_time, MIN_PASSAGE_TIME, levels);
+    default:
+        return 0;
+    }
+}
+
+// Keeps maximum green and passage time of a road that is not actuated unset
+static void param_set(
+    const optimizer_t *const optimizer,
+    const size_t road,
+    phase_timing_t *const timing,
+    const param_t param,
+    const uint32_t level)
+{
+    switch (param)
+    {
+    case PARAM_YELLOW:
+        timing->yellow_time = optimizer->min_yellow_s[road] + (float)level * OPTIMIZER_TIME_STEP;
+        break;
+    case PARAM_RED_CLEARANCE:
+        timing->red_clearance = optimizer->min_red_clearance_s[road] + (float)level * OPTIMIZER_TIME_STEP;
+        break;
+    case PARAM_MIN_GREEN:
+        timing->min_green = (uint8_t)(MIN_GREEN_STOP_LINE + level);
+        break;
+    case PARAM_MAX_GREEN:
+        timing->max_green = is_actuated(timing) ? (uint8_t)(MIN_GREEN_STOP_LINE + level) : timing->max_green;
+        break;
+    case PARAM_PASSAGE:
+        timing->passage_time = is_actuated(timing) ? MIN_PASSAGE_TIME + (float)level * OPTIMIZER_TIME_STEP
+                                                   : timing->passage_time;
+        break;
+    default:
+        break;
+    }
+}
+
+// Like the parser, a maximum green must not be shorter than the minimum
+static void fix_max_green(phase_timing_t *const timing)
+{
+    if (is_actuated(timing) && timing->max_green < timing->min_green)
+    {
+        timing->max_green = timing->min_green;
+    }
+}
+
+// The configured plan may clear faster than the search allows, its neighbors do not
+static void fix_clearances(const optimizer_t *const optimizer, optimizer_plan_t *const plan)
+{
+    for (size_t road = 0; road < MAX_ROADS; road++)
+    {
+        phase_timing_t *timing = &plan->timing[road];
+
+        if (timing->yellow_time < optimizer->min_yellow_s[road])
+        {
+            timing->yellow_time = optimizer->min_yellow_s[road];
+        }
+
+        if (timing->red_clearance < optimizer->min_red_clearance_s[road])
+        {
+            timing->red_clearance = optimizer->min_red_clearance_s[road];
+        }
+    }
+}
+
+static void sample_uniform(optimizer_t *const optimizer, optimizer_plan_t *const plan)
+{
+    memcpy(plan->timing, optimizer->current.timing, sizeof(plan->timing));
+
+    for (size_t road = 0; road < MAX_ROADS; road++)
+    {
+        phase_timing_t *timing = &plan->timing[road];
+
+        for (param_t param = PARAM_YELLOW; param < NUM_PARAMS; param++)
+        {
+            uint32_t levels = param_levels(optimizer, road, timing, param);
+            param_set(optimizer, road, timing, param, (uint32_t)(next_random(&optimizer->rng) % levels));
+        }
+
+        fix_max_green(timing);
+    }
+}
+
+// Moves a few parameters of a plan of the front by a few levels
+static void sample_neighbor(optimizer_t *const optimizer, optimizer_plan_t *const plan)
+{
+    const optimizer_plan_t *origin = &optimizer->front[next_random(&optimizer->rng) % optimizer->front_count];
+    uint32_t changes = 1U + (uint32_t)(next_random(&optimizer->rng) % MAX_CHANGES);
+
+    memcpy(plan->timing, origin->timing, sizeof(plan->timing));
+    fix_clearances(optimizer, plan);
+
+    for (uint32_t i = 0; i < changes; i++)
+    {
+        uint64_t random = next_random(&optimizer->rng);
+        size_t road = random % MAX_ROADS;
+        phase_timing_t *timing = &plan->timing[road];
+        param_t param = (param_t)((random >> 8) % NUM_PARAMS);
+        uint32_t step = 1U + (uint32_t)((random >> 16) % MAX_STEP);
+        bool is_up = ((random >> 24) & 1U) != 0;
+        uint32_t levels = param_levels(optimizer, road, timing, param);
+        uint32_t level = param_level(optimizer, road, timing, param);
+
+        level = is_up ? (level + step < levels ? level + step : levels - 1U) : (level > step ? level - step : 0U);
+        param_set(optimizer, road, timing, param, level);
+        fix_max_green(timing);
+    }
+}
+
+// No worse on every objective and better on one
+static bool dominates(const optimizer_plan_t *const a, const optimizer_plan_t *const b)
+{
+    bool is_no_worse = a->avg_delay_s <= b->avg_delay_s &&
+                       a->max_delay_s <= b->max_delay_s &&
+                       a->clearance_s >= b->clearance_s;
+    bool is_better = a->avg_delay_s < b->avg_delay_s ||
+                     a->max_delay_s < b->max_delay_s ||
+                     a->clearance_s > b->clearance_s;
+
+    return is_no_worse && is_better;
+}
+
+static bool is_tied(const optimizer_plan_t *const a, const optimizer_plan_t *const b)
+{
+    return a->avg_delay_s == b->avg_delay_s && a->max_delay_s == b->max_delay_s && a->clearance_s == b->clearance_s;
+}
+
+// Adds a plan no plan of the front dominates or ties, and drops the ones it dominates
+static bool merge(optimizer_t *const optimizer, const optimizer_plan_t *const plan)
+{
+    if (!plan->is_valid)
+    {
+        optimizer->rejected++;
+        return true;
+    }
+
+    for (size_t i = 0; i < optimizer->front_count; i++)
+    {
+        if (dominates(&optimizer->front[i], plan) || is_tied(&optimizer->front[i], plan))
+        {
+            return true;
+        }
+    }
+
+    size_t kept = 0;
+
+    for (size_t i = 0; i < optimizer->front_count; i++)
+    {
+        if (!dominates(plan, &optimizer->front[i]))
+        {
+            optimizer->front[kept++] = optimizer->front[i];
+        }
+    }
+
+    optimizer->front_count = kept;
+
+    if (optimizer->front_count == optimizer->front_capacity)
+    {
+        size_t capacity = optimizer->front_capacity > 0 ? optimizer->front_capacity * 2U : 64U;
+        optimizer_plan_t *front = realloc(optimizer->front, capacity * sizeof(optimizer_plan_t));
+
+        if (front == NULL)
+        {
+            fprintf(stderr, "Out of memory while growing the Pareto front\n");
+            return false;
+        }
+
+        optimizer->front = front;
+        optimizer->front_capacity = capacity;
+    }
+
+    optimizer->front[optimizer->front_count++] = *plan;
+    return true;
+}
+
+static void evaluate_task(void *const ctx, const uint32_t task)
+{
+    optimizer_t *optimizer = ctx;
+
+    optimizer_evaluate(optimizer, &optimizer->batch[task]);
+}
+
+static int compare_plans(const void *const a, const void *const b)
+{
+    const optimizer_plan_t *plan_a = a;
+    const optimizer_plan_t *plan_b = b;
+
+    if (plan_a->avg_delay_s != plan_b->avg_delay_s)
+    {
+        return plan_a->avg_delay_s < plan_b->avg_delay_s ? -1 : 1;
+    }
+
+    if (plan_a->max_delay_s != plan_b->max_delay_s)
+    {
+        return plan_a->max_delay_s < plan_b->max_delay_s ? -1 : 1;
+    }
+
+    return plan_a->clearance_s > plan_b->clearance_s ? -1 : plan_a->clearance_s < plan_b->clearance_s;
+}
+
+/*Interface Functions*/
+
+bool optimizer_init(
+    optimizer_t *const optimizer,
+    const config_t *const config,
+    const char *const plan_id,
+    const sim_script_t *const script,
+    const sim_demand_t *const demand,
+    const uint64_t duration_ms,
+    const uint32_t tick_ms,
+    const uint8_t max_green,
+    const size_t batch_size,
+    const uint64_t seed)
+{
+    bool result = false;
+
+    do
+    {
+        if (optimizer == NULL || config == NULL || plan_id == NULL || script == NULL || demand == NULL || tick_ms == 0 ||
+            max_green < MIN_GREEN_STOP_LINE || batch_size == 0 || batch_size > OPTIMIZER_MAX_BATCH)
+        {
+            fprintf(stderr, "Assertion error in optimizer_init\n");
+            break;
+        }
+
+        memset(optimizer, 0, sizeof(*optimizer));
+
+        size_t plan;
+        for (plan = 0; plan < config->num_plans; plan++)
+        {
+            if (strncmp(config->plans[plan].id, plan_id, MAX_STR_LEN) == 0)
+            {
+                break;
+            }
+        }
+
+        if (plan == config->num_plans)
+        {
+            fprintf(stderr, "Unknown timing plan: %s\n", plan_id);
+            break;
+        }
+
+        if (config->plans[plan].is_flash)
+        {
+            fprintf(stderr, "Timing plan %s flashes, it has no timing to optimize\n", plan_id);
+            break;
+        }
+
+        // A single transition at the start of the week runs the plan throughout
+        optimizer->config = *config;
+        optimizer->config.main_road = config->main_road != NULL ? &optimizer->config.roads[config->main_road - config->roads]
+                                                                : NULL;
+        optimizer->config.num_transitions = 1;
+        optimizer->config.transitions[0] = (plan_transition_t){.minute = 0, .plan = (uint8_t)plan};
+        optimizer->plan = (uint8_t)plan;
+        optimizer->script = script;
+        optimizer->demand = demand;
+        optimizer->duration_ms = duration_ms;
+        optimizer->tick_ms = tick_ms;
+        optimizer->max_green = max_green;
+        optimizer->rng = seed;
+        optimizer->batch_size = batch_size;
+
+        optimizer->batch = malloc(batch_size * sizeof(optimizer_plan_t));
+        optimizer->tasks = malloc(batch_size * sizeof(uint32_t));
+
+        if (optimizer->batch == NULL || optimizer->tasks == NULL)
+        {
+            fprintf(stderr, "Out of memory while creating optimizer\n");
+            break;
+        }
+
+        for (size_t i = 0; i < batch_size; i++)
+        {
+            optimizer->tasks[i] = (uint32_t)i;
+        }
+
+        memcpy(optimizer->current.timing, config->plans[plan].timing, sizeof(optimizer->current.timing));
+
+        for (size_t road = 0; road < MAX_ROADS; road++)
+        {
+            const phase_timing_t *timing = &optimizer->current.timing[road];
+
+            optimizer->min_yellow_s[road] = ite_yellow_time(config->roads[road].speed_limit);
+            optimizer->min_red_clearance_s[road] = timing->red_clearance > MIN_RED_CLEARANCE ? timing->red_clearance
+                                                                                               : MIN_RED_CLEARANCE;
+
+            if (timing->yellow_time < optimizer->min_yellow_s[road])
+            {
+                fprintf(stderr, "Road %s: yellow of %.1f s is shorter than %.1f s at %u mph, not searched below it\n",
+                        config->roads[road].id,
+                        timing->yellow_time,
+                        optimizer->min_yellow_s[road],
+                        config->roads[road].speed_limit);
+            }
+        }
+
+        optimizer_evaluate(optimizer, &optimizer->current);
+        optimizer->evaluated++;
+
+        if (!optimizer->current.is_valid)
+        {
+            fprintf(stderr, "Timing plan %s does not simulate\n", plan_id);
+            break;
+        }
+
+        if (!merge(optimizer, &optimizer->current))
+        {
+            break;
+        }
+
+        result = true;
+
+    } while (0);
+
+    if (!result && optimizer != NULL)
+    {
+        optimizer_free(optimizer);
+    }
+
+    return result;
+}
+
+void optimizer_evaluate(const optimizer_t *const optimizer, optimizer_plan_t *const plan)
+{
+    config_t config = optimizer->config;
+    config.main_road = optimizer->config.main_road != NULL ? &config.roads[optimizer->config.main_road - optimizer->config.roads]
+                                                           : NULL;
+    memcpy(config.plans[optimizer->plan].timing, plan->timing, sizeof(plan->timing));
+
+    // Most rejected plans break a coordinated split, the search moves on without a message
+    config_error_sink_t sink = {0};
+    config_set_error_sink(&sink);
+    plan->is_valid = config_validate(&config);
+    config_set_error_sink(NULL);
+
+    plan->clearance_s = 0.0f;
+    for (size_t road = 0; road < MAX_ROADS; road++)
+    {
+        float clearance_s = plan->timing[road].yellow_time + plan->timing[road].red_clearance;
+        plan->clearance_s = road == 0 || clearance_s < plan->clearance_s ? clearance_s : plan->clearance_s;
+    }
+
+    if (!plan->is_valid)
+    {
+        return;
+    }
+
+    controller_t controller;
+    scheduler_t scheduler;
+
+    memset(&controller, 0, sizeof(controller));
+    controller.config = &config;
+    controller.tick_ms = optimizer->tick_ms;
+
+    if (!controller_init(&controller) || !scheduler_init_virtual(&scheduler, optimizer->tick_ms))
+    {
+        plan->is_valid = false;
+        return;
+    }
+
+    queue_model_t queues = {0};
+    sim_sinks_t sinks = {.queues = &queues};
+    sim_stats_t stats;
+
+    if (!queue_model_init(&queues, &controller, 1) || !sim_demand_schedule(optimizer->demand, &queues, 0))
+    {
+        queue_model_free(&queues);
+        plan->is_valid = false;
+        return;
+    }
+
+    sim_run(&controller, &scheduler, optimizer->script, optimizer->duration_ms, &sinks, &stats);
+
+    // The queue model averages over the whole demand, the script only samples it
+    queue_totals_t totals;
+    queue_model_totals(&queues, 0, &totals);
+    queue_model_free(&queues);
+
+    double arrivals = stats.arrivals > 0 ? (double)stats.arrivals : 1.0;
+    plan->avg_delay_s = totals.arrived > 0.0 ? totals.delay_ms / MS_PER_SEC / totals.arrived : 0.0;
+    plan->max_delay_s = (double)stats.max_delay_ms / MS_PER_SEC;
+    plan->green_share = (double)stats.arrivals_green / arrivals;
+}
+
+bool optimizer_round(optimizer_t *const optimizer, thread_pool_t *const pool)
+{
+    // The first round spreads over the whole space, later ones mostly refine the front
+    for (size_t i = 0; i < optimizer->batch_size; i++)
+    {
+        if (optimizer->rounds > 0 && i % NEIGHBOR_SHARE != 0)
+        {
+            sample_neighbor(optimizer, &optimizer->batch[i]);
+        }
+        else
+        {
+            sample_uniform(optimizer, &optimizer->batch[i]);
+        }
+    }
+
+    thread_pool_run(pool, optimizer->tasks, optimizer->batch_size, evaluate_task, optimizer);
+    optimizer->evaluated += optimizer->batch_size;
+    optimizer->rounds++;
+
+    // In batch order, so a seed gives the same front on any number of threads
+    for (size_t i = 0; i < optimizer->batch_size; i++)
+    {
+        if (!merge(optimizer, &optimizer->batch[i]))
+        {
+            return false;
+        }
+    }
+
+    return true;
+}
+
+void optimizer_sort_front(optimizer_t *const optimizer)
+{
+    qsort(optimizer->front, optimizer->front_count, sizeof(optimizer_plan_t), compare_plans);
+}
+
+void optimizer_free(optimizer_t *const optimizer)
+{
+    free(optimizer->batch);
+    free(optimizer->tasks);
+    free(optimizer->front);
+    memset(optimizer, 0, sizeof(*optimizer));
+}
@@ -0,0 +1,299 @@
+#include "queue_model.h"
+#include <stdlib.h>
+#include <string.h>
+
+#define MS_PER_SEC 1000.0
+#define MS_PER_HOUR (60U * MS_PER_MINUTE)
+#define NUM_ARRAYS 8U // Doubles per approach
+
+// Built for AVX2 and for the baseline, an ifunc resolver picks one at load time
+#if defined(__x86_64__) && defined(__GNUC__)
+#define QUEUE_KERNEL __attribute__((target_clones("avx2", "default")))
+#else
+#define QUEUE_KERNEL
+#endif
+
+/*
+ * The fluid queue of every approach over one tick. Vehicles arriving in the
+ * tick join the queue, the signal lets up to its capacity leave, and the
+ * delay adds the mean of the queues at both ends of the tick. Selects
+ * instead of branches, so the loop vectorizes.
+ */
+QUEUE_KERNEL static void step_approaches(
+    const size_t n,
+    const double dt_ms,
+    const double *restrict arrival,
+    const double *restrict saturation,
+    const double *restrict service,
+    double *restrict queue,
+    double *restrict delay,
+    double *restrict arrived,
+    double *restrict departed,
+    double *restrict max_queue)
+{
+    arrival = __builtin_assume_aligned(arrival, QUEUE_ALIGN);
+    saturation = __builtin_assume_aligned(saturation, QUEUE_ALIGN);
+    service = __builtin_assume_aligned(service, QUEUE_ALIGN);
+    queue = __builtin_assume_aligned(queue, QUEUE_ALIGN);
+    delay = __builtin_assume_aligned(delay, QUEUE_ALIGN);
+    arrived = __builtin_assume_aligned(arrived, QUEUE_ALIGN);
+    departed = __builtin_assume_aligned(departed, QUEUE_ALIGN);
+    max_queue = __builtin_assume_aligned(max_queue, QUEUE_ALIGN);
+
+    for (size_t i = 0; i < n; i++)
+    {
+        double in = arrival[i] * dt_ms;
+        double capacity = saturation[i] * service[i] * dt_ms;
+        double waiting = queue[i] + in;
+        double out = waiting < capacity ? waiting : capacity;
+        double left = waiting - out;
+
+        delay[i] += 0.5 * (queue[i] + left) * dt_ms;
+        arrived[i] += in;
+        departed[i] += out;
+        max_queue[i] = left > max_queue[i] ? left : max_queue[i];
+        queue[i] = left;
+    }
+}
+
+// Approach of an intersection served by phase, num_approaches if there is none
+static size_t approach_of_phase(const queue_model_t *const model, const size_t index, const phase_t phase)
+{
+    for (size_t i = index * QUEUE_APPROACHES; i < (index + 1U) * QUEUE_APPROACHES; i++)
+    {
+        if (model->phase[i] == phase)
+        {
+            return i;
+        }
+    }
+
+    return model->num_approaches;
+}
+
+/*Interface Functions*/
+
+bool queue_model_init(queue_model_t *const model, const controller_t *const controllers, const size_t count)
+{
+    bool result = false;
+
+    do
+    {
+        if (model == NULL || controllers == NULL || count == 0)
+        {
+            fprintf(stderr, "Assertion error in queue_model_init\n");
+            break;
+        }
+
+        memset(model, 0, sizeof(*model));
+        model->count = count;
+        model->num_approaches = count * QUEUE_APPROACHES;
+
+        // One block, every array starts on a vector boundary since each holds whole intersections
+        size_t array_size = model->num_approaches * sizeof(double);
+        double *block = aligned_alloc(QUEUE_ALIGN, NUM_ARRAYS * array_size);
+        model->phase = malloc(model->num_approaches);
+        model->direction = malloc(model->num_approaches);
+
+        if (block == NULL || model->phase == NULL || model->direction == NULL)
+        {
+            free(block);
+            fprintf(stderr, "Out of memory while creating queue model\n");
+            break;
+        }
+
+        memset(block, 0, NUM_ARRAYS * array_size);
+        model->arrival = block;
+        model->saturation = block + model->num_approaches;
+        model->service = block + 2U * model->num_approaches;
+        model->queue = block + 3U * model->num_approaches;
+        model->delay = block + 4U * model->num_approaches;
+        model->arrived = block + 5U * model->num_approaches;
+        model->departed = block + 6U * model->num_approaches;
+        model->max_queue = block + 7U * model->num_approaches;
+
+        for (size_t i = 0; i < count; i++)
+        {
+            const config_t *config = controllers[i].config;
+            const road_t *main_road = config->main_road != NULL ? config->main_road : &config->roads[0];
+
+            for (size_t road = 0; road < MAX_ROADS; road++)
+            {
+                const phase_t *phases = direction_phases[&config->roads[road] == main_road ? ROAD_MAIN : ROAD_SIDE];
+
+                for (size_t dir = 0; dir < MAX_DIRECTIONS; dir++)
+                {
+                    const direction_t *direction = &config->roads[road].directions[dir];
+                    size_t approach = i * QUEUE_APPROACHES + road * MAX_DIRECTIONS + dir;
+
+                    model->saturation[approach] = direction->straight.count * QUEUE_SATURATION_VPHPL / MS_PER_HOUR;
+                    model->phase[approach] = (uint8_t)phases[dir];
+                    model->direction[approach] = (uint8_t)direction->type;
+                }
+            }
+
+            queue_model_signals(model, i, &controllers[i]);
+        }
+
+        result = true;
+
+    } while (0);
+
+    if (!result && model != NULL)
+    {
+        queue_model_free(model);
+    }
+
+    return result;
+}
+
+bool queue_model_set_rate(queue_model_t *const model, const size_t index, const direction_type_t direction, const double vehicles_per_hour)
+{
+    if (index >= model->count || !(vehicles_per_hour >= 0.0))
+    {
+        fprintf(stderr, "Assertion error in queue_model_set_rate\n");
+        return false;
+    }
+
+    for (size_t i = index * QUEUE_APPROACHES; i < (index + 1U) * QUEUE_APPROACHES; i++)
+    {
+        if (model->direction[i] == direction)
+        {
+            model->arrival[i] = vehicles_per_hour / MS_PER_HOUR;
+            return true;
+        }
+    }
+
+    fprintf(stderr, "Intersection %lu has no approach in direction %d\n", index, direction);
+    return false;
+}
+
+bool queue_model_add_rate(
+    queue_model_t *const model,
+    const size_t index,
+    const phase_t phase,
+    const uint32_t time_ms,
+    const double vehicles_per_hour)
+{
+    if (index >= model->count || !(vehicles_per_hour >= 0.0))
+    {
+        fprintf(stderr, "Assertion error in queue_model_add_rate\n");
+        return false;
+    }
+
+    size_t approach = approach_of_phase(model, index, phase);
+
+    if (approach == model->num_approaches)
+    {
+        fprintf(stderr, "Intersection %lu has no approach served by phase %d\n", index, phase + 1);
+        return false;
+    }
+
+    if (model->num_rates == model->rates_capacity)
+    {
+        size_t capacity = model->rates_capacity > 0 ? model->rates_capacity * 2U : 64U;
+        queue_rate_t *rates = realloc(model->rates, capacity * sizeof(queue_rate_t));
+
+        if (rates == NULL)
+        {
+            fprintf(stderr, "Out of memory while scheduling arrival rates\n");
+            return false;
+        }
+
+        model->rates = rates;
+        model->rates_capacity = capacity;
+    }
+
+    // After the rates of the same time, and never before the ones already applied
+    size_t pos = model->num_rates;
+    while (pos > model->next_rate && model->rates[pos - 1U].time_ms > time_ms)
+    {
+        pos--;
+    }
+
+    memmove(&model->rates[pos + 1U], &model->rates[pos], (model->num_rates - pos) * sizeof(queue_rate_t));
+    model->rates[pos] = (queue_rate_t){.time_ms = time_ms, .approach = (uint32_t)approach, .vehicles_per_hour = vehicles_per_hour};
+    model->num_rates++;
+
+    return true;
+}
+
+void queue_model_signals(queue_model_t *const model, const size_t index, const controller_t *const controller)
+{
+    if (index >= model->count)
+    {
+        return;
+    }
+
+    for (size_t i = index * QUEUE_APPROACHES; i < (index + 1U) * QUEUE_APPROACHES; i++)
+    {
+        signal_state_t state = controller_head_state(controller, (phase_t)model->phase[i]);
+
+        model->service[i] = state == SIGNAL_GREEN || state == SIGNAL_FLASH_YELLOW ? 1.0
+                            : state == SIGNAL_FLASH_RED                         ? QUEUE_FLASH_RED_SHARE
+                                                                                : 0.0;
+    }
+}
+
+void queue_model_step(queue_model_t *const model, const uint32_t elapsed_ms)
+{
+    while (model->next_rate < model->num_rates && model->rates[model->next_rate].time_ms <= model->now_ms)
+    {
+        const queue_rate_t *rate = &model->rates[model->next_rate++];
+        model->arrival[rate->approach] = rate->vehicles_per_hour / MS_PER_HOUR;
+    }
+
+    step_approaches(
+        model->num_approaches,
+        (double)elapsed_ms,
+        model->arrival,
+        model->saturation,
+        model->service,
+        model->queue,
+        model->delay,
+        model->arrived,
+        model->departed,
+        model->max_queue);
+
+    model->now_ms += elapsed_ms;
+}
+
+void queue_model_totals(const queue_model_t *const model, const size_t index, queue_totals_t *const totals)
+{
+    memset(totals, 0, sizeof(*totals));
+
+    if (index >= model->count)
+    {
+        return;
+    }
+
+    for (size_t i = index * QUEUE_APPROACHES; i < (index + 1U) * QUEUE_APPROACHES; i++)
+    {
+        totals->arrived += model->arrived[i];
+        totals->departed += model->departed[i];
+        totals->delay_ms += model->delay[i];
+        totals->queue += model->queue[i];
+        totals->max_queue = model->max_queue[i] > totals->max_queue ? model->max_queue[i] : totals->max_queue;
+    }
+}
+
+void queue_model_print(const queue_model_t *const model, const size_t index, FILE *const stream)
+{
+    queue_totals_t totals;
+    queue_model_totals(model, index, &totals);
+
+    fprintf(stream,
+            "Queue model: %.0f vehicles, average delay %.1f s, longest queue %.1f vehicles, %.1f queued at the end\n",
+            totals.arrived,
+            totals.arrived > 0.0 ? totals.delay_ms / MS_PER_SEC / totals.arrived : 0.0,
+            totals.max_queue,
+            totals.queue);
+}
+
+void queue_model_free(queue_model_t *const model)
+{
+    free(model->arrival); // Start of the block of all arrays
+    free(model->phase);
+    free(model->direction);
+    free(model->rates);
+    memset(model, 0, sizeof(*model));
+}
@@ -0,0 +1,365 @@
+#include "replay.h"
+#include "config_cache.h"
+#include "latency.h"
+#include "scheduler.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define MS_PER_SEC 1000.0
+#define NS_PER_MS 1000000.0
+
+// Index of the config's intersection in the log, or the only one it recorded
+static bool find_intersection(const event_log_view_t *const view, const config_t *const config, uint16_t *const index)
+{
+    for (uint32_t i = 0; i < view->header->num_intersections; i++)
+    {
+        if (strncmp(view->ids[i], config->id, MAX_STR_LEN) == 0)
+        {
+            *index = (uint16_t)i;
+            return true;
+        }
+    }
+
+    if (view->header->num_intersections == 1)
+    {
+        *index = 0;
+        return true;
+    }
+
+    fprintf(stderr, "Intersection %s is not in the event log\n", config->id);
+    return false;
+}
+
+// Calls and actuations of the intersection, in the order they were recorded
+static bool build_script(const event_log_view_t *const view, const uint16_t intersection, sim_script_t *const script)
+{
+    static const sim_call_kind_t call_kinds[] = {
+        [EVENT_DETECTOR_ON] = SIM_DETECTOR_ON,
+        [EVENT_DETECTOR_OFF] = SIM_DETECTOR_OFF,
+        [EVENT_CALL] = SIM_CALL};
+
+    size_t count = 0;
+
+    for (uint64_t i = 0; i < view->count; i++)
+    {
+        const event_record_t *record = event_log_view_record(view, i);
+        count += record->intersection == intersection &&
+                 (record->kind == EVENT_DETECTOR_ON || record->kind == EVENT_DETECTOR_OFF || record->kind == EVENT_CALL);
+    }
+
+    memset(script, 0, sizeof(*script));
+    script->calls = malloc((count > 0 ? count : 1U) * sizeof(sim_call_t));
+
+    if (script->calls == NULL)
+    {
+        fprintf(stderr, "Out of memory while loading replay\n");
+        return false;
+    }
+
+    for (uint64_t i = 0; i < view->count && script->count < count; i++)
+    {
+        const event_record_t *record = event_log_view_record(view, i);
+
+        if (record->intersection != intersection ||
+            (record->kind != EVENT_DETECTOR_ON && record->kind != EVENT_DETECTOR_OFF && record->kind != EVENT_CALL))
+        {
+            continue;
+        }
+
+        script->calls[script->count++] = (sim_call_t){
+            .time_ms = (uint32_t)record->time_ms,
+            .phase = (phase_t)(record->phase < NUM_PHASES ? record->phase : PHASE_1),
+            .kind = call_kinds[record->kind]};
+    }
+
+    return true;
+}
+
+/*
+ * Measures the signals the log recorded like sim_run measures a candidate.
+ * Interval changes are not recorded, the first main and side road phases
+ * stand for their road.
+ */
+static void measure_recorded(const replay_t *const replay, replay_candidate_t *const candidate)
+{
+    const event_log_view_t *view = &replay->view;
+    sim_stats_t *stats = &candidate->recorded;
+    signal_state_t main_state = SIGNAL_OFF;
+    signal_state_t side_state = SIGNAL_OFF;
+    uint64_t last_ms = 0;
+    sim_delay_t delay;
+
+    memset(stats, 0, sizeof(*stats));
+    sim_delay_init(&delay, candidate->controller.runtime.phase_mask);
+
+    for (uint64_t i = 0; i < view->count; i++)
+    {
+        const event_record_t *record = event_log_view_record(view, i);
+
+        if (record->intersection != candidate->intersection || record->phase >= NUM_PHASES)
+        {
+            continue;
+        }
+
+        stats->main_green_ms += main_state == SIGNAL_GREEN ? record->time_ms - last_ms : 0;
+        stats->side_green_ms += side_state == SIGNAL_GREEN ? record->time_ms - last_ms : 0;
+        stats->flash_ms += main_state == SIGNAL_FLASH_YELLOW ? record->time_ms - last_ms : 0;
+        last_ms = record->time_ms;
+
+        switch (record->kind)
+        {
+        case EVENT_SIGNAL:
+            sim_delay_signal(&delay, stats, (phase_t)record->phase, (signal_state_t)record->state, record->time_ms);
+
+            if (record->phase == PHASE_2 || record->phase == PHASE_4)
+            {
+                bool is_main = record->phase == PHASE_2;
+                stats->cycles += is_main && record->state == SIGNAL_GREEN;
+                stats->side_serves += !is_main && record->state == SIGNAL_GREEN;
+                stats->gap_outs += record->cause == TERMINATION_GAP_OUT;
+                stats->max_outs += record->cause == TERMINATION_MAX_OUT;
+                stats->force_offs += record->cause == TERMINATION_FORCE_OFF;
+                *(is_main ? &main_state : &side_state) = (signal_state_t)record->state;
+            }
+            break;
+        case EVENT_DETECTOR_ON:
+        case EVENT_CALL:
+            sim_delay_arrival(&delay, stats, (phase_t)record->phase, record->time_ms);
+            stats->calls_placed++;
+            break;
+        case EVENT_DETECTOR_OFF:
+            stats->calls_placed++;
+            break;
+        case EVENT_PLAN:
+            stats->plan_changes += record->time_ms > 0; // The log opens with the plan running
+            break;
+        default:
+            break;
+        }
+    }
+
+    stats->main_green_ms += main_state == SIGNAL_GREEN ? replay->duration_ms - last_ms : 0;
+    stats->side_green_ms += side_state == SIGNAL_GREEN ? replay->duration_ms - last_ms : 0;
+    stats->flash_ms += main_state == SIGNAL_FLASH_YELLOW ? replay->duration_ms - last_ms : 0;
+    sim_delay_finish(&delay, stats, replay->duration_ms);
+}
+
+static void replay_task(void *const ctx, const uint32_t task)
+{
+    replay_t *replay = ctx;
+    replay_candidate_t *candidate = &replay->candidates[task];
+    controller_t *controller = &candidate->controller;
+    sim_script_t script = {0};
+
+    do
+    {
+        if (!config_load_cached(&candidate->config, candidate->path) ||
+            !find_intersection(&replay->view, &candidate->config, &candidate->intersection))
+        {
+            break;
+        }
+
+        memset(controller, 0, sizeof(*controller));
+        controller->config = &candidate->config;
+        controller->tick_ms = replay->view.header->tick_ms;
+        controller->start_week_ms = replay->start_week_ms;
+
+        if (!controller_init(controller) || !build_script(&replay->view, candidate->intersection, &script))
+        {
+            break;
+        }
+
+        measure_recorded(replay, candidate);
+
+        scheduler_t scheduler;
+
+        if (!scheduler_init_virtual(&scheduler, controller->tick_ms))
+        {
+            break;
+        }
+
+        uint64_t start_ns = latency_now_ns();
+        sim_run(controller, &scheduler, &script, replay->duration_ms, NULL, &candidate->stats);
+        candidate->wall_ns = latency_now_ns() - start_ns;
+        candidate->is_done = true;
+
+    } while (0);
+
+    sim_script_free(&script);
+}
+
+static void print_row(const char *const id, const char *const run, const sim_stats_t *const stats, const sim_stats_t *const recorded, const double wall_ms)
+{
+    double avg_delay_s = stats->arrivals > 0 ? (double)stats->delay_ms / MS_PER_SEC / (double)stats->arrivals : 0.0;
+    char change[16] = "";
+
+    if (recorded != NULL && recorded->delay_ms > 0)
+    {
+        snprintf(change, sizeof(change), "%+.1f%%", 100.0 * ((double)stats->delay_ms / (double)recorded->delay_ms - 1.0));
+    }
+
+    printf("%-12s %-32s %8llu %7.1f%% %9.1f %8s %9.1f %7llu %8llu %8llu %10llu %8.1f\n",
+           id,
+           run,
+           (unsigned long long)stats->arrivals,
+           stats->arrivals > 0 ? 100.0 * (double)stats->arrivals_green / (double)stats->arrivals : 0.0,
+           avg_delay_s,
+           change,
+           (double)stats->max_delay_ms / MS_PER_SEC,
+           (unsigned long long)stats->cycles,
+           (unsigned long long)stats->gap_outs,
+           (unsigned long long)stats->max_outs,
+           (unsigned long long)stats->force_offs,
+           wall_ms);
+}
+
+/*Interface Functions*/
+
+bool replay_open(replay_t *const replay, const char *const log_path)
+{
+    bool result = false;
+
+    do
+    {
+        if (replay == NULL || log_path == NULL)
+        {
+            fprintf(stderr, "Assertion error in replay_open\n");
+            break;
+        }
+
+        memset(replay, 0, sizeof(*replay));
+
+        if (!event_log_view_open(&replay->view, log_path))
+        {
+            break;
+        }
+
+        if (replay->view.count == 0 || replay->view.header->tick_ms == 0)
+        {
+            fprintf(stderr, "Nothing to replay in event log: %s\n", log_path);
+            break;
+        }
+
+        if (replay->view.first > 0)
+        {
+            fprintf(stderr, "Event log wrapped, replaying its last %llu records\n", (unsigned long long)replay->view.count);
+        }
+
+        const event_log_view_t *view = &replay->view;
+        replay->duration_ms = event_log_view_record(view, view->count - 1U)->time_ms;
+        replay->start_week_ms = view->header->epoch_ms > 0 ? scheduler_week_ms_at(view->header->epoch_ms) : 0;
+        result = true;
+
+    } while (0);
+
+    if (!result && replay != NULL)
+    {
+        replay_close(replay);
+    }
+
+    return result;
+}
+
+bool replay_run(replay_t *const replay, char *const config_paths[], const size_t count, const size_t num_threads)
+{
+    bool result = false;
+    uint32_t *tasks = NULL;
+
+    do
+    {
+        if (replay == NULL || config_paths == NULL || count == 0 || count > UINT32_MAX)
+        {
+            fprintf(stderr, "Assertion error in replay_run\n");
+            break;
+        }
+
+        replay->candidates = aligned_alloc(CONTROLLER_CACHE_LINE, count * sizeof(replay_candidate_t));
+        tasks = malloc(count * sizeof(uint32_t));
+
+        if (replay->candidates == NULL || tasks == NULL)
+        {
+            fprintf(stderr, "Out of memory while creating replay candidates\n");
+            break;
+        }
+
+        memset(replay->candidates, 0, count * sizeof(replay_candidate_t));
+        replay->count = count;
+
+        for (size_t i = 0; i < count; i++)
+        {
+            replay->candidates[i].path = config_paths[i];
+            tasks[i] = (uint32_t)i;
+        }
+
+        size_t resolved = thread_pool_resolve_threads(num_threads);
+
+        if (!thread_pool_init(&replay->pool, resolved < count ? resolved : count, count))
+        {
+            fprintf(stderr, "Failed to create replay threads\n");
+            break;
+        }
+
+        thread_pool_run(&replay->pool, tasks, count, replay_task, replay);
+
+        result = true;
+        for (size_t i = 0; i < count; i++)
+        {
+            result = result && replay->candidates[i].is_done;
+        }
+
+    } while (0);
+
+    free(tasks);
+
+    return result;
+}
+
+void replay_print(const replay_t *const replay)
+{
+    const event_log_header_t *header = replay->view.header;
+
+    printf("Replayed %.0f s of %u intersections, %llu records, %u ms ticks, on %lu threads\n",
+           (double)replay->duration_ms / MS_PER_SEC,
+           header->num_intersections,
+           (unsigned long long)replay->view.count,
+           header->tick_ms,
+           replay->pool.num_threads);
+    printf("%-12s %-32s %8s %8s %9s %8s %9s %7s %8s %8s %10s %8s\n",
+           "intersection", "run", "arrivals", "on green", "avg delay", "change", "max delay",
+           "cycles", "gap-outs", "max-outs", "force-offs", "wall ms");
+
+    for (size_t i = 0; i < replay->count; i++)
+    {
+        const replay_candidate_t *candidate = &replay->candidates[i];
+        const char *id = replay->view.ids[candidate->intersection];
+        bool is_first = true;
+
+        if (!candidate->is_done)
+        {
+            printf("%-12s %-32s failed\n", "", candidate->path);
+            continue;
+        }
+
+        // The recorded run once per intersection, before its first candidate
+        for (size_t j = 0; j < i; j++)
+        {
+            is_first = is_first && !(replay->candidates[j].is_done && replay->candidates[j].intersection == candidate->intersection);
+        }
+
+        if (is_first)
+        {
+            print_row(id, "recorded", &candidate->recorded, NULL, 0.0);
+        }
+
+        print_row(id, candidate->path, &candidate->stats, &candidate->recorded, (double)candidate->wall_ns / NS_PER_MS);
+    }
+}
+
+void replay_close(replay_t *const replay)
+{
+    thread_pool_free(&replay->pool);
+    free(replay->candidates);
+    event_log_view_close(&replay->view);
+    memset(replay, 0, sizeof(*replay));
+}
@@ -0,0 +1,160 @@
+#include "scheduler.h"
+#include <stdio.h>
+#include <time.h>
+#include <errno.h>
+#include <string.h>
+
+#define NS_PER_MS 1000000ULL
+#define NS_PER_SEC 1000000000ULL
+
+static uint64_t monotonic_ns(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * NS_PER_SEC + (uint64_t)ts.tv_nsec;
+}
+
+static bool scheduler_setup(scheduler_t *const sched, const uint32_t period_ms, const bool is_virtual)
+{
+    bool result = false;
+
+    do
+    {
+        if (sched == NULL)
+        {
+            fprintf(stderr, "Assertion error in scheduler_setup\n");
+            break;
+        }
+
+        if (period_ms < SCHEDULER_MIN_TICK_MS || period_ms > SCHEDULER_MAX_TICK_MS)
+        {
+            fprintf(stderr,
+                    "Invalid tick period %u, must be within %u to %u ms\n",
+                    period_ms,
+                    SCHEDULER_MIN_TICK_MS,
+                    SCHEDULER_MAX_TICK_MS);
+            break;
+        }
+
+        memset(sched, 0, sizeof(*sched));
+        sched->period_ms = period_ms;
+        sched->period_ns = period_ms * NS_PER_MS;
+        sched->is_virtual = is_virtual;
+        sched->start_ns = is_virtual ? 0 : monotonic_ns();
+        sched->deadline_ns = sched->start_ns + sched->period_ns;
+
+        result = true;
+
+    } while (0);
+
+    return result;
+}
+
+bool scheduler_init(scheduler_t *const sched, const uint32_t period_ms)
+{
+    return scheduler_setup(sched, period_ms, false);
+}
+
+bool scheduler_init_virtual(scheduler_t *const sched, const uint32_t period_ms)
+{
+    return scheduler_setup(sched, period_ms, true);
+}
+
+uint32_t scheduler_wait(scheduler_t *const sched)
+{
+    if (sched->is_virtual)
+    {
+        // Jump straight to the deadline, no jitter on a virtual clock
+        sched->virtual_ns = sched->deadline_ns;
+        sched->deadline_ns += sched->period_ns;
+        sched->stats.ticks++;
+        return 1U;
+    }
+
+    struct timespec deadline = {
+        .tv_sec = (time_t)(sched->deadline_ns / NS_PER_SEC),
+        .tv_nsec = (long)(sched->deadline_ns % NS_PER_SEC)};
+
+    int err = clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME, &deadline, NULL);
+
+    if (err != 0)
+    {
+        if (err != EINTR)
+        {
+            fprintf(stderr, "clock_nanosleep failed: %s\n", strerror(err));
+        }
+
+        return 0;
+    }
+
+    uint64_t now = monotonic_ns();
+    uint64_t lateness = (now > sched->deadline_ns) ? now - sched->deadline_ns : 0;
+
+    // Catch up on whole periods lost to an overrun instead of drifting
+    uint32_t elapsed = 1U + (uint32_t)(lateness / sched->period_ns);
+
+    sched->woken_ns = sched->deadline_ns;
+    sched->jitter_ns = lateness;
+    sched->stats.ticks++;
+    sched->stats.total_jitter_ns += lateness;
+
+    if (lateness > sched->stats.max_jitter_ns)
+    {
+        sched->stats.max_jitter_ns = lateness;
+    }
+
+    if (elapsed > 1U)
+    {
+        sched->stats.overruns++;
+        sched->stats.missed_ticks += elapsed - 1U;
+    }
+
+    sched->deadline_ns += elapsed * sched->period_ns;
+
+    return elapsed;
+}
+
+uint64_t scheduler_now_ms(const scheduler_t *const sched)
+{
+    uint64_t now_ns = sched->is_virtual ? sched->virtual_ns : monotonic_ns() - sched->start_ns;
+
+    return now_ns / NS_PER_MS;
+}
+
+uint32_t scheduler_week_ms(void)
+{
+    struct timespec ts;
+
+    clock_gettime(CLOCK_REALTIME, &ts);
+
+    return scheduler_week_ms_at((uint64_t)ts.tv_sec * 1000U + (uint64_t)(ts.tv_nsec / (long)NS_PER_MS));
+}
+
+uint32_t scheduler_week_ms_at(const uint64_t unix_ms)
+{
+    time_t unix_s = (time_t)(unix_ms / 1000U);
+    struct tm local;
+
+    localtime_r(&unix_s, &local);
+
+    uint32_t day = (uint32_t)(local.tm_wday + 6) % 7U; // tm_wday counts from Sunday
+    uint32_t sec = ((day * 24U + (uint32_t)local.tm_hour) * 60U + (uint32_t)local.tm_min) * 60U +
+                   (uint32_t)local.tm_sec;
+
+    return sec * 1000U + (uint32_t)(unix_ms % 1000U);
+}
+
+void scheduler_print_stats(const scheduler_t *const sched)
+{
+    const scheduler_stats_t *stats = &sched->stats;
+    uint64_t avg_jitter_ns = stats->ticks > 0 ? stats->total_jitter_ns / stats->ticks : 0;
+
+    printf("Scheduler: %llu ticks of %u ms, %llu overruns (%llu missed ticks), "
+           "jitter avg %llu us, max %llu us\n",
+           (unsigned long long)stats->ticks,
+           sched->period_ms,
+           (unsigned long long)stats->overruns,
+           (unsigned long long)stats->missed_ticks,
+           (unsigned long long)(avg_jitter_ns / 1000U),
+           (unsigned long long)(stats->max_jitter_ns / 1000U));
+}
@@ -0,0 +1,362 @@
+#include "signal_output.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/ioctl.h>
+#include <sys/stat.h>
+#include <linux/gpio.h>
+
+#define SIGNAL_SHOWN_NONE 0xFFU // No state emitted yet, forces the first update
+#define SIGNAL_LINE_MAX_LEN (MAX_STR_LEN + 64U)
+#define SIGNAL_LAMP_MASK ((1ULL << SIGNAL_LAMPS) - 1ULL)
+#define GPIO_CONSUMER "traffic_controller"
+
+// Lamp bits per signal_state_t: red, yellow, green. The cabinet flasher blinks flashing lamps
+static const uint8_t state_lamps[] = {
+    [SIGNAL_RED] = 0x1,
+    [SIGNAL_YELLOW] = 0x2,
+    [SIGNAL_GREEN] = 0x4,
+    [SIGNAL_FLASH_YELLOW] = 0x2,
+    [SIGNAL_FLASH_RED] = 0x1,
+    [SIGNAL_OFF] = 0x0};
+
+/* File driver */
+
+static bool file_open(signal_output_t *const output)
+{
+    struct stat st;
+
+    // A FIFO is opened without blocking for a reader, and a full pipe drops changes instead of stalling the tick
+    if (stat(output->path, &st) == 0 && S_ISFIFO(st.st_mode))
+    {
+        output->fd = open(output->path, O_RDWR | O_NONBLOCK);
+    }
+    else
+    {
+        output->fd = open(output->path, O_WRONLY | O_CREAT | O_TRUNC, 0644);
+    }
+
+    if (output->fd < 0)
+    {
+        fprintf(stderr, "Failed to open signal output: %s\n", output->path);
+        return false;
+    }
+
+    output->buffer = malloc(SIGNAL_OUTPUT_BUFFER_LEN);
+
+    if (output->buffer == NULL)
+    {
+        fprintf(stderr, "Out of memory while creating signal output\n");
+        return false;
+    }
+
+    return true;
+}
+
+static void file_emit(signal_output_t *const output, const signal_change_t *const change)
+{
+    if (SIGNAL_OUTPUT_BUFFER_LEN - output->buffer_len < SIGNAL_LINE_MAX_LEN)
+    {
+        signal_output_flush(output);
+    }
+
+    int len = snprintf(output->buffer + output->buffer_len,
+                       SIGNAL_OUTPUT_BUFFER_LEN - output->buffer_len,
+                       "%llu %s %u %s\n",
+                       (unsigned long long)change->time_ms,
+                       output->controllers[change->intersection].config->id,
+                       (unsigned)(change->phase - PHASE_1 + 1),
+                       signal_state_str(change->state));
+
+    output->buffer_len += len > 0 ? (size_t)len : 0;
+}
+
+static bool file_flush(signal_output_t *const output)
+{
+    size_t written = 0;
+    bool result = true;
+
+    while (written < output->buffer_len)
+    {
+        ssize_t len = write(output->fd, output->buffer + written, output->buffer_len - written);
+        output->writes++;
+
+        if (len < 0 && errno == EINTR)
+        {
+            continue;
+        }
+
+        if (len <= 0)
+        {
+            result = false;
+            break;
+        }
+
+        written += (size_t)len;
+    }
+
+    output->buffer_len = 0;
+
+    return result;
+}
+
+static void file_close(signal_output_t *const output)
+{
+    if (output->fd >= 0)
+    {
+        close(output->fd);
+    }
+
+    free(output->buffer);
+    output->buffer = NULL;
+}
+
+/* GPIO character device driver */
+
+static bool gpio_open(signal_output_t *const output)
+{
+    uint32_t num_lines = output->num_heads * SIGNAL_LAMPS;
+
+    if (num_lines > GPIO_V2_LINES_MAX)
+    {
+        fprintf(stderr,
+                "Too many signal lamps %u for a GPIO chip, must be not more than %u\n",
+                num_lines,
+                GPIO_V2_LINES_MAX);
+        return false;
+    }
+
+    int chip_fd = open(output->path, O_RDWR | O_CLOEXEC);
+
+    if (chip_fd < 0)
+    {
+        fprintf(stderr, "Failed to open GPIO chip: %s\n", output->path);
+        return false;
+    }
+
+    // Request every lamp line at once, values are then set for all lines with a single ioctl
+    struct gpio_v2_line_request request;
+    memset(&request, 0, sizeof(request));
+
+    for (uint32_t i = 0; i < num_lines; i++)
+    {
+        request.offsets[i] = i;
+    }
+
+    strncpy(request.consumer, GPIO_CONSUMER, sizeof(request.consumer) - 1U);
+    request.config.flags = GPIO_V2_LINE_FLAG_OUTPUT;
+    request.num_lines = num_lines;
+
+    bool result = ioctl(chip_fd, GPIO_V2_GET_LINE_IOCTL, &request) == 0;
+    close(chip_fd);
+
+    if (!result)
+    {
+        fprintf(stderr, "Failed to request %u GPIO lines of %s\n", num_lines, output->path);
+        return false;
+    }
+
+    output->fd = request.fd;
+
+    return true;
+}
+
+static void gpio_emit(signal_output_t *const output, const signal_change_t *const change)
+{
+    unsigned shift = change->head * SIGNAL_LAMPS;
+
+    output->line_mask |= SIGNAL_LAMP_MASK << shift;
+    output->line_bits &= ~(SIGNAL_LAMP_MASK << shift);
+    output->line_bits |= (uint64_t)state_lamps[change->state] << shift;
+}
+
+static bool gpio_flush(signal_output_t *const output)
+{
+    struct gpio_v2_line_values values = {
+        .bits = output->line_bits,
+        .mask = output->line_mask};
+
+    output->writes++;
+    output->line_mask = 0;
+
+    return ioctl(output->fd, GPIO_V2_LINE_SET_VALUES_IOCTL, &values) == 0;
+}
+
+static void gpio_close(signal_output_t *const output)
+{
+    if (output->fd >= 0)
+    {
+        close(output->fd);
+    }
+}
+
+/*Interface Functions*/
+
+bool signal_output_start(
+    signal_output_t *const output,
+    const char *const spec,
+    const controller_t *const controllers,
+    const size_t count)
+{
+    bool result = false;
+
+    do
+    {
+        if (output == NULL || spec == NULL || controllers == NULL || count == 0)
+        {
+            fprintf(stderr, "Assertion error in signal_output_start\n");
+            break;
+        }
+
+        memset(output, 0, sizeof(*output));
+        output->fd = -1;
+        output->controllers = controllers;
+        output->heads = calloc(count, sizeof(signal_heads_t));
+
+        if (output->heads == NULL)
+        {
+            fprintf(stderr, "Out of memory while creating signal heads\n");
+            break;
+        }
+
+        output->count = count;
+
+        for (size_t i = 0; i < count; i++)
+        {
+            signal_heads_t *heads = &output->heads[i];
+
+            heads->first_head = output->num_heads;
+            heads->phase_mask = controllers[i].runtime.phase_mask;
+            heads->main_shown = SIGNAL_SHOWN_NONE;
+            heads->side_shown = SIGNAL_SHOWN_NONE;
+            output->num_heads += (uint32_t)__builtin_popcount(heads->phase_mask);
+        }
+
+        if (strncmp(spec, SIGNAL_OUTPUT_GPIO_PREFIX, strlen(SIGNAL_OUTPUT_GPIO_PREFIX)) == 0)
+        {
+            output->path = spec + strlen(SIGNAL_OUTPUT_GPIO_PREFIX);
+            output->open = gpio_open;
+            output->emit = gpio_emit;
+            output->flush = gpio_flush;
+            output->close = gpio_close;
+        }
+        else
+        {
+            output->path = spec;
+            output->open = file_open;
+            output->emit = file_emit;
+            output->flush = file_flush;
+            output->close = file_close;
+        }
+
+        if (!output->open(output))
+        {
+            break;
+        }
+
+        // Every head starts from an unknown state, so the first flush shows them all
+        for (size_t i = 0; i < count; i++)
+        {
+            signal_output_update(output, i, 0);
+        }
+
+        signal_output_flush(output);
+        result = true;
+
+    } while (0);
+
+    if (!result && output != NULL)
+    {
+        signal_output_stop(output);
+    }
+
+    return result;
+}
+
+void signal_output_update(signal_output_t *const output, const size_t index, const uint64_t time_ms)
+{
+    if (index >= output->count)
+    {
+        return;
+    }
+
+    const controller_state_t *state = &output->controllers[index].state;
+    signal_heads_t *heads = &output->heads[index];
+
+    if (state->main_state == heads->main_shown && state->side_state == heads->side_shown)
+    {
+        return;
+    }
+
+    signal_change_t change = {
+        .time_ms = time_ms,
+        .intersection = (uint32_t)index,
+        .head = heads->first_head};
+
+    for (phase_t phase = PHASE_1; phase < NUM_PHASES; phase++)
+    {
+        if ((heads->phase_mask & PHASE_BIT(phase)) == 0)
+        {
+            continue;
+        }
+
+        bool is_main = (MAIN_ROAD_PHASES & PHASE_BIT(phase)) != 0;
+        change.phase = phase;
+        change.state = is_main ? state->main_state : state->side_state;
+
+        if (change.state != (is_main ? heads->main_shown : heads->side_shown))
+        {
+            output->emit(output, &change);
+            output->pending++;
+            output->changes++;
+        }
+
+        change.head++;
+    }
+
+    heads->main_shown = (uint8_t)state->main_state;
+    heads->side_shown = (uint8_t)state->side_state;
+}
+
+void signal_output_flush(signal_output_t *const output)
+{
+    if (output->pending == 0)
+    {
+        return;
+    }
+
+    if (!output->flush(output))
+    {
+        output->dropped += output->pending;
+    }
+
+    output->pending = 0;
+}
+
+void signal_output_stop(signal_output_t *const output)
+{
+    if (output->close == NULL)
+    {
+        return;
+    }
+
+    if (output->fd >= 0)
+    {
+        signal_output_flush(output);
+
+        printf("Signal output %s: %u heads, %llu changes in %llu writes, %llu dropped\n",
+               output->path,
+               output->num_heads,
+               (unsigned long long)output->changes,
+               (unsigned long long)output->writes,
+               (unsigned long long)output->dropped);
+    }
+
+    output->close(output);
+    free(output->heads);
+    memset(output, 0, sizeof(*output));
+    output->fd = -1;
+}
@@ -0,0 +1,698 @@
+#include "simulation.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <ctype.h>
+#include <math.h>
+#include <strings.h>
+
+#define MAX_SCRIPT_LINE_LEN 128U
+#define MS_PER_SEC 1000.0
+#define MS_PER_HOUR (60U * MS_PER_MINUTE)
+
+/*
+ * Detectors occupied by vehicles stopped on red. The scripted off event of
+ * such a vehicle is dropped, and the detector clears once its phase turned
+ * green and the queue waiting for it discharged, so presence keeps calling
+ * a phase without lock memory.
+ */
+typedef struct
+{
+    uint8_t held_mask;      // Detectors held on, their scripted off events are dropped
+    uint8_t releasing_mask; // Held detectors of phases turned green
+    uint64_t release_ms[NUM_PHASES];
+} sim_hold_t;
+
+static bool script_append(sim_script_t *const script, size_t *const capacity, const sim_call_t *const call)
+{
+    if (script->count == *capacity)
+    {
+        size_t new_capacity = *capacity > 0 ? *capacity * 2U : 256U;
+        sim_call_t *calls = realloc(script->calls, new_capacity * sizeof(sim_call_t));
+
+        if (calls == NULL)
+        {
+            fprintf(stderr, "Out of memory while loading call script\n");
+            return false;
+        }
+
+        script->calls = calls;
+        *capacity = new_capacity;
+    }
+
+    script->calls[script->count++] = *call;
+    return true;
+}
+
+bool sim_script_load(sim_script_t *const script, const char *const filename)
+{
+    bool result = false;
+    FILE *file = NULL;
+    size_t capacity = 0;
+
+    do
+    {
+        if (script == NULL || filename == NULL)
+        {
+            fprintf(stderr, "Assertion error in sim_script_load\n");
+            break;
+        }
+
+        memset(script, 0, sizeof(*script));
+
+        file = fopen(filename, "r");
+        if (file == NULL)
+        {
+            fprintf(stderr, "Failed to open call script: %s\n", filename);
+            break;
+        }
+
+        char line[MAX_SCRIPT_LINE_LEN];
+        size_t line_num = 0;
+        bool is_valid = true;
+
+        while (is_valid && fgets(line, sizeof(line), file) != NULL)
+        {
+            line_num++;
+
+            char *ptr = line;
+            while (isspace((unsigned char)*ptr))
+            {
+                ptr++;
+            }
+
+            if (*ptr == '\0' || *ptr == '#')
+            {
+                continue;
+            }
+
+            char *end;
+            double time_s = strtod(ptr, &end);
+            long phase = (end != ptr) ? strtol(end, &end, 10) : 0;
+            char state[8] = {0};
+            sim_call_kind_t kind = SIM_CALL;
+            bool is_known_state = true;
+
+            if (sscanf(end, "%7s", state) == 1)
+            {
+                is_known_state = strcasecmp(state, "on") == 0 || strcasecmp(state, "off") == 0;
+                kind = strcasecmp(state, "on") == 0 ? SIM_DETECTOR_ON : SIM_DETECTOR_OFF;
+            }
+
+            if (!(time_s >= 0.0 && time_s <= UINT32_MAX / MS_PER_SEC) ||
+                phase < 1 || phase > NUM_PHASES || !is_known_state)
+            {
+                fprintf(stderr,
+                        "Invalid call at %s:%lu, expected \"<time_s> <phase 1-%d> [on|off]\"\n",
+                        filename,
+                        line_num,
+                        NUM_PHASES);
+                is_valid = false;
+                break;
+            }
+
+            sim_call_t call = {
+                .time_ms = (uint32_t)(time_s * MS_PER_SEC + 0.5),
+                .phase = (phase_t)(PHASE_1 + phase - 1),
+                .kind = kind};
+
+            if (script->count > 0 && call.time_ms < script->calls[script->count - 1U].time_ms)
+            {
+                fprintf(stderr, "Calls out of order at %s:%lu\n", filename, line_num);
+                is_valid = false;
+                break;
+            }
+
+            is_valid = script_append(script, &capacity, &call);
+        }
+
+        if (!is_valid)
+        {
+            break;
+        }
+
+        result = true;
+
+    } while (0);
+
+    if (file != NULL)
+    {
+        fclose(file);
+    }
+
+    if (!result && script != NULL)
+    {
+        sim_script_free(script);
+    }
+
+    return result;
+}
+
+void sim_script_free(sim_script_t *const script)
+{
+    free(script->calls);
+    memset(script, 0, sizeof(*script));
+}
+
+bool sim_demand_load(sim_demand_t *const demand, const char *const filename)
+{
+    bool result = false;
+    FILE *file = NULL;
+    size_t capacity = 0;
+
+    do
+    {
+        if (demand == NULL || filename == NULL)
+        {
+            fprintf(stderr, "Assertion error in sim_demand_load\n");
+            break;
+        }
+
+        memset(demand, 0, sizeof(*demand));
+
+        file = fopen(filename, "r");
+        if (file == NULL)
+        {
+            fprintf(stderr, "Failed to open demand profile: %s\n", filename);
+            break;
+        }
+
+        char line[MAX_SCRIPT_LINE_LEN];
+        size_t line_num = 0;
+        bool is_valid = true;
+
+        while (is_valid && fgets(line, sizeof(line), file) != NULL)
+        {
+            line_num++;
+
+            char *ptr = line;
+            while (isspace((unsigned char)*ptr))
+            {
+                ptr++;
+            }
+
+            if (*ptr == '\0' || *ptr == '#')
+            {
+                continue;
+            }
+
+            char *end;
+            double time_s = strtod(ptr, &end);
+            long phase = (end != ptr) ? strtol(end, &end, 10) : 0;
+            char *rate_end = end;
+            double vehicles_per_hour = strtod(end, &rate_end);
+
+            if (!(time_s >= 0.0 && time_s <= UINT32_MAX / MS_PER_SEC) || phase < 1 || phase > NUM_PHASES ||
+                rate_end == end || !(vehicles_per_hour >= 0.0 && vehicles_per_hour <= SIM_MAX_DEMAND_VPH))
+            {
+                fprintf(stderr,
+                        "Invalid demand at %s:%lu, expected \"<time_s> <phase 1-%d> <vehicles_per_hour 0-%.0f>\"\n",
+                        filename,
+                        line_num,
+                        NUM_PHASES,
+                        SIM_MAX_DEMAND_VPH);
+                is_valid = false;
+                break;
+            }
+
+            sim_demand_entry_t entry = {
+                .time_ms = (uint32_t)(time_s * MS_PER_SEC + 0.5),
+                .phase = (phase_t)(PHASE_1 + phase - 1),
+                .vehicles_per_hour = vehicles_per_hour};
+
+            if (demand->count > 0 && entry.time_ms < demand->entries[demand->count - 1U].time_ms)
+            {
+                fprintf(stderr, "Demand out of order at %s:%lu\n", filename, line_num);
+                is_valid = false;
+                break;
+            }
+
+            if (demand->count == capacity)
+            {
+                size_t new_capacity = capacity > 0 ? capacity * 2U : 64U;
+                sim_demand_entry_t *entries = realloc(demand->entries, new_capacity * sizeof(sim_demand_entry_t));
+
+                if (entries == NULL)
+                {
+                    fprintf(stderr, "Out of memory while loading demand profile\n");
+                    is_valid = false;
+                    break;
+                }
+
+                demand->entries = entries;
+                capacity = new_capacity;
+            }
+
+            demand->entries[demand->count++] = entry;
+        }
+
+        if (!is_valid)
+        {
+            break;
+        }
+
+        result = true;
+
+    } while (0);
+
+    if (file != NULL)
+    {
+        fclose(file);
+    }
+
+    if (!result && demand != NULL)
+    {
+        sim_demand_free(demand);
+    }
+
+    return result;
+}
+
+void sim_demand_free(sim_demand_t *const demand)
+{
+    free(demand->entries);
+    memset(demand, 0, sizeof(*demand));
+}
+
+// splitmix64, uniform in (0, 1]
+static double next_uniform(uint64_t *const state)
+{
+    uint64_t z = (*state += 0x9E3779B97F4A7C15ULL);
+    z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ULL;
+    z = (z ^ (z >> 27)) * 0x94D049BB133111EBULL;
+    z ^= z >> 31;
+
+    return (double)((z >> 11) + 1U) * 0x1p-53;
+}
+
+static int compare_calls(const void *const a, const void *const b)
+{
+    const sim_call_t *call_a = a;
+    const sim_call_t *call_b = b;
+
+    if (call_a->time_ms != call_b->time_ms)
+    {
+        return call_a->time_ms < call_b->time_ms ? -1 : 1;
+    }
+
+    return (int)call_a->phase - (int)call_b->phase;
+}
+
+bool sim_script_generate(
+    sim_script_t *const script,
+    const sim_demand_t *const demand,
+    const uint64_t duration_ms,
+    const uint64_t seed)
+{
+    bool result = false;
+    size_t capacity = 0;
+
+    do
+    {
+        if (script == NULL || demand == NULL || duration_ms > UINT32_MAX)
+        {
+            fprintf(stderr, "Assertion error in sim_script_generate\n");
+            break;
+        }
+
+        memset(script, 0, sizeof(*script));
+
+        bool is_valid = true;
+
+        for (phase_t phase = PHASE_1; is_valid && phase < NUM_PHASES; phase++)
+        {
+            // Every phase draws from its own stream, so its arrivals do not depend on the others
+            uint64_t state = seed ^ ((uint64_t)(phase + 1U) << 56);
+            double rate_per_ms = 0.0;
+            double time_ms = 0.0;
+            size_t next = 0;
+            uint64_t off_ms = 0;
+            bool is_occupied = false;
+
+            while (is_valid && time_ms < (double)duration_ms)
+            {
+                // Rate changes of this phase up to now, the next one ends the current rate
+                double end_ms = (double)duration_ms;
+
+                for (; next < demand->count; next++)
+                {
+                    const sim_demand_entry_t *entry = &demand->entries[next];
+
+                    if (entry->phase != phase)
+                    {
+                        continue;
+                    }
+
+                    if ((double)entry->time_ms > time_ms)
+                    {
+                        end_ms = (double)entry->time_ms;
+                        break;
+                    }
+
+                    rate_per_ms = entry->vehicles_per_hour / (double)MS_PER_HOUR;
+                }
+
+                double arrival_ms = rate_per_ms > 0.0 ? time_ms - log(next_uniform(&state)) / rate_per_ms : end_ms;
+
+                // Arrivals are memoryless, so the draw restarts at a rate change
+                if (arrival_ms >= end_ms)
+                {
+                    time_ms = end_ms;
+                    continue;
+                }
+
+                time_ms = arrival_ms;
+
+                sim_call_t call = {.time_ms = (uint32_t)time_ms, .phase = phase, .kind = SIM_DETECTOR_ON};
+
+                // Back to back vehicles hold the detector, each one still counts as an actuation
+                if (is_occupied && call.time_ms > off_ms)
+                {
+                    sim_call_t off = {.time_ms = (uint32_t)off_ms, .phase = phase, .kind = SIM_DETECTOR_OFF};
+                    is_valid = script_append(script, &capacity, &off);
+                }
+
+                is_valid = is_valid && script_append(script, &capacity, &call);
+                off_ms = (uint64_t)call.time_ms + SIM_VEHICLE_OCCUPANCY_MS;
+                is_occupied = true;
+            }
+
+            if (is_valid && is_occupied && off_ms < duration_ms)
+            {
+                sim_call_t off = {.time_ms = (uint32_t)off_ms, .phase = phase, .kind = SIM_DETECTOR_OFF};
+                is_valid = script_append(script, &capacity, &off);
+            }
+        }
+
+        if (!is_valid)
+        {
+            break;
+        }
+
+        qsort(script->calls, script->count, sizeof(sim_call_t), compare_calls);
+        result = true;
+
+    } while (0);
+
+    if (!result && script != NULL)
+    {
+        sim_script_free(script);
+    }
+
+    return result;
+}
+
+// Starts the discharge of held detectors whose phase turned green, holds them again on red
+static void update_holds(sim_hold_t *const hold, const sim_delay_t *const delay, const controller_t *const controller, const uint64_t time_ms)
+{
+    for (phase_t phase = PHASE_1; phase < NUM_PHASES; phase++)
+    {
+        uint8_t bit = PHASE_BIT(phase);
+        signal_state_t state = controller_head_state(controller, phase);
+        bool is_serving = state == SIGNAL_GREEN || state == SIGNAL_FLASH_YELLOW || state == SIGNAL_FLASH_RED;
+
+        if ((hold->held_mask & bit) == 0)
+        {
+            continue;
+        }
+
+        if (!is_serving)
+        {
+            hold->releasing_mask &= (uint8_t)~bit;
+        }
+        else if ((hold->releasing_mask & bit) == 0)
+        {
+            // Still counts the queue of the red, the delay is updated after the holds
+            uint32_t queued = delay->waiting[phase] > 0 ? delay->waiting[phase] : 1U;
+
+            hold->releasing_mask |= bit;
+            hold->release_ms[phase] = time_ms + (uint64_t)queued * SIM_DISCHARGE_HEADWAY_MS;
+        }
+    }
+}
+
+static void log_input(const sim_sinks_t *const sinks, const uint64_t time_ms, const event_kind_t kind, const phase_t phase)
+{
+    if (sinks->log != NULL)
+    {
+        event_log_input(sinks->log, 0, time_ms, kind, phase);
+    }
+}
+
+// Clears the held detectors whose queue discharged
+static void release_holds(sim_hold_t *const hold, controller_t *const controller, const sim_sinks_t *const sinks, const uint64_t time_ms)
+{
+    for (phase_t phase = PHASE_1; hold->releasing_mask != 0 && phase < NUM_PHASES; phase++)
+    {
+        uint8_t bit = PHASE_BIT(phase);
+
+        if ((hold->releasing_mask & bit) != 0 && hold->release_ms[phase] <= time_ms)
+        {
+            controller_detector_input(controller, phase, false);
+            log_input(sinks, time_ms, EVENT_DETECTOR_OFF, phase);
+            hold->held_mask &= (uint8_t)~bit;
+            hold->releasing_mask &= (uint8_t)~bit;
+        }
+    }
+}
+
+static void update_delay(sim_delay_t *const delay, sim_stats_t *const stats, const controller_t *const controller, const uint64_t time_ms)
+{
+    for (phase_t phase = PHASE_1; phase < NUM_PHASES; phase++)
+    {
+        sim_delay_signal(delay, stats, phase, controller_head_state(controller, phase), time_ms);
+    }
+}
+
+void sim_run(
+    controller_t *const controller,
+    scheduler_t *const sched,
+    const sim_script_t *const script,
+    const uint64_t duration_ms,
+    const sim_sinks_t *const sinks,
+    sim_stats_t *const stats)
+{
+    static const sim_sinks_t no_sinks = {0};
+    const sim_sinks_t *out = sinks != NULL ? sinks : &no_sinks;
+    size_t next_call = 0;
+    size_t num_calls = script != NULL ? script->count : 0;
+    sim_delay_t delay;
+    sim_hold_t hold = {0};
+
+    memset(stats, 0, sizeof(*stats));
+    sim_delay_init(&delay, controller->runtime.phase_mask);
+    update_delay(&delay, stats, controller, 0);
+
+    if (out->queues != NULL)
+    {
+        queue_model_signals(out->queues, 0, controller);
+    }
+
+    while (scheduler_now_ms(sched) < duration_ms)
+    {
+        scheduler_wait(sched);
+        uint64_t now_ms = scheduler_now_ms(sched);
+
+        release_holds(&hold, controller, out, now_ms);
+
+        while (next_call < num_calls && script->calls[next_call].time_ms <= now_ms)
+        {
+            const sim_call_t *call = &script->calls[next_call];
+            uint8_t bit = PHASE_BIT(call->phase);
+
+            if (call->kind == SIM_CALL)
+            {
+                controller_place_call(controller, call->phase);
+                log_input(out, now_ms, EVENT_CALL, call->phase);
+                sim_delay_arrival(&delay, stats, call->phase, now_ms);
+            }
+            else if (call->kind == SIM_DETECTOR_OFF &&
+                     ((hold.held_mask & bit) != 0 || (delay.phase_mask & (uint8_t)~delay.serving_mask & bit) != 0))
+            {
+                hold.held_mask |= bit; // Stopped on red, or queued behind a held vehicle
+            }
+            else
+            {
+                controller_detector_input(controller, call->phase, call->kind == SIM_DETECTOR_ON);
+                log_input(out, now_ms, call->kind == SIM_DETECTOR_ON ? EVENT_DETECTOR_ON : EVENT_DETECTOR_OFF, call->phase);
+
+                if (call->kind == SIM_DETECTOR_ON)
+                {
+                    sim_delay_arrival(&delay, stats, call->phase, now_ms);
+                }
+            }
+
+            stats->calls_placed++;
+            next_call++;
+        }
+
+        uint8_t interval = controller->state.interval;
+        uint8_t plan = controller->runtime.active_plan;
+
+        controller->run(controller);
+
+        if (out->output != NULL)
+        {
+            signal_output_update(out->output, 0, now_ms);
+            signal_output_flush(out->output);
+        }
+
+        if (out->log != NULL)
+        {
+            event_log_update(out->log, 0, now_ms);
+        }
+
+        if (out->atspm != NULL && out->log != NULL)
+        {
+            atspm_consume(out->atspm, out->log);
+        }
+
+        stats->plan_changes += controller->runtime.active_plan != plan;
+        stats->steps++;
+
+        const controller_state_t *state = &controller->state;
+
+        if (state->interval != interval)
+        {
+            update_holds(&hold, &delay, controller, now_ms);
+            update_delay(&delay, stats, controller, now_ms);
+
+            if (out->queues != NULL)
+            {
+                queue_model_signals(out->queues, 0, controller);
+            }
+
+            stats->transitions++;
+            stats->cycles += state->main_state == SIGNAL_GREEN;
+            stats->side_serves += state->side_state == SIGNAL_GREEN;
+
+            if (controller->intervals[interval].green_mask != 0)
+            {
+                stats->gap_outs += state->termination == TERMINATION_GAP_OUT;
+                stats->max_outs += state->termination == TERMINATION_MAX_OUT;
+                stats->force_offs += state->termination == TERMINATION_FORCE_OFF;
+            }
+        }
+
+        stats->main_green_ms += (state->main_state == SIGNAL_GREEN) ? controller->tick_ms : 0;
+        stats->side_green_ms += (state->side_state == SIGNAL_GREEN) ? controller->tick_ms : 0;
+        stats->flash_ms += (state->main_state == SIGNAL_FLASH_YELLOW) ? controller->tick_ms : 0;
+
+        if (out->queues != NULL)
+        {
+            queue_model_step(out->queues, controller->tick_ms);
+        }
+    }
+
+    sim_delay_finish(&delay, stats, scheduler_now_ms(sched));
+}
+
+bool sim_demand_schedule(const sim_demand_t *const demand, queue_model_t *const queues, const size_t index)
+{
+    for (size_t i = 0; i < demand->count; i++)
+    {
+        const sim_demand_entry_t *entry = &demand->entries[i];
+
+        if (!queue_model_add_rate(queues, index, entry->phase, entry->time_ms, entry->vehicles_per_hour))
+        {
+            return false;
+        }
+    }
+
+    return true;
+}
+
+void sim_delay_init(sim_delay_t *const delay, const uint8_t phase_mask)
+{
+    memset(delay, 0, sizeof(*delay));
+    delay->phase_mask = phase_mask;
+}
+
+void sim_delay_arrival(sim_delay_t *const delay, sim_stats_t *const stats, const phase_t phase, const uint64_t time_ms)
+{
+    uint8_t bit = PHASE_BIT(phase);
+
+    if ((delay->phase_mask & bit) == 0)
+    {
+        return;
+    }
+
+    stats->arrivals++;
+    stats->arrivals_green += (delay->green_mask & bit) != 0;
+
+    if ((delay->serving_mask & bit) != 0)
+    {
+        return;
+    }
+
+    delay->oldest_ms[phase] = delay->waiting[phase] == 0 ? time_ms : delay->oldest_ms[phase];
+    delay->waiting[phase]++;
+    delay->waiting_sum_ms[phase] += time_ms;
+}
+
+void sim_delay_signal(
+    sim_delay_t *const delay,
+    sim_stats_t *const stats,
+    const phase_t phase,
+    const signal_state_t state,
+    const uint64_t time_ms)
+{
+    uint8_t bit = PHASE_BIT(phase);
+    bool is_serving = state == SIGNAL_GREEN || state == SIGNAL_FLASH_YELLOW || state == SIGNAL_FLASH_RED;
+
+    delay->green_mask = state == SIGNAL_GREEN ? delay->green_mask | bit : delay->green_mask & (uint8_t)~bit;
+    delay->serving_mask = is_serving ? delay->serving_mask | bit : delay->serving_mask & (uint8_t)~bit;
+
+    if (!is_serving || delay->waiting[phase] == 0)
+    {
+        return;
+    }
+
+    uint64_t max_ms = time_ms - delay->oldest_ms[phase];
+
+    stats->delay_ms += delay->waiting[phase] * time_ms - delay->waiting_sum_ms[phase];
+    stats->max_delay_ms = max_ms > stats->max_delay_ms ? max_ms : stats->max_delay_ms;
+    delay->waiting[phase] = 0;
+    delay->waiting_sum_ms[phase] = 0;
+}
+
+void sim_delay_finish(sim_delay_t *const delay, sim_stats_t *const stats, const uint64_t time_ms)
+{
+    // Every waiting phase is released at once, as if it turned green now
+    for (phase_t phase = PHASE_1; phase < NUM_PHASES; phase++)
+    {
+        sim_delay_signal(delay, stats, phase, SIGNAL_GREEN, time_ms);
+    }
+}
+
+void sim_print_stats(const sim_stats_t *const stats, const uint64_t duration_ms)
+{
+    double duration_s = (double)duration_ms / MS_PER_SEC;
+
+    printf("Simulated %.0f s in %llu steps: %llu interval changes, %llu cycles, "
+           "%llu side road services, %llu calls\n",
+           duration_s,
+           (unsigned long long)stats->steps,
+           (unsigned long long)stats->transitions,
+           (unsigned long long)stats->cycles,
+           (unsigned long long)stats->side_serves,
+           (unsigned long long)stats->calls_placed);
+
+    printf("Green time: main road %.1f%%, side road %.1f%%, %llu gap-outs, %llu max-outs, "
+           "%llu force-offs\n",
+           duration_ms > 0 ? 100.0 * (double)stats->main_green_ms / (double)duration_ms : 0.0,
+           duration_ms > 0 ? 100.0 * (double)stats->side_green_ms / (double)duration_ms : 0.0,
+           (unsigned long long)stats->gap_outs,
+           (unsigned long long)stats->max_outs,
+           (unsigned long long)stats->force_offs);
+
+    printf("Timing plans: %llu changes, flashing %.1f%%\n",
+           (unsigned long long)stats->plan_changes,
+           duration_ms > 0 ? 100.0 * (double)stats->flash_ms / (double)duration_ms : 0.0);
+
+    printf("Arrivals: %llu, %.1f%% on green, average delay %.1f s, max %.1f s\n",
+           (unsigned long long)stats->arrivals,
+           stats->arrivals > 0 ? 100.0 * (double)stats->arrivals_green / (double)stats->arrivals : 0.0,
+           stats->arrivals > 0 ? (double)stats->delay_ms / MS_PER_SEC / (double)stats->arrivals : 0.0,
+           (double)stats->max_delay_ms / MS_PER_SEC);
+}
@@ -0,0 +1,352 @@
+#include "thread_pool.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#define DEQUE_EMPTY UINT32_MAX
+
+static uint32_t round_up_pow2(const size_t value)
+{
+    uint32_t result = 1U;
+
+    while (result < value)
+    {
+        result <<= 1U;
+    }
+
+    return result;
+}
+
+// Owner only, called before the start barrier while no thief is active
+static void deque_push(pool_deque_t *const deque, const uint32_t task)
+{
+    long bottom = atomic_load_explicit(&deque->bottom, memory_order_relaxed);
+
+    deque->tasks[(uint32_t)bottom & deque->mask] = task;
+    atomic_store_explicit(&deque->bottom, bottom + 1, memory_order_release);
+}
+
+static uint32_t deque_pop(pool_deque_t *const deque)
+{
+    long bottom = atomic_load_explicit(&deque->bottom, memory_order_relaxed) - 1;
+    atomic_store_explicit(&deque->bottom, bottom, memory_order_relaxed);
+    atomic_thread_fence(memory_order_seq_cst);
+    long top = atomic_load_explicit(&deque->top, memory_order_relaxed);
+
+    if (top > bottom)
+    {
+        atomic_store_explicit(&deque->bottom, bottom + 1, memory_order_relaxed);
+        return DEQUE_EMPTY;
+    }
+
+    uint32_t task = deque->tasks[(uint32_t)bottom & deque->mask];
+
+    if (top == bottom)
+    {
+        // Last task, race the thieves for it
+        if (!atomic_compare_exchange_strong_explicit(
+                &deque->top, &top, top + 1, memory_order_seq_cst, memory_order_relaxed))
+        {
+            task = DEQUE_EMPTY;
+        }
+
+        atomic_store_explicit(&deque->bottom, bottom + 1, memory_order_relaxed);
+    }
+
+    return task;
+}
+
+/*
+ * Returns the stolen task, DEQUE_EMPTY if the deque is empty, and sets
+ * is_contended if another thread won the race for a remaining task.
+ */
+static uint32_t deque_steal(pool_deque_t *const deque, bool *const is_contended)
+{
+    long top = atomic_load_explicit(&deque->top, memory_order_acquire);
+    atomic_thread_fence(memory_order_seq_cst);
+    long bottom = atomic_load_explicit(&deque->bottom, memory_order_acquire);
+
+    if (top >= bottom)
+    {
+        return DEQUE_EMPTY;
+    }
+
+    uint32_t task = deque->tasks[(uint32_t)top & deque->mask];
+
+    if (!atomic_compare_exchange_strong_explicit(
+            &deque->top, &top, top + 1, memory_order_seq_cst, memory_order_relaxed))
+    {
+        *is_contended = true;
+        return DEQUE_EMPTY;
+    }
+
+    return task;
+}
+
+static void worker_drain(thread_pool_t *const pool, pool_deque_t *const own)
+{
+    uint32_t task;
+
+    while ((task = deque_pop(own)) != DEQUE_EMPTY)
+    {
+        pool->fn(pool->ctx, task);
+        own->executed++;
+    }
+
+    // No new tasks appear during a batch, so stop once a full sweep finds nothing
+    bool is_contended;
+    do
+    {
+        is_contended = false;
+
+        for (size_t i = 1; i < pool->num_threads; i++)
+        {
+            pool_deque_t *victim = &pool->deques[(own->index + i) % pool->num_threads];
+
+            while ((task = deque_steal(victim, &is_contended)) != DEQUE_EMPTY)
+            {
+                pool->fn(pool->ctx, task);
+                own->executed++;
+                own->stolen++;
+            }
+        }
+    } while (is_contended);
+}
+
+static void *worker_main(void *arg)
+{
+    pool_deque_t *own = arg;
+    thread_pool_t *pool = own->pool;
+
+    // The barriers count every thread, so nothing runs until all of them started
+    pthread_mutex_lock(&pool->launch_lock);
+
+    while (!pool->is_launched && !pool->is_stopping)
+    {
+        pthread_cond_wait(&pool->launched, &pool->launch_lock);
+    }
+
+    bool is_launched = pool->is_launched;
+    pthread_mutex_unlock(&pool->launch_lock);
+
+    if (!is_launched)
+    {
+        return NULL;
+    }
+
+    while (true)
+    {
+        pthread_barrier_wait(&pool->start);
+
+        if (pool->is_stopping)
+        {
+            break;
+        }
+
+        worker_drain(pool, own);
+        pthread_barrier_wait(&pool->done);
+    }
+
+    return NULL;
+}
+
+bool thread_pool_init(thread_pool_t *const pool, const size_t num_threads, const size_t max_tasks)
+{
+    bool result = false;
+    size_t num_started = 0;
+
+    do
+    {
+        if (pool == NULL || num_threads == 0 || num_threads > POOL_MAX_THREADS || max_tasks == 0)
+        {
+            fprintf(stderr, "Assertion error in thread_pool_init\n");
+            break;
+        }
+
+        memset(pool, 0, sizeof(*pool));
+        pool->num_threads = num_threads;
+
+        uint32_t capacity = round_up_pow2(max_tasks);
+
+        pool->deques = aligned_alloc(POOL_CACHE_LINE, num_threads * sizeof(pool_deque_t));
+        pool->threads = calloc(num_threads, sizeof(pthread_t));
+
+        if (pool->deques == NULL || pool->threads == NULL)
+        {
+            fprintf(stderr, "Out of memory while creating thread pool\n");
+            break;
+        }
+
+        memset(pool->deques, 0, num_threads * sizeof(pool_deque_t));
+
+        size_t i;
+        for (i = 0; i < num_threads; i++)
+        {
+            pool_deque_t *deque = &pool->deques[i];
+
+            atomic_init(&deque->top, 0);
+            atomic_init(&deque->bottom, 0);
+            deque->mask = capacity - 1U;
+            deque->pool = pool;
+            deque->index = (uint32_t)i;
+            deque->tasks = calloc(capacity, sizeof(uint32_t));
+
+            if (deque->tasks == NULL)
+            {
+                fprintf(stderr, "Out of memory while creating thread pool\n");
+                break;
+            }
+        }
+
+        if (i != num_threads)
+        {
+            break;
+        }
+
+        pthread_barrier_init(&pool->start, NULL, (unsigned)num_threads);
+        pthread_barrier_init(&pool->done, NULL, (unsigned)num_threads);
+        pthread_mutex_init(&pool->launch_lock, NULL);
+        pthread_cond_init(&pool->launched, NULL);
+
+        // Worker 0 is the caller of thread_pool_run
+        for (num_started = 1; num_started < num_threads; num_started++)
+        {
+            if (pthread_create(&pool->threads[num_started], NULL, worker_main,
+                               &pool->deques[num_started]) != 0)
+            {
+                fprintf(stderr, "Failed to start worker thread %lu\n", num_started);
+                break;
+            }
+        }
+
+        // A partial start releases the workers to exit, the pool cannot run short-handed
+        pthread_mutex_lock(&pool->launch_lock);
+        pool->is_launched = num_started == num_threads;
+        pool->is_stopping = !pool->is_launched;
+        pthread_cond_broadcast(&pool->launched);
+        pthread_mutex_unlock(&pool->launch_lock);
+
+        if (!pool->is_launched)
+        {
+            break;
+        }
+
+        result = true;
+
+    } while (0);
+
+    if (!result && pool != NULL && pool->deques != NULL)
+    {
+        // Zero until the barriers exist, then the caller plus the workers started
+        if (num_started > 0)
+        {
+            for (size_t i = 1; i < num_started; i++)
+            {
+                pthread_join(pool->threads[i], NULL);
+            }
+
+            pthread_barrier_destroy(&pool->start);
+            pthread_barrier_destroy(&pool->done);
+            pthread_mutex_destroy(&pool->launch_lock);
+            pthread_cond_destroy(&pool->launched);
+        }
+
+        for (size_t i = 0; i < pool->num_threads; i++)
+        {
+            free(pool->deques[i].tasks);
+        }
+
+        free(pool->deques);
+        free(pool->threads);
+        memset(pool, 0, sizeof(*pool));
+    }
+
+    return result;
+}
+
+size_t thread_pool_resolve_threads(const size_t num_threads)
+{
+    size_t result = num_threads;
+
+    if (result == 0)
+    {
+        long num_cpus = sysconf(_SC_NPROCESSORS_ONLN);
+        result = num_cpus > 0 ? (size_t)num_cpus : 1U; // One when the CPU count is unknown
+    }
+
+    return result < POOL_MAX_THREADS ? result : POOL_MAX_THREADS;
+}
+
+void thread_pool_run(
+    thread_pool_t *const pool,
+    const uint32_t *const tasks,
+    const size_t count,
+    pool_task_fn fn,
+    void *const ctx)
+{
+    pool->fn = fn;
+    pool->ctx = ctx;
+
+    // Contiguous chunks keep neighbouring tasks on the same core
+    size_t chunk = (count + pool->num_threads - 1U) / pool->num_threads;
+
+    for (size_t i = 0; i < pool->num_threads; i++)
+    {
+        pool_deque_t *deque = &pool->deques[i];
+        size_t first = i * chunk;
+        size_t last = first + chunk < count ? first + chunk : count;
+
+        atomic_store_explicit(&deque->top, 0, memory_order_relaxed);
+        atomic_store_explicit(&deque->bottom, 0, memory_order_relaxed);
+
+        // Push in reverse so the owner pops its chunk in order
+        for (size_t j = last; j > first; j--)
+        {
+            deque_push(deque, tasks[j - 1U]);
+        }
+    }
+
+    if (pool->num_threads == 1)
+    {
+        worker_drain(pool, &pool->deques[0]);
+        return;
+    }
+
+    pthread_barrier_wait(&pool->start);
+    worker_drain(pool, &pool->deques[0]);
+    pthread_barrier_wait(&pool->done);
+}
+
+void thread_pool_free(thread_pool_t *const pool)
+{
+    if (pool->deques == NULL)
+    {
+        return;
+    }
+
+    if (pool->num_threads > 1)
+    {
+        pool->is_stopping = true;
+        pthread_barrier_wait(&pool->start);
+
+        for (size_t i = 1; i < pool->num_threads; i++)
+        {
+            pthread_join(pool->threads[i], NULL);
+        }
+    }
+
+    pthread_barrier_destroy(&pool->start);
+    pthread_barrier_destroy(&pool->done);
+    pthread_mutex_destroy(&pool->launch_lock);
+    pthread_cond_destroy(&pool->launched);
+
+    for (size_t i = 0; i < pool->num_threads; i++)
+    {
+        free(pool->deques[i].tasks);
+    }
+
+    free(pool->deques);
+    free(pool->threads);
+    memset(pool, 0, sizeof(*pool));
+}
@@ -0,0 +1,147 @@
+#include "timer_wheel.h"
+#include <string.h>
+
+#define LEVEL_SHIFT(level) ((level) * WHEEL_SLOT_BITS)
+#define LEVEL_SPAN(level) (1ULL << LEVEL_SHIFT((level) + 1U)) // Ticks covered up to level
+#define MAX_DELTA (LEVEL_SPAN(WHEEL_LEVELS - 1U) - 1U)
+
+static void slot_insert(wheel_timer_t **const slot, wheel_timer_t *const timer)
+{
+    timer->next = *slot;
+    timer->pprev = slot;
+
+    if (*slot != NULL)
+    {
+        (*slot)->pprev = &timer->next;
+    }
+
+    *slot = timer;
+}
+
+static void place_timer(timer_wheel_t *const wheel, wheel_timer_t *const timer)
+{
+    uint64_t delta = timer->expires - wheel->now;
+
+    if (delta > MAX_DELTA)
+    {
+        // Re-cascaded from the top level until it comes into range
+        delta = MAX_DELTA;
+    }
+
+    uint32_t level = 0;
+    while (level < WHEEL_LEVELS - 1U && delta >= LEVEL_SPAN(level))
+    {
+        level++;
+    }
+
+    uint64_t tick = wheel->now + delta;
+    uint32_t slot = (uint32_t)((tick >> LEVEL_SHIFT(level)) & WHEEL_SLOT_MASK);
+
+    slot_insert(&wheel->slots[level][slot], timer);
+}
+
+static void cascade(timer_wheel_t *const wheel, const uint32_t level)
+{
+    uint32_t slot = (uint32_t)((wheel->now >> LEVEL_SHIFT(level)) & WHEEL_SLOT_MASK);
+    wheel_timer_t *timer = wheel->slots[level][slot];
+
+    wheel->slots[level][slot] = NULL;
+
+    while (timer != NULL)
+    {
+        wheel_timer_t *next = timer->next;
+        place_timer(wheel, timer);
+        timer = next;
+    }
+}
+
+void timer_wheel_init(timer_wheel_t *const wheel, const uint64_t now)
+{
+    memset(wheel, 0, sizeof(*wheel));
+    wheel->now = now;
+}
+
+void timer_wheel_add(timer_wheel_t *const wheel, wheel_timer_t *const timer, const uint64_t expires)
+{
+    if (timer->is_armed)
+    {
+        timer_wheel_remove(wheel, timer);
+    }
+
+    // The current slot has already been processed, fire on the next tick at the earliest
+    timer->expires = expires > wheel->now ? expires : wheel->now + 1U;
+    timer->is_armed = true;
+
+    place_timer(wheel, timer);
+}
+
+void timer_wheel_remove(timer_wheel_t *const wheel, wheel_timer_t *const timer)
+{
+    (void)wheel; // Links are self-contained, kept for API symmetry
+
+    if (!timer->is_armed)
+    {
+        return;
+    }
+
+    *timer->pprev = timer->next;
+
+    if (timer->next != NULL)
+    {
+        timer->next->pprev = timer->pprev;
+    }
+
+    timer->next = NULL;
+    timer->pprev = NULL;
+    timer->is_armed = false;
+}
+
+wheel_timer_t *timer_wheel_advance(timer_wheel_t *const wheel)
+{
+    wheel->now++;
+
+    // Pull the next span of each higher level down when the level below wraps
+    for (uint32_t level = 1; level < WHEEL_LEVELS; level++)
+    {
+        if ((wheel->now & ((1ULL << LEVEL_SHIFT(level)) - 1U)) != 0)
+        {
+            break;
+        }
+
+        cascade(wheel, level);
+    }
+
+    uint32_t slot = (uint32_t)(wheel->now & WHEEL_SLOT_MASK);
+    wheel_timer_t *expired = wheel->slots[0][slot];
+    wheel_timer_t *pending = NULL;
+
+    wheel->slots[0][slot] = NULL;
+
+    // Timers clamped to the top level may land here before they are due
+    wheel_timer_t **link = &expired;
+    while (*link != NULL)
+    {
+        wheel_timer_t *timer = *link;
+
+        if (timer->expires > wheel->now)
+        {
+            *link = timer->next;
+            timer->next = pending;
+            pending = timer;
+            continue;
+        }
+
+        timer->pprev = NULL;
+        timer->is_armed = false;
+        link = &timer->next;
+    }
+
+    while (pending != NULL)
+    {
+        wheel_timer_t *next = pending->next;
+        place_timer(wheel, pending);
+        pending = next;
+    }
+
+    return expired;
+}
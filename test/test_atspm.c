@@ -0,0 +1,203 @@
+/*
+ * ATSPM aggregation: feeds hand-built event records of a side road phase
+ * and checks the arrivals, split failures and times of its 15 minute bins,
+ * and that records overwritten in the log ring are counted as lost.
+ */
+
+#include "unity.h"
+#include "atspm.h"
+#include "config.h"
+#include "controller.h"
+#include "controller_type1.h"
+#include "event_log.h"
+#include <string.h>
+
+#define CONFIG_PATH "example_config_type1.json"
+#define TICK_MS 100U
+#define NUM_BINS 4U
+#define LOG_RECORDS 16U // Ring of the in-memory log
+
+static config_t config;
+static controller_t controller;
+static atspm_t atspm;
+static event_log_t log;
+static atspm_bin_t bins[NUM_BINS];
+
+static void ingest(const uint64_t time_ms, const event_kind_t kind, const signal_state_t state, const termination_t cause)
+{
+    event_record_t record = {
+        .time_ms = time_ms,
+        .kind = (uint8_t)kind,
+        .phase = PHASE_4,
+        .state = (uint8_t)state,
+        .cause = (uint8_t)cause};
+
+    atspm_ingest(&atspm, &record);
+}
+
+static void signal_at(const uint64_t time_ms, const signal_state_t state)
+{
+    ingest(time_ms, EVENT_SIGNAL, state, TERMINATION_NONE);
+}
+
+static void green_ends_at(const uint64_t time_ms, const termination_t cause)
+{
+    ingest(time_ms, EVENT_SIGNAL, SIGNAL_YELLOW, cause);
+}
+
+static void detector_at(const uint64_t time_ms, const bool is_on)
+{
+    ingest(time_ms, is_on ? EVENT_DETECTOR_ON : EVENT_DETECTOR_OFF, SIGNAL_OFF, TERMINATION_NONE);
+}
+
+static void call_at(const uint64_t time_ms)
+{
+    ingest(time_ms, EVENT_CALL, SIGNAL_OFF, TERMINATION_NONE);
+}
+
+// Bins of the phase 4 lane group up to time_ms, oldest first
+static size_t snapshot(const uint64_t time_ms)
+{
+    uint64_t first_bin_ms;
+    int32_t lane = atspm.lane_of[PHASE_4];
+
+    TEST_ASSERT_TRUE(lane >= 0);
+
+    return atspm_snapshot(&atspm, time_ms, (size_t)lane, bins, NUM_BINS, &first_bin_ms);
+}
+
+void setUp(void)
+{
+    memset(&config, 0, sizeof(config)); // config_load expects a zeroed config
+    memset(&controller, 0, sizeof(controller));
+    memset(&log, 0, sizeof(log));
+
+    TEST_ASSERT_TRUE(config_load(&config, CONFIG_PATH));
+
+    controller.config = &config;
+    controller.tick_ms = TICK_MS;
+
+    TEST_ASSERT_TRUE(controller_init(&controller));
+    TEST_ASSERT_TRUE(atspm_init(&atspm, &controller, 1, NUM_BINS, 0));
+}
+
+void tearDown(void)
+{
+    atspm_free(&atspm);
+
+    if (log.header != NULL)
+    {
+        event_log_close(&log);
+    }
+}
+
+void test_occupied_green_and_red_make_a_split_failure(void)
+{
+    signal_at(0, SIGNAL_RED);
+    detector_at(10000, true);
+
+    // Occupied through green and the whole red window
+    signal_at(20000, SIGNAL_GREEN);
+    green_ends_at(40000, TERMINATION_MAX_OUT);
+    signal_at(43500, SIGNAL_RED);
+    detector_at(50000, false);
+
+    // Occupied through green, cleared 1.5 s into red
+    signal_at(60000, SIGNAL_GREEN);
+    detector_at(61000, true);
+    green_ends_at(80000, TERMINATION_MAX_OUT);
+    signal_at(83500, SIGNAL_RED);
+    detector_at(85000, false);
+
+    // Occupied through green and a short red, green again closes the window early
+    detector_at(110000, true);
+    signal_at(110000, SIGNAL_GREEN);
+    green_ends_at(130000, TERMINATION_MAX_OUT);
+    signal_at(133500, SIGNAL_RED);
+    signal_at(136000, SIGNAL_GREEN);
+    detector_at(140000, false);
+
+    // Unoccupied green, no red window
+    green_ends_at(150000, TERMINATION_GAP_OUT);
+    signal_at(153500, SIGNAL_RED);
+
+    TEST_ASSERT_EQUAL_size_t(1, snapshot(200000));
+    TEST_ASSERT_EQUAL_UINT32(2, bins[0].split_failures);
+    TEST_ASSERT_EQUAL_UINT32(4, bins[0].cycles);
+    TEST_ASSERT_EQUAL_UINT32(3, bins[0].terminations[TERMINATION_MAX_OUT]);
+    TEST_ASSERT_EQUAL_UINT32(1, bins[0].terminations[TERMINATION_GAP_OUT]);
+    TEST_ASSERT_EQUAL_UINT32(20000 + 20000 + 20000 + 14000, bins[0].green_ms);
+    TEST_ASSERT_EQUAL_UINT32(40000 + 24000 + 30000, bins[0].occupied_ms);
+}
+
+void test_arrivals_count_in_the_bin_and_state_they_arrive_in(void)
+{
+    signal_at(0, SIGNAL_RED);
+    call_at(100000);
+
+    // Green spans the bin boundary at 900000
+    signal_at(890000, SIGNAL_GREEN);
+    detector_at(895000, true);
+    detector_at(899000, false);
+    green_ends_at(905000, TERMINATION_GAP_OUT);
+    detector_at(906000, true);
+    detector_at(907000, false);
+    signal_at(909000, SIGNAL_RED);
+    call_at(950000);
+
+    TEST_ASSERT_EQUAL_size_t(2, snapshot(1000000));
+
+    TEST_ASSERT_EQUAL_UINT32(2, bins[0].volume);
+    TEST_ASSERT_EQUAL_UINT32(1, bins[0].arrivals_green);
+    TEST_ASSERT_EQUAL_UINT32(0, bins[0].arrivals_yellow);
+    TEST_ASSERT_EQUAL_UINT32(1, bins[0].arrivals_red);
+    TEST_ASSERT_EQUAL_UINT32(1, bins[0].cycles);
+    TEST_ASSERT_EQUAL_UINT32(10000, bins[0].green_ms);
+    TEST_ASSERT_EQUAL_UINT32(4000, bins[0].occupied_ms);
+
+    TEST_ASSERT_EQUAL_UINT32(2, bins[1].volume);
+    TEST_ASSERT_EQUAL_UINT32(0, bins[1].arrivals_green);
+    TEST_ASSERT_EQUAL_UINT32(1, bins[1].arrivals_yellow);
+    TEST_ASSERT_EQUAL_UINT32(1, bins[1].arrivals_red);
+    TEST_ASSERT_EQUAL_UINT32(0, bins[1].cycles);
+    TEST_ASSERT_EQUAL_UINT32(1, bins[1].terminations[TERMINATION_GAP_OUT]);
+    TEST_ASSERT_EQUAL_UINT32(5000, bins[1].green_ms);
+    TEST_ASSERT_EQUAL_UINT32(1000, bins[1].occupied_ms);
+}
+
+void test_out_of_order_record_does_not_wrap_the_accrued_time(void)
+{
+    signal_at(0, SIGNAL_RED);
+    signal_at(10000, SIGNAL_GREEN);
+    call_at(100000);
+    call_at(50000); // Behind the accrued time, still an arrival
+
+    // Green time accrued up to 100000 is kept, not wound back
+    TEST_ASSERT_EQUAL_size_t(1, snapshot(60000));
+    TEST_ASSERT_EQUAL_UINT32(2, bins[0].volume);
+    TEST_ASSERT_EQUAL_UINT32(90000, bins[0].green_ms);
+
+    TEST_ASSERT_EQUAL_size_t(1, snapshot(200000));
+    TEST_ASSERT_EQUAL_UINT32(190000, bins[0].green_ms);
+}
+
+void test_records_overwritten_in_the_log_are_lost(void)
+{
+    TEST_ASSERT_TRUE(event_log_open(&log, NULL, LOG_RECORDS, &controller, 1, TICK_MS, true));
+
+    atspm_consume(&atspm, &log); // The signals logged at time 0
+
+    TEST_ASSERT_EQUAL_UINT64(0, atspm.lost);
+
+    for (uint64_t i = 0; i < LOG_RECORDS + 24U; i++)
+    {
+        event_log_input(&log, 0, 1000U + i, EVENT_CALL, PHASE_4);
+    }
+
+    atspm_consume(&atspm, &log);
+
+    TEST_ASSERT_EQUAL_UINT64(24, atspm.lost);
+    TEST_ASSERT_EQUAL_UINT64(log.head, atspm.cursor);
+    TEST_ASSERT_EQUAL_size_t(1, snapshot(2000));
+    TEST_ASSERT_EQUAL_UINT32(LOG_RECORDS, bins[0].volume);
+}
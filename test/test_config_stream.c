@@ -0,0 +1,272 @@
+/*
+ * The single pass parser against the json-c one. Every example config, and
+ * mutants of them with each key and each scalar value replaced in turn,
+ * must load into the same config_t through both parsers and report the
+ * same errors.
+ */
+
+#include "unity.h"
+#include "config.h"
+#include "config_stream.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#define MAX_ERRORS 16U
+#define MUTANT_PATH_TEMPLATE "/tmp/test_config_stream_XXXXXX"
+#define WHAT_LEN 256U
+
+typedef struct
+{
+    bool is_loaded;
+    config_t config;
+    uint32_t num_errors; // Reported, only the first MAX_ERRORS are kept
+    config_error_t errors[MAX_ERRORS];
+} load_result_t;
+
+// Key or scalar value in a JSON document
+typedef struct
+{
+    size_t start;
+    size_t len;
+    bool is_key;
+} token_span_t;
+
+static const char *const example_paths[] = {
+    "example_config_type1.json",
+    "example_config_type2.json",
+    "example_config_type3.json",
+    "example_config_type4.json"};
+
+// Wrong types, out of range numbers, unknown and overlong strings
+static const char *const value_mutations[] = {
+    "0",
+    "-1",
+    "2.5",
+    "1e9",
+    "\"\"",
+    "\"bogus\"",
+    "\"0123456789012345678901234567890123456789012345678901234567890123456789\"",
+    "true",
+    "null",
+    "[]",
+    "{}"};
+
+// Drops the member, every parser must then report it missing or fall back to its default
+static const char *const key_mutation = "\"unknown_member\"";
+
+static char mutant_path[] = MUTANT_PATH_TEMPLATE;
+static load_result_t json_result;
+static load_result_t stream_result;
+
+static void load(load_result_t *const result, bool (*load_fn)(config_t *, const char *), const char *const path)
+{
+    memset(result, 0, sizeof(*result));
+
+    config_error_sink_t sink = {.errors = result->errors, .capacity = MAX_ERRORS};
+
+    config_set_error_sink(&sink);
+    result->is_loaded = load_fn(&result->config, path);
+    config_set_error_sink(NULL);
+
+    result->num_errors = sink.count;
+}
+
+static long main_road_index(const config_t *const config)
+{
+    return config->main_road != NULL ? (long)(config->main_road - config->roads) : -1;
+}
+
+static void assert_same_load(const char *const path, const char *const what)
+{
+    load(&json_result, config_load, path);
+    load(&stream_result, config_stream_load, path);
+
+    TEST_ASSERT_EQUAL_MESSAGE(json_result.is_loaded, stream_result.is_loaded, what);
+    TEST_ASSERT_EQUAL_UINT32_MESSAGE(json_result.num_errors, stream_result.num_errors, what);
+
+    for (uint32_t i = 0; i < json_result.num_errors && i < MAX_ERRORS; i++)
+    {
+        char json_text[CONFIG_ERROR_STR_LEN * 2U];
+        char stream_text[CONFIG_ERROR_STR_LEN * 2U];
+
+        TEST_ASSERT_EQUAL_MESSAGE(json_result.errors[i].code, stream_result.errors[i].code, what);
+
+        config_error_path(&json_result.errors[i], json_text, sizeof(json_text));
+        config_error_path(&stream_result.errors[i], stream_text, sizeof(stream_text));
+        TEST_ASSERT_EQUAL_STRING_MESSAGE(json_text, stream_text, what);
+
+        config_error_message(&json_result.errors[i], json_text, sizeof(json_text));
+        config_error_message(&stream_result.errors[i], stream_text, sizeof(stream_text));
+        TEST_ASSERT_EQUAL_STRING_MESSAGE(json_text, stream_text, what);
+    }
+
+    if (!json_result.is_loaded)
+    {
+        return; // A failed load leaves the config partly filled, in parser order
+    }
+
+    // Compared like a config_cache image, which stores no pointers
+    TEST_ASSERT_EQUAL_MESSAGE(main_road_index(&json_result.config), main_road_index(&stream_result.config), what);
+    json_result.config.main_road = NULL;
+    stream_result.config.main_road = NULL;
+    TEST_ASSERT_EQUAL_MEMORY_MESSAGE(&json_result.config, &stream_result.config, sizeof(config_t), what);
+}
+
+static char *read_document(const char *const path, size_t *const len)
+{
+    FILE *file = fopen(path, "rb");
+    char *text = NULL;
+
+    TEST_ASSERT_NOT_NULL(file);
+    fseek(file, 0, SEEK_END);
+    *len = (size_t)ftell(file);
+    rewind(file);
+
+    text = malloc(*len);
+    TEST_ASSERT_NOT_NULL(text);
+    TEST_ASSERT_EQUAL(*len, fread(text, 1, *len, file));
+    fclose(file);
+
+    return text;
+}
+
+// Finds the keys, strings, numbers and literals of a document, returns their count
+static size_t find_tokens(const char *const text, const size_t len, token_span_t *const spans, const size_t max_spans)
+{
+    size_t count = 0;
+    size_t i = 0;
+
+    while (i < len && count < max_spans)
+    {
+        size_t start = i;
+
+        if (text[i] == '"')
+        {
+            for (i++; i < len && text[i] != '"'; i++)
+            {
+                i += text[i] == '\\' ? 1U : 0U;
+            }
+
+            i++;
+
+            size_t next = i;
+            while (next < len && strchr(" \t\r\n", text[next]) != NULL)
+            {
+                next++;
+            }
+
+            spans[count++] = (token_span_t){.start = start, .len = i - start, .is_key = next < len && text[next] == ':'};
+        }
+        else if (strchr("-0123456789", text[i]) != NULL)
+        {
+            while (i < len && strchr("+-.0123456789eE", text[i]) != NULL)
+            {
+                i++;
+            }
+
+            spans[count++] = (token_span_t){.start = start, .len = i - start};
+        }
+        else if (strchr("tfn", text[i]) != NULL)
+        {
+            while (i < len && text[i] >= 'a' && text[i] <= 'z')
+            {
+                i++;
+            }
+
+            spans[count++] = (token_span_t){.start = start, .len = i - start};
+        }
+        else
+        {
+            i++;
+        }
+    }
+
+    return count;
+}
+
+static void write_mutant(const char *const text, const size_t len, const token_span_t *const span, const char *const replacement)
+{
+    FILE *file = fopen(mutant_path, "wb");
+
+    TEST_ASSERT_NOT_NULL(file);
+    fwrite(text, 1, span->start, file);
+    fputs(replacement, file);
+    fwrite(text + span->start + span->len, 1, len - span->start - span->len, file);
+    fclose(file);
+}
+
+void setUp(void)
+{
+    strcpy(mutant_path, MUTANT_PATH_TEMPLATE);
+
+    int fd = mkstemp(mutant_path);
+
+    TEST_ASSERT_TRUE(fd >= 0);
+    close(fd);
+}
+
+void tearDown(void)
+{
+    unlink(mutant_path);
+}
+
+void test_examples_load_the_same(void)
+{
+    for (size_t i = 0; i < sizeof(example_paths) / sizeof(example_paths[0]); i++)
+    {
+        assert_same_load(example_paths[i], example_paths[i]);
+    }
+
+    // The complete example must load, or the comparison above proved little
+    load(&json_result, config_load, example_paths[0]);
+    TEST_ASSERT_TRUE(json_result.is_loaded);
+}
+
+void test_missing_and_malformed_files_fail_the_same(void)
+{
+    assert_same_load("test/no_such_config.json", "missing file");
+
+    FILE *file = fopen(mutant_path, "wb");
+    TEST_ASSERT_NOT_NULL(file);
+    fputs("{\"intersection_id\": \"INT001\", \"type\": 1, \"roads\": [", file);
+    fclose(file);
+
+    assert_same_load(mutant_path, "truncated document");
+}
+
+void test_mutants_load_the_same(void)
+{
+    static token_span_t spans[4096];
+    size_t num_mutants = 0;
+
+    for (size_t i = 0; i < sizeof(example_paths) / sizeof(example_paths[0]); i++)
+    {
+        size_t len;
+        char *text = read_document(example_paths[i], &len);
+        size_t num_spans = find_tokens(text, len, spans, sizeof(spans) / sizeof(spans[0]));
+
+        for (size_t j = 0; j < num_spans; j++)
+        {
+            const char *const *replacements = spans[j].is_key ? &key_mutation : value_mutations;
+            size_t num_replacements = spans[j].is_key ? 1U : sizeof(value_mutations) / sizeof(value_mutations[0]);
+
+            for (size_t k = 0; k < num_replacements; k++)
+            {
+                char what[WHAT_LEN];
+
+                snprintf(what, sizeof(what), "%s: %.*s replaced by %s",
+                         example_paths[i], (int)spans[j].len, text + spans[j].start, replacements[k]);
+
+                write_mutant(text, len, &spans[j], replacements[k]);
+                assert_same_load(mutant_path, what);
+                num_mutants++;
+            }
+        }
+
+        free(text);
+    }
+
+    TEST_ASSERT_GREATER_THAN_UINT32(1000, num_mutants);
+}
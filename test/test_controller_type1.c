@@ -0,0 +1,352 @@
+/*
+ * Type 1 controller timing: drives controller_type1_advance tick by tick
+ * with scripted detector input on the example config, and checks the
+ * interval sequence, its timing and how each green ends.
+ */
+
+#include "unity.h"
+#include "config.h"
+#include "controller.h"
+#include "controller_type1.h"
+#include <string.h>
+
+#define CONFIG_PATH "example_config_type1.json"
+#define TICK_MS 100U
+#define LIMIT_MS (600U * 1000U) // Longest a single wait may take
+#define MONDAY_0629_50_MS (((6U * 60U + 29U) * 60U + 50U) * 1000U) // Ten seconds before am_peak
+#define MONDAY_2259_MS ((22U * 60U + 59U) * 60U * 1000U)             // A minute before night_flash
+
+// Interval indices of the Type 1 sequence
+enum
+{
+    MAIN_GREEN,
+    MAIN_YELLOW,
+    MAIN_RED_CLEARANCE,
+    SIDE_GREEN,
+    SIDE_YELLOW,
+    SIDE_RED_CLEARANCE,
+    FLASH
+};
+
+static config_t config;
+static controller_t controller;
+static uint8_t pulse_mask; // Phases actuated on every step, a steady stream of vehicles
+
+static void start_controller(const uint32_t start_week_ms)
+{
+    memset(&controller, 0, sizeof(controller));
+    controller.config = &config;
+    controller.tick_ms = TICK_MS;
+    controller.start_week_ms = start_week_ms;
+
+    TEST_ASSERT_TRUE(controller_init(&controller));
+}
+
+static void actuate(void)
+{
+    for (size_t phase = 0; phase < NUM_PHASES; phase++)
+    {
+        if (pulse_mask & PHASE_BIT(phase))
+        {
+            controller_detector_input(&controller, (phase_t)phase, true);
+        }
+    }
+}
+
+static void step(void)
+{
+    actuate();
+    controller_type1_advance(&controller, TICK_MS);
+}
+
+static void run_for(const uint32_t duration_ms)
+{
+    for (uint32_t elapsed_ms = 0; elapsed_ms < duration_ms; elapsed_ms += TICK_MS)
+    {
+        step();
+    }
+}
+
+// Steps as the host does, by whole ticks up to the next expiry, and returns the time it took to enter interval
+static uint32_t advance_until(const uint8_t interval)
+{
+    uint32_t elapsed_ms = 0;
+
+    do
+    {
+        uint32_t expiry_ms = controller_time_to_expiry(&controller);
+        uint32_t ticks = expiry_ms == CONTROLLER_NO_EXPIRY ? 1U : (expiry_ms + TICK_MS - 1U) / TICK_MS;
+        uint32_t step_ms = (ticks > 0 ? ticks : 1U) * TICK_MS;
+
+        actuate();
+        controller_type1_advance(&controller, step_ms);
+        elapsed_ms += step_ms;
+    } while (controller.state.interval != interval && elapsed_ms < LIMIT_MS);
+
+    TEST_ASSERT_EQUAL_UINT8_MESSAGE(interval, controller.state.interval, "Interval not reached");
+
+    return elapsed_ms;
+}
+
+// Steps until the controller enters interval and returns the time it took
+static uint32_t run_until(const uint8_t interval)
+{
+    uint32_t elapsed_ms = 0;
+
+    do
+    {
+        step();
+        elapsed_ms += TICK_MS;
+    } while (controller.state.interval != interval && elapsed_ms < LIMIT_MS);
+
+    TEST_ASSERT_EQUAL_UINT8_MESSAGE(interval, controller.state.interval, "Interval not reached");
+
+    return elapsed_ms;
+}
+
+static uint8_t find_plan(const char *const plan_id)
+{
+    for (size_t i = 0; i < config.num_plans; i++)
+    {
+        if (strcmp(config.plans[i].id, plan_id) == 0)
+        {
+            return (uint8_t)i;
+        }
+    }
+
+    TEST_FAIL_MESSAGE("Plan not in the example config");
+    return CONFIG_BASE_PLAN;
+}
+
+// Runs the timing and coordination of plan as the base plan
+static void use_plan_as_base(const char *const plan_id)
+{
+    const timing_plan_t *plan = &config.plans[find_plan(plan_id)];
+
+    memcpy(config.plans[CONFIG_BASE_PLAN].timing, plan->timing, sizeof(plan->timing));
+    config.plans[CONFIG_BASE_PLAN].coord = plan->coord;
+}
+
+// Loads the example config with its schedule, config_load expects a zeroed config
+static void load_config(void)
+{
+    memset(&config, 0, sizeof(config));
+    TEST_ASSERT_TRUE(config_load(&config, CONFIG_PATH));
+}
+
+void setUp(void)
+{
+    load_config();
+
+    config.num_transitions = 0; // The base plan runs all week
+    pulse_mask = 0;
+}
+
+void tearDown(void)
+{
+}
+
+void test_startup_clears_then_rests_in_main_green(void)
+{
+    start_controller(0);
+
+    TEST_ASSERT_EQUAL_UINT8(SIDE_RED_CLEARANCE, controller.state.interval);
+    TEST_ASSERT_EQUAL(SIGNAL_RED, controller.state.main_state);
+    TEST_ASSERT_EQUAL(SIGNAL_RED, controller.state.side_state);
+
+    TEST_ASSERT_EQUAL_UINT32(1800, run_until(MAIN_GREEN));
+
+    run_for(LIMIT_MS);
+
+    TEST_ASSERT_EQUAL_UINT8(MAIN_GREEN, controller.state.interval);
+    TEST_ASSERT_EQUAL(SIGNAL_GREEN, controller.state.main_state);
+    TEST_ASSERT_EQUAL(TERMINATION_NONE, controller.state.termination);
+}
+
+void test_side_call_gaps_out_main_green_at_min_green(void)
+{
+    start_controller(0);
+    run_until(MAIN_GREEN);
+
+    controller_detector_input(&controller, PHASE_4, true);
+
+    TEST_ASSERT_EQUAL_UINT32(15000, run_until(MAIN_YELLOW));
+    TEST_ASSERT_EQUAL(TERMINATION_GAP_OUT, controller.state.termination);
+    TEST_ASSERT_EQUAL_UINT32(4000, run_until(MAIN_RED_CLEARANCE));
+    TEST_ASSERT_EQUAL_UINT32(2000, run_until(SIDE_GREEN));
+    TEST_ASSERT_EQUAL(SIGNAL_RED, controller.state.main_state);
+    TEST_ASSERT_EQUAL(SIGNAL_GREEN, controller.state.side_state);
+}
+
+void test_steady_main_traffic_maxes_out_under_side_call(void)
+{
+    start_controller(0);
+    run_until(MAIN_GREEN);
+
+    pulse_mask = PHASE_BIT(PHASE_2);
+    run_for(60000); // Without a conflicting call the max timer does not run
+
+    TEST_ASSERT_EQUAL_UINT8(MAIN_GREEN, controller.state.interval);
+
+    controller_detector_input(&controller, PHASE_4, true);
+
+    TEST_ASSERT_EQUAL_UINT32(45000, run_until(MAIN_YELLOW));
+    TEST_ASSERT_EQUAL(TERMINATION_MAX_OUT, controller.state.termination);
+}
+
+void test_side_call_after_a_long_rest_gets_the_full_max_green(void)
+{
+    start_controller(0);
+    run_until(MAIN_GREEN);
+
+    controller_type1_advance(&controller, LIMIT_MS); // The host catches a resting controller up at once
+
+    TEST_ASSERT_EQUAL_UINT8(MAIN_GREEN, controller.state.interval);
+
+    controller_detector_input(&controller, PHASE_4, true);
+    pulse_mask = PHASE_BIT(PHASE_2); // Each actuation extends the green until the next expiry
+
+    // The rest before the call is not charged against the max timer
+    TEST_ASSERT_UINT32_WITHIN(TICK_MS, 45000, advance_until(MAIN_YELLOW));
+    TEST_ASSERT_EQUAL(TERMINATION_MAX_OUT, controller.state.termination);
+}
+
+void test_side_green_gaps_out_a_passage_time_after_the_detector_clears(void)
+{
+    start_controller(0);
+    run_until(MAIN_GREEN);
+    controller_detector_input(&controller, PHASE_4, true);
+    run_until(SIDE_GREEN);
+
+    run_for(20000); // Occupied past the minimum green
+
+    TEST_ASSERT_EQUAL_UINT8(SIDE_GREEN, controller.state.interval);
+
+    controller_detector_input(&controller, PHASE_4, false);
+
+    TEST_ASSERT_UINT32_WITHIN(TICK_MS, 2500, run_until(SIDE_YELLOW));
+    TEST_ASSERT_EQUAL(TERMINATION_GAP_OUT, controller.state.termination);
+    TEST_ASSERT_EQUAL_UINT32(3500, run_until(SIDE_RED_CLEARANCE));
+    TEST_ASSERT_EQUAL_UINT32(1800, run_until(MAIN_GREEN));
+}
+
+void test_occupied_side_green_maxes_out_under_main_call(void)
+{
+    start_controller(0);
+    run_until(MAIN_GREEN);
+    controller_detector_input(&controller, PHASE_4, true);
+    run_until(SIDE_GREEN);
+
+    // Lock memory latches the main road call while it is red
+    controller_detector_input(&controller, PHASE_2, true);
+
+    TEST_ASSERT_EQUAL_UINT32(30000, run_until(SIDE_YELLOW));
+    TEST_ASSERT_EQUAL(TERMINATION_MAX_OUT, controller.state.termination);
+}
+
+void test_coordinated_main_green_yields_at_split_and_side_green_is_forced_off(void)
+{
+    use_plan_as_base("am_peak"); // 100 s cycle, 12 s offset, 70 s main road split
+    start_controller(0);
+    run_until(MAIN_GREEN);
+
+    controller_detector_input(&controller, PHASE_4, true);
+
+    // The yield point is the split less the main road clearance
+    run_until(MAIN_YELLOW);
+    TEST_ASSERT_EQUAL_UINT32(64000, controller_cycle_position(&controller));
+    TEST_ASSERT_EQUAL(TERMINATION_TIMED, controller.state.termination);
+
+    run_until(SIDE_GREEN);
+    TEST_ASSERT_EQUAL_UINT32(70000, controller_cycle_position(&controller));
+
+    // Occupied all along, forced off so its clearance ends with the cycle
+    run_until(SIDE_YELLOW);
+    TEST_ASSERT_EQUAL_UINT32(94700, controller_cycle_position(&controller));
+    TEST_ASSERT_EQUAL(TERMINATION_FORCE_OFF, controller.state.termination);
+
+    run_until(MAIN_GREEN);
+    TEST_ASSERT_EQUAL_UINT32(0, controller_cycle_position(&controller));
+}
+
+void test_reloaded_config_is_taken_while_main_green_rests(void)
+{
+    static config_t reloaded;
+    size_t main_index = (size_t)(config.main_road - config.roads);
+
+    reloaded = config;
+    reloaded.main_road = &reloaded.roads[main_index];
+    reloaded.plans[CONFIG_BASE_PLAN].timing[main_index].max_green = 60;
+
+    start_controller(0);
+    run_until(MAIN_GREEN);
+    run_for(60000); // Resting, nothing calls the side road
+
+    atomic_store(&controller.pending_config, &reloaded);
+    step();
+
+    TEST_ASSERT_NULL(atomic_load(&controller.pending_config));
+    TEST_ASSERT_EQUAL_PTR(&reloaded, controller.config);
+    TEST_ASSERT_EQUAL_UINT32(60000, controller.runtime.max_green_ms[PHASE_2]);
+
+    // The rest goes on under the new config
+    run_for(60000);
+
+    TEST_ASSERT_EQUAL_UINT8(MAIN_GREEN, controller.state.interval);
+    TEST_ASSERT_EQUAL(TERMINATION_NONE, controller.state.termination);
+}
+
+void test_scheduled_plan_starts_while_main_green_rests(void)
+{
+    load_config();
+
+    start_controller(MONDAY_0629_50_MS);
+    run_until(MAIN_GREEN);
+
+    TEST_ASSERT_EQUAL_UINT8(CONFIG_BASE_PLAN, controller.runtime.active_plan);
+
+    run_for(20000); // Past 06:30, nothing calls the side road
+
+    TEST_ASSERT_EQUAL_UINT8(find_plan("am_peak"), controller.runtime.active_plan);
+    TEST_ASSERT_EQUAL_UINT32(100000, controller.runtime.cycle_ms);
+    TEST_ASSERT_EQUAL_UINT8(MAIN_GREEN, controller.state.interval);
+}
+
+void test_flash_plan_maxes_out_an_extending_main_green(void)
+{
+    load_config();
+
+    start_controller(MONDAY_2259_MS);
+    run_until(MAIN_GREEN); // 22:59:01.8
+
+    pulse_mask = PHASE_BIT(PHASE_2);
+    run_for(60000); // Flash is due from 23:00, traffic keeps extending the green
+
+    TEST_ASSERT_EQUAL_UINT8(MAIN_GREEN, controller.state.interval);
+
+    // The max timer runs from 23:00 as if the side road had called
+    TEST_ASSERT_UINT32_WITHIN(TICK_MS, 45000 - 1800, run_until(MAIN_YELLOW));
+    TEST_ASSERT_EQUAL(TERMINATION_MAX_OUT, controller.state.termination);
+
+    run_until(FLASH);
+    TEST_ASSERT_EQUAL(SIGNAL_FLASH_YELLOW, controller.state.main_state);
+    TEST_ASSERT_EQUAL(SIGNAL_FLASH_RED, controller.state.side_state);
+}
+
+void test_monitor_fault_latches_red_flash(void)
+{
+    start_controller(0);
+    run_until(MAIN_GREEN);
+
+    atomic_store(&controller.is_faulted, true);
+    step();
+
+    TEST_ASSERT_EQUAL_UINT8(CONTROLLER_FAULT_INTERVAL, controller.state.interval);
+    TEST_ASSERT_EQUAL(SIGNAL_FLASH_RED, controller.state.main_state);
+    TEST_ASSERT_EQUAL(SIGNAL_FLASH_RED, controller.state.side_state);
+
+    controller_detector_input(&controller, PHASE_4, true);
+    run_for(LIMIT_MS);
+
+    TEST_ASSERT_EQUAL_UINT8(CONTROLLER_FAULT_INTERVAL, controller.state.interval);
+}
@@ -0,0 +1,219 @@
+/*
+ * Detector input: pushes events through the SPSC ring from a producer
+ * thread and checks none are lost or reordered across wraparound, then
+ * feeds detector lines from a file and checks which ones are rejected.
+ */
+
+#include "unity.h"
+#include "config.h"
+#include "controller.h"
+#include "detector_input.h"
+#include "event_log.h"
+#include <sched.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#define NUM_EVENTS (DETECTOR_RING_SIZE * 64U + 7U) // Wraps the ring many times, ends off a boundary
+#define WAIT_LIMIT_MS 5000U
+
+static detector_ring_t ring;
+static config_t configs[2];
+static controller_t controllers[2];
+static detector_input_t input;
+static char path[] = "/tmp/test_detector_XXXXXX";
+
+static void *produce(void *arg)
+{
+    (void)arg;
+
+    for (uint64_t i = 0; i < NUM_EVENTS; i++)
+    {
+        detector_event_t event = {.timestamp_ns = i, .phase = (uint8_t)(i % NUM_PHASES), .is_on = (i & 1U) != 0};
+
+        while (!detector_ring_push(&ring, &event))
+        {
+            sched_yield(); // Full, wait for the consumer
+        }
+    }
+
+    return NULL;
+}
+
+// Starts a source reading lines from a file, routed by intersection ID when is_routed
+static void start_source(const char *const lines, const bool is_routed)
+{
+    int fd = mkstemp(path);
+
+    TEST_ASSERT_TRUE(fd >= 0);
+    TEST_ASSERT_EQUAL_size_t(strlen(lines), (size_t)write(fd, lines, strlen(lines)));
+    close(fd);
+
+    char *paths[] = {path};
+
+    TEST_ASSERT_TRUE(detector_input_start(&input, paths, 1, is_routed ? controllers : NULL, 2));
+}
+
+// Pops count events from the source, waiting for its thread to read them
+static void pop_events(detector_event_t *const events, const size_t count)
+{
+    size_t popped = 0;
+
+    for (uint32_t waited_ms = 0; popped < count && waited_ms < WAIT_LIMIT_MS; waited_ms++)
+    {
+        popped += detector_ring_pop(&input.sources[0].ring, &events[popped], count - popped);
+
+        if (popped < count)
+        {
+            usleep(1000);
+        }
+    }
+
+    TEST_ASSERT_EQUAL_size_t(count, popped);
+
+    // The last line is valid, so every line has been read and only the valid ones made events
+    TEST_ASSERT_EQUAL_size_t(0, detector_ring_pop(&input.sources[0].ring, events, 1));
+}
+
+void setUp(void)
+{
+    memset(&ring, 0, sizeof(ring));
+    memset(&input, 0, sizeof(input));
+    memset(configs, 0, sizeof(configs));
+    memset(controllers, 0, sizeof(controllers));
+    strcpy(path, "/tmp/test_detector_XXXXXX");
+
+    // Routes are sorted by ID, listed out of order here
+    strcpy(configs[0].id, "INT002");
+    strcpy(configs[1].id, "INT001");
+    controllers[0].config = &configs[0];
+    controllers[1].config = &configs[1];
+}
+
+void tearDown(void)
+{
+    if (input.sources != NULL)
+    {
+        detector_input_stop(&input);
+    }
+
+    unlink(path);
+}
+
+void test_ring_is_full_at_its_size_and_empty_after_draining(void)
+{
+    detector_event_t event = {.phase = PHASE_4, .is_on = true};
+    detector_event_t events[DETECTOR_BATCH_SIZE];
+
+    // Start near the end of the index range so the indices wrap too
+    atomic_store(&ring.head, SIZE_MAX - 10U);
+    atomic_store(&ring.tail, SIZE_MAX - 10U);
+
+    for (size_t i = 0; i < DETECTOR_RING_SIZE; i++)
+    {
+        event.timestamp_ns = i;
+        TEST_ASSERT_TRUE(detector_ring_push(&ring, &event));
+    }
+
+    TEST_ASSERT_FALSE(detector_ring_push(&ring, &event));
+
+    size_t total = 0;
+    size_t count;
+
+    while ((count = detector_ring_pop(&ring, events, DETECTOR_BATCH_SIZE)) > 0)
+    {
+        for (size_t i = 0; i < count; i++)
+        {
+            TEST_ASSERT_EQUAL_UINT64(total + i, events[i].timestamp_ns);
+        }
+
+        total += count;
+    }
+
+    TEST_ASSERT_EQUAL_size_t(DETECTOR_RING_SIZE, total);
+    TEST_ASSERT_EQUAL_size_t(0, detector_ring_pop(&ring, events, DETECTOR_BATCH_SIZE));
+    TEST_ASSERT_TRUE(detector_ring_push(&ring, &event));
+}
+
+void test_ring_passes_every_event_in_order_from_a_producer_thread(void)
+{
+    detector_event_t events[DETECTOR_BATCH_SIZE];
+    pthread_t producer;
+    uint64_t expected = 0;
+
+    TEST_ASSERT_EQUAL_INT(0, pthread_create(&producer, NULL, produce, NULL));
+
+    while (expected < NUM_EVENTS)
+    {
+        size_t count = detector_ring_pop(&ring, events, DETECTOR_BATCH_SIZE);
+
+        for (size_t i = 0; i < count; i++, expected++)
+        {
+            TEST_ASSERT_EQUAL_UINT64(expected, events[i].timestamp_ns);
+            TEST_ASSERT_EQUAL_UINT8(expected % NUM_PHASES, events[i].phase);
+            TEST_ASSERT_EQUAL(expected & 1U, events[i].is_on);
+        }
+
+        if (count == 0)
+        {
+            sched_yield();
+        }
+    }
+
+    pthread_join(producer, NULL);
+
+    TEST_ASSERT_EQUAL_size_t(0, detector_ring_pop(&ring, events, DETECTOR_BATCH_SIZE));
+}
+
+void test_single_intersection_lines_parse_phase_and_state(void)
+{
+    detector_event_t events[4];
+
+    start_source("4 on\n"
+                 "# comment\n"
+                 "\n"
+                 "0 on\n"
+                 "9 off\n"
+                 "4\n"
+                 "4 maybe\n"
+                 "x on\n"
+                 "2 OFF\n"
+                 "8 1\n"
+                 "6 0\n",
+                 false);
+    pop_events(events, 4);
+    detector_input_stop(&input);
+
+    TEST_ASSERT_EQUAL_UINT8(PHASE_4, events[0].phase);
+    TEST_ASSERT_TRUE(events[0].is_on);
+    TEST_ASSERT_EQUAL_UINT8(PHASE_2, events[1].phase);
+    TEST_ASSERT_FALSE(events[1].is_on);
+    TEST_ASSERT_EQUAL_UINT8(PHASE_8, events[2].phase);
+    TEST_ASSERT_TRUE(events[2].is_on);
+    TEST_ASSERT_EQUAL_UINT8(PHASE_6, events[3].phase);
+    TEST_ASSERT_FALSE(events[3].is_on);
+}
+
+void test_routed_lines_carry_the_controller_of_their_id(void)
+{
+    detector_event_t events[2];
+
+    start_source("INT001 4 on\n"
+                 "INT003 4 on\n"
+                 "4 on\n"
+                 "INT002 0 on\n"
+                 "INT002 9 on\n"
+                 "INT002 4\n"
+                 "INT002 8 off\n",
+                 true);
+    pop_events(events, 2);
+    detector_input_stop(&input);
+
+    TEST_ASSERT_EQUAL_UINT32(1, events[0].intersection);
+    TEST_ASSERT_EQUAL_UINT8(PHASE_4, events[0].phase);
+    TEST_ASSERT_TRUE(events[0].is_on);
+    TEST_ASSERT_EQUAL_UINT32(0, events[1].intersection);
+    TEST_ASSERT_EQUAL_UINT8(PHASE_8, events[1].phase);
+    TEST_ASSERT_FALSE(events[1].is_on);
+}
@@ -0,0 +1,153 @@
+/*
+ * Simulation of detector traffic: runs sim_run on the example config with
+ * a scripted vehicle and checks that presence detection without lock
+ * memory gets it served, and that the call and demand loaders reject
+ * times the millisecond clock cannot hold.
+ */
+
+#include "unity.h"
+#include "atspm.h"
+#include "config.h"
+#include "controller.h"
+#include "controller_type1.h"
+#include "event_log.h"
+#include "queue_model.h"
+#include "scheduler.h"
+#include "signal_output.h"
+#include "simulation.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#define CONFIG_PATH "example_config_type1.json"
+#define TICK_MS 100U
+#define ARRIVAL_MS 30000U // Main road green rests by then
+
+static config_t config;
+static char path[] = "/tmp/test_simulation_XXXXXX";
+static controller_t controller;
+static sim_stats_t stats;
+
+static void start_controller(void)
+{
+    memset(&controller, 0, sizeof(controller));
+    controller.config = &config;
+    controller.tick_ms = TICK_MS;
+
+    TEST_ASSERT_TRUE(controller_init(&controller));
+}
+
+// A single vehicle crossing the side road detector, as sim_script_generate draws it
+static void run_single_arrival(const phase_t phase, const uint64_t duration_ms)
+{
+    sim_call_t calls[] = {
+        {.time_ms = ARRIVAL_MS, .phase = phase, .kind = SIM_DETECTOR_ON},
+        {.time_ms = ARRIVAL_MS + SIM_VEHICLE_OCCUPANCY_MS, .phase = phase, .kind = SIM_DETECTOR_OFF}};
+    sim_script_t script = {.calls = calls, .count = sizeof(calls) / sizeof(calls[0])};
+
+    scheduler_t scheduler;
+
+    TEST_ASSERT_TRUE(scheduler_init_virtual(&scheduler, TICK_MS));
+    sim_run(&controller, &scheduler, &script, duration_ms, NULL, &stats);
+}
+
+// Writes a single line to a new file at path
+static void write_line(const char *const line)
+{
+    strcpy(path, "/tmp/test_simulation_XXXXXX");
+
+    int fd = mkstemp(path);
+
+    TEST_ASSERT_TRUE(fd >= 0);
+    TEST_ASSERT_EQUAL_size_t(strlen(line), (size_t)write(fd, line, strlen(line)));
+    close(fd);
+}
+
+static bool loads_script(const char *const line)
+{
+    sim_script_t script;
+
+    write_line(line);
+    bool result = sim_script_load(&script, path);
+    sim_script_free(&script);
+    unlink(path);
+
+    return result;
+}
+
+static bool loads_demand(const char *const line)
+{
+    sim_demand_t demand;
+
+    write_line(line);
+    bool result = sim_demand_load(&demand, path);
+    sim_demand_free(&demand);
+    unlink(path);
+
+    return result;
+}
+
+// Runs the timing and coordination of plan as the base plan
+static void use_plan_as_base(const char *const plan_id)
+{
+    for (size_t i = 0; i < config.num_plans; i++)
+    {
+        if (strcmp(config.plans[i].id, plan_id) == 0)
+        {
+            memcpy(config.plans[CONFIG_BASE_PLAN].timing, config.plans[i].timing, sizeof(config.plans[i].timing));
+            config.plans[CONFIG_BASE_PLAN].coord = config.plans[i].coord;
+            return;
+        }
+    }
+
+    TEST_FAIL_MESSAGE("Plan not in the example config");
+}
+
+void setUp(void)
+{
+    memset(&config, 0, sizeof(config)); // config_load expects a zeroed config
+    TEST_ASSERT_TRUE(config_load(&config, CONFIG_PATH));
+
+    config.num_transitions = 0; // The base plan runs all week
+}
+
+void tearDown(void)
+{
+}
+
+void test_side_arrival_on_red_is_served_at_min_green(void)
+{
+    start_controller();
+    run_single_arrival(PHASE_4, ARRIVAL_MS + 60000U);
+
+    // Main road min green has run out, the call gaps it out at once
+    TEST_ASSERT_EQUAL_UINT64(1, stats.arrivals);
+    TEST_ASSERT_EQUAL_UINT64(1, stats.side_serves);
+    TEST_ASSERT_UINT64_WITHIN(TICK_MS, 4000 + 2000, stats.max_delay_ms);
+}
+
+void test_side_arrival_on_red_is_served_within_a_coordinated_cycle(void)
+{
+    use_plan_as_base("am_peak"); // 100 s cycle
+    start_controller();
+    run_single_arrival(PHASE_4, ARRIVAL_MS + 2U * controller.runtime.cycle_ms);
+
+    TEST_ASSERT_EQUAL_UINT64(1, stats.arrivals);
+    TEST_ASSERT_EQUAL_UINT64(1, stats.side_serves);
+    TEST_ASSERT_TRUE(stats.max_delay_ms < controller.runtime.cycle_ms);
+}
+
+void test_loaders_reject_times_outside_the_millisecond_clock(void)
+{
+    // The largest time that still fits the uint32_t milliseconds of a call
+    TEST_ASSERT_TRUE(loads_script("4294967 4\n"));
+    TEST_ASSERT_TRUE(loads_demand("4294967 4 600\n"));
+
+    TEST_ASSERT_FALSE(loads_script("-1 4\n"));
+    TEST_ASSERT_FALSE(loads_script("1e10 4 on\n"));
+    TEST_ASSERT_FALSE(loads_script("nan 4\n"));
+    TEST_ASSERT_FALSE(loads_script("inf 4 off\n"));
+    TEST_ASSERT_FALSE(loads_demand("1e10 4 600\n"));
+    TEST_ASSERT_FALSE(loads_demand("nan 4 600\n"));
+}
@@ -0,0 +1,150 @@
+/*
+ * Work-stealing thread pool: runs batches of counted tasks and checks that
+ * each one runs exactly once, that idle threads steal from an overloaded
+ * one, and that a pool whose workers only partly start fails cleanly.
+ */
+
+#define _GNU_SOURCE
+#include "unity.h"
+#include "thread_pool.h"
+#include <dlfcn.h>
+#include <errno.h>
+#include <stdatomic.h>
+#include <string.h>
+#include <unistd.h>
+
+#define MAX_TASKS 1000U
+#define NUM_BATCHES 200U
+#define SLOW_TASK_US 1000U
+
+typedef int (*create_fn)(pthread_t *, const pthread_attr_t *, void *(*)(void *), void *);
+
+static atomic_uint runs[MAX_TASKS];
+static uint32_t tasks[MAX_TASKS];
+static size_t num_slow; // Tasks below this id take SLOW_TASK_US
+static size_t create_budget = SIZE_MAX; // Worker starts that succeed before pthread_create fails
+static thread_pool_t pool;
+
+// Interposes the pool's pthread_create so a test can make a worker fail to start
+int pthread_create(pthread_t *thread, const pthread_attr_t *attr, void *(*start)(void *), void *arg)
+{
+    static create_fn real_create;
+
+    if (create_budget == 0)
+    {
+        return EAGAIN;
+    }
+
+    if (create_budget != SIZE_MAX)
+    {
+        create_budget--;
+    }
+
+    if (real_create == NULL)
+    {
+        *(void **)&real_create = dlsym(RTLD_NEXT, "pthread_create");
+    }
+
+    return real_create(thread, attr, start, arg);
+}
+
+static void count_task(void *const ctx, const uint32_t task)
+{
+    (void)ctx;
+
+    if (task < num_slow)
+    {
+        usleep(SLOW_TASK_US);
+    }
+
+    atomic_fetch_add_explicit(&runs[task], 1U, memory_order_relaxed);
+}
+
+// Runs tasks 0 to count - 1 as one batch and checks every one ran once
+static void run_batch(const size_t count)
+{
+    for (size_t i = 0; i < count; i++)
+    {
+        atomic_store(&runs[i], 0U);
+    }
+
+    thread_pool_run(&pool, tasks, count, count_task, NULL);
+
+    for (size_t i = 0; i < count; i++)
+    {
+        TEST_ASSERT_EQUAL_UINT32_MESSAGE(1, atomic_load(&runs[i]), "Task not run exactly once");
+    }
+}
+
+static uint64_t total_stolen(void)
+{
+    uint64_t stolen = 0;
+
+    for (size_t i = 0; i < pool.num_threads; i++)
+    {
+        stolen += pool.deques[i].stolen;
+    }
+
+    return stolen;
+}
+
+void setUp(void)
+{
+    for (uint32_t i = 0; i < MAX_TASKS; i++)
+    {
+        tasks[i] = i;
+    }
+
+    num_slow = 0;
+    create_budget = SIZE_MAX;
+    memset(&pool, 0, sizeof(pool));
+}
+
+void tearDown(void)
+{
+    thread_pool_free(&pool);
+}
+
+void test_every_task_runs_once_across_batches_and_thread_counts(void)
+{
+    static const size_t thread_counts[] = {1, 2, 3, 8};
+
+    for (size_t i = 0; i < sizeof(thread_counts) / sizeof(thread_counts[0]); i++)
+    {
+        TEST_ASSERT_TRUE(thread_pool_init(&pool, thread_counts[i], MAX_TASKS));
+
+        // Batches smaller and larger than the thread count, the deques reset between them
+        for (size_t batch = 0; batch < NUM_BATCHES; batch++)
+        {
+            run_batch(1U + (batch * 37U) % MAX_TASKS);
+        }
+
+        thread_pool_free(&pool);
+    }
+}
+
+void test_idle_threads_steal_from_an_overloaded_one(void)
+{
+    TEST_ASSERT_TRUE(thread_pool_init(&pool, 4, MAX_TASKS));
+
+    num_slow = 16; // The whole chunk of worker 0, the others finish theirs at once
+    run_batch(64);
+
+    TEST_ASSERT_TRUE(total_stolen() > 0);
+    TEST_ASSERT_TRUE(pool.deques[0].executed < num_slow);
+}
+
+void test_pool_fails_cleanly_when_a_worker_does_not_start(void)
+{
+    create_budget = 1; // Worker 1 starts, worker 2 does not
+
+    TEST_ASSERT_FALSE(thread_pool_init(&pool, 4, MAX_TASKS));
+    TEST_ASSERT_NULL(pool.deques);
+    TEST_ASSERT_EQUAL_size_t(0, pool.num_threads);
+
+    // The started worker has exited, a new pool starts and runs in full
+    create_budget = SIZE_MAX;
+
+    TEST_ASSERT_TRUE(thread_pool_init(&pool, 4, MAX_TASKS));
+    run_batch(MAX_TASKS);
+}
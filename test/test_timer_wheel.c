@@ -0,0 +1,175 @@
+/*
+ * Hierarchical timer wheel: advances the wheel tick by tick and checks
+ * that timers fire exactly on their tick across level boundaries, through
+ * cascades and when re-armed, including timers beyond the wheel's range.
+ */
+
+#include "unity.h"
+#include "timer_wheel.h"
+#include <string.h>
+
+#define NUM_TIMERS 8U
+#define WHEEL_RANGE (1ULL << (WHEEL_LEVELS * WHEEL_SLOT_BITS)) // Ticks the top level covers
+
+static timer_wheel_t wheel;
+static wheel_timer_t timers[NUM_TIMERS];
+static uint64_t fired_at[NUM_TIMERS]; // Tick each timer fired on, 0 until it fires
+static uint32_t fire_count[NUM_TIMERS];
+
+static void advance(void)
+{
+    for (wheel_timer_t *timer = timer_wheel_advance(&wheel); timer != NULL; timer = timer->next)
+    {
+        TEST_ASSERT_FALSE(timer->is_armed);
+
+        fired_at[timer->owner] = wheel.now;
+        fire_count[timer->owner]++;
+    }
+}
+
+static void advance_to(const uint64_t tick)
+{
+    while (wheel.now < tick)
+    {
+        advance();
+    }
+}
+
+// Arms a timer delta ticks ahead and checks it fires on that tick, not before
+static void check_fires_after(const uint64_t delta)
+{
+    uint64_t expires = wheel.now + delta;
+
+    timer_wheel_add(&wheel, &timers[0], expires);
+    advance_to(expires - 1U);
+
+    TEST_ASSERT_EQUAL_UINT32_MESSAGE(0, fire_count[0], "Fired early");
+
+    advance();
+
+    TEST_ASSERT_EQUAL_UINT32_MESSAGE(1, fire_count[0], "Not fired on its tick");
+    TEST_ASSERT_EQUAL_UINT64(expires, fired_at[0]);
+
+    fire_count[0] = 0;
+}
+
+void setUp(void)
+{
+    timer_wheel_init(&wheel, 0);
+    memset(timers, 0, sizeof(timers));
+    memset(fired_at, 0, sizeof(fired_at));
+    memset(fire_count, 0, sizeof(fire_count));
+
+    for (uint32_t i = 0; i < NUM_TIMERS; i++)
+    {
+        timers[i].owner = i;
+    }
+}
+
+void tearDown(void)
+{
+}
+
+void test_timers_fire_on_level_boundaries(void)
+{
+    static const uint64_t deltas[] = {1, 63, 64, 65, 4095, 4096, 4097};
+
+    for (size_t i = 0; i < sizeof(deltas) / sizeof(deltas[0]); i++)
+    {
+        check_fires_after(deltas[i]);
+    }
+
+    // Again from a start that is not aligned to any level
+    timer_wheel_init(&wheel, 4096U * 3U + 4000U);
+
+    for (size_t i = 0; i < sizeof(deltas) / sizeof(deltas[0]); i++)
+    {
+        check_fires_after(deltas[i]);
+    }
+}
+
+void test_cascaded_timers_fire_in_order(void)
+{
+    // Spread over three levels, each cascades down before it fires
+    static const uint64_t expires[NUM_TIMERS] = {5, 70, 130, 4000, 4100, 9000, 70000, 262143};
+
+    timer_wheel_init(&wheel, 10);
+
+    for (uint32_t i = 0; i < NUM_TIMERS; i++)
+    {
+        timer_wheel_add(&wheel, &timers[i], wheel.now + expires[i]);
+    }
+
+    advance_to(10U + expires[NUM_TIMERS - 1U]);
+
+    for (uint32_t i = 0; i < NUM_TIMERS; i++)
+    {
+        TEST_ASSERT_EQUAL_UINT32(1, fire_count[i]);
+        TEST_ASSERT_EQUAL_UINT64(10U + expires[i], fired_at[i]);
+    }
+}
+
+void test_re_adding_an_armed_timer_moves_it(void)
+{
+    timer_wheel_add(&wheel, &timers[0], 100);
+    timer_wheel_add(&wheel, &timers[1], 100);
+    timer_wheel_add(&wheel, &timers[0], 5000); // From level 1 to level 2
+    timer_wheel_add(&wheel, &timers[0], 40);   // And back to level 0
+
+    advance_to(6000);
+
+    TEST_ASSERT_EQUAL_UINT32(1, fire_count[0]);
+    TEST_ASSERT_EQUAL_UINT64(40, fired_at[0]);
+
+    // The other timer in its old slot is still linked
+    TEST_ASSERT_EQUAL_UINT32(1, fire_count[1]);
+    TEST_ASSERT_EQUAL_UINT64(100, fired_at[1]);
+}
+
+void test_removed_timer_does_not_fire(void)
+{
+    timer_wheel_add(&wheel, &timers[0], 64);
+    timer_wheel_add(&wheel, &timers[1], 64);
+    timer_wheel_remove(&wheel, &timers[0]);
+    timer_wheel_remove(&wheel, &timers[0]); // Removing a disarmed timer is a no-op
+
+    advance_to(200);
+
+    TEST_ASSERT_EQUAL_UINT32(0, fire_count[0]);
+    TEST_ASSERT_EQUAL_UINT32(1, fire_count[1]);
+}
+
+void test_timer_in_the_past_fires_on_the_next_tick(void)
+{
+    timer_wheel_init(&wheel, 500);
+    timer_wheel_add(&wheel, &timers[0], 100);
+
+    advance();
+
+    TEST_ASSERT_EQUAL_UINT32(1, fire_count[0]);
+    TEST_ASSERT_EQUAL_UINT64(501, fired_at[0]);
+}
+
+void test_timers_beyond_the_wheel_range_fire_on_time(void)
+{
+    uint64_t start = 1000;
+    uint64_t far = start + WHEEL_RANGE + 12345U;
+    uint64_t farther = start + 2U * WHEEL_RANGE + 7U;
+
+    timer_wheel_init(&wheel, start);
+    timer_wheel_add(&wheel, &timers[0], far);
+    timer_wheel_add(&wheel, &timers[1], farther);
+
+    // Clamped to the top level, they are placed again until they come into range
+    advance_to(far - 1U);
+
+    TEST_ASSERT_EQUAL_UINT32(0, fire_count[0]);
+    TEST_ASSERT_TRUE(timers[0].is_armed);
+
+    advance_to(farther);
+
+    TEST_ASSERT_EQUAL_UINT32(1, fire_count[0]);
+    TEST_ASSERT_EQUAL_UINT64(far, fired_at[0]);
+    TEST_ASSERT_EQUAL_UINT32(1, fire_count[1]);
+    TEST_ASSERT_EQUAL_UINT64(farther, fired_at[1]);
+}
@@ -0,0 +1,525 @@
+/*
+ * Micro-benchmarks of the startup and tick paths: config_load of every
+ * given config, config_validate, controller_init, the controller step
+ * over a simulated day and the queue model step of many intersections.
+ * Each benchmark runs a fixed number of rounds on fixed inputs after a
+ * warm-up, so runs on the same machine compare. The step benchmarks split
+ * the simulated time into the rounds, after a warm-up of a twentieth of it.
+ * Heap allocations are counted by interposing malloc and friends on the
+ * glibc implementation.
+ */
+
+#include "config.h"
+#include "controller.h"
+#include "latency.h"
+#include "queue_model.h"
+#include <errno.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <getopt.h>
+
+#define DEFAULT_ROUNDS 200U
+#define WARMUP_ROUNDS 10U
+#define STEP_WARMUP_DIVISOR 20U // Share of the simulated time stepped before the timed rounds
+#define STEP_TICK_MS 100U
+#define DEFAULT_STEP_DURATION_S 86400U
+#define CALL_MEAN_INTERVAL_MS 30000U // Side road calls, uniform up to twice the mean apart
+#define CALL_SEED 12345U
+#define BENCH_NAME_LEN 128U
+#define QUEUE_INTERSECTIONS 1024U // Copies of the stepped controller behind one queue model
+#define QUEUE_VEHICLES_PER_HOUR 300.0
+
+typedef struct
+{
+    char name[BENCH_NAME_LEN];
+    uint64_t ops;
+    uint64_t total_ns;
+    uint64_t allocs;
+    latency_histogram_t rounds; // Time per op of every round
+} bench_result_t;
+
+// Simulated time of the step benchmarks, in steps
+typedef struct
+{
+    uint64_t warmup_steps; // Untimed, before the first round
+    uint64_t timed_steps;  // Spread evenly over the rounds
+    uint32_t rounds;
+} step_plan_t;
+
+// Side road calls placed during the step benchmarks
+typedef struct
+{
+    uint32_t seed;
+    uint64_t call_ms;
+    uint64_t now_ms;
+    phase_t call_phase;
+} call_script_t;
+
+/* Allocation counting, the benchmarks are single threaded */
+
+extern void *__libc_malloc(size_t size);
+extern void *__libc_calloc(size_t count, size_t size);
+extern void *__libc_realloc(void *ptr, size_t size);
+extern void *__libc_memalign(size_t alignment, size_t size);
+extern void __libc_free(void *ptr);
+
+static uint64_t num_allocs;
+
+void *malloc(size_t size)
+{
+    num_allocs++;
+    return __libc_malloc(size);
+}
+
+void *calloc(size_t count, size_t size)
+{
+    num_allocs++;
+    return __libc_calloc(count, size);
+}
+
+void *realloc(void *ptr, size_t size)
+{
+    num_allocs++;
+    return __libc_realloc(ptr, size);
+}
+
+void *aligned_alloc(size_t alignment, size_t size)
+{
+    num_allocs++;
+    return __libc_memalign(alignment, size);
+}
+
+int posix_memalign(void **ptr, size_t alignment, size_t size)
+{
+    num_allocs++;
+    *ptr = __libc_memalign(alignment, size);
+    return *ptr != NULL ? 0 : ENOMEM;
+}
+
+void free(void *ptr)
+{
+    __libc_free(ptr);
+}
+
+/* Benchmarks */
+
+static void print_usage(const char *const prog)
+{
+    fprintf(stderr,
+            "Usage: %s [options] <config_file_path>...\n"
+            "  -n, --rounds N   Timed rounds per benchmark (default %u)\n"
+            "  -d, --duration S Simulated time of the step benchmark, seconds\n"
+            "                   (default %u)\n"
+            "  -o, --output FILE\n"
+            "                   Also write the results to FILE, one JSON object\n"
+            "                   per benchmark\n"
+            "Percentiles are of the time per op of each round, the step benchmarks\n"
+            "split the simulated time into the rounds after a warm-up of 1/%u of\n"
+            "it, an op of the queue model step is one intersection for one tick.\n",
+            prog,
+            DEFAULT_ROUNDS,
+            DEFAULT_STEP_DURATION_S,
+            STEP_WARMUP_DIVISOR);
+}
+
+static void result_init(bench_result_t *const result, const char *const name, const char *const path)
+{
+    memset(result, 0, sizeof(*result));
+    snprintf(result->name, sizeof(result->name), "%s %s", name, path);
+}
+
+static void result_add(bench_result_t *const result, const uint64_t ops, const uint64_t elapsed_ns, const uint64_t allocs)
+{
+    result->ops += ops;
+    result->total_ns += elapsed_ns;
+    result->allocs += allocs;
+    latency_histogram_record(&result->rounds, elapsed_ns / ops);
+}
+
+static void print_header(void)
+{
+    printf("%-52s %9s %11s %9s %10s %10s %10s %10s\n",
+           "benchmark", "ops", "ns/op", "allocs/op", "p50 ns", "p90 ns", "p99 ns", "max ns");
+}
+
+static void print_result(FILE *const report, const bench_result_t *const result)
+{
+    double ns_per_op = result->ops > 0 ? (double)result->total_ns / (double)result->ops : 0.0;
+    double allocs_per_op = result->ops > 0 ? (double)result->allocs / (double)result->ops : 0.0;
+    uint64_t p50 = latency_histogram_percentile(&result->rounds, 0.50);
+    uint64_t p90 = latency_histogram_percentile(&result->rounds, 0.90);
+    uint64_t p99 = latency_histogram_percentile(&result->rounds, 0.99);
+
+    printf("%-52s %9llu %11.1f %9.2f %10llu %10llu %10llu %10llu\n",
+           result->name,
+           (unsigned long long)result->ops,
+           ns_per_op,
+           allocs_per_op,
+           (unsigned long long)p50,
+           (unsigned long long)p90,
+           (unsigned long long)p99,
+           (unsigned long long)result->rounds.max_ns);
+
+    if (report != NULL)
+    {
+        fprintf(report,
+                "{\"benchmark\":\"%s\",\"ops\":%llu,\"ns_per_op\":%.1f,\"allocs_per_op\":%.2f,"
+                "\"p50_ns\":%llu,\"p90_ns\":%llu,\"p99_ns\":%llu,\"max_ns\":%llu}\n",
+                result->name,
+                (unsigned long long)result->ops,
+                ns_per_op,
+                allocs_per_op,
+                (unsigned long long)p50,
+                (unsigned long long)p90,
+                (unsigned long long)p99,
+                (unsigned long long)result->rounds.max_ns);
+    }
+}
+
+static bool bench_load(bench_result_t *const result, config_t *const config, const char *const path, const uint32_t rounds)
+{
+    config_error_sink_t sink = {0}; // Counts errors without printing them
+    bool is_loaded = false;
+
+    result_init(result, "config_load", path);
+    config_set_error_sink(&sink);
+
+    for (uint32_t i = 0; i < WARMUP_ROUNDS + rounds; i++)
+    {
+        memset(config, 0, sizeof(*config));
+
+        uint64_t allocs = num_allocs;
+        uint64_t start_ns = latency_now_ns();
+        is_loaded = config_load(config, path);
+        uint64_t elapsed_ns = latency_now_ns() - start_ns;
+
+        if (i >= WARMUP_ROUNDS)
+        {
+            result_add(result, 1U, elapsed_ns, num_allocs - allocs);
+        }
+    }
+
+    config_set_error_sink(NULL);
+
+    if (!is_loaded)
+    {
+        strncat(result->name, " (invalid)", sizeof(result->name) - strlen(result->name) - 1U);
+    }
+
+    return is_loaded;
+}
+
+static bool bench_validate(bench_result_t *const result, const config_t *const config, const char *const path, const uint32_t rounds)
+{
+    config_error_sink_t sink = {0};
+    bool is_valid = false;
+
+    result_init(result, "config_validate", path);
+    config_set_error_sink(&sink);
+
+    for (uint32_t i = 0; i < WARMUP_ROUNDS + rounds; i++)
+    {
+        uint64_t allocs = num_allocs;
+        uint64_t start_ns = latency_now_ns();
+        is_valid = config_validate(config);
+        uint64_t elapsed_ns = latency_now_ns() - start_ns;
+
+        if (i >= WARMUP_ROUNDS)
+        {
+            result_add(result, 1U, elapsed_ns, num_allocs - allocs);
+        }
+    }
+
+    config_set_error_sink(NULL);
+
+    if (!is_valid)
+    {
+        strncat(result->name, " (invalid)", sizeof(result->name) - strlen(result->name) - 1U);
+    }
+
+    return is_valid;
+}
+
+static void controller_setup(controller_t *const controller, const config_t *const config)
+{
+    memset(controller, 0, sizeof(*controller));
+    controller->config = config;
+    controller->tick_ms = STEP_TICK_MS;
+    controller->start_week_ms = 0; // Monday 00:00, like the simulation
+}
+
+static bool bench_init(bench_result_t *const result, controller_t *const controller, const config_t *const config, const char *const path, const uint32_t rounds)
+{
+    bool is_ready = false;
+
+    result_init(result, "controller_init", path);
+
+    for (uint32_t i = 0; i < WARMUP_ROUNDS + rounds; i++)
+    {
+        controller_setup(controller, config);
+
+        uint64_t allocs = num_allocs;
+        uint64_t start_ns = latency_now_ns();
+        is_ready = controller_init(controller);
+        uint64_t elapsed_ns = latency_now_ns() - start_ns;
+
+        if (!is_ready)
+        {
+            break; // Intersection type without a controller, the message is printed once
+        }
+
+        if (i >= WARMUP_ROUNDS)
+        {
+            result_add(result, 1U, elapsed_ns, num_allocs - allocs);
+        }
+    }
+
+    return is_ready;
+}
+
+// Splits the simulated time of the step benchmarks, fails if a round would have no step to time
+static bool step_plan_init(step_plan_t *const plan, const uint32_t duration_s, const uint32_t rounds)
+{
+    uint64_t num_steps = (uint64_t)duration_s * 1000U / STEP_TICK_MS;
+
+    plan->warmup_steps = num_steps / STEP_WARMUP_DIVISOR;
+    plan->timed_steps = num_steps - plan->warmup_steps;
+    plan->rounds = rounds;
+
+    if (plan->timed_steps < rounds)
+    {
+        fprintf(stderr, "%u s of simulated time leave %llu timed steps, too few for %u rounds\n",
+                duration_s, (unsigned long long)plan->timed_steps, rounds);
+        return false;
+    }
+
+    return true;
+}
+
+// Steps of a timed round, rounds differ by at most one step
+static uint64_t round_steps(const step_plan_t *const plan, const uint32_t round)
+{
+    return plan->timed_steps * (round + 1U) / plan->rounds - plan->timed_steps * round / plan->rounds;
+}
+
+// Deterministic pseudo random interval, the same call pattern on every run
+static uint32_t next_call_ms(uint32_t *const seed)
+{
+    *seed = *seed * 1103515245U + 12345U;
+    return (*seed >> 8) % (2U * CALL_MEAN_INTERVAL_MS);
+}
+
+static void run_steps(controller_t *const controller, call_script_t *const script, const uint64_t steps)
+{
+    for (uint64_t i = 0; i < steps; i++)
+    {
+        script->now_ms += STEP_TICK_MS;
+
+        if (script->now_ms >= script->call_ms)
+        {
+            controller_place_call(controller, script->call_phase);
+            script->call_phase = script->call_phase == PHASE_4 ? PHASE_8 : PHASE_4;
+            script->call_ms += next_call_ms(&script->seed);
+        }
+
+        controller->run(controller);
+    }
+}
+
+static void bench_step(bench_result_t *const result, controller_t *const controller, const char *const path, const step_plan_t *const plan)
+{
+    call_script_t script = {.seed = CALL_SEED, .call_phase = PHASE_4};
+    script.call_ms = next_call_ms(&script.seed);
+
+    result_init(result, "controller_step", path);
+    run_steps(controller, &script, plan->warmup_steps);
+
+    for (uint32_t round = 0; round < plan->rounds; round++)
+    {
+        uint64_t steps = round_steps(plan, round);
+        uint64_t allocs = num_allocs;
+        uint64_t start_ns = latency_now_ns();
+
+        run_steps(controller, &script, steps);
+
+        uint64_t elapsed_ns = latency_now_ns() - start_ns;
+        result_add(result, steps, elapsed_ns, num_allocs - allocs);
+    }
+}
+
+static void run_queue_steps(queue_model_t *const model, controller_t *const controller, const uint64_t steps)
+{
+    for (uint64_t i = 0; i < steps; i++)
+    {
+        uint8_t interval = controller->state.interval;
+        controller->run(controller);
+
+        if (controller->state.interval != interval)
+        {
+            for (size_t j = 0; j < QUEUE_INTERSECTIONS; j++)
+            {
+                queue_model_signals(model, j, controller);
+            }
+        }
+
+        queue_model_step(model, STEP_TICK_MS);
+    }
+}
+
+static void bench_queue(bench_result_t *const result, controller_t *const controller, const char *const path, const step_plan_t *const plan)
+{
+    // controller_t is cache line aligned, calloc only guarantees max_align_t
+    controller_t *controllers = aligned_alloc(_Alignof(controller_t), QUEUE_INTERSECTIONS * sizeof(controller_t));
+    queue_model_t model;
+
+    result_init(result, "queue_model_step", path);
+
+    if (controllers == NULL)
+    {
+        fprintf(stderr, "Out of memory while creating %u intersections\n", QUEUE_INTERSECTIONS);
+        return;
+    }
+
+    // The copies only lend their config and signals to the model, the original runs
+    for (size_t i = 0; i < QUEUE_INTERSECTIONS; i++)
+    {
+        memcpy(&controllers[i], controller, sizeof(controller_t));
+    }
+
+    bool is_ready = queue_model_init(&model, controllers, QUEUE_INTERSECTIONS);
+    free(controllers);
+
+    if (!is_ready)
+    {
+        return;
+    }
+
+    static const direction_type_t directions[] = {DIRECTION_NB, DIRECTION_SB, DIRECTION_EB, DIRECTION_WB};
+    for (size_t i = 0; i < QUEUE_INTERSECTIONS; i++)
+    {
+        for (size_t dir = 0; dir < sizeof(directions) / sizeof(directions[0]); dir++)
+        {
+            queue_model_set_rate(&model, i, directions[dir], QUEUE_VEHICLES_PER_HOUR);
+        }
+    }
+
+    run_queue_steps(&model, controller, plan->warmup_steps);
+
+    for (uint32_t round = 0; round < plan->rounds; round++)
+    {
+        uint64_t steps = round_steps(plan, round);
+        uint64_t allocs = num_allocs;
+        uint64_t start_ns = latency_now_ns();
+
+        run_queue_steps(&model, controller, steps);
+
+        uint64_t elapsed_ns = latency_now_ns() - start_ns;
+        result_add(result, steps * QUEUE_INTERSECTIONS, elapsed_ns, num_allocs - allocs);
+    }
+
+    queue_model_free(&model);
+}
+
+int main(int argc, char *argv[])
+{
+    static const struct option long_options[] = {
+        {"rounds", required_argument, NULL, 'n'},
+        {"duration", required_argument, NULL, 'd'},
+        {"output", required_argument, NULL, 'o'},
+        {NULL, 0, NULL, 0}};
+
+    uint32_t rounds = DEFAULT_ROUNDS;
+    uint32_t duration_s = DEFAULT_STEP_DURATION_S;
+    const char *output_path = NULL;
+    int opt;
+
+    while ((opt = getopt_long(argc, argv, "n:d:o:", long_options, NULL)) != -1)
+    {
+        switch (opt)
+        {
+        case 'n':
+            rounds = (uint32_t)strtoul(optarg, NULL, 10);
+            break;
+        case 'd':
+            duration_s = (uint32_t)strtoul(optarg, NULL, 10);
+            break;
+        case 'o':
+            output_path = optarg;
+            break;
+        default:
+            print_usage(argv[0]);
+            return EXIT_FAILURE;
+        }
+    }
+
+    if (argc - optind < 1 || rounds == 0 || duration_s == 0)
+    {
+        print_usage(argv[0]);
+        return EXIT_FAILURE;
+    }
+
+    static config_t config;
+    static controller_t controller;
+    static bench_result_t result;
+    step_plan_t step_plan;
+    FILE *report = NULL;
+
+    if (!step_plan_init(&step_plan, duration_s, rounds))
+    {
+        return EXIT_FAILURE;
+    }
+
+    if (output_path != NULL)
+    {
+        report = fopen(output_path, "w");
+
+        if (report == NULL)
+        {
+            fprintf(stderr, "Failed to create report: %s\n", output_path);
+            return EXIT_FAILURE;
+        }
+    }
+
+    print_header();
+
+    for (int i = optind; i < argc; i++)
+    {
+        const char *path = argv[i];
+        bool is_ready = bench_load(&result, &config, path, rounds);
+        print_result(report, &result);
+
+        if (!is_ready)
+        {
+            continue;
+        }
+
+        is_ready = bench_validate(&result, &config, path, rounds);
+        print_result(report, &result);
+
+        if (!is_ready)
+        {
+            continue;
+        }
+
+        if (!bench_init(&result, &controller, &config, path, rounds))
+        {
+            continue;
+        }
+
+        print_result(report, &result);
+
+        bench_step(&result, &controller, path, &step_plan);
+        print_result(report, &result);
+
+        bench_queue(&result, &controller, path, &step_plan);
+        print_result(report, &result);
+    }
+
+    if (report != NULL)
+    {
+        fclose(report);
+    }
+
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,363 @@
+/*
+ * Bulk config validation. Walks the given files and directory trees,
+ * loads and validates every *.json config on a thread pool and writes a
+ * JSON Lines report with the status and first error of each file. Workers
+ * only record errors, messages are formatted when the report is written.
+ * An error carries its code, the JSON path of the failing field, e.g.
+ * roads[1].directions[0].lanes.straight.detector.distance, and the value
+ * and legal limits of an out of range number. Exits with failure if any
+ * config is invalid.
+ */
+
+#define _XOPEN_SOURCE 700 // nftw
+
+#include "config.h"
+#include "thread_pool.h"
+#include <stdio.h>
+#include <math.h>
+#include <stdlib.h>
+#include <string.h>
+#include <ftw.h>
+#include <getopt.h>
+#include <time.h>
+
+#define CONFIG_FILE_EXT ".json"
+#define MAX_OPEN_DIRS 32 // File descriptors used by the directory walk
+#define NS_PER_MS 1000000ULL
+#define CONFIG_ERROR_TEXT_LEN 512U
+
+typedef struct
+{
+    char *path;
+    bool is_valid;
+    uint32_t num_errors;
+    config_error_t error; // First error, formatted when the report is written
+} check_result_t;
+
+typedef struct
+{
+    check_result_t *results;
+    size_t count;
+    size_t capacity;
+} check_list_t;
+
+static check_list_t file_list; // nftw callbacks take no context argument
+
+static void print_usage(const char *const prog)
+{
+    fprintf(stderr,
+            "Usage: %s [options] <config_file_path|config_dir>...\n"
+            "  -j, --threads N  Worker threads, 0 uses all online CPUs (default 0)\n"
+            "  -o, --output FILE\n"
+            "                   Write the report to FILE instead of stdout\n"
+            "Directories are searched recursively for *%s files. The report has\n"
+            "one JSON object per file: {\"file\", \"status\": \"ok\"|\"error\",\n"
+            "\"errors\", \"code\", \"path\", \"error\"} with the number of errors and\n"
+            "the first one, range errors add \"actual\", \"min\" and \"max\".\n",
+            prog,
+            CONFIG_FILE_EXT);
+}
+
+static int collect_file(const char *path, const struct stat *st, int type, struct FTW *ftw)
+{
+    (void)st; // Unused parameter
+
+    const char *name = path + ftw->base;
+    size_t len = strlen(name);
+    bool is_config = name[0] != '.' &&
+                     len > strlen(CONFIG_FILE_EXT) &&
+                     strcmp(name + len - strlen(CONFIG_FILE_EXT), CONFIG_FILE_EXT) == 0;
+
+    // Files named on the command line are checked whatever their name
+    if (type != FTW_F || (ftw->level > 0 && !is_config))
+    {
+        return 0;
+    }
+
+    if (file_list.count == file_list.capacity)
+    {
+        size_t capacity = file_list.capacity > 0 ? file_list.capacity * 2U : 256U;
+        check_result_t *results = realloc(file_list.results, capacity * sizeof(check_result_t));
+
+        if (results == NULL)
+        {
+            fprintf(stderr, "Out of memory while collecting config paths\n");
+            return -1;
+        }
+
+        file_list.results = results;
+        file_list.capacity = capacity;
+    }
+
+    check_result_t *result = &file_list.results[file_list.count];
+    memset(result, 0, sizeof(*result));
+    result->path = strdup(path);
+
+    if (result->path == NULL)
+    {
+        fprintf(stderr, "Out of memory while collecting config paths\n");
+        return -1;
+    }
+
+    file_list.count++;
+    return 0;
+}
+
+static int compare_results(const void *a, const void *b)
+{
+    return strcmp(((const check_result_t *)a)->path, ((const check_result_t *)b)->path);
+}
+
+static void check_file(void *const ctx, const uint32_t task)
+{
+    check_result_t *result = &((check_list_t *)ctx)->results[task];
+    config_error_sink_t sink = {.errors = &result->error, .capacity = 1U};
+    config_t config;
+
+    memset(&config, 0, sizeof(config));
+    config_set_error_sink(&sink);
+
+    result->is_valid = config_load(&config, result->path) && config_validate(&config);
+    result->num_errors = sink.count;
+
+    config_set_error_sink(NULL);
+}
+
+static void print_json_string(FILE *const out, const char *str)
+{
+    fputc('"', out);
+
+    for (; *str != '\0'; str++)
+    {
+        unsigned char c = (unsigned char)*str;
+
+        if (c == '"' || c == '\\')
+        {
+            fprintf(out, "\\%c", c);
+        }
+        else if (c < 0x20U)
+        {
+            fprintf(out, "\\u%04x", c);
+        }
+        else
+        {
+            fputc(c, out);
+        }
+    }
+
+    fputc('"', out);
+}
+
+static void print_json_number(FILE *const out, const char *const name, const double value)
+{
+    if (isnan(value))
+    {
+        fprintf(out, ",\"%s\":null", name);
+    }
+    else
+    {
+        fprintf(out, ",\"%s\":%g", name, value);
+    }
+}
+
+static void print_report(FILE *const out, const check_list_t *const list)
+{
+    char text[CONFIG_ERROR_TEXT_LEN];
+
+    for (size_t i = 0; i < list->count; i++)
+    {
+        const check_result_t *result = &list->results[i];
+        const config_error_t *error = &result->error;
+
+        fputs("{\"file\":", out);
+        print_json_string(out, result->path);
+
+        if (result->is_valid)
+        {
+            fputs(",\"status\":\"ok\"}\n", out);
+            continue;
+        }
+
+        fprintf(out, ",\"status\":\"error\",\"errors\":%u", result->num_errors);
+
+        if (result->num_errors == 0)
+        {
+            fputs("}\n", out);
+            continue;
+        }
+
+        fprintf(out, ",\"code\":\"%s\",\"path\":", config_error_code_str(error->code));
+        config_error_path(error, text, sizeof(text));
+        print_json_string(out, text);
+
+        if (error->code == CONFIG_ERROR_RANGE)
+        {
+            print_json_number(out, "actual", error->actual);
+            print_json_number(out, "min", error->min);
+            print_json_number(out, "max", error->max);
+        }
+
+        fputs(",\"error\":", out);
+        config_error_message(error, text, sizeof(text));
+        print_json_string(out, text);
+        fputs("}\n", out);
+    }
+}
+
+static uint64_t monotonic_ns(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000ULL + (uint64_t)ts.tv_nsec;
+}
+
+int main(int argc, char *argv[])
+{
+    static const struct option long_options[] = {
+        {"threads", required_argument, NULL, 'j'},
+        {"output", required_argument, NULL, 'o'},
+        {NULL, 0, NULL, 0}};
+
+    size_t num_threads = 0;
+    const char *output_path = NULL;
+    int opt;
+
+    while ((opt = getopt_long(argc, argv, "j:o:", long_options, NULL)) != -1)
+    {
+        switch (opt)
+        {
+        case 'j':
+            num_threads = (size_t)strtoul(optarg, NULL, 10);
+            break;
+        case 'o':
+            output_path = optarg;
+            break;
+        default:
+            print_usage(argv[0]);
+            return EXIT_FAILURE;
+        }
+    }
+
+    if (argc - optind < 1)
+    {
+        print_usage(argv[0]);
+        return EXIT_FAILURE;
+    }
+
+    num_threads = thread_pool_resolve_threads(num_threads);
+
+    int status = EXIT_FAILURE;
+    uint32_t *tasks = NULL;
+    thread_pool_t pool = {0};
+    bool has_pool = false;
+    FILE *out = stdout;
+
+    do
+    {
+        int i;
+        for (i = optind; i < argc; i++)
+        {
+            if (nftw(argv[i], collect_file, MAX_OPEN_DIRS, FTW_PHYS) != 0)
+            {
+                fprintf(stderr, "Failed to scan config path: %s\n", argv[i]);
+                break;
+            }
+        }
+
+        if (i != argc)
+        {
+            break;
+        }
+
+        if (file_list.count == 0)
+        {
+            fprintf(stderr, "No config files found\n");
+            break;
+        }
+
+        qsort(file_list.results, file_list.count, sizeof(check_result_t), compare_results);
+
+        tasks = malloc(file_list.count * sizeof(uint32_t));
+
+        if (tasks == NULL)
+        {
+            fprintf(stderr, "Out of memory while allocating %lu tasks\n", file_list.count);
+            break;
+        }
+
+        for (size_t j = 0; j < file_list.count; j++)
+        {
+            tasks[j] = (uint32_t)j;
+        }
+
+        if (num_threads > file_list.count)
+        {
+            num_threads = file_list.count;
+        }
+
+        has_pool = thread_pool_init(&pool, num_threads, file_list.count);
+
+        if (!has_pool)
+        {
+            fprintf(stderr, "Failed to start %lu worker threads\n", num_threads);
+            break;
+        }
+
+        uint64_t start_ns = monotonic_ns();
+        thread_pool_run(&pool, tasks, file_list.count, check_file, &file_list);
+        uint64_t elapsed_ns = monotonic_ns() - start_ns;
+
+        if (output_path != NULL)
+        {
+            out = fopen(output_path, "w");
+
+            if (out == NULL)
+            {
+                out = stdout;
+                fprintf(stderr, "Failed to create report: %s\n", output_path);
+                break;
+            }
+        }
+
+        print_report(out, &file_list);
+
+        size_t num_invalid = 0;
+        for (size_t j = 0; j < file_list.count; j++)
+        {
+            num_invalid += !file_list.results[j].is_valid;
+        }
+
+        fprintf(stderr,
+                "Checked %lu configs on %lu threads in %.1f ms: %lu valid, %lu invalid\n",
+                file_list.count,
+                num_threads,
+                (double)elapsed_ns / NS_PER_MS,
+                file_list.count - num_invalid,
+                num_invalid);
+
+        status = num_invalid == 0 ? EXIT_SUCCESS : EXIT_FAILURE;
+
+    } while (0);
+
+    if (out != stdout && fclose(out) != 0)
+    {
+        fprintf(stderr, "Failed to write report: %s\n", output_path);
+        status = EXIT_FAILURE;
+    }
+
+    if (has_pool)
+    {
+        thread_pool_free(&pool);
+    }
+
+    free(tasks);
+
+    for (size_t j = 0; j < file_list.count; j++)
+    {
+        free(file_list.results[j].path);
+    }
+
+    free(file_list.results);
+
+    return status;
+}
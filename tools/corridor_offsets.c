@@ -0,0 +1,205 @@
+/*
+ * Corridor offset optimization. Loads the configs of the intersections
+ * along one main road, orders them by corridor position and searches the
+ * cycle length and offsets with the widest two-way progression band.
+ * Cycle lengths are optimized in parallel on a thread pool. The result is
+ * printed as a coordination object per intersection, ready for its config.
+ */
+
+#include "config.h"
+#include "config_cache.h"
+#include "coordination.h"
+#include "thread_pool.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <getopt.h>
+
+#define DEFAULT_MIN_CYCLE 60U
+#define DEFAULT_MAX_CYCLE 150U
+#define DEFAULT_CYCLE_STEP 5U
+
+static void print_usage(const char *const prog)
+{
+    fprintf(stderr,
+            "Usage: %s [options] <config_file_path>...\n"
+            "  -j, --threads N  Worker threads, 0 uses all online CPUs (default 0)\n"
+            "  -m, --min-cycle S\n"
+            "                   Shortest cycle length tried, seconds (default %u)\n"
+            "  -M, --max-cycle S\n"
+            "                   Longest cycle length tried, seconds (default %u)\n"
+            "  -s, --step S     Cycle length increment, seconds (default %u)\n"
+            "Intersections are ordered by their corridor_position. Cycle lengths\n"
+            "must be within %u to %u seconds.\n",
+            prog,
+            DEFAULT_MIN_CYCLE,
+            DEFAULT_MAX_CYCLE,
+            DEFAULT_CYCLE_STEP,
+            MIN_CYCLE_LENGTH,
+            MAX_CYCLE_LENGTH);
+}
+
+static void print_plans(const corridor_plan_t *const plans, const size_t count)
+{
+    printf("cycle  outbound  inbound  efficiency\n");
+
+    for (size_t i = 0; i < count; i++)
+    {
+        const corridor_plan_t *plan = &plans[i];
+
+        if (!plan->is_feasible)
+        {
+            printf("%5u  minimum times do not fit\n", plan->cycle_length);
+            continue;
+        }
+
+        printf("%5u  %7.1fs  %6.1fs  %9.1f%%\n",
+               plan->cycle_length,
+               plan->bandwidth_out,
+               plan->bandwidth_in,
+               100.0f * plan->efficiency);
+    }
+}
+
+static void print_offsets(const corridor_t *const corridor, const corridor_plan_t *const plan)
+{
+    printf("\nBest cycle length %u s, %.1f%% two-way efficiency\n",
+           plan->cycle_length,
+           100.0f * plan->efficiency);
+
+    for (size_t i = 0; i < corridor->num_nodes; i++)
+    {
+        const corridor_node_t *node = &corridor->nodes[i];
+
+        printf("%s at %u ft: \"coordination\": "
+               "{\"cycle_length\": %u, \"offset\": %u, \"split\": %u}\n",
+               node->id,
+               node->position_ft,
+               plan->cycle_length,
+               plan->offsets[i],
+               plan->splits[i]);
+    }
+}
+
+int main(int argc, char *argv[])
+{
+    static const struct option long_options[] = {
+        {"threads", required_argument, NULL, 'j'},
+        {"min-cycle", required_argument, NULL, 'm'},
+        {"max-cycle", required_argument, NULL, 'M'},
+        {"step", required_argument, NULL, 's'},
+        {NULL, 0, NULL, 0}};
+
+    size_t num_threads = 0;
+    unsigned long min_cycle = DEFAULT_MIN_CYCLE;
+    unsigned long max_cycle = DEFAULT_MAX_CYCLE;
+    unsigned long step = DEFAULT_CYCLE_STEP;
+    int opt;
+
+    while ((opt = getopt_long(argc, argv, "j:m:M:s:", long_options, NULL)) != -1)
+    {
+        switch (opt)
+        {
+        case 'j':
+            num_threads = (size_t)strtoul(optarg, NULL, 10);
+            break;
+        case 'm':
+            min_cycle = strtoul(optarg, NULL, 10);
+            break;
+        case 'M':
+            max_cycle = strtoul(optarg, NULL, 10);
+            break;
+        case 's':
+            step = strtoul(optarg, NULL, 10);
+            break;
+        default:
+            print_usage(argv[0]);
+            return EXIT_FAILURE;
+        }
+    }
+
+    if (argc - optind < 1 ||
+        min_cycle < MIN_CYCLE_LENGTH ||
+        max_cycle > MAX_CYCLE_LENGTH ||
+        min_cycle > max_cycle ||
+        step == 0 ||
+        step > MAX_CYCLE_LENGTH)
+    {
+        print_usage(argv[0]);
+        return EXIT_FAILURE;
+    }
+
+    size_t max_plans = (max_cycle - min_cycle) / step + 1U;
+    num_threads = thread_pool_resolve_threads(num_threads);
+    num_threads = num_threads < max_plans ? num_threads : max_plans;
+
+    static corridor_t corridor;
+    static corridor_plan_t plans[CORRIDOR_MAX_CYCLES];
+    static config_t config;
+    int status = EXIT_FAILURE;
+    thread_pool_t pool = {0};
+    bool has_pool = false;
+
+    do
+    {
+        int i;
+        for (i = optind; i < argc; i++)
+        {
+            memset(&config, 0, sizeof(config));
+
+            if (!config_load_cached(&config, argv[i]) || !corridor_add(&corridor, &config))
+            {
+                fprintf(stderr, "Failed to add intersection: %s\n", argv[i]);
+                break;
+            }
+        }
+
+        if (i != argc)
+        {
+            break;
+        }
+
+        has_pool = thread_pool_init(&pool, num_threads, max_plans);
+
+        if (!has_pool)
+        {
+            fprintf(stderr, "Failed to start %lu worker threads\n", num_threads);
+            break;
+        }
+
+        size_t num_plans = 0;
+
+        if (!corridor_search(
+                &corridor,
+                &pool,
+                (uint16_t)min_cycle,
+                (uint16_t)max_cycle,
+                (uint16_t)step,
+                plans,
+                &num_plans))
+        {
+            break;
+        }
+
+        print_plans(plans, num_plans);
+
+        size_t best = corridor_best_plan(plans, num_plans);
+
+        if (best == num_plans)
+        {
+            fprintf(stderr, "No cycle length fits the minimum times of every intersection\n");
+            break;
+        }
+
+        print_offsets(&corridor, &plans[best]);
+        status = EXIT_SUCCESS;
+
+    } while (0);
+
+    if (has_pool)
+    {
+        thread_pool_free(&pool);
+    }
+
+    return status;
+}
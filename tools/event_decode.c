@@ -0,0 +1,144 @@
+/*
+ * Converts an event log written with --event-log to CSV, one row per
+ * record from the oldest kept to the newest. The log may still be written
+ * by a running controller, records appended meanwhile are not included.
+ */
+
+#include "event_log.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+#include <getopt.h>
+
+static void print_usage(const char *const prog)
+{
+    fprintf(stderr,
+            "Usage: %s [options] <event_log_path>\n"
+            "  -o, --output FILE\n"
+            "                   Write the CSV to FILE instead of stdout\n"
+            "Columns: time_ms,intersection,event,phase,state,cause,value\n",
+            prog);
+}
+
+static void print_summary(const event_log_view_t *const view, const char *const path)
+{
+    const event_log_header_t *header = view->header;
+    uint64_t head = view->first + view->count; // Records ever appended
+
+    fprintf(stderr,
+            "%s: %llu of %llu records kept, %u intersections, %u ms ticks",
+            path,
+            (unsigned long long)view->count,
+            (unsigned long long)head,
+            header->num_intersections,
+            header->tick_ms);
+
+    if (header->epoch_ms == 0)
+    {
+        fprintf(stderr, ", simulated\n");
+        return;
+    }
+
+    time_t epoch_s = (time_t)(header->epoch_ms / 1000U);
+    struct tm tm;
+    char started[32];
+
+    strftime(started, sizeof(started), "%Y-%m-%d %H:%M:%S", localtime_r(&epoch_s, &tm));
+    fprintf(stderr, ", started %s\n", started);
+}
+
+static void print_record(FILE *const csv, const event_log_view_t *const view, const event_record_t *const record)
+{
+    const char *id = record->intersection < view->header->num_intersections ? view->ids[record->intersection] : "";
+
+    fprintf(csv, "%llu,%s,%s,", (unsigned long long)record->time_ms, id, event_kind_str((event_kind_t)record->kind));
+
+    switch (record->kind)
+    {
+    case EVENT_SIGNAL:
+        fprintf(csv,
+                "%u,%s,%s,\n",
+                record->phase + 1U,
+                signal_state_str((signal_state_t)record->state),
+                record->cause != TERMINATION_NONE ? termination_str((termination_t)record->cause) : "");
+        break;
+    case EVENT_DETECTOR_ON:
+    case EVENT_DETECTOR_OFF:
+    case EVENT_CALL:
+        fprintf(csv, "%u,,,\n", record->phase + 1U);
+        break;
+    case EVENT_PLAN:
+        fprintf(csv, ",,,%u\n", record->value);
+        break;
+    default:
+        fprintf(csv, ",,,\n");
+        break;
+    }
+}
+
+int main(int argc, char *argv[])
+{
+    static const struct option long_options[] = {
+        {"output", required_argument, NULL, 'o'},
+        {NULL, 0, NULL, 0}};
+
+    const char *output_path = NULL;
+    int opt;
+
+    while ((opt = getopt_long(argc, argv, "o:", long_options, NULL)) != -1)
+    {
+        switch (opt)
+        {
+        case 'o':
+            output_path = optarg;
+            break;
+        default:
+            print_usage(argv[0]);
+            return EXIT_FAILURE;
+        }
+    }
+
+    if (argc - optind != 1)
+    {
+        print_usage(argv[0]);
+        return EXIT_FAILURE;
+    }
+
+    event_log_view_t view;
+
+    if (!event_log_view_open(&view, argv[optind]))
+    {
+        return EXIT_FAILURE;
+    }
+
+    FILE *csv = stdout;
+
+    if (output_path != NULL)
+    {
+        csv = fopen(output_path, "w");
+
+        if (csv == NULL)
+        {
+            fprintf(stderr, "Failed to create CSV: %s\n", output_path);
+            event_log_view_close(&view);
+            return EXIT_FAILURE;
+        }
+    }
+
+    print_summary(&view, argv[optind]);
+    fprintf(csv, "time_ms,intersection,event,phase,state,cause,value\n");
+
+    for (uint64_t i = 0; i < view.count; i++)
+    {
+        print_record(csv, &view, event_log_view_record(&view, i));
+    }
+
+    if (csv != stdout)
+    {
+        fclose(csv);
+    }
+
+    event_log_view_close(&view);
+
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,252 @@
+/*
+ * Timing plan optimization. Loads a config and a demand profile, draws the
+ * arrivals of the profile once, and searches the clearance and green times
+ * of one timing plan against them on a simulated controller, in parallel
+ * on a thread pool. The Pareto-best plans are printed as timing objects per
+ * road, ready for the config.
+ */
+
+#include "config.h"
+#include "config_cache.h"
+#include "optimizer.h"
+#include "scheduler.h"
+#include "simulation.h"
+#include "thread_pool.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <getopt.h>
+#include <time.h>
+
+#define DEFAULT_ROUNDS 8U
+#define DEFAULT_DURATION_S 3600U
+#define DEFAULT_SEED 1U
+
+static void print_usage(const char *const prog)
+{
+    fprintf(stderr,
+            "Usage: %s [options] <config_file_path> <demand_file>\n"
+            "  -p, --plan ID    Timing plan to optimize (default \"%s\", the base plan)\n"
+            "  -n, --batch N    Plans evaluated per round, at most %u (default %u)\n"
+            "  -r, --rounds N   Search rounds, later ones refine the best plans (default %u)\n"
+            "  -d, --duration S Seconds of demand each plan runs (default %u)\n"
+            "  -G, --max-green S\n"
+            "                   Longest maximum green searched (default %u)\n"
+            "  -s, --seed N     Seed of the arrivals and the search (default %u)\n"
+            "  -j, --threads N  Worker threads, 0 uses all online CPUs (default 0)\n"
+            "Demand lines are \"<time_s> <phase> <vehicles_per_hour>\", the rate of a\n"
+            "phase from time_s on. Plans are compared on average delay, maximum\n"
+            "delay and the shortest yellow and red clearance of the two roads.\n",
+            prog,
+            CONFIG_BASE_PLAN_ID,
+            OPTIMIZER_MAX_BATCH,
+            OPTIMIZER_DEFAULT_BATCH,
+            DEFAULT_ROUNDS,
+            DEFAULT_DURATION_S,
+            OPTIMIZER_DEFAULT_MAX_GREEN,
+            DEFAULT_SEED);
+}
+
+static void print_plan(const char *const label, const optimizer_plan_t *const plan, const config_t *const config)
+{
+    printf("%-8s %8.1fs %8.1fs %8.1fs %7.1f%%\n",
+           label,
+           plan->avg_delay_s,
+           plan->max_delay_s,
+           plan->clearance_s,
+           100.0 * plan->green_share);
+
+    for (size_t road = 0; road < MAX_ROADS; road++)
+    {
+        const phase_timing_t *timing = &plan->timing[road];
+
+        printf("         %s: \"timing\": {\"yellow_time\": %.1f, \"red_clearance\": %.1f, \"min_green\": %u",
+               config->roads[road].name,
+               timing->yellow_time,
+               timing->red_clearance,
+               timing->min_green);
+
+        if (timing->passage_time > 0.0f && timing->max_green > 0)
+        {
+            printf(", \"max_green\": %u, \"passage_time\": %.1f", timing->max_green, timing->passage_time);
+        }
+
+        printf("}\n");
+    }
+}
+
+int main(int argc, char *argv[])
+{
+    static const struct option long_options[] = {
+        {"plan", required_argument, NULL, 'p'},
+        {"batch", required_argument, NULL, 'n'},
+        {"rounds", required_argument, NULL, 'r'},
+        {"duration", required_argument, NULL, 'd'},
+        {"max-green", required_argument, NULL, 'G'},
+        {"seed", required_argument, NULL, 's'},
+        {"threads", required_argument, NULL, 'j'},
+        {NULL, 0, NULL, 0}};
+
+    const char *plan_id = CONFIG_BASE_PLAN_ID;
+    unsigned long batch_size = OPTIMIZER_DEFAULT_BATCH;
+    unsigned long rounds = DEFAULT_ROUNDS;
+    unsigned long long duration_s = DEFAULT_DURATION_S;
+    unsigned long max_green = OPTIMIZER_DEFAULT_MAX_GREEN;
+    unsigned long long seed = DEFAULT_SEED;
+    size_t num_threads = 0;
+    int opt;
+
+    while ((opt = getopt_long(argc, argv, "p:n:r:d:G:s:j:", long_options, NULL)) != -1)
+    {
+        switch (opt)
+        {
+        case 'p':
+            plan_id = optarg;
+            break;
+        case 'n':
+            batch_size = strtoul(optarg, NULL, 10);
+            break;
+        case 'r':
+            rounds = strtoul(optarg, NULL, 10);
+            break;
+        case 'd':
+            duration_s = strtoull(optarg, NULL, 10);
+            break;
+        case 'G':
+            max_green = strtoul(optarg, NULL, 10);
+            break;
+        case 's':
+            seed = strtoull(optarg, NULL, 10);
+            break;
+        case 'j':
+            num_threads = (size_t)strtoul(optarg, NULL, 10);
+            break;
+        default:
+            print_usage(argv[0]);
+            return EXIT_FAILURE;
+        }
+    }
+
+    if (argc - optind != 2 ||
+        batch_size == 0 ||
+        batch_size > OPTIMIZER_MAX_BATCH ||
+        duration_s == 0 ||
+        duration_s > UINT32_MAX / 1000U ||
+        max_green < MIN_GREEN_STOP_LINE ||
+        max_green > UINT8_MAX)
+    {
+        print_usage(argv[0]);
+        return EXIT_FAILURE;
+    }
+
+    num_threads = thread_pool_resolve_threads(num_threads);
+    num_threads = num_threads < batch_size ? num_threads : batch_size;
+
+    static config_t config;
+    static optimizer_t optimizer;
+    sim_demand_t demand = {0};
+    sim_script_t script = {0};
+    thread_pool_t pool = {0};
+    bool has_optimizer = false;
+    bool has_pool = false;
+    int status = EXIT_FAILURE;
+
+    do
+    {
+        if (!config_load_cached(&config, argv[optind]) || !sim_demand_load(&demand, argv[optind + 1]))
+        {
+            break;
+        }
+
+        if (!sim_script_generate(&script, &demand, duration_s * 1000U, seed))
+        {
+            break;
+        }
+
+        struct timespec start, end;
+        clock_gettime(CLOCK_MONOTONIC, &start);
+
+        has_optimizer = optimizer_init(
+            &optimizer,
+            &config,
+            plan_id,
+            &script,
+            &demand,
+            duration_s * 1000U,
+            SCHEDULER_DEFAULT_TICK_MS,
+            (uint8_t)max_green,
+            batch_size,
+            seed);
+
+        if (!has_optimizer)
+        {
+            break;
+        }
+
+        has_pool = thread_pool_init(&pool, num_threads, batch_size);
+
+        if (!has_pool)
+        {
+            fprintf(stderr, "Failed to start %lu worker threads\n", num_threads);
+            break;
+        }
+
+        printf("Optimizing plan %s of %s over %llu s of demand, %lu detector events\n",
+               plan_id,
+               config.id,
+               duration_s,
+               script.count);
+
+        unsigned long round;
+        for (round = 0; round < rounds; round++)
+        {
+            if (!optimizer_round(&optimizer, &pool))
+            {
+                break;
+            }
+
+            printf("Round %lu: %lu plans on the front\n", round + 1U, optimizer.front_count);
+        }
+
+        if (round != rounds)
+        {
+            break;
+        }
+
+        clock_gettime(CLOCK_MONOTONIC, &end);
+        optimizer_sort_front(&optimizer);
+
+        printf("Evaluated %llu plans, %llu rejected by validation, in %.1f s on %lu threads\n\n",
+               (unsigned long long)optimizer.evaluated,
+               (unsigned long long)optimizer.rejected,
+               (double)(end.tv_sec - start.tv_sec) + (double)(end.tv_nsec - start.tv_nsec) / 1e9,
+               pool.num_threads);
+        printf("plan     avg delay max delay clearance on green\n");
+        print_plan("current", &optimizer.current, &config);
+
+        for (size_t i = 0; i < optimizer.front_count; i++)
+        {
+            char label[24];
+            snprintf(label, sizeof(label), "%lu", i + 1U);
+            print_plan(label, &optimizer.front[i], &config);
+        }
+
+        status = EXIT_SUCCESS;
+
+    } while (0);
+
+    if (has_pool)
+    {
+        thread_pool_free(&pool);
+    }
+
+    if (has_optimizer)
+    {
+        optimizer_free(&optimizer);
+    }
+
+    sim_script_free(&script);
+    sim_demand_free(&demand);
+
+    return status;
+}